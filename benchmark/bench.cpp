@@ -9,6 +9,7 @@
 #include <iostream>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "generator.hpp"
 #include "kvdk/engine.hpp"
@@ -80,15 +81,57 @@ DEFINE_bool(
 
 DEFINE_uint64(max_access_threads, 64, "Max access threads of the instance");
 
+DEFINE_uint64(max_elastic_access_threads, 0,
+              "Max elastic access threads of the instance, 0 to disable");
+
 DEFINE_uint64(space, (256ULL << 30), "Max usable PMem space of the instance");
 
+DEFINE_uint64(recovery_threads, 0,
+              "Threads to recover the instance, 0 means max_access_threads");
+
+DEFINE_bool(numa_bind_recovery_threads, false,
+            "Bind recovery threads to NUMA node of the PMem device");
+
 DEFINE_bool(opt_large_sorted_collection_restore, true,
             " Optional optimization strategy which Multi-thread recovery a "
             "skiplist. When having few large skiplists, the optimization can "
             "get better performance");
 
+DEFINE_bool(opt_large_hash_list_restore, false,
+            " Optional optimization strategy which Multi-thread recovery a "
+            "hash collection or list by segments. When having few large hash "
+            "collections or lists, the optimization can get better "
+            "performance");
+
 DEFINE_bool(use_devdax_mode, false, "Use devdax device for kvdk");
 
+DEFINE_bool(emulate_pmem, false,
+            "Emulate PMem with regular files under path, e.g. on tmpfs");
+
+DEFINE_bool(emulate_pmem_msync, false, "msync writes in emulated PMem");
+
+DEFINE_uint64(emulate_pmem_write_latency_ns, 0,
+              "Latency injected to each persist barrier in emulated PMem");
+
+DEFINE_uint64(emulate_pmem_write_bandwidth_mb, 0,
+              "Per thread write bandwidth in MB/s of emulated PMem, 0 for "
+              "unlimited");
+
+DEFINE_bool(xpline_aware_allocation, false,
+            "Allocate records by 256 bytes XPLines of Optane PMem");
+
+DEFINE_bool(relaxed_durability, false,
+            "Make string writes durable in group flushes");
+
+DEFINE_uint64(background_threads, 0,
+              "Threads to run background works, 0 means clean_threads + 1");
+
+DEFINE_string(background_cpus, "",
+              "Comma separated CPUs that background threads are bound to, "
+              "e.g. \"0,1,2\". Empty for no binding");
+
+DEFINE_int32(background_nice, 0, "Nice value of background threads");
+
 class Timer {
  public:
   void Start() { clock_gettime(CLOCK_REALTIME, &start); }
@@ -485,6 +528,22 @@ void ProcessBenchmarkConfigs() {
   }
 }
 
+std::vector<int> ParseCPUs(const std::string& cpus) {
+  std::vector<int> ret;
+  size_t pos = 0;
+  while (pos < cpus.size()) {
+    size_t end = cpus.find(',', pos);
+    if (end == std::string::npos) {
+      end = cpus.size();
+    }
+    if (end > pos) {
+      ret.push_back(std::stoi(cpus.substr(pos, end - pos)));
+    }
+    pos = end + 1;
+  }
+  return ret;
+}
+
 int main(int argc, char** argv) {
   ParseCommandLineFlags(&argc, &argv, true);
   ProcessBenchmarkConfigs();
@@ -493,10 +552,26 @@ int main(int argc, char** argv) {
     Configs configs;
     configs.populate_pmem_space = FLAGS_populate;
     configs.max_access_threads = FLAGS_max_access_threads;
+    configs.max_elastic_access_threads = FLAGS_max_elastic_access_threads;
     configs.pmem_file_size = FLAGS_space;
     configs.opt_large_sorted_collection_recovery =
         FLAGS_opt_large_sorted_collection_restore;
+    configs.opt_large_hash_collection_recovery =
+        FLAGS_opt_large_hash_list_restore;
+    configs.opt_large_list_recovery = FLAGS_opt_large_hash_list_restore;
+    configs.recovery_threads = FLAGS_recovery_threads;
+    configs.numa_bind_recovery_threads = FLAGS_numa_bind_recovery_threads;
     configs.use_devdax_mode = FLAGS_use_devdax_mode;
+    configs.emulate_pmem = FLAGS_emulate_pmem;
+    configs.emulate_pmem_msync = FLAGS_emulate_pmem_msync;
+    configs.emulate_pmem_write_latency_ns = FLAGS_emulate_pmem_write_latency_ns;
+    configs.emulate_pmem_write_bandwidth_mb =
+        FLAGS_emulate_pmem_write_bandwidth_mb;
+    configs.xpline_aware_allocation = FLAGS_xpline_aware_allocation;
+    configs.relaxed_durability = FLAGS_relaxed_durability;
+    configs.background_threads = FLAGS_background_threads;
+    configs.background_cpus = ParseCPUs(FLAGS_background_cpus);
+    configs.background_nice = FLAGS_background_nice;
     Status s = Engine::Open(FLAGS_path, &engine, configs, stdout);
     if (s != Status::Ok) {
       throw std::runtime_error{
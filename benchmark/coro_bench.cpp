@@ -0,0 +1,196 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+// Compare point lookups of plain Get, batched MultiGet and interleaved
+// coroutine lookups. Build with -DBUILD_CORO_LOOKUP=ON
+
+#include <gflags/gflags.h>
+#include <sys/time.h>
+
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine/coro/lookup_coro.hpp"
+#include "kvdk/engine.hpp"
+
+using namespace google;
+using namespace KVDK_NAMESPACE;
+
+DEFINE_string(path, "/mnt/pmem0/kvdk_coro_bench", "Instance path");
+
+DEFINE_uint64(num_kv, (1 << 24), "Number of KVs to fill");
+
+DEFINE_uint64(value_size, 120, "Value size of KV");
+
+DEFINE_uint64(threads, 8, "Number of concurrent threads to run benchmark");
+
+DEFINE_uint64(num_operations, (1 << 24), "Number of lookups of each method");
+
+DEFINE_uint64(batch_size, 16,
+              "Number of lookups in flight of MultiGet and coroutines");
+
+DEFINE_string(type, "string",
+              "Lookup type to benchmark, can be string, hash or sorted");
+
+DEFINE_uint64(space, (64ULL << 30), "Max usable PMem space of the instance");
+
+DEFINE_uint64(max_access_threads, 64, "Max access threads of the instance");
+
+DEFINE_uint64(hash_bucket_num, (1 << 27), "Hash buckets of the instance");
+
+DEFINE_bool(populate, false, "Populate pmem space while creating instance");
+
+static const std::string kCollection = "coro_bench_collection";
+
+static std::string KeyOf(uint64_t i) { return "key" + std::to_string(i); }
+
+static double NowSeconds() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static void Fill(Engine* engine) {
+  std::string value(FLAGS_value_size, 'v');
+  std::vector<std::thread> ts;
+  for (uint64_t tid = 0; tid < FLAGS_threads; tid++) {
+    ts.emplace_back([&, tid]() {
+      for (uint64_t i = tid; i < FLAGS_num_kv; i += FLAGS_threads) {
+        std::string key = KeyOf(i);
+        Status s;
+        if (FLAGS_type == "hash") {
+          s = engine->HashPut(kCollection, key, value);
+        } else if (FLAGS_type == "sorted") {
+          s = engine->SortedPut(kCollection, key, value);
+        } else {
+          s = engine->Put(key, value);
+        }
+        if (s != Status::Ok) {
+          fprintf(stderr, "Fill failed with status %d\n", s);
+          exit(1);
+        }
+      }
+    });
+  }
+  for (auto& t : ts) {
+    t.join();
+  }
+}
+
+// Run "lookup_batch" over random keys in all threads, return lookups per
+// second
+static double RunBench(
+    const std::function<void(std::vector<std::string>&,
+                             std::vector<std::string>&, std::vector<Status>&)>&
+        lookup_batch) {
+  std::atomic<uint64_t> not_found{0};
+  std::vector<std::thread> ts;
+  double start = NowSeconds();
+  for (uint64_t tid = 0; tid < FLAGS_threads; tid++) {
+    ts.emplace_back([&, tid]() {
+      std::mt19937_64 rand(tid);
+      std::vector<std::string> keys(FLAGS_batch_size);
+      std::vector<std::string> values(FLAGS_batch_size);
+      std::vector<Status> status(FLAGS_batch_size);
+      uint64_t ops = FLAGS_num_operations / FLAGS_threads;
+      for (uint64_t done = 0; done < ops; done += FLAGS_batch_size) {
+        for (auto& key : keys) {
+          key = KeyOf(rand() % FLAGS_num_kv);
+        }
+        lookup_batch(keys, values, status);
+        for (auto s : status) {
+          if (s != Status::Ok) {
+            not_found++;
+          }
+        }
+      }
+    });
+  }
+  for (auto& t : ts) {
+    t.join();
+  }
+  double elapsed = NowSeconds() - start;
+  if (not_found.load() > 0) {
+    fprintf(stderr, "%lu lookups not found\n", not_found.load());
+  }
+  return FLAGS_num_operations / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+  ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_batch_size == 0 || FLAGS_threads == 0) {
+    fprintf(stderr, "batch_size and threads should be positive\n");
+    return 1;
+  }
+
+  Configs configs;
+  configs.pmem_file_size = FLAGS_space;
+  configs.populate_pmem_space = FLAGS_populate;
+  configs.max_access_threads = FLAGS_max_access_threads;
+  configs.hash_bucket_num = FLAGS_hash_bucket_num;
+  configs.log_level = LogLevel::None;
+  Engine* engine;
+  Status s = Engine::Open(FLAGS_path, &engine, configs, stdout);
+  if (s != Status::Ok) {
+    fprintf(stderr, "Open instance %s failed: %d\n", FLAGS_path.c_str(), s);
+    return 1;
+  }
+  if (FLAGS_type == "hash") {
+    engine->HashCreate(kCollection);
+  } else if (FLAGS_type == "sorted") {
+    engine->SortedCreate(kCollection);
+  }
+  Fill(engine);
+
+  auto plain_get = [&](std::vector<std::string>& keys,
+                       std::vector<std::string>& values,
+                       std::vector<Status>& status) {
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (FLAGS_type == "hash") {
+        status[i] = engine->HashGet(kCollection, keys[i], &values[i]);
+      } else if (FLAGS_type == "sorted") {
+        status[i] = engine->SortedGet(kCollection, keys[i], &values[i]);
+      } else {
+        status[i] = engine->Get(keys[i], &values[i]);
+      }
+    }
+  };
+
+  auto multi_get = [&](std::vector<std::string>& keys,
+                       std::vector<std::string>& values,
+                       std::vector<Status>& status) {
+    std::vector<StringView> key_views(keys.begin(), keys.end());
+    MultiGet(engine, key_views, &values, &status);
+  };
+
+  auto coro_get = [&](std::vector<std::string>& keys,
+                      std::vector<std::string>& values,
+                      std::vector<Status>& status) {
+    InterleavedLookup lookup(engine, FLAGS_batch_size);
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (FLAGS_type == "hash") {
+        lookup.HashGet(kCollection, keys[i], &values[i], &status[i]);
+      } else if (FLAGS_type == "sorted") {
+        lookup.SortedGet(kCollection, keys[i], &values[i], &status[i]);
+      } else {
+        lookup.Get(keys[i], &values[i], &status[i]);
+      }
+    }
+    lookup.Run();
+  };
+
+  printf("Get: %.0f ops/s\n", RunBench(plain_get));
+  if (FLAGS_type == "string") {
+    printf("MultiGet: %.0f ops/s\n", RunBench(multi_get));
+  }
+  printf("Coroutine lookups: %.0f ops/s\n", RunBench(coro_get));
+
+  delete engine;
+  return 0;
+}
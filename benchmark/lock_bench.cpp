@@ -0,0 +1,119 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+// Compare SpinMutex and QueuedMutex on a few hot locks, e.g. hash slots of
+// contended counters. Report throughput and lock acquisition latencies
+
+#include <gflags/gflags.h>
+#include <sys/time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "engine/utils/utils.hpp"
+
+using namespace google;
+using namespace KVDK_NAMESPACE;
+
+DEFINE_uint64(threads, 64, "Number of threads contending the locks");
+
+DEFINE_uint64(locks, 1, "Number of hot locks");
+
+DEFINE_uint64(num_operations, (1 << 22),
+              "Number of lock acquisitions of all threads");
+
+DEFINE_uint64(critical_section, 32,
+              "Number of pauses to execute while holding a lock");
+
+DEFINE_uint64(sample_interval, 16,
+              "Record latency of one in every this number of acquisitions");
+
+static double NowSeconds() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+// Cache line aligned lock and the counter it protects
+template <typename Mutex>
+struct alignas(64) HotLock {
+  Mutex mu;
+  uint64_t counter = 0;
+};
+
+template <typename Mutex>
+static void RunBench(const char* name) {
+  std::vector<HotLock<Mutex>> locks(FLAGS_locks);
+  std::vector<std::vector<uint64_t>> latencies(FLAGS_threads);
+  std::vector<std::thread> ts;
+  uint64_t ops = FLAGS_num_operations / FLAGS_threads;
+  double start = NowSeconds();
+  for (uint64_t tid = 0; tid < FLAGS_threads; tid++) {
+    ts.emplace_back([&, tid]() {
+      std::mt19937_64 rand(tid);
+      auto& lat = latencies[tid];
+      for (uint64_t i = 0; i < ops; i++) {
+        auto& l = locks[rand() % locks.size()];
+        auto begin = std::chrono::steady_clock::now();
+        l.mu.lock();
+        auto acquired = std::chrono::steady_clock::now();
+        l.counter++;
+        for (uint64_t p = 0; p < FLAGS_critical_section; p++) {
+          _mm_pause();
+        }
+        l.mu.unlock();
+        if (i % FLAGS_sample_interval == 0) {
+          lat.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            acquired - begin)
+                            .count());
+        }
+      }
+    });
+  }
+  for (auto& t : ts) {
+    t.join();
+  }
+  double elapsed = NowSeconds() - start;
+
+  uint64_t total = 0;
+  for (auto& l : locks) {
+    total += l.counter;
+  }
+  if (total != ops * FLAGS_threads) {
+    fprintf(stderr, "%s: counter mismatch, %lu != %lu\n", name, total,
+            ops * FLAGS_threads);
+    exit(1);
+  }
+
+  std::vector<uint64_t> all;
+  for (auto& lat : latencies) {
+    all.insert(all.end(), lat.begin(), lat.end());
+  }
+  std::sort(all.begin(), all.end());
+  auto percentile = [&](double p) {
+    return all.empty() ? 0 : all[std::min(all.size() - 1,
+                                          (size_t)(p * all.size()))];
+  };
+  printf(
+      "%s: %.0f ops/s, acquire latency(ns) p50 %lu, p99 %lu, p999 %lu, max "
+      "%lu\n",
+      name, total / elapsed, percentile(0.5), percentile(0.99),
+      percentile(0.999), all.empty() ? 0 : all.back());
+}
+
+int main(int argc, char* argv[]) {
+  ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_threads == 0 || FLAGS_locks == 0 || FLAGS_sample_interval == 0) {
+    fprintf(stderr, "threads, locks and sample_interval should be positive\n");
+    return 1;
+  }
+  RunBench<SpinMutex>("SpinMutex");
+  RunBench<QueuedMutex>("QueuedMutex");
+  return 0;
+}
@@ -15,5 +15,7 @@ enum class WriteOp { Put, Delete };
 using PMemOffsetType = std::uint64_t;
 using TimestampType = std::uint64_t;
 
+constexpr PMemOffsetType kNullPMemOffset = UINT64_MAX;
+
 const uint64_t kMaxCachedOldRecords = 1024;
 }  // namespace KVDK_NAMESPACE
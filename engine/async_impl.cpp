@@ -0,0 +1,210 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include "async_impl.hpp"
+
+#include "kv_engine.hpp"
+
+namespace KVDK_NAMESPACE {
+
+AsyncExecutor::AsyncExecutor(KVEngine* kv_engine, uint64_t num_workers)
+    : kv_engine_(kv_engine) {
+  for (uint64_t i = 0; i < num_workers; i++) {
+    workers_.emplace_back([this]() { this->work(); });
+  }
+}
+
+AsyncExecutor::~AsyncExecutor() {
+  {
+    std::lock_guard<std::mutex> lg(mu_);
+    closing_ = true;
+    cv_.notify_all();
+  }
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void AsyncExecutor::Schedule(AsyncQueueImpl* queue,
+                             std::vector<AsyncOp>&& ops) {
+  std::lock_guard<std::mutex> lg(mu_);
+  pending_batches_.push_back(PendingBatch{queue, std::move(ops)});
+  cv_.notify_one();
+}
+
+void AsyncExecutor::work() {
+  std::vector<PendingBatch> batches;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> ul(mu_);
+      while (pending_batches_.empty() && !closing_) {
+        cv_.wait(ul);
+      }
+      // Scheduled ops are all executed before exit
+      if (pending_batches_.empty()) {
+        return;
+      }
+      size_t num_ops = 0;
+      while (!pending_batches_.empty() && num_ops < kMaxBatchOps) {
+        num_ops += pending_batches_.front().ops.size();
+        batches.push_back(std::move(pending_batches_.front()));
+        pending_batches_.pop_front();
+      }
+    }
+
+    // Prefetch hash buckets of all fetched ops first, so their cache misses
+    // overlap with each other instead of stalling ops one by one
+    HashTable* hash_table = kv_engine_->GetHashTable();
+    for (auto& batch : batches) {
+      for (auto& op : batch.ops) {
+        switch (op.type) {
+          case AsyncOpType::StringGet:
+          case AsyncOpType::StringPut:
+          case AsyncOpType::StringDelete:
+            hash_table->Prefetch(op.key);
+            break;
+          default:
+            hash_table->Prefetch(op.collection);
+            break;
+        }
+      }
+    }
+
+    for (auto& batch : batches) {
+      std::vector<AsyncCompletion> completions(batch.ops.size());
+      for (size_t i = 0; i < batch.ops.size(); i++) {
+        execute(batch.ops[i], &completions[i]);
+      }
+      batch.queue->Complete(std::move(completions));
+    }
+    batches.clear();
+  }
+}
+
+void AsyncExecutor::execute(AsyncOp& op, AsyncCompletion* completion) {
+  Status s;
+  std::string* value = &completion->value;
+  switch (op.type) {
+    case AsyncOpType::StringGet:
+      s = kv_engine_->Get(op.key, value);
+      break;
+    case AsyncOpType::StringPut:
+      s = kv_engine_->Put(op.key, op.value, op.write_options);
+      break;
+    case AsyncOpType::StringDelete:
+      s = kv_engine_->Delete(op.key);
+      break;
+    case AsyncOpType::SortedGet:
+      s = kv_engine_->SortedGet(op.collection, op.key, value);
+      break;
+    case AsyncOpType::SortedPut:
+      s = kv_engine_->SortedPut(op.collection, op.key, op.value);
+      break;
+    case AsyncOpType::SortedDelete:
+      s = kv_engine_->SortedDelete(op.collection, op.key);
+      break;
+    case AsyncOpType::HashGet:
+      s = kv_engine_->HashGet(op.collection, op.key, value);
+      break;
+    case AsyncOpType::HashPut:
+      s = kv_engine_->HashPut(op.collection, op.key, op.value);
+      break;
+    case AsyncOpType::HashDelete:
+      s = kv_engine_->HashDelete(op.collection, op.key);
+      break;
+    case AsyncOpType::ListPushFront:
+      s = kv_engine_->ListPushFront(op.collection, op.value);
+      break;
+    case AsyncOpType::ListPushBack:
+      s = kv_engine_->ListPushBack(op.collection, op.value);
+      break;
+    case AsyncOpType::ListPopFront:
+      s = kv_engine_->ListPopFront(op.collection, value);
+      break;
+    case AsyncOpType::ListPopBack:
+      s = kv_engine_->ListPopBack(op.collection, value);
+      break;
+    default:
+      s = Status::InvalidArgument;
+      break;
+  }
+  completion->user_data = op.user_data;
+  completion->type = op.type;
+  completion->status = s;
+}
+
+AsyncQueueImpl::~AsyncQueueImpl() {
+  std::unique_lock<std::mutex> ul(mu_);
+  while (in_flight_ > 0) {
+    cv_.wait(ul);
+  }
+}
+
+Status AsyncQueueImpl::Submit(std::vector<AsyncOp>&& ops) {
+  if (ops.size() > queue_depth_) {
+    return Status::InvalidBatchSize;
+  }
+  if (ops.empty()) {
+    return Status::Ok;
+  }
+  {
+    std::lock_guard<std::mutex> lg(mu_);
+    if (in_flight_ + completions_.size() + ops.size() > queue_depth_) {
+      return Status::Abort;
+    }
+    in_flight_ += ops.size();
+  }
+  executor_->Schedule(this, std::move(ops));
+  return Status::Ok;
+}
+
+Status AsyncQueueImpl::Submit(AsyncOp&& op) {
+  std::vector<AsyncOp> ops;
+  ops.push_back(std::move(op));
+  Status s = Submit(std::move(ops));
+  if (s != Status::Ok) {
+    op = std::move(ops.front());
+  }
+  return s;
+}
+
+size_t AsyncQueueImpl::Poll(std::vector<AsyncCompletion>* completions,
+                            size_t max_completions, int64_t timeout_ms) {
+  std::unique_lock<std::mutex> ul(mu_);
+  if (timeout_ms > 0) {
+    cv_.wait_for(ul, std::chrono::milliseconds(timeout_ms),
+                 [&]() { return !completions_.empty(); });
+  }
+  size_t cnt = std::min(max_completions, completions_.size());
+  for (size_t i = 0; i < cnt; i++) {
+    completions->push_back(std::move(completions_.front()));
+    completions_.pop_front();
+  }
+  return cnt;
+}
+
+size_t AsyncQueueImpl::InFlight() {
+  std::lock_guard<std::mutex> lg(mu_);
+  return in_flight_;
+}
+
+void AsyncQueueImpl::Complete(std::vector<AsyncCompletion>&& completions) {
+  if (callback_) {
+    for (auto& completion : completions) {
+      callback_(std::move(completion));
+    }
+  }
+  // The queue may be destroyed as soon as in_flight_ reaches 0, so notify
+  // waiters before releasing the lock
+  std::lock_guard<std::mutex> lg(mu_);
+  if (!callback_) {
+    for (auto& completion : completions) {
+      completions_.push_back(std::move(completion));
+    }
+  }
+  in_flight_ -= completions.size();
+  cv_.notify_all();
+}
+
+}  // namespace KVDK_NAMESPACE
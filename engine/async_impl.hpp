@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "alias.hpp"
+#include "kvdk/async.hpp"
+#include "macros.hpp"
+
+namespace KVDK_NAMESPACE {
+
+class KVEngine;
+class AsyncQueueImpl;
+
+// Worker threads that execute async ops of all AsyncQueues of an instance
+class AsyncExecutor {
+ public:
+  // Max number of ops a worker fetches and executes at a time
+  static constexpr size_t kMaxBatchOps = 32;
+
+  AsyncExecutor(KVEngine* kv_engine, uint64_t num_workers);
+
+  // Wait all scheduled ops complete, then stop workers
+  ~AsyncExecutor();
+
+  AsyncExecutor(const AsyncExecutor&) = delete;
+
+  void Schedule(AsyncQueueImpl* queue, std::vector<AsyncOp>&& ops);
+
+ private:
+  struct PendingBatch {
+    AsyncQueueImpl* queue;
+    std::vector<AsyncOp> ops;
+  };
+
+  void work();
+
+  void execute(AsyncOp& op, AsyncCompletion* completion);
+
+  KVEngine* kv_engine_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<PendingBatch> pending_batches_;
+  bool closing_{false};
+  std::vector<std::thread> workers_;
+};
+
+class AsyncQueueImpl final : public AsyncQueue {
+ public:
+  AsyncQueueImpl(AsyncExecutor* executor, size_t queue_depth,
+                 AsyncCallback callback)
+      : executor_(executor),
+        queue_depth_(queue_depth),
+        callback_(std::move(callback)) {}
+
+  ~AsyncQueueImpl() final;
+
+  Status Submit(std::vector<AsyncOp>&& ops) final;
+  Status Submit(AsyncOp&& op) final;
+  size_t Poll(std::vector<AsyncCompletion>* completions,
+              size_t max_completions, int64_t timeout_ms) final;
+  size_t InFlight() final;
+
+  // Called by executor on completion of a batch of ops
+  void Complete(std::vector<AsyncCompletion>&& completions);
+
+ private:
+  AsyncExecutor* executor_;
+  const size_t queue_depth_;
+  AsyncCallback callback_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  // Submitted but not completed ops
+  size_t in_flight_{0};
+  // Completed but not polled ops
+  std::deque<AsyncCompletion> completions_;
+};
+
+}  // namespace KVDK_NAMESPACE
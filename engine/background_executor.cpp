@@ -0,0 +1,163 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include "background_executor.hpp"
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "logger.hpp"
+#include "utils/utils.hpp"
+
+namespace KVDK_NAMESPACE {
+
+BackgroundExecutor::BackgroundExecutor(uint64_t num_threads,
+                                       const std::vector<int>& cpus, int nice)
+    : cpus_(cpus), nice_(nice) {
+  for (uint64_t i = 0; i < num_threads; i++) {
+    threads_.emplace_back(&BackgroundExecutor::work, this);
+  }
+}
+
+BackgroundExecutor::TaskID BackgroundExecutor::AddTask(const std::string& name,
+                                                       double interval_seconds,
+                                                       double budget_seconds,
+                                                       TaskFunc func) {
+  std::lock_guard<std::mutex> lg(mu_);
+  TaskID id = next_id_++;
+  Task& task = tasks_[id];
+  task.name = name;
+  task.interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(interval_seconds));
+  task.budget_seconds = budget_seconds;
+  task.func = func;
+  task.next_run = Clock::now() + task.interval;
+  cv_.notify_one();
+  return id;
+}
+
+void BackgroundExecutor::Wake(TaskID id) {
+  std::lock_guard<std::mutex> lg(mu_);
+  auto iter = tasks_.find(id);
+  if (iter != tasks_.end()) {
+    iter->second.next_run = Clock::now();
+    cv_.notify_one();
+  }
+}
+
+void BackgroundExecutor::RemoveTask(TaskID id) {
+  std::unique_lock<std::mutex> ul(mu_);
+  auto iter = tasks_.find(id);
+  if (iter == tasks_.end()) {
+    return;
+  }
+  if (!iter->second.running) {
+    tasks_.erase(iter);
+    return;
+  }
+  // The executing thread erases the task after the run
+  iter->second.removed = true;
+  removed_cv_.wait(ul, [&]() { return tasks_.find(id) == tasks_.end(); });
+}
+
+void BackgroundExecutor::Close() {
+  {
+    std::lock_guard<std::mutex> lg(mu_);
+    closing_ = true;
+    cv_.notify_all();
+  }
+  for (auto& t : threads_) {
+    t.join();
+  }
+  threads_.clear();
+  std::lock_guard<std::mutex> lg(mu_);
+  tasks_.clear();
+}
+
+std::vector<BackgroundExecutor::TaskStats> BackgroundExecutor::GetStats() {
+  std::vector<TaskStats> stats;
+  std::lock_guard<std::mutex> lg(mu_);
+  for (auto& t : tasks_) {
+    const Task& task = t.second;
+    stats.push_back(
+        TaskStats{task.name, task.runs, task.overruns, task.busy_seconds});
+  }
+  return stats;
+}
+
+std::map<BackgroundExecutor::TaskID, BackgroundExecutor::Task>::iterator
+BackgroundExecutor::pickTask(Clock::time_point* wake_up) {
+  auto picked = tasks_.end();
+  for (auto iter = tasks_.begin(); iter != tasks_.end(); iter++) {
+    if (iter->second.running || iter->second.removed) {
+      continue;
+    }
+    if (picked == tasks_.end() ||
+        iter->second.next_run < picked->second.next_run) {
+      picked = iter;
+    }
+  }
+  if (picked == tasks_.end()) {
+    *wake_up = Clock::time_point::max();
+    return tasks_.end();
+  }
+  if (picked->second.next_run > Clock::now()) {
+    *wake_up = picked->second.next_run;
+    return tasks_.end();
+  }
+  return picked;
+}
+
+void BackgroundExecutor::work() {
+  if (!cpus_.empty() && bind_thread_to_pus(cpus_) != 0) {
+    GlobalLogger.Error("Bind background thread to cpus failed\n");
+  }
+  if (nice_ != 0 &&
+      setpriority(PRIO_PROCESS, syscall(SYS_gettid), nice_) != 0) {
+    GlobalLogger.Error("Set nice %d of background thread failed\n", nice_);
+  }
+
+  std::unique_lock<std::mutex> ul(mu_);
+  while (!closing_) {
+    Clock::time_point wake_up;
+    auto iter = pickTask(&wake_up);
+    if (iter == tasks_.end()) {
+      if (wake_up == Clock::time_point::max()) {
+        cv_.wait(ul);
+      } else {
+        cv_.wait_until(ul, wake_up);
+      }
+      continue;
+    }
+
+    // Iterators of std::map keep valid while other tasks are added or
+    // removed, and a running task is erased only by this thread
+    Task& task = iter->second;
+    task.running = true;
+    ul.unlock();
+    auto start = Clock::now();
+    bool more_work = task.func(TaskBudget(task.budget_seconds));
+    auto end = Clock::now();
+    ul.lock();
+
+    double elapsed = std::chrono::duration<double>(end - start).count();
+    task.running = false;
+    task.runs++;
+    task.busy_seconds += elapsed;
+    if (elapsed > task.budget_seconds) {
+      task.overruns++;
+    }
+    if (task.removed) {
+      tasks_.erase(iter);
+      removed_cv_.notify_all();
+      continue;
+    }
+    // A task with more work is queued behind other due tasks, otherwise it
+    // runs at a fixed rate
+    task.next_run = more_work ? end : start + task.interval;
+  }
+}
+
+}  // namespace KVDK_NAMESPACE
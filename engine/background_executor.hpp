@@ -0,0 +1,116 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "alias.hpp"
+
+namespace KVDK_NAMESPACE {
+
+// Time budget of a run of a background task
+class TaskBudget {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit TaskBudget(double seconds)
+      : deadline_(Clock::now() +
+                  std::chrono::duration_cast<Clock::duration>(
+                      std::chrono::duration<double>(seconds))) {}
+
+  bool Exhausted() const { return Clock::now() >= deadline_; }
+
+ private:
+  Clock::time_point deadline_;
+};
+
+// A fixed set of threads that run all background tasks of an instance.
+//
+// A task runs every "interval" seconds and should return within its time
+// budget. If it returns true, it has more work to do and is rescheduled right
+// after other due tasks, so long works are split into budgeted runs and
+// tasks share threads fairly. A task never runs concurrently with itself.
+class BackgroundExecutor {
+ public:
+  using TaskID = uint64_t;
+  // Return true if the task has more work to do right now
+  using TaskFunc = std::function<bool(const TaskBudget& budget)>;
+
+  struct TaskStats {
+    std::string name;
+    uint64_t runs;
+    // Runs that exceeded the budget
+    uint64_t overruns;
+    double busy_seconds;
+  };
+
+  // Args:
+  // * cpus: CPUs that executor threads are bound to, empty for no binding
+  // * nice: nice value of executor threads, 0 to keep the default priority
+  BackgroundExecutor(uint64_t num_threads, const std::vector<int>& cpus,
+                     int nice);
+
+  BackgroundExecutor(const BackgroundExecutor&) = delete;
+
+  ~BackgroundExecutor() { Close(); }
+
+  // Add a task, it first runs after "interval_seconds"
+  TaskID AddTask(const std::string& name, double interval_seconds,
+                 double budget_seconds, TaskFunc func);
+
+  // Run a task as soon as possible
+  void Wake(TaskID id);
+
+  // Remove a task, wait until its current run finishes
+  //
+  // Notice: do not call it inside a task to remove itself
+  void RemoveTask(TaskID id);
+
+  // Remove all tasks and stop threads
+  void Close();
+
+  std::vector<TaskStats> GetStats();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Task {
+    std::string name;
+    Clock::duration interval;
+    double budget_seconds;
+    TaskFunc func;
+    Clock::time_point next_run;
+    bool running = false;
+    bool removed = false;
+    uint64_t runs = 0;
+    uint64_t overruns = 0;
+    double busy_seconds = 0;
+  };
+
+  void work();
+
+  // Pick the earliest due task, or return end() and set "wake_up" to time of
+  // the next due task
+  std::map<TaskID, Task>::iterator pickTask(Clock::time_point* wake_up);
+
+  std::vector<int> cpus_;
+  int nice_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::condition_variable removed_cv_;
+  std::map<TaskID, Task> tasks_;
+  TaskID next_id_{0};
+  bool closing_{false};
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace KVDK_NAMESPACE
@@ -0,0 +1,105 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include "kvdk_c.hpp"
+
+using kvdk::AsyncCallback;
+using kvdk::AsyncCompletion;
+using kvdk::AsyncOpType;
+
+// Only get and pop ops return a value
+static bool ReturnsValue(AsyncOpType type) {
+  switch (type) {
+    case AsyncOpType::StringGet:
+    case AsyncOpType::SortedGet:
+    case AsyncOpType::HashGet:
+    case AsyncOpType::ListPopFront:
+    case AsyncOpType::ListPopBack:
+      return true;
+    default:
+      return false;
+  }
+}
+
+extern "C" {
+KVDKAsyncQueue* KVDKAsyncQueueCreate(KVDKEngine* engine, size_t queue_depth,
+                                     KVDKAsyncCallback cb, void* cb_args) {
+  AsyncCallback callback;
+  if (cb != nullptr) {
+    callback = [cb, cb_args](AsyncCompletion&& completion) {
+      KVDKAsyncCompletion c;
+      c.user_data = completion.user_data;
+      c.op_type = static_cast<int>(completion.type);
+      c.status = completion.status;
+      bool has_value = ReturnsValue(completion.type);
+      c.val = has_value ? &completion.value[0] : nullptr;
+      c.val_len = has_value ? completion.value.size() : 0;
+      cb(&c, cb_args);
+    };
+  }
+  std::unique_ptr<AsyncQueue> rep =
+      engine->rep->AsyncQueueCreate(queue_depth, callback);
+  if (rep == nullptr) {
+    return nullptr;
+  }
+  KVDKAsyncQueue* queue = new KVDKAsyncQueue{};
+  queue->rep = std::move(rep);
+  return queue;
+}
+
+void KVDKAsyncQueueDestroy(KVDKAsyncQueue* queue) { delete queue; }
+
+void KVDKAsyncQueueAdd(KVDKAsyncQueue* queue, int op_type,
+                       char const* collection, size_t collection_len,
+                       char const* key, size_t key_len, char const* val,
+                       size_t val_len, uint64_t user_data) {
+  AsyncOp op;
+  op.type = static_cast<AsyncOpType>(op_type);
+  op.collection.assign(collection, collection_len);
+  op.key.assign(key, key_len);
+  op.value.assign(val, val_len);
+  op.user_data = user_data;
+  queue->batch.push_back(std::move(op));
+}
+
+KVDKStatus KVDKAsyncQueueSubmit(KVDKAsyncQueue* queue) {
+  // The batch is left untouched if it's not submitted
+  KVDKStatus s = queue->rep->Submit(std::move(queue->batch));
+  if (s == KVDKStatus::Ok) {
+    queue->batch.clear();
+  }
+  return s;
+}
+
+size_t KVDKAsyncQueueDiscard(KVDKAsyncQueue* queue) {
+  size_t discarded = queue->batch.size();
+  queue->batch.clear();
+  return discarded;
+}
+
+size_t KVDKAsyncQueuePoll(KVDKAsyncQueue* queue,
+                          KVDKAsyncCompletion* completions,
+                          size_t max_completions, int64_t timeout_ms) {
+  std::vector<AsyncCompletion> fetched;
+  size_t cnt = queue->rep->Poll(&fetched, max_completions, timeout_ms);
+  for (size_t i = 0; i < cnt; i++) {
+    completions[i].user_data = fetched[i].user_data;
+    completions[i].op_type = static_cast<int>(fetched[i].type);
+    completions[i].status = fetched[i].status;
+    if (ReturnsValue(fetched[i].type)) {
+      completions[i].val = CopyStringToChar(fetched[i].value);
+      completions[i].val_len = fetched[i].value.size();
+    } else {
+      completions[i].val = nullptr;
+      completions[i].val_len = 0;
+    }
+  }
+  return cnt;
+}
+
+size_t KVDKAsyncQueueInFlight(KVDKAsyncQueue* queue) {
+  return queue->rep->InFlight();
+}
+
+}  // extern "C"
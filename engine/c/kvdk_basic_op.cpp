@@ -63,6 +63,11 @@ void KVDKWriteOptionsSetUpdateTTL(KVDKWriteOptions* kv_options,
   kv_options->rep.update_ttl = update_ttl;
 }
 
+void KVDKWriteOptionsSetCompression(KVDKWriteOptions* kv_options,
+                                    int compression) {
+  kv_options->rep.compression = static_cast<kvdk::CompressionType>(compression);
+}
+
 KVDKStatus KVDKOpen(const char* name, const KVDKConfigs* config, FILE* log_file,
                     KVDKEngine** kv_engine) {
   Engine* engine;
@@ -107,6 +112,67 @@ void KVDKReleaseSnapshot(KVDKEngine* engine, KVDKSnapshot* snapshot) {
   delete snapshot;
 }
 
+KVDKStatus KVDKFlush(KVDKEngine* engine) { return engine->rep->Flush(); }
+
+void KVDKGetStatistics(KVDKEngine* engine, KVDKStatistics* stats) {
+  kvdk::Statistics rep = engine->rep->GetStatistics();
+  stats->enabled = rep.enabled;
+  for (int op = 0; op < KVDKStatOpNum; op++) {
+    stats->ops[op].count = rep.ops[op].count;
+    stats->ops[op].avg_ns = rep.ops[op].avg_ns;
+    stats->ops[op].p50_ns = rep.ops[op].p50_ns;
+    stats->ops[op].p99_ns = rep.ops[op].p99_ns;
+    stats->ops[op].p999_ns = rep.ops[op].p999_ns;
+    stats->ops[op].max_ns = rep.ops[op].max_ns;
+  }
+  stats->pmem_capacity_bytes = rep.pmem_capacity_bytes;
+  stats->pmem_usage_bytes = rep.pmem_usage_bytes;
+  stats->pmem_segment_bytes = rep.pmem_segment_bytes;
+  stats->cleaner_workers = rep.cleaner_workers;
+  stats->cleaner_scanned_slots = rep.cleaner_scanned_slots;
+  stats->cleaner_purged_records = rep.cleaner_purged_records;
+  stats->cleaner_destroyed_collections = rep.cleaner_destroyed_collections;
+  stats->hash_buckets = rep.hash_buckets;
+  stats->hash_load_factor = rep.hash_load_factor;
+  stats->hash_avg_chain_length = rep.hash_avg_chain_length;
+  stats->hash_max_chain_length = rep.hash_max_chain_length;
+  stats->recovery.finished = rep.recovery.finished;
+  stats->recovery.segments_restored = rep.recovery.segments_restored;
+  stats->recovery.restored_segments = rep.recovery.restored_segments;
+  stats->recovery.restored_records = rep.recovery.restored_records;
+  stats->recovery.total_segments = rep.recovery.total_segments;
+  stats->recovery.elapsed_seconds = rep.recovery.elapsed_seconds;
+  stats->recovery.segments_per_second = rep.recovery.segments_per_second;
+  stats->recovery.records_per_second = rep.recovery.records_per_second;
+  stats->recovery.eta_seconds = rep.recovery.eta_seconds;
+}
+
+void KVDKEnableStatistics(KVDKEngine* engine, int enable) {
+  engine->rep->EnableStatistics(enable);
+}
+
+void KVDKSetTraceSampleInterval(KVDKEngine* engine, uint64_t interval) {
+  engine->rep->SetTraceSampleInterval(interval);
+}
+
+KVDKStatus KVDKDumpTrace(KVDKEngine* engine, const char* path) {
+  return engine->rep->DumpTrace(std::string(path));
+}
+
+void KVDKGetHotKeys(KVDKEngine* engine, uint32_t k, int writes,
+                    KVDKHotKeyFunc func, void* args) {
+  kvdk::HotKeys hot_keys = engine->rep->GetHotKeys(k);
+  for (auto& hot_key : writes ? hot_keys.writes : hot_keys.reads) {
+    func(hot_key.key.data(), hot_key.key.size(), hot_key.count, args);
+  }
+}
+
+void KVDKSetHotKeySampleInterval(KVDKEngine* engine, uint64_t interval) {
+  engine->rep->SetHotKeySampleInterval(interval);
+}
+
+void KVDKResetHotKeys(KVDKEngine* engine) { engine->rep->ResetHotKeys(); }
+
 void KVDKCloseEngine(KVDKEngine* engine) { delete engine; }
 
 void KVDKRemovePMemContents(const char* name) {
@@ -8,6 +8,7 @@
 #include <regex>
 
 #include "../alias.hpp"
+#include "kvdk/async.hpp"
 #include "kvdk/configs.hpp"
 #include "kvdk/engine.h"
 #include "kvdk/engine.hpp"
@@ -17,6 +18,8 @@
 
 using kvdk::StringView;
 
+using kvdk::AsyncOp;
+using kvdk::AsyncQueue;
 using kvdk::Configs;
 using kvdk::Engine;
 using kvdk::HashIterator;
@@ -74,6 +77,12 @@ struct KVDKRegex {
   std::regex rep;
 };
 
+struct KVDKAsyncQueue {
+  std::unique_ptr<AsyncQueue> rep;
+  // Ops added by KVDKAsyncQueueAdd and not submitted yet
+  std::vector<AsyncOp> batch;
+};
+
 inline char* CopyStringToChar(const std::string& str) {
   char* result = static_cast<char*>(malloc(str.size()));
   memcpy(result, str.data(), str.size());
@@ -0,0 +1,46 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include "kvdk_c.hpp"
+
+extern "C" {
+KVDKStatus KVDKSetCreate(KVDKEngine* engine, char const* key_data,
+                         size_t key_len) {
+  return engine->rep->SetCreate(StringView{key_data, key_len});
+}
+
+KVDKStatus KVDKSetDestroy(KVDKEngine* engine, char const* key_data,
+                          size_t key_len) {
+  return engine->rep->SetDestroy(StringView{key_data, key_len});
+}
+
+KVDKStatus KVDKSetCard(KVDKEngine* engine, char const* key_data,
+                       size_t key_len, size_t* card) {
+  return engine->rep->SetCard(StringView{key_data, key_len}, card);
+}
+
+KVDKStatus KVDKSetAdd(KVDKEngine* engine, char const* key_data,
+                      size_t key_len, char const* member_data,
+                      size_t member_len) {
+  return engine->rep->SetAdd(StringView{key_data, key_len},
+                             StringView{member_data, member_len});
+}
+
+KVDKStatus KVDKSetRemove(KVDKEngine* engine, char const* key_data,
+                         size_t key_len, char const* member_data,
+                         size_t member_len) {
+  return engine->rep->SetRemove(StringView{key_data, key_len},
+                                StringView{member_data, member_len});
+}
+
+KVDKStatus KVDKSetIsMember(KVDKEngine* engine, char const* key_data,
+                           size_t key_len, char const* member_data,
+                           size_t member_len, int* is_member) {
+  bool ret = false;
+  KVDKStatus s = engine->rep->SetIsMember(
+      StringView{key_data, key_len}, StringView{member_data, member_len}, &ret);
+  *is_member = ret ? 1 : 0;
+  return s;
+}
+}
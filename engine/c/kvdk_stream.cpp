@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include "kvdk_c.hpp"
+
+extern "C" {
+KVDKStatus KVDKStreamCreate(KVDKEngine* engine, char const* key_data,
+                            size_t key_len) {
+  return engine->rep->StreamCreate(StringView{key_data, key_len});
+}
+
+KVDKStatus KVDKStreamDestroy(KVDKEngine* engine, char const* key_data,
+                             size_t key_len) {
+  return engine->rep->StreamDestroy(StringView{key_data, key_len});
+}
+
+KVDKStatus KVDKXAdd(KVDKEngine* engine, char const* key_data, size_t key_len,
+                    char const* entry_data, size_t entry_len, uint64_t* id) {
+  return engine->rep->XAdd(StringView{key_data, key_len},
+                           StringView{entry_data, entry_len}, id);
+}
+
+KVDKStatus KVDKXLen(KVDKEngine* engine, char const* key_data, size_t key_len,
+                    size_t* len) {
+  return engine->rep->XLen(StringView{key_data, key_len}, len);
+}
+
+KVDKStatus KVDKXTrim(KVDKEngine* engine, char const* key_data, size_t key_len,
+                     uint64_t min_id, size_t* trimmed) {
+  return engine->rep->XTrim(StringView{key_data, key_len}, min_id, trimmed);
+}
+}
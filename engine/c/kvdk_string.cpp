@@ -19,6 +19,16 @@ KVDKStatus KVDKGet(KVDKEngine* engine, const char* key, size_t key_len,
   return s;
 }
 
+KVDKStatus KVDKGetChunks(KVDKEngine* engine, const char* key, size_t key_len,
+                         KVDKValueChunkFunc chunk_func, void* chunk_args) {
+  return engine->rep->GetChunks(
+      StringView(key, key_len),
+      [&](const StringView& chunk, void* args) {
+        return chunk_func(chunk.data(), chunk.size(), args) != 0;
+      },
+      chunk_args);
+}
+
 KVDKStatus KVDKPut(KVDKEngine* engine, const char* key, size_t key_len,
                    const char* val, size_t val_len,
                    const KVDKWriteOptions* write_option) {
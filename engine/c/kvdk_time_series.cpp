@@ -0,0 +1,23 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include "kvdk_c.hpp"
+
+extern "C" {
+KVDKStatus KVDKTSCreate(KVDKEngine* engine, char const* key_data,
+                        size_t key_len, int64_t bucket_width) {
+  return engine->rep->TSCreate(StringView{key_data, key_len}, bucket_width);
+}
+
+KVDKStatus KVDKTSDestroy(KVDKEngine* engine, char const* key_data,
+                         size_t key_len) {
+  return engine->rep->TSDestroy(StringView{key_data, key_len});
+}
+
+KVDKStatus KVDKTSAppend(KVDKEngine* engine, char const* key_data,
+                        size_t key_len, int64_t timestamp, double value) {
+  return engine->rep->TSAppend(StringView{key_data, key_len}, timestamp,
+                               value);
+}
+}
@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include "kvdk_c.hpp"
+
+extern "C" {
+KVDKStatus KVDKZSetCreate(KVDKEngine* engine, char const* key_data,
+                          size_t key_len) {
+  return engine->rep->ZSetCreate(StringView{key_data, key_len});
+}
+
+KVDKStatus KVDKZSetDestroy(KVDKEngine* engine, char const* key_data,
+                           size_t key_len) {
+  return engine->rep->ZSetDestroy(StringView{key_data, key_len});
+}
+
+KVDKStatus KVDKZCard(KVDKEngine* engine, char const* key_data, size_t key_len,
+                     size_t* card) {
+  return engine->rep->ZCard(StringView{key_data, key_len}, card);
+}
+
+KVDKStatus KVDKZAdd(KVDKEngine* engine, char const* key_data, size_t key_len,
+                    char const* member_data, size_t member_len, double score) {
+  return engine->rep->ZAdd(StringView{key_data, key_len},
+                           StringView{member_data, member_len}, score);
+}
+
+KVDKStatus KVDKZIncrBy(KVDKEngine* engine, char const* key_data,
+                       size_t key_len, char const* member_data,
+                       size_t member_len, double increment,
+                       double* new_score) {
+  return engine->rep->ZIncrBy(StringView{key_data, key_len},
+                              StringView{member_data, member_len}, increment,
+                              new_score);
+}
+
+KVDKStatus KVDKZRem(KVDKEngine* engine, char const* key_data, size_t key_len,
+                    char const* member_data, size_t member_len) {
+  return engine->rep->ZRem(StringView{key_data, key_len},
+                           StringView{member_data, member_len});
+}
+
+KVDKStatus KVDKZScore(KVDKEngine* engine, char const* key_data,
+                      size_t key_len, char const* member_data,
+                      size_t member_len, double* score) {
+  return engine->rep->ZScore(StringView{key_data, key_len},
+                             StringView{member_data, member_len}, score);
+}
+
+KVDKStatus KVDKZRank(KVDKEngine* engine, char const* key_data, size_t key_len,
+                     char const* member_data, size_t member_len,
+                     size_t* rank) {
+  return engine->rep->ZRank(StringView{key_data, key_len},
+                            StringView{member_data, member_len}, rank);
+}
+}
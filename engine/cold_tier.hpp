@@ -0,0 +1,266 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#pragma once
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+
+#include "alias.hpp"
+#include "data_record.hpp"
+#include "kvdk/types.hpp"
+#include "logger.hpp"
+#include "utils/utils.hpp"
+
+namespace KVDK_NAMESPACE {
+
+// An append-only file on a block device (e.g. a SSD) that cold string values
+// are demoted to from PMem, see Configs::cold_tier_path.
+//
+// Format:
+// entry 1 | entry 2 | ... | entry n
+//
+// An entry is a Header followed by the key and the value, and referenced by a
+// ColdRef stored as value of its record on PMem, so it's recovered with the
+// record. Entries are made durable by Sync() before they are referenced, and
+// a torn entry at the end after a crash is never referenced. Space of entries
+// of overwritten or deleted keys is not reclaimed, instead the file is capped
+// and an entry is reused if its value is demoted again unchanged, see
+// ColdCopy.
+class ColdTier {
+ public:
+  ~ColdTier() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  ColdTier(const ColdTier&) = delete;
+  ColdTier& operator=(const ColdTier&) = delete;
+
+  // Open or create the cold tier file "path" of at most "max_size" bytes,
+  // return nullptr on failure
+  static ColdTier* Open(const std::string& path, uint64_t max_size) {
+    int fd = open(path.c_str(), O_CREAT | O_RDWR, 0666);
+    if (fd < 0) {
+      GlobalLogger.Error("Open cold tier file %s error: %s\n", path.c_str(),
+                         strerror(errno));
+      return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      GlobalLogger.Error("Stat cold tier file %s error: %s\n", path.c_str(),
+                         strerror(errno));
+      close(fd);
+      return nullptr;
+    }
+    return new ColdTier(path, fd, st.st_size, max_size);
+  }
+
+  // Append "key" and "value" to the file and store reference of the value in
+  // "ref". The entry is not durable until Sync(). Return Status::OutOfRange if
+  // the file is full
+  Status Append(const StringView& key, const StringView& value, ColdRef* ref) {
+    std::string entry = encode(key, value);
+    uint64_t offset = tail_.load();
+    do {
+      if (offset + entry.size() > max_size_) {
+        return Status::OutOfRange;
+      }
+    } while (!tail_.compare_exchange_weak(offset, offset + entry.size()));
+    if (!pwriteAll(entry.data(), entry.size(), offset)) {
+      GlobalLogger.Error("Write cold tier file %s error: %s\n", path_.c_str(),
+                         strerror(errno));
+      return Status::IOError;
+    }
+    ref->offset = offset;
+    ref->size = value.size();
+    return Status::Ok;
+  }
+
+  // Make appended entries durable
+  Status Sync() {
+    if (fdatasync(fd_) != 0) {
+      GlobalLogger.Error("Sync cold tier file %s error: %s\n", path_.c_str(),
+                         strerror(errno));
+      return Status::IOError;
+    }
+    return Status::Ok;
+  }
+
+  // Read the value of "key" referenced by "ref" to "value"
+  Status Read(const ColdRef& ref, const StringView& key, std::string* value) {
+    std::string entry(sizeof(Header) + key.size() + ref.size, 0);
+    if (!preadAll(&entry[0], entry.size(), ref.offset)) {
+      GlobalLogger.Error("Read cold tier file %s error: %s\n", path_.c_str(),
+                         strerror(errno));
+      return Status::IOError;
+    }
+    Header header;
+    memcpy(&header, entry.data(), sizeof(Header));
+    StringView stored_key(entry.data() + sizeof(Header), key.size());
+    StringView stored_value(stored_key.data() + key.size(), ref.size);
+    if (header.key_size != key.size() || header.value_size != ref.size ||
+        stored_key.compare(key) != 0 ||
+        header.checksum != checksum(entry)) {
+      GlobalLogger.Error("Corrupted cold value of key %s at %lu of %s\n",
+                         string_view_2_string(key).c_str(), ref.offset,
+                         path_.c_str());
+      return Status::Abort;
+    }
+    value->assign(stored_value.data(), stored_value.size());
+    return Status::Ok;
+  }
+
+  // Check if "ref" refers to an entry of "key" and "value", so a record of
+  // them can refer to it rather than a new one
+  bool Holds(const ColdRef& ref, const StringView& key,
+             const StringView& value) {
+    std::string entry = encode(key, value);
+    if (ref.size != value.size() || ref.offset > tail_.load() ||
+        tail_.load() - ref.offset < entry.size()) {
+      return false;
+    }
+    Header header;
+    return preadAll(reinterpret_cast<char*>(&header), sizeof(Header),
+                    ref.offset) &&
+           memcmp(&header, entry.data(), sizeof(Header)) == 0;
+  }
+
+  // Bytes appended to the file
+  uint64_t Size() const { return tail_.load(); }
+
+ private:
+  struct Header {
+    uint32_t checksum;
+    uint32_t key_size;
+    uint64_t value_size;
+  };
+
+  ColdTier(const std::string& path, int fd, uint64_t size, uint64_t max_size)
+      : path_(path), fd_(fd), max_size_(max_size), tail_(size) {}
+
+  // Checksum of key and value of "entry"
+  static uint32_t checksum(const std::string& entry) {
+    return get_checksum(entry.data() + sizeof(Header),
+                        entry.size() - sizeof(Header));
+  }
+
+  // Encode an entry of "key" and "value"
+  static std::string encode(const StringView& key, const StringView& value) {
+    Header header;
+    header.checksum = 0;
+    header.key_size = key.size();
+    header.value_size = value.size();
+    std::string entry;
+    entry.reserve(sizeof(Header) + key.size() + value.size());
+    entry.append(reinterpret_cast<const char*>(&header), sizeof(Header));
+    entry.append(key.data(), key.size());
+    entry.append(value.data(), value.size());
+    header.checksum = checksum(entry);
+    memcpy(&entry[0], &header, sizeof(Header));
+    return entry;
+  }
+
+  bool pwriteAll(const char* data, uint64_t size, uint64_t offset) {
+    while (size > 0) {
+      ssize_t n = pwrite(fd_, data, size, offset);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        return false;
+      }
+      data += n;
+      size -= n;
+      offset += n;
+    }
+    return true;
+  }
+
+  bool preadAll(char* data, uint64_t size, uint64_t offset) {
+    while (size > 0) {
+      ssize_t n = pread(fd_, data, size, offset);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        return false;
+      }
+      data += n;
+      size -= n;
+      offset += n;
+    }
+    return true;
+  }
+
+  std::string path_;
+  int fd_;
+  uint64_t max_size_;
+  std::atomic<uint64_t> tail_;
+};
+
+// Reference to the cold tier entry of a value promoted back to PMem, which is
+// kept in the padding after the value of the promoted record, so the value
+// reuses the entry if it's demoted again unchanged.
+//
+// The padding is not checksummed with the record and may be left by a former
+// record, so the reference is only a hint, which should be checked by
+// ColdTier::Holds() before it's reused
+struct ColdCopy {
+  uint64_t magic;
+  ColdRef ref;
+  uint64_t checksum;
+
+  // Space to allocate for a record of "key" and "value" with a ColdCopy
+  static uint32_t RecordSize(const StringView& key, const StringView& value) {
+    return StringRecord::RecordSize(key, value) + sizeof(ColdCopy);
+  }
+
+  // Persist "ref" to the padding of "record", which should be allocated with
+  // RecordSize(), before the record is persisted
+  static void Persist(const PersistPolicy& policy, StringRecord* record,
+                      const StringView& key, const StringView& value,
+                      const ColdRef& ref) {
+    ColdCopy copy;
+    copy.magic = kMagic;
+    copy.ref = ref;
+    copy.checksum = copy.Checksum();
+    char* dst =
+        reinterpret_cast<char*>(record) + StringRecord::RecordSize(key, value);
+    memcpy(dst, &copy, sizeof(ColdCopy));
+    policy.Persist(dst, sizeof(ColdCopy));
+  }
+
+  // Read the hint in the padding of "record" to "ref", return false if there
+  // is not one
+  static bool Read(const StringRecord* record, ColdRef* ref) {
+    uint64_t size = StringRecord::RecordSize(record->Key(), record->Value());
+    if (record->entry.header.record_size < size + sizeof(ColdCopy)) {
+      return false;
+    }
+    ColdCopy copy;
+    memcpy(&copy, reinterpret_cast<const char*>(record) + size,
+           sizeof(ColdCopy));
+    if (copy.magic != kMagic || copy.checksum != copy.Checksum()) {
+      return false;
+    }
+    *ref = copy.ref;
+    return true;
+  }
+
+ private:
+  static constexpr uint64_t kMagic = 0x59504f43444c4f43;  // "COLDCOPY"
+
+  uint64_t Checksum() const {
+    return get_checksum(&ref, sizeof(ColdRef)) ^ kMagic;
+  }
+};
+
+}  // namespace KVDK_NAMESPACE
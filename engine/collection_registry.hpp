@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "alias.hpp"
+#include "utils/utils.hpp"
+
+namespace KVDK_NAMESPACE {
+
+// Concurrent registry of collections of a type, indexed by collection id.
+//
+// Collections are sharded by id into cache line aligned shards, each guarded
+// by its own spin lock, so lookups of different collections from many
+// threads do not serialize on a global mutex. As collection ids are assigned
+// sequentially, collections spread evenly over shards. Get() never inserts
+// on a miss.
+template <typename CollectionType>
+class CollectionRegistry {
+ public:
+  using MapType =
+      std::unordered_map<CollectionIDType, std::shared_ptr<CollectionType>>;
+
+  // Return nullptr if collection "id" is not registered
+  std::shared_ptr<CollectionType> Get(CollectionIDType id) {
+    Shard& shard = shardOf(id);
+    std::lock_guard<SpinMutex> lg(shard.spin);
+    auto iter = shard.collections.find(id);
+    return iter == shard.collections.end() ? nullptr : iter->second;
+  }
+
+  bool Contains(CollectionIDType id) {
+    Shard& shard = shardOf(id);
+    std::lock_guard<SpinMutex> lg(shard.spin);
+    return shard.collections.count(id) != 0;
+  }
+
+  void Add(std::shared_ptr<CollectionType> collection) {
+    CollectionIDType id = collection->ID();
+    Shard& shard = shardOf(id);
+    std::lock_guard<SpinMutex> lg(shard.spin);
+    shard.collections.emplace(id, std::move(collection));
+  }
+
+  void Remove(CollectionIDType id) {
+    // Destroy the collection outside the lock if this is the last reference
+    std::shared_ptr<CollectionType> removed;
+    Shard& shard = shardOf(id);
+    std::lock_guard<SpinMutex> lg(shard.spin);
+    auto iter = shard.collections.find(id);
+    if (iter != shard.collections.end()) {
+      removed.swap(iter->second);
+      shard.collections.erase(iter);
+    }
+  }
+
+  // Replace all registered collections, e.g. by rebuilt ones in recovery
+  void Reset(MapType&& collections) {
+    MapType sharded[kNumShards];
+    for (auto& c : collections) {
+      sharded[c.first & (kNumShards - 1)].emplace(c.first,
+                                                  std::move(c.second));
+    }
+    collections.clear();
+    for (size_t i = 0; i < kNumShards; i++) {
+      std::lock_guard<SpinMutex> lg(shards_[i].spin);
+      shards_[i].collections.swap(sharded[i]);
+    }
+  }
+
+  // Call "f" on each registered collection. A shard is locked while visiting
+  // its collections, so "f" should not access the registry
+  template <typename F>
+  void ForEach(F&& f) {
+    for (size_t i = 0; i < kNumShards; i++) {
+      std::lock_guard<SpinMutex> lg(shards_[i].spin);
+      for (auto& c : shards_[i].collections) {
+        f(c.second);
+      }
+    }
+  }
+
+  // Copy of all registered collections
+  MapType Snapshot() {
+    MapType ret;
+    ForEach([&](const std::shared_ptr<CollectionType>& c) {
+      ret.emplace(c->ID(), c);
+    });
+    return ret;
+  }
+
+ private:
+  static constexpr size_t kNumShards = 64;
+
+  struct alignas(64) Shard {
+    SpinMutex spin;
+    MapType collections;
+  };
+
+  Shard& shardOf(CollectionIDType id) {
+    return shards_[id & (kNumShards - 1)];
+  }
+
+  // Allocated aligned on heap, as the registry is a member of the engine
+  // which is not allocated aligned by new in C++11
+  Array<Shard> shards_{kNumShards};
+};
+
+}  // namespace KVDK_NAMESPACE
@@ -0,0 +1,139 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include "lookup_coro.hpp"
+
+#include "../kv_engine.hpp"
+
+namespace KVDK_NAMESPACE {
+
+void InterleavedScheduler::Run() {
+  std::vector<LookupTask> running;
+  running.reserve(max_in_flight_);
+  while (!pending_.empty() && running.size() < max_in_flight_) {
+    running.push_back(std::move(pending_.front()));
+    pending_.pop_front();
+  }
+
+  while (!running.empty()) {
+    for (size_t i = 0; i < running.size();) {
+      running[i].Resume();
+      if (!running[i].Done()) {
+        i++;
+        continue;
+      }
+      // Start a pending task in the slot of the finished one
+      if (!pending_.empty()) {
+        running[i] = std::move(pending_.front());
+        pending_.pop_front();
+        i++;
+      } else {
+        running[i] = std::move(running.back());
+        running.pop_back();
+      }
+    }
+  }
+}
+
+InterleavedLookup::InterleavedLookup(Engine* engine, size_t max_in_flight)
+    : kv_engine_(static_cast<KVEngine*>(engine)),
+      scheduler_(max_in_flight) {}
+
+void InterleavedLookup::Get(StringView key, std::string* value, Status* s) {
+  scheduler_.Add(getTask(key, value, s));
+}
+
+void InterleavedLookup::HashGet(StringView collection, StringView key,
+                                std::string* value, Status* s) {
+  scheduler_.Add(hashGetTask(collection, key, value, s));
+}
+
+void InterleavedLookup::SortedGet(StringView collection, StringView key,
+                                  std::string* value, Status* s) {
+  scheduler_.Add(sortedGetTask(collection, key, value, s));
+}
+
+void InterleavedLookup::Run() {
+  // Prefetch stages read collections without access thread, so hold a
+  // snapshot to prevent them from being freed
+  Snapshot* snapshot = kv_engine_->GetSnapshot(false);
+  scheduler_.Run();
+  kv_engine_->ReleaseSnapshot(snapshot);
+}
+
+LookupTask InterleavedLookup::getTask(StringView key, std::string* value,
+                                      Status* s) {
+  HashTable* hash_table = kv_engine_->GetHashTable();
+  hash_table->Prefetch(key);
+  co_await PrefetchSuspend{};
+  hash_table->PrefetchIndex(key, RecordType::String);
+  co_await PrefetchSuspend{};
+  *s = kv_engine_->Get(key, value);
+}
+
+LookupTask InterleavedLookup::hashGetTask(StringView collection,
+                                          StringView key, std::string* value,
+                                          Status* s) {
+  HashTable* hash_table = kv_engine_->GetHashTable();
+  hash_table->Prefetch(collection);
+  co_await PrefetchSuspend{};
+  hash_table->PrefetchIndex(collection, RecordType::HashRecord);
+  co_await PrefetchSuspend{};
+  auto ret = hash_table->Lookup<false>(collection, RecordType::HashRecord);
+  if (ret.s == Status::Ok &&
+      ret.entry.GetRecordStatus() != RecordStatus::Outdated &&
+      ret.entry.GetIndexType() == PointerType::HashList) {
+    std::string internal_key = ret.entry.GetIndex().hlist->InternalKey(key);
+    hash_table->Prefetch(internal_key);
+    co_await PrefetchSuspend{};
+    hash_table->PrefetchIndex(internal_key, RecordType::HashElem);
+    co_await PrefetchSuspend{};
+  }
+  *s = kv_engine_->HashGet(collection, key, value);
+}
+
+LookupTask InterleavedLookup::sortedGetTask(StringView collection,
+                                            StringView key, std::string* value,
+                                            Status* s) {
+  HashTable* hash_table = kv_engine_->GetHashTable();
+  hash_table->Prefetch(collection);
+  co_await PrefetchSuspend{};
+  hash_table->PrefetchIndex(collection, RecordType::SortedRecord);
+  co_await PrefetchSuspend{};
+  auto ret = hash_table->Lookup<false>(collection, RecordType::SortedRecord);
+  // Elems of skiplist without hash index are searched by skiplist, which is
+  // not staged here
+  if (ret.s == Status::Ok &&
+      ret.entry.GetRecordStatus() != RecordStatus::Outdated &&
+      ret.entry.GetIndexType() == PointerType::Skiplist &&
+      ret.entry.GetIndex().skiplist->IndexWithHashtable()) {
+    std::string internal_key = ret.entry.GetIndex().skiplist->InternalKey(key);
+    hash_table->Prefetch(internal_key);
+    co_await PrefetchSuspend{};
+    hash_table->PrefetchIndex(internal_key, RecordType::SortedElem);
+    co_await PrefetchSuspend{};
+  }
+  *s = kv_engine_->SortedGet(collection, key, value);
+}
+
+void MultiGet(Engine* engine, const std::vector<StringView>& keys,
+              std::vector<std::string>* values, std::vector<Status>* status) {
+  KVEngine* kv_engine = static_cast<KVEngine*>(engine);
+  HashTable* hash_table = kv_engine->GetHashTable();
+  values->resize(keys.size());
+  status->resize(keys.size());
+  Snapshot* snapshot = kv_engine->GetSnapshot(false);
+  for (auto& key : keys) {
+    hash_table->Prefetch(key);
+  }
+  for (auto& key : keys) {
+    hash_table->PrefetchIndex(key, RecordType::String);
+  }
+  for (size_t i = 0; i < keys.size(); i++) {
+    (*status)[i] = kv_engine->Get(keys[i], &(*values)[i]);
+  }
+  kv_engine->ReleaseSnapshot(snapshot);
+}
+
+}  // namespace KVDK_NAMESPACE
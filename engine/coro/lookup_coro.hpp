@@ -0,0 +1,138 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#pragma once
+
+#if __cplusplus < 202002L
+#error "Coroutine lookups require C++20, build with -DBUILD_CORO_LOOKUP=ON"
+#endif
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "kvdk/engine.hpp"
+
+namespace KVDK_NAMESPACE {
+
+class KVEngine;
+
+// A lookup coroutine, it starts suspended and is driven by
+// InterleavedScheduler
+class LookupTask {
+ public:
+  struct promise_type {
+    LookupTask get_return_object() {
+      return LookupTask{
+          std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+
+  LookupTask() = default;
+  LookupTask(const LookupTask&) = delete;
+  LookupTask(LookupTask&& other) noexcept : handle_(other.handle_) {
+    other.handle_ = nullptr;
+  }
+  LookupTask& operator=(LookupTask&& other) noexcept {
+    if (this != &other) {
+      destroy();
+      handle_ = other.handle_;
+      other.handle_ = nullptr;
+    }
+    return *this;
+  }
+  ~LookupTask() { destroy(); }
+
+  bool Done() const { return handle_ == nullptr || handle_.done(); }
+
+  void Resume() { handle_.resume(); }
+
+ private:
+  explicit LookupTask(std::coroutine_handle<promise_type> handle)
+      : handle_(handle) {}
+
+  void destroy() {
+    if (handle_) {
+      handle_.destroy();
+      handle_ = nullptr;
+    }
+  }
+
+  std::coroutine_handle<promise_type> handle_{nullptr};
+};
+
+// Suspend a lookup after it issued prefetches, so the scheduler runs other
+// lookups while the cache lines are loading
+struct PrefetchSuspend {
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<>) const noexcept {}
+  void await_resume() const noexcept {}
+};
+
+// Run lookup tasks round robin in the calling thread, keeping up to
+// "max_in_flight" of them started at a time
+class InterleavedScheduler {
+ public:
+  explicit InterleavedScheduler(size_t max_in_flight)
+      : max_in_flight_(max_in_flight == 0 ? 1 : max_in_flight) {}
+
+  void Add(LookupTask&& task) { pending_.push_back(std::move(task)); }
+
+  // Run until all added tasks are done
+  void Run();
+
+ private:
+  size_t max_in_flight_;
+  std::deque<LookupTask> pending_;
+};
+
+// Point lookups of a KVDK instance, interleaved in the calling thread to hide
+// cache misses on hash buckets and records.
+//
+// Each lookup prefetches the hash bucket, suspends, prefetches the indexed
+// record (or collection, then the bucket and record of the element), suspends
+// again and finally does the regular engine lookup on warm cache lines.
+//
+// Notice: keys and outputs passed to Get(), HashGet() and SortedGet() should be
+// valid until Run() returns
+class InterleavedLookup {
+ public:
+  static constexpr size_t kDefaultInFlight = 16;
+
+  explicit InterleavedLookup(Engine* engine,
+                             size_t max_in_flight = kDefaultInFlight);
+
+  void Get(StringView key, std::string* value, Status* s);
+  void HashGet(StringView collection, StringView key, std::string* value,
+               Status* s);
+  void SortedGet(StringView collection, StringView key, std::string* value,
+                 Status* s);
+
+  // Execute all added lookups
+  void Run();
+
+ private:
+  LookupTask getTask(StringView key, std::string* value, Status* s);
+  LookupTask hashGetTask(StringView collection, StringView key,
+                         std::string* value, Status* s);
+  LookupTask sortedGetTask(StringView collection, StringView key,
+                           std::string* value, Status* s);
+
+  KVEngine* kv_engine_;
+  InterleavedScheduler scheduler_;
+};
+
+// Batched string lookups with group prefetching, i.e. prefetch hash buckets of
+// all keys, then indexed records of all keys, then get them one by one. This
+// is the non-coroutine counterpart of InterleavedLookup
+void MultiGet(Engine* engine, const std::vector<StringView>& keys,
+              std::vector<std::string>* values, std::vector<Status>* status);
+
+}  // namespace KVDK_NAMESPACE
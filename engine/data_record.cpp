@@ -10,9 +10,10 @@ thread_local std::string thread_data_buffer;
 static constexpr int kDataBufferSize = 1024 * 1024;
 
 StringRecord* StringRecord::PersistStringRecord(
-    void* addr, uint32_t record_size, TimestampType timestamp, RecordType type,
-    RecordStatus status, PMemOffsetType old_version, const StringView& key,
-    const StringView& value, ExpireTimeType expired_time) {
+    const PersistPolicy& policy, void* addr, uint32_t record_size,
+    TimestampType timestamp, RecordType type, RecordStatus status,
+    PMemOffsetType old_version, const StringView& key, const StringView& value,
+    ExpireTimeType expired_time, uint8_t value_flags) {
   void* data_cpy_target;
   auto write_size = key.size() + value.size() + sizeof(StringRecord);
   bool with_buffer = write_size <= kDataBufferSize;
@@ -26,24 +27,49 @@ StringRecord* StringRecord::PersistStringRecord(
   }
   StringRecord::ConstructStringRecord(data_cpy_target, record_size, timestamp,
                                       type, status, old_version, key, value,
-                                      expired_time);
+                                      expired_time, value_flags,
+                                      policy.Checksummed());
   if (with_buffer) {
-    pmem_memcpy(addr, data_cpy_target, write_size, PMEM_F_MEM_NONTEMPORAL);
-    pmem_drain();
+    policy.CopyNT(addr, data_cpy_target, write_size);
+    policy.Drain();
   } else {
-    pmem_persist(addr, write_size);
+    policy.Persist(addr, write_size);
   }
 
   return static_cast<StringRecord*>(addr);
 }
 
+ExtentRecord* ExtentRecord::PersistExtentRecord(const PersistPolicy& policy,
+                                                void* addr,
+                                                uint32_t record_size,
+                                                TimestampType timestamp,
+                                                PMemOffsetType next,
+                                                const StringView& data) {
+  ExtentRecord* record = static_cast<ExtentRecord*>(addr);
+  policy.CopyNT(record->data, data.data(), data.size());
+  // Checksum data from DRAM rather than reading back the just streamed PMem
+  ExtentRecord header;
+  header.entry = DataEntry(0, record_size, timestamp, RecordType::Extent,
+                           RecordStatus::Normal, 0, data.size());
+  header.next = next;
+  if (policy.Checksummed()) {
+    header.entry.header.checksum = Checksum(header.entry.meta, next, data);
+  }
+  policy.CopyNT(addr, &header, sizeof(ExtentRecord));
+  policy.Drain();
+  return record;
+}
+
 DLRecord* DLRecord::PersistDLRecord(
-    void* addr, uint32_t record_size, TimestampType timestamp, RecordType type,
-    RecordStatus status, PMemOffsetType old_version, PMemOffsetType prev,
-    PMemOffsetType next, const StringView& key, const StringView& value,
+    const PersistPolicy& policy, void* addr, uint32_t record_size,
+    TimestampType timestamp, RecordType type, RecordStatus status,
+    PMemOffsetType old_version, PMemOffsetType prev, PMemOffsetType next,
+    const StringView& key, const StringView& value,
     ExpireTimeType expired_time) {
   void* data_cpy_target;
-  auto write_size = key.size() + value.size() + sizeof(DLRecord);
+  bool compact = record_size < RecordSize(key, value);
+  auto write_size = compact ? CompactRecordSize(key, value)
+                            : RecordSize(key, value);
   bool with_buffer = write_size <= kDataBufferSize;
   if (with_buffer) {
     if (thread_data_buffer.empty()) {
@@ -55,12 +81,12 @@ DLRecord* DLRecord::PersistDLRecord(
   }
   DLRecord::ConstructDLRecord(data_cpy_target, record_size, timestamp, type,
                               status, old_version, prev, next, key, value,
-                              expired_time);
+                              expired_time, compact, policy.Checksummed());
   if (with_buffer) {
-    pmem_memcpy(addr, data_cpy_target, write_size, PMEM_F_MEM_NONTEMPORAL);
-    pmem_drain();
+    policy.CopyNT(addr, data_cpy_target, write_size);
+    policy.Drain();
   } else {
-    pmem_persist(addr, write_size);
+    policy.Persist(addr, write_size);
   }
 
   return static_cast<DLRecord*>(addr);
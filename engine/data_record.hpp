@@ -10,6 +10,7 @@
 
 #include "alias.hpp"
 #include "kvdk/configs.hpp"
+#include "utils/persist.hpp"
 #include "utils/utils.hpp"
 
 namespace KVDK_NAMESPACE {
@@ -23,6 +24,8 @@ enum RecordType : uint8_t {
   HashElem = (1 << 4),
   ListRecord = (1 << 5),
   ListElem = (1 << 6),
+  // A piece of a large value stored out of its record, see ExtentRecord
+  Extent = (1 << 7),
 };
 
 enum class RecordStatus : uint8_t {
@@ -34,6 +37,23 @@ enum class RecordStatus : uint8_t {
   Outdated,
 };
 
+// Flags of how value and layout of a record are stored, they share a byte
+// with RecordStatus in DataMeta so only 4 bits are usable
+enum ValueFlag : uint8_t {
+  // Value is stored in the record
+  Inline = 0,
+  // Value is stored in a chain of extents, the record stores an ExtentRef
+  Extents = (1 << 0),
+  // Value is compressed, see utils/compression.hpp. With Extents, the
+  // compressed value is stored in extents
+  Compressed = (1 << 1),
+  // Record is a DLRecord in the compact layout, see DLRecord
+  Compact = (1 << 2),
+  // Value is demoted to the cold tier file, the record stores a ColdRef, see
+  // ColdTier. With Compressed, the compressed value is demoted
+  Cold = (1 << 3),
+};
+
 const uint8_t ExpirableRecordType =
     (RecordType::String | RecordType::SortedRecord | RecordType::HashRecord |
      RecordType::ListRecord);
@@ -58,15 +78,18 @@ struct DataHeader {
 struct DataMeta {
   DataMeta() = default;
   DataMeta(TimestampType _timestamp, RecordType _type, RecordStatus _status,
-           uint16_t _key_size, uint32_t _value_size)
+           uint16_t _key_size, uint32_t _value_size, uint8_t _value_flags = 0)
       : type(_type),
         status(_status),
+        value_flags(_value_flags),
         k_size(_key_size),
         v_size(_value_size),
         timestamp(_timestamp) {}
 
   RecordType type;
-  RecordStatus status;
+  RecordStatus status : 4;
+  // Bits of ValueFlag
+  uint8_t value_flags : 4;
   uint16_t k_size;
   uint32_t v_size;
   TimestampType timestamp;
@@ -76,15 +99,16 @@ struct DataMeta {
 struct DataEntry {
   DataEntry(uint32_t _checksum, uint32_t _record_size /* size in blocks */,
             TimestampType _timestamp, RecordType _type, RecordStatus _status,
-            uint16_t _key_size, uint32_t _value_size)
+            uint16_t _key_size, uint32_t _value_size, uint8_t _value_flags = 0)
       : header(_checksum, _record_size),
-        meta(_timestamp, _type, _status, _key_size, _value_size) {}
+        meta(_timestamp, _type, _status, _key_size, _value_size,
+             _value_flags) {}
 
   DataEntry() = default;
 
-  void Destroy() {
+  void Destroy(const PersistPolicy& policy) {
     meta.type = RecordType::Empty;
-    pmem_persist(&meta.type, sizeof(RecordType));
+    policy.Persist(&meta.type, sizeof(RecordType));
   }
 
   // TODO jiayu: use function to access these
@@ -93,6 +117,91 @@ struct DataEntry {
 };
 static_assert(sizeof(DataEntry) <= kMinPMemBlockSize);
 
+// Reference to the chain of extents of a large value, which is stored as
+// value of a record with ValueFlag::Extents
+struct ExtentRef {
+  PMemOffsetType first;
+  uint64_t size;
+
+  std::string Encode() const {
+    return std::string(reinterpret_cast<const char*>(this), sizeof(ExtentRef));
+  }
+
+  static bool Decode(const StringView& src, ExtentRef* ref) {
+    if (src.size() != sizeof(ExtentRef)) {
+      return false;
+    }
+    memcpy(ref, src.data(), sizeof(ExtentRef));
+    return true;
+  }
+};
+
+// Reference to a value demoted to the cold tier file, which is stored as
+// value of a record with ValueFlag::Cold
+struct ColdRef {
+  uint64_t offset;
+  uint64_t size;
+
+  std::string Encode() const {
+    return std::string(reinterpret_cast<const char*>(this), sizeof(ColdRef));
+  }
+
+  static bool Decode(const StringView& src, ColdRef* ref) {
+    if (src.size() != sizeof(ColdRef)) {
+      return false;
+    }
+    memcpy(ref, src.data(), sizeof(ColdRef));
+    return true;
+  }
+};
+
+// A piece of a large value stored out of its record.
+//
+// A large value is split into extents of at most a PMem segment, which are
+// linked by "next" and referenced by an ExtentRef in the record. Extents are
+// persisted before the record, and freed as a unit after the record is
+// purged.
+struct ExtentRecord {
+ public:
+  DataEntry entry;
+  PMemOffsetType next;
+  char data[0];
+
+  // Persist an extent of "data" at PMem address "addr". Data is copied with
+  // non-temporal stores as it's not going to be read soon
+  static ExtentRecord* PersistExtentRecord(const PersistPolicy& policy,
+                                           void* addr, uint32_t record_size,
+                                           TimestampType timestamp,
+                                           PMemOffsetType next,
+                                           const StringView& data);
+
+  void Destroy(const PersistPolicy& policy) { entry.Destroy(policy); }
+
+  StringView Data() const { return StringView(data, entry.meta.v_size); }
+
+  bool Validate(const PersistPolicy& policy) {
+    if (sizeof(ExtentRecord) + entry.meta.v_size <= entry.header.record_size) {
+      return !policy.Checksummed() ||
+             Checksum(entry.meta, next, Data()) == entry.header.checksum;
+    }
+    return false;
+  }
+
+  uint32_t GetRecordSize() const { return entry.header.record_size; }
+
+  static uint64_t RecordSize(uint64_t data_size) {
+    return sizeof(ExtentRecord) + data_size;
+  }
+
+ private:
+  static uint32_t Checksum(const DataMeta& meta, PMemOffsetType next,
+                           const StringView& data) {
+    return get_checksum(&meta, sizeof(DataMeta)) +
+           get_checksum(&next, sizeof(PMemOffsetType)) +
+           get_checksum(data.data(), data.size());
+  }
+};
+
 struct StringRecord {
  public:
   DataEntry entry;
@@ -105,53 +214,90 @@ struct StringRecord {
   //
   // target_address: pre-allocated space to store constructed record, it
   // should larger than sizeof(StringRecord) + key size + value size
+  //
+  // The record is not checksummed if "checksummed" is false, see
+  // PersistPolicy::Checksummed()
   static StringRecord* ConstructStringRecord(
       void* target_address, uint32_t _record_size, TimestampType _timestamp,
       RecordType _record_type, RecordStatus _record_status,
       PMemOffsetType _old_version, const StringView& _key,
-      const StringView& _value, ExpireTimeType _expired_time) {
-    StringRecord* record = new (target_address)
-        StringRecord(_record_size, _timestamp, _record_type, _record_status,
-                     _old_version, _key, _value, _expired_time);
+      const StringView& _value, ExpireTimeType _expired_time,
+      uint8_t _value_flags = 0, bool checksummed = true) {
+    StringRecord* record = new (target_address) StringRecord(
+        _record_size, _timestamp, _record_type, _record_status, _old_version,
+        _key, _value, _expired_time, _value_flags, checksummed);
     return record;
   }
 
   // Construct and persist a string record at pmem address "addr"
   static StringRecord* PersistStringRecord(
-      void* addr, uint32_t record_size, TimestampType timestamp,
-      RecordType type, RecordStatus status, PMemOffsetType old_version,
-      const StringView& key, const StringView& value,
-      ExpireTimeType expired_time = kPersistTime);
+      const PersistPolicy& policy, void* addr, uint32_t record_size,
+      TimestampType timestamp, RecordType type, RecordStatus status,
+      PMemOffsetType old_version, const StringView& key,
+      const StringView& value, ExpireTimeType expired_time = kPersistTime,
+      uint8_t value_flags = 0);
 
-  void Destroy() { entry.Destroy(); }
+  void Destroy(const PersistPolicy& policy) { entry.Destroy(policy); }
 
   // make sure there is data followed in data[0]
   StringView Key() const { return StringView(data, entry.meta.k_size); }
 
+  PMemOffsetType GetOldVersion() const { return old_version; }
+
   // make sure there is data followed in data[0]
+  //
+  // Notice: this is an ExtentRef if the value is stored in extents, see
+  // HasExtents(), a ColdRef if IsCold(), and compressed bytes if
+  // IsCompressed()
   StringView Value() const {
     return StringView(data + entry.meta.k_size, entry.meta.v_size);
   }
 
+  bool HasExtents() const {
+    return entry.meta.value_flags & ValueFlag::Extents;
+  }
+
+  bool IsCompressed() const {
+    return entry.meta.value_flags & ValueFlag::Compressed;
+  }
+
+  bool IsCold() const { return entry.meta.value_flags & ValueFlag::Cold; }
+
+  uint8_t GetValueFlags() const { return entry.meta.value_flags; }
+
+  ColdRef GetColdRef() const {
+    ColdRef ref{};
+    kvdk_assert(IsCold(), "Get cold ref of a value on PMem");
+    ColdRef::Decode(Value(), &ref);
+    return ref;
+  }
+
+  ExtentRef GetExtentRef() const {
+    ExtentRef ref{};
+    kvdk_assert(HasExtents(), "Get extent ref of an inline value");
+    ExtentRef::Decode(Value(), &ref);
+    return ref;
+  }
+
   // Check whether the record corrupted
-  bool Validate() {
+  bool Validate(const PersistPolicy& policy) {
     if (ValidateRecordSize()) {
-      return Checksum() == entry.header.checksum;
+      return !policy.Checksummed() || Checksum() == entry.header.checksum;
     }
     return false;
   }
 
-  bool ValidOrDirty() {
-    bool valid = Validate();
+  bool ValidOrDirty(const PersistPolicy& policy) {
+    bool valid = Validate(policy);
     asm volatile("" ::: "memory");
     bool dirty = (GetRecordStatus() == RecordStatus::Dirty);
     return (valid || dirty);
   }
 
   // Check whether the record corrupted with expected checksum
-  bool Validate(uint32_t expected_checksum) {
+  bool Validate(const PersistPolicy& policy, uint32_t expected_checksum) {
     if (ValidateRecordSize()) {
-      return Checksum() == expected_checksum;
+      return !policy.Checksummed() || Checksum() == expected_checksum;
     }
     return false;
   }
@@ -159,28 +305,24 @@ struct StringRecord {
   ExpireTimeType GetExpireTime() const { return expired_time; }
   bool HasExpired() const { return TimeUtils::CheckIsExpired(GetExpireTime()); }
 
-  void PersistExpireTimeNT(ExpireTimeType time) {
-    _mm_stream_si64(reinterpret_cast<long long*>(&expired_time),
-                    static_cast<long long>(time));
-    _mm_mfence();
+  void PersistExpireTimeNT(const PersistPolicy& policy, ExpireTimeType time) {
+    policy.StoreNT(reinterpret_cast<uint64_t*>(&expired_time),
+                   static_cast<uint64_t>(time));
   }
 
-  void PersistExpireTimeCLWB(ExpireTimeType time) {
+  void PersistExpireTimeCLWB(const PersistPolicy& policy,
+                             ExpireTimeType time) {
     expired_time = time;
-    _mm_clwb(&expired_time);
-    _mm_mfence();
+    policy.Flush(&expired_time);
   }
 
-  void PersistOldVersion(PMemOffsetType offset) {
-    _mm_stream_si64(reinterpret_cast<long long*>(&old_version),
-                    static_cast<long long>(offset));
-    _mm_mfence();
+  void PersistOldVersion(const PersistPolicy& policy, PMemOffsetType offset) {
+    policy.StoreNT(&old_version, offset);
   }
 
-  void PersistStatus(RecordStatus status) {
+  void PersistStatus(const PersistPolicy& policy, RecordStatus status) {
     entry.meta.status = status;
-    _mm_clwb(&entry.meta.status);
-    _mm_mfence();
+    policy.Flush(&entry.meta);
   }
 
   TimestampType GetTimestamp() const { return entry.meta.timestamp; }
@@ -199,15 +341,16 @@ struct StringRecord {
   StringRecord(uint32_t _record_size, TimestampType _timestamp,
                RecordType _record_type, RecordStatus _record_status,
                PMemOffsetType _old_version, const StringView& _key,
-               const StringView& _value, ExpireTimeType _expired_time)
+               const StringView& _value, ExpireTimeType _expired_time,
+               uint8_t _value_flags, bool _checksummed)
       : entry(0, _record_size, _timestamp, _record_type, _record_status,
-              _key.size(), _value.size()),
+              _key.size(), _value.size(), _value_flags),
         old_version(_old_version),
         expired_time(_expired_time) {
     kvdk_assert(_record_type == RecordType::String, "");
     memcpy(data, _key.data(), _key.size());
     memcpy(data + _key.size(), _value.data(), _value.size());
-    entry.header.checksum = Checksum();
+    entry.header.checksum = _checksummed ? Checksum() : 0;
   }
 
   // check validation of k_size and v_size, as record may be left corrupted
@@ -227,21 +370,29 @@ struct StringRecord {
 };
 
 // doubly linked record
+//
+// A record of a collection elem type may use the compact layout if it saves
+// space (see ValueFlag::Compact), which stores old_version, prev and next as
+// 32-bit offsets in units of kCompactOffsetUnit bytes and no expire time, so
+// data follows a 36 bytes header rather than 56. Links should always be
+// accessed by GetPrev()/PersistPrevNT() etc. as their layout differs.
 struct DLRecord {
  public:
   DataEntry entry;
-  PMemOffsetType old_version;
-  PMemOffsetType prev;
-  PMemOffsetType next;
-  ExpireTimeType expired_time;
 
-  char data[0];
+  // Offsets of compact records are stored in this unit, so they can address
+  // (UINT32_MAX - 1) * kCompactOffsetUnit bytes of PMem
+  static constexpr uint64_t kCompactOffsetUnit = 64;
 
   // Construct a DLRecord instance at "target_address". As the record need
   // additional space to store data, we need pre-allocate enough space for it.
   //
   // target_address: pre-allocated space to store constructed record, it
-  // should no smaller than sizeof(DLRecord) + key size + value size
+  // should no smaller than sizeof(DLRecord) + key size + value size, or
+  // CompactRecordSize() if "compact"
+  //
+  // The record is not checksummed if "checksummed" is false, see
+  // PersistPolicy::Checksummed()
   static DLRecord* ConstructDLRecord(void* target_address, uint32_t record_size,
                                      TimestampType timestamp,
                                      RecordType record_type,
@@ -249,89 +400,122 @@ struct DLRecord {
                                      PMemOffsetType old_version, uint64_t prev,
                                      uint64_t next, const StringView& key,
                                      const StringView& value,
-                                     ExpireTimeType expired_time) {
-    DLRecord* record = new (target_address)
-        DLRecord(record_size, timestamp, record_type, record_status,
-                 old_version, prev, next, key, value, expired_time);
+                                     ExpireTimeType expired_time,
+                                     bool compact = false,
+                                     bool checksummed = true) {
+    DLRecord* record = new (target_address) DLRecord(
+        record_size, timestamp, record_type, record_status, old_version, prev,
+        next, key, value, expired_time, compact, checksummed);
     return record;
   }
 
-  void Destroy() { entry.Destroy(); }
+  void Destroy(const PersistPolicy& policy) { entry.Destroy(policy); }
 
-  bool Validate() {
+  bool Validate(const PersistPolicy& policy) {
     if (ValidateRecordSize()) {
-      return Checksum() == entry.header.checksum;
+      return !policy.Checksummed() || Checksum() == entry.header.checksum;
     }
     return false;
   }
 
-  bool Validate(uint32_t expected_checksum) {
+  bool Validate(const PersistPolicy& policy, uint32_t expected_checksum) {
     if (ValidateRecordSize()) {
-      return Checksum() == expected_checksum;
+      return !policy.Checksummed() || Checksum() == expected_checksum;
     }
     return false;
   }
 
-  StringView Key() const { return StringView(data, entry.meta.k_size); }
+  StringView Key() const { return StringView(data(), entry.meta.k_size); }
 
   StringView Value() const {
-    return StringView(data + entry.meta.k_size, entry.meta.v_size);
+    return StringView(data() + entry.meta.k_size, entry.meta.v_size);
   }
 
-  void PersistNextNT(PMemOffsetType offset) {
-    _mm_stream_si64(reinterpret_cast<long long*>(&next),
-                    static_cast<long long>(offset));
-    _mm_mfence();
+  bool IsCompact() const {
+    return entry.meta.value_flags & ValueFlag::Compact;
   }
 
-  void PersistPrevNT(PMemOffsetType offset) {
-    _mm_stream_si64(reinterpret_cast<long long*>(&prev),
-                    static_cast<long long>(offset));
-    _mm_mfence();
+  PMemOffsetType GetOldVersion() const {
+    return IsCompact() ? decodeOffset(links_.compact.old_version)
+                       : links_.full.old_version;
   }
 
-  void PersistExpireTimeNT(ExpireTimeType time) {
+  PMemOffsetType GetPrev() const {
+    return IsCompact() ? decodeOffset(links_.compact.prev) : links_.full.prev;
+  }
+
+  PMemOffsetType GetNext() const {
+    return IsCompact() ? decodeOffset(links_.compact.next) : links_.full.next;
+  }
+
+  void PersistNextNT(const PersistPolicy& policy, PMemOffsetType offset) {
+    if (IsCompact()) {
+      policy.StoreNT(&links_.compact.next, encodeOffset(offset));
+    } else {
+      policy.StoreNT(&links_.full.next, offset);
+    }
+  }
+
+  void PersistPrevNT(const PersistPolicy& policy, PMemOffsetType offset) {
+    if (IsCompact()) {
+      policy.StoreNT(&links_.compact.prev, encodeOffset(offset));
+    } else {
+      policy.StoreNT(&links_.full.prev, offset);
+    }
+  }
+
+  void PersistExpireTimeNT(const PersistPolicy& policy, ExpireTimeType time) {
     kvdk_assert(entry.meta.type & ExpirableRecordType, "");
-    _mm_stream_si64(reinterpret_cast<long long*>(&expired_time),
-                    static_cast<long long>(time));
-    _mm_mfence();
+    kvdk_assert(!IsCompact(), "Compact record has no expire time");
+    policy.StoreNT(reinterpret_cast<uint64_t*>(&links_.full.expired_time),
+                   static_cast<uint64_t>(time));
   }
 
-  void PersistNextCLWB(PMemOffsetType offset) {
-    next = offset;
-    _mm_clwb(&next);
-    _mm_mfence();
+  void PersistNextCLWB(const PersistPolicy& policy, PMemOffsetType offset) {
+    if (IsCompact()) {
+      links_.compact.next = encodeOffset(offset);
+      policy.Flush(&links_.compact.next);
+    } else {
+      links_.full.next = offset;
+      policy.Flush(&links_.full.next);
+    }
   }
 
-  void PersistPrevCLWB(PMemOffsetType offset) {
-    prev = offset;
-    _mm_clwb(&prev);
-    _mm_mfence();
+  void PersistPrevCLWB(const PersistPolicy& policy, PMemOffsetType offset) {
+    if (IsCompact()) {
+      links_.compact.prev = encodeOffset(offset);
+      policy.Flush(&links_.compact.prev);
+    } else {
+      links_.full.prev = offset;
+      policy.Flush(&links_.full.prev);
+    }
   }
 
-  void PersistExpireTimeCLWB(ExpireTimeType time) {
+  void PersistExpireTimeCLWB(const PersistPolicy& policy,
+                             ExpireTimeType time) {
     kvdk_assert(entry.meta.type & ExpirableRecordType, "");
-    expired_time = time;
-    _mm_clwb(&expired_time);
-    _mm_mfence();
+    kvdk_assert(!IsCompact(), "Compact record has no expire time");
+    links_.full.expired_time = time;
+    policy.Flush(&links_.full.expired_time);
   }
 
-  void PersistOldVersion(PMemOffsetType offset) {
-    _mm_stream_si64(reinterpret_cast<long long*>(&old_version),
-                    static_cast<long long>(offset));
-    _mm_mfence();
+  void PersistOldVersion(const PersistPolicy& policy, PMemOffsetType offset) {
+    if (IsCompact()) {
+      policy.StoreNT(&links_.compact.old_version, encodeOffset(offset));
+    } else {
+      policy.StoreNT(&links_.full.old_version, offset);
+    }
   }
 
-  void PersistStatus(RecordStatus status) {
+  void PersistStatus(const PersistPolicy& policy, RecordStatus status) {
     entry.meta.status = status;
-    _mm_clwb(&entry.meta.status);
-    _mm_mfence();
+    policy.Flush(&entry.meta);
   }
 
   ExpireTimeType GetExpireTime() const {
     kvdk_assert(entry.meta.type & ExpirableRecordType,
                 "Call DLRecord::GetExpireTime with an unexpirable type");
-    return expired_time;
+    return IsCompact() ? kPersistTime : links_.full.expired_time;
   }
 
   RecordType GetRecordType() const { return entry.meta.type; }
@@ -342,41 +526,115 @@ struct DLRecord {
   TimestampType GetTimestamp() const { return entry.meta.timestamp; }
 
   // Construct and persist a dl record to PMem address "addr"
+  //
+  // The compact layout is used if the record doesn't fit in "record_size"
+  // with the full layout, which requires "type" to be CompactCapable() and
+  // the offsets CompactEncodable()
   static DLRecord* PersistDLRecord(
-      void* addr, uint32_t record_size, TimestampType timestamp,
-      RecordType type, RecordStatus status, PMemOffsetType old_version,
-      PMemOffsetType prev, PMemOffsetType next, const StringView& key,
-      const StringView& value, ExpireTimeType expired_time = kPersistTime);
+      const PersistPolicy& policy, void* addr, uint32_t record_size,
+      TimestampType timestamp, RecordType type, RecordStatus status,
+      PMemOffsetType old_version, PMemOffsetType prev, PMemOffsetType next,
+      const StringView& key, const StringView& value,
+      ExpireTimeType expired_time = kPersistTime);
 
   uint32_t GetRecordSize() const { return entry.header.record_size; }
 
+  // Size of a record with the full layout
   static uint32_t RecordSize(const StringView& key, const StringView& value) {
     return sizeof(DLRecord) + key.size() + value.size();
   }
 
+  // Size of a record with the compact layout
+  static uint32_t CompactRecordSize(const StringView& key,
+                                    const StringView& value) {
+    return kCompactHeaderSize + key.size() + value.size();
+  }
+
+  // Elems are not expirable, so they can be stored compactly
+  static bool CompactCapable(RecordType type) {
+    return type & (RecordType::SortedElem | RecordType::HashElem |
+                   RecordType::ListElem);
+  }
+
+  static bool CompactEncodable(PMemOffsetType offset) {
+    return offset == kNullPMemOffset ||
+           (offset % kCompactOffsetUnit == 0 &&
+            offset / kCompactOffsetUnit < kCompactNull);
+  }
+
  private:
+  static constexpr uint32_t kCompactNull = UINT32_MAX;
+
+  struct FullLinks {
+    PMemOffsetType old_version;
+    PMemOffsetType prev;
+    PMemOffsetType next;
+    ExpireTimeType expired_time;
+  };
+
+  struct CompactLinks {
+    uint32_t old_version;
+    uint32_t prev;
+    uint32_t next;
+  };
+
+  static constexpr uint32_t kCompactHeaderSize =
+      sizeof(DataEntry) + sizeof(CompactLinks);
+
   DLRecord(uint32_t _record_size, TimestampType _timestamp, RecordType _type,
            RecordStatus _status, PMemOffsetType _old_version,
            PMemOffsetType _prev, PMemOffsetType _next, const StringView& _key,
-           const StringView& _value, ExpireTimeType _expired_time)
+           const StringView& _value, ExpireTimeType _expired_time,
+           bool _compact, bool _checksummed)
       : entry(0, _record_size, _timestamp, _type, _status, _key.size(),
-              _value.size()),
-        old_version(_old_version),
-        prev(_prev),
-        next(_next),
-        expired_time(_expired_time) {
+              _value.size(), _compact ? ValueFlag::Compact : 0) {
     kvdk_assert(_type & (RecordType::SortedElem | RecordType::SortedRecord |
                          RecordType::HashElem | RecordType::HashRecord |
                          RecordType::ListElem | RecordType::ListRecord),
                 "");
-    memcpy(data, _key.data(), _key.size());
-    memcpy(data + _key.size(), _value.data(), _value.size());
-    entry.header.checksum = Checksum();
+    if (_compact) {
+      kvdk_assert(CompactCapable(_type) && CompactEncodable(_old_version) &&
+                      CompactEncodable(_prev) && CompactEncodable(_next),
+                  "Construct compact record with unencodable fields");
+      links_.compact.old_version = encodeOffset(_old_version);
+      links_.compact.prev = encodeOffset(_prev);
+      links_.compact.next = encodeOffset(_next);
+    } else {
+      links_.full.old_version = _old_version;
+      links_.full.prev = _prev;
+      links_.full.next = _next;
+      links_.full.expired_time = _expired_time;
+    }
+    memcpy(data(), _key.data(), _key.size());
+    memcpy(data() + _key.size(), _value.data(), _value.size());
+    entry.header.checksum = _checksummed ? Checksum() : 0;
+  }
+
+  static uint32_t encodeOffset(PMemOffsetType offset) {
+    return offset == kNullPMemOffset
+               ? kCompactNull
+               : static_cast<uint32_t>(offset / kCompactOffsetUnit);
+  }
+
+  static PMemOffsetType decodeOffset(uint32_t offset) {
+    return offset == kCompactNull
+               ? kNullPMemOffset
+               : static_cast<PMemOffsetType>(offset) * kCompactOffsetUnit;
+  }
+
+  uint32_t headerSize() const {
+    return IsCompact() ? kCompactHeaderSize : sizeof(DLRecord);
+  }
+
+  char* data() { return reinterpret_cast<char*>(this) + headerSize(); }
+
+  const char* data() const {
+    return reinterpret_cast<const char*>(this) + headerSize();
   }
 
   // check validation of k_size and v_size, as record may be left corrupted
   bool ValidateRecordSize() {
-    return entry.meta.k_size + entry.meta.v_size + sizeof(DLRecord) <=
+    return entry.meta.k_size + entry.meta.v_size + headerSize() <=
            entry.header.record_size;
   }
 
@@ -386,7 +644,14 @@ struct DLRecord {
     uint32_t data_checksum_size = entry.meta.k_size + entry.meta.v_size;
 
     return get_checksum((char*)&entry.meta, meta_checksum_size) +
-           get_checksum(data, data_checksum_size);
+           get_checksum(data(), data_checksum_size);
   }
+
+  // Layout of links follows entry, then key and value
+  union {
+    FullLinks full;
+    CompactLinks compact;
+  } links_;
 };
+static_assert(sizeof(DLRecord) == sizeof(DataEntry) + 32, "");
 }  // namespace KVDK_NAMESPACE
\ No newline at end of file
@@ -28,7 +28,7 @@ DLRecord* DLList::RemoveFront() {
   kvdk_assert(header_ != nullptr, "");
   while (true) {
     DLRecord* front =
-        pmem_allocator_->offset2addr_checked<DLRecord>(header_->next);
+        pmem_allocator_->offset2addr_checked<DLRecord>(header_->GetNext());
     if (front == header_) {
       return nullptr;
     }
@@ -44,7 +44,7 @@ DLRecord* DLList::RemoveBack() {
   kvdk_assert(header_ != nullptr, "");
   while (true) {
     DLRecord* back =
-        pmem_allocator_->offset2addr_checked<DLRecord>(header_->prev);
+        pmem_allocator_->offset2addr_checked<DLRecord>(header_->GetPrev());
     if (back == header_) {
       return nullptr;
     }
@@ -62,12 +62,14 @@ Status DLList::InsertBetween(const DLList::WriteArgs& args, DLRecord* prev,
   PMemOffsetType next_offset = pmem_allocator_->addr2offset_checked(next);
   PMemOffsetType prev_offset = pmem_allocator_->addr2offset_checked(prev);
   // Check if the linkage has changed before we successfully acquire lock.
-  bool check_linkage = prev->next == next_offset && next->prev == prev_offset;
+  bool check_linkage =
+      prev->GetNext() == next_offset && next->GetPrev() == prev_offset;
   if (!check_linkage) {
     return Status::Fail;
   }
 
   DLRecord* new_record = DLRecord::PersistDLRecord(
+      pmem_allocator_->GetPersistPolicy(),
       pmem_allocator_->offset2addr_checked(args.space.offset), args.space.size,
       args.ts, args.type, args.status, kNullPMemOffset, prev_offset,
       next_offset, args.key, args.val);
@@ -78,12 +80,14 @@ Status DLList::InsertBetween(const DLList::WriteArgs& args, DLRecord* prev,
 
 Status DLList::InsertAfter(const DLList::WriteArgs& args, DLRecord* prev) {
   return InsertBetween(
-      args, prev, pmem_allocator_->offset2addr_checked<DLRecord>(prev->next));
+      args, prev,
+      pmem_allocator_->offset2addr_checked<DLRecord>(prev->GetNext()));
 }
 
 Status DLList::InsertBefore(const DLList::WriteArgs& args, DLRecord* next) {
   return InsertBetween(
-      args, pmem_allocator_->offset2addr_checked<DLRecord>(next->prev), next);
+      args, pmem_allocator_->offset2addr_checked<DLRecord>(next->GetPrev()),
+      next);
 }
 
 Status DLList::Update(const DLList::WriteArgs& args, DLRecord* current) {
@@ -91,14 +95,15 @@ Status DLList::Update(const DLList::WriteArgs& args, DLRecord* current) {
               "");
   auto guard = acquireRecordLock(current);
   PMemOffsetType current_offset = pmem_allocator_->addr2offset_checked(current);
-  PMemOffsetType prev_offset = current->prev;
-  PMemOffsetType next_offset = current->next;
+  PMemOffsetType prev_offset = current->GetPrev();
+  PMemOffsetType next_offset = current->GetNext();
   DLRecord* prev = pmem_allocator_->offset2addr_checked<DLRecord>(prev_offset);
   DLRecord* next = pmem_allocator_->offset2addr_checked<DLRecord>(next_offset);
-  if (next->prev != current_offset || prev->next != current_offset) {
+  if (next->GetPrev() != current_offset || prev->GetNext() != current_offset) {
     return Status::Fail;
   }
   DLRecord* new_record = DLRecord::PersistDLRecord(
+      pmem_allocator_->GetPersistPolicy(),
       pmem_allocator_->offset2addr_checked(args.space.offset), args.space.size,
       args.ts, args.type, args.status, current_offset, prev_offset, next_offset,
       args.key, args.val);
@@ -122,14 +127,15 @@ bool DLList::Remove(DLRecord* removing_record) {
 bool DLList::Replace(DLRecord* old_record, DLRecord* new_record,
                      PMEMAllocator* pmem_allocator, LockTable* lock_table) {
   auto guard = acquireRecordLock(old_record, pmem_allocator, lock_table);
-  PMemOffsetType prev_offset = old_record->prev;
-  PMemOffsetType next_offset = old_record->next;
+  PMemOffsetType prev_offset = old_record->GetPrev();
+  PMemOffsetType next_offset = old_record->GetNext();
   auto old_record_offset = pmem_allocator->addr2offset(old_record);
   DLRecord* prev = pmem_allocator->offset2addr_checked<DLRecord>(prev_offset);
   DLRecord* next = pmem_allocator->offset2addr_checked<DLRecord>(next_offset);
-  bool on_list =
-      prev != nullptr && next != nullptr && prev->next == old_record_offset;
+  bool on_list = prev != nullptr && next != nullptr &&
+                 prev->GetNext() == old_record_offset;
   if (on_list) {
+    const PersistPolicy& policy = pmem_allocator->GetPersistPolicy();
     if (prev_offset == old_record_offset && next_offset == old_record_offset) {
       // old record is the only record (the header) in the list, so we
       // make
@@ -140,12 +146,10 @@ bool DLList::Replace(DLRecord* old_record, DLRecord* new_record,
                   "Non-header record shouldn't be the only record in a list");
       linkRecord(new_record, new_record, new_record, pmem_allocator);
       auto new_record_offset = pmem_allocator->addr2offset(new_record);
-      old_record->PersistPrevNT(new_record_offset);
+      old_record->PersistPrevNT(policy, new_record_offset);
     } else {
-      new_record->prev = prev_offset;
-      pmem_persist(&new_record->prev, sizeof(PMemOffsetType));
-      new_record->next = next_offset;
-      pmem_persist(&new_record->next, sizeof(PMemOffsetType));
+      new_record->PersistPrevCLWB(policy, prev_offset);
+      new_record->PersistNextCLWB(policy, next_offset);
       linkRecord(prev, next, new_record, pmem_allocator);
     }
   }
@@ -156,22 +160,21 @@ bool DLList::Remove(DLRecord* removing_record, PMEMAllocator* pmem_allocator,
                     LockTable* lock_table) {
   auto guard = acquireRecordLock(removing_record, pmem_allocator, lock_table);
   PMemOffsetType removing_offset = pmem_allocator->addr2offset(removing_record);
-  PMemOffsetType prev_offset = removing_record->prev;
-  PMemOffsetType next_offset = removing_record->next;
+  PMemOffsetType prev_offset = removing_record->GetPrev();
+  PMemOffsetType next_offset = removing_record->GetNext();
   DLRecord* prev = pmem_allocator->offset2addr_checked<DLRecord>(prev_offset);
   DLRecord* next = pmem_allocator->offset2addr_checked<DLRecord>(next_offset);
   bool on_list =
-      prev != nullptr && next != nullptr && prev->next == removing_offset;
+      prev != nullptr && next != nullptr && prev->GetNext() == removing_offset;
   if (on_list) {
     // For repair in recovery due to crashes during pointers changing, we
     // should
     // first unlink deleting entry from next's prev.(It is the reverse process
     // of insertion)
-    next->prev = prev_offset;
-    pmem_persist(&next->prev, 8);
+    const PersistPolicy& policy = pmem_allocator->GetPersistPolicy();
+    next->PersistPrevCLWB(policy, prev_offset);
     TEST_SYNC_POINT("KVEngine::DLList::Remove::PersistNext'sPrev::After");
-    prev->next = next_offset;
-    pmem_persist(&prev->next, 8);
+    prev->PersistNextCLWB(policy, next_offset);
   }
   return on_list;
 }
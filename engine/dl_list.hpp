@@ -31,7 +31,9 @@ class DLList {
           status(_status),
           ts(_ts),
           space(_space) {
-      kvdk_assert(space.size >= DLRecord::RecordSize(_key, _val),
+      kvdk_assert(space.size >= (DLRecord::CompactCapable(_type)
+                                     ? DLRecord::CompactRecordSize(_key, _val)
+                                     : DLRecord::RecordSize(_key, _val)),
                   "space to write dl record too small");
     }
 
@@ -96,14 +98,15 @@ class DLList {
   static LockTable::MultiGuardType acquireRecordLock(
       DLRecord* record, PMEMAllocator* pmem_allocator, LockTable* lock_table) {
     while (1) {
-      PMemOffsetType prev_offset = record->prev;
-      PMemOffsetType next_offset = record->next;
+      PMemOffsetType prev_offset = record->GetPrev();
+      PMemOffsetType next_offset = record->GetNext();
       DLRecord* prev =
           pmem_allocator->offset2addr_checked<DLRecord>(prev_offset);
       auto guard =
           lock_table->MultiGuard({recordHash(prev), recordHash(record)});
       // Check if the linkage has changed before we successfully acquire lock.
-      if (record->prev != prev_offset || record->next != next_offset) {
+      if (record->GetPrev() != prev_offset ||
+          record->GetNext() != next_offset) {
         continue;
       }
 
@@ -125,9 +128,10 @@ class DLList {
                          PMEMAllocator* pmem_allocator) {
     auto linking_record_offset =
         pmem_allocator->addr2offset_checked(linking_record);
-    prev->PersistNextNT(linking_record_offset);
+    const PersistPolicy& policy = pmem_allocator->GetPersistPolicy();
+    prev->PersistNextNT(policy, linking_record_offset);
     TEST_SYNC_POINT("KVEngine::DLList::LinkDLRecord::HalfLink");
-    next->PersistPrevNT(linking_record_offset);
+    next->PersistPrevNT(policy, linking_record_offset);
   }
 
   DLRecord* header_;
@@ -152,13 +156,13 @@ class DLListDataIterator {
   }
 
   void SeekToFirst() {
-    auto first = dl_list_->Header()->next;
+    auto first = dl_list_->Header()->GetNext();
     current_ = pmem_allocator_->offset2addr_checked<DLRecord>(first);
     skipInvalidRecords(true);
   }
 
   void SeekToLast() {
-    auto last = dl_list_->Header()->prev;
+    auto last = dl_list_->Header()->GetPrev();
     current_ = pmem_allocator_->offset2addr<DLRecord>(last);
     skipInvalidRecords(false);
   }
@@ -171,7 +175,8 @@ class DLListDataIterator {
     if (!Valid()) {
       return;
     }
-    current_ = pmem_allocator_->offset2addr_checked<DLRecord>(current_->next);
+    current_ =
+        pmem_allocator_->offset2addr_checked<DLRecord>(current_->GetNext());
     skipInvalidRecords(true);
   }
 
@@ -179,7 +184,7 @@ class DLListDataIterator {
     if (!Valid()) {
       return;
     }
-    current_ = (pmem_allocator_->offset2addr<DLRecord>(current_->prev));
+    current_ = (pmem_allocator_->offset2addr<DLRecord>(current_->GetPrev()));
     skipInvalidRecords(false);
   }
 
@@ -193,13 +198,16 @@ class DLListDataIterator {
     return current_->Value();
   }
 
+  DLRecord* Record() const { return Valid() ? current_ : nullptr; }
+
  private:
   DLRecord* findValidVersion(DLRecord* pmem_record) {
     DLRecord* curr = pmem_record;
     TimestampType ts = snapshot_->GetTimestamp();
     while (curr != nullptr && curr->GetTimestamp() > ts) {
-      curr = pmem_allocator_->offset2addr<DLRecord>(curr->old_version);
-      kvdk_assert(curr == nullptr || curr->Validate(),
+      curr = pmem_allocator_->offset2addr<DLRecord>(curr->GetOldVersion());
+      kvdk_assert(curr == nullptr ||
+                      curr->Validate(pmem_allocator_->GetPersistPolicy()),
                   "Broken checkpoint: invalid older version sorted record");
       kvdk_assert(
           curr == nullptr || equal_string_view(curr->Key(), pmem_record->Key()),
@@ -218,9 +226,10 @@ class DLListDataIterator {
           valid_version_record->GetRecordStatus() == RecordStatus::Outdated) {
         current_ =
             forward
-                ? pmem_allocator_->offset2addr_checked<DLRecord>(current_->next)
+                ? pmem_allocator_->offset2addr_checked<DLRecord>(
+                      current_->GetNext())
                 : pmem_allocator_->offset2addr_checked<DLRecord>(
-                      current_->prev);
+                      current_->GetPrev());
       } else {
         current_ = valid_version_record;
         break;
@@ -247,13 +256,15 @@ class DLListRecordIterator {
 
   void Next() {
     if (Valid()) {
-      current_ = pmem_allocator_->offset2addr_checked<DLRecord>(current_->next);
+      current_ =
+          pmem_allocator_->offset2addr_checked<DLRecord>(current_->GetNext());
     }
   }
 
   void Prev() {
     if (Valid()) {
-      current_ = pmem_allocator_->offset2addr_checked<DLRecord>(current_->prev);
+      current_ =
+          pmem_allocator_->offset2addr_checked<DLRecord>(current_->GetPrev());
     }
   }
 
@@ -261,12 +272,14 @@ class DLListRecordIterator {
 
   void SeekToFirst() {
     kvdk_assert(header_ != nullptr, "");
-    current_ = pmem_allocator_->offset2addr_checked<DLRecord>(header_->next);
+    current_ =
+        pmem_allocator_->offset2addr_checked<DLRecord>(header_->GetNext());
   }
 
   void SeekToLast() {
     kvdk_assert(header_ != nullptr, "");
-    current_ = pmem_allocator_->offset2addr_checked<DLRecord>(header_->prev);
+    current_ =
+        pmem_allocator_->offset2addr_checked<DLRecord>(header_->GetPrev());
   }
 
   DLRecord* Record() { return Valid() ? current_ : nullptr; }
@@ -295,8 +308,9 @@ class DLListRecoveryUtils {
     // If only prev linkage is correct, then repair the next linkage
     if (CheckPrevLinkage(record)) {
       DLRecord* next =
-          pmem_allocator_->offset2addr_checked<DLRecord>(record->next);
-      next->PersistPrevNT(pmem_allocator_->addr2offset_checked(record));
+          pmem_allocator_->offset2addr_checked<DLRecord>(record->GetNext());
+      next->PersistPrevNT(pmem_allocator_->GetPersistPolicy(),
+                          pmem_allocator_->addr2offset_checked(record));
       return true;
     }
 
@@ -306,9 +320,9 @@ class DLListRecoveryUtils {
   bool CheckNextLinkage(DLRecord* record) {
     uint64_t offset = pmem_allocator_->addr2offset_checked(record);
     DLRecord* next =
-        pmem_allocator_->offset2addr_checked<DLRecord>(record->next);
+        pmem_allocator_->offset2addr_checked<DLRecord>(record->GetNext());
 
-    auto check_linkage = [&]() { return next->prev == offset; };
+    auto check_linkage = [&]() { return next->GetPrev() == offset; };
 
     auto check_type = [&]() { return CType::MatchType(record); };
 
@@ -324,9 +338,9 @@ class DLListRecoveryUtils {
   bool CheckPrevLinkage(DLRecord* record) {
     uint64_t offset = pmem_allocator_->addr2offset_checked(record);
     DLRecord* prev =
-        pmem_allocator_->offset2addr_checked<DLRecord>(record->prev);
+        pmem_allocator_->offset2addr_checked<DLRecord>(record->GetPrev());
 
-    auto check_linkage = [&]() { return prev->next == offset; };
+    auto check_linkage = [&]() { return prev->GetNext() == offset; };
 
     auto check_type = [&]() { return CType::MatchType(record); };
 
@@ -4,6 +4,8 @@
 
 #include "hash_list.hpp"
 
+#include "../utils/trace.hpp"
+
 namespace KVDK_NAMESPACE {
 HashList::WriteResult HashList::Put(const StringView& key,
                                     const StringView& value,
@@ -38,6 +40,19 @@ Status HashList::Get(const StringView& key, std::string* value) {
   }
 }
 
+bool HashList::Contains(const StringView& key) {
+  std::string internal_key(InternalKey(key));
+  auto lookup_result =
+      hash_table_->Lookup<false>(internal_key, RecordType::HashElem);
+  if (lookup_result.s != Status::Ok ||
+      lookup_result.entry.GetRecordStatus() == RecordStatus::Outdated) {
+    return false;
+  }
+  // As lookup is lockless, the elem may be deleted after we get it
+  return lookup_result.entry.GetIndex().dl_record->GetRecordStatus() !=
+         RecordStatus::Outdated;
+}
+
 HashList::WriteResult HashList::Delete(const StringView& key,
                                        TimestampType timestamp) {
   WriteResult ret;
@@ -83,8 +98,8 @@ HashList::WriteResult HashList::Modify(const StringView key,
       HashWriteArgs args = InitWriteArgs(key, new_value, WriteOp::Put);
       args.ts = ts;
       args.lookup_result = lookup_result;
-      args.space = pmem_allocator_->Allocate(
-          DLRecord::RecordSize(internal_key, new_value));
+      args.space =
+          pmem_allocator_->Allocate(elemRecordSize(internal_key, new_value));
       if (args.space.size == 0) {
         ret.s = Status::PmemOverflow;
         return ret;
@@ -96,8 +111,7 @@ HashList::WriteResult HashList::Modify(const StringView key,
       HashWriteArgs args = InitWriteArgs(key, "", WriteOp::Delete);
       args.ts = ts;
       args.lookup_result = lookup_result;
-      args.space =
-          pmem_allocator_->Allocate(DLRecord::RecordSize(internal_key, ""));
+      args.space = pmem_allocator_->Allocate(elemRecordSize(internal_key, ""));
       if (args.space.size == 0) {
         ret.s = Status::PmemOverflow;
         return ret;
@@ -150,6 +164,7 @@ Status HashList::PrepareWrite(HashWriteArgs& args, TimestampType ts) {
     args.lookup_result =
         hash_table_->Lookup<true>(internal_key, RecordType::HashElem);
   }
+  Tracer::Stage("lookup");
 
   switch (args.lookup_result.s) {
     case Status::Ok: {
@@ -173,8 +188,10 @@ Status HashList::PrepareWrite(HashWriteArgs& args, TimestampType ts) {
   }
 
   if (allocate_space) {
-    auto request_size = DLRecord::RecordSize(internal_key, args.value);
+    auto request_size =
+        elemRecordSize(internal_key, args.value) + args.padding;
     args.space = pmem_allocator_->Allocate(request_size);
+    Tracer::Stage("allocate");
     if (args.space.size == 0) {
       return Status::PmemOverflow;
     }
@@ -217,9 +234,11 @@ HashList::WriteResult HashList::SetExpireTime(ExpireTimeType expired_time,
     return ret;
   }
   DLRecord* pmem_record = DLRecord::PersistDLRecord(
+      pmem_allocator_->GetPersistPolicy(),
       pmem_allocator_->offset2addr_checked(space.offset), space.size, timestamp,
       RecordType::HashRecord, RecordStatus::Normal,
-      pmem_allocator_->addr2offset_checked(header), header->prev, header->next,
+      pmem_allocator_->addr2offset_checked(header), header->GetPrev(),
+      header->GetNext(),
       header->Key(), header->Value(), expired_time);
   bool success = dl_list_.Replace(header, pmem_record);
   kvdk_assert(success, "existing header should be linked on its list");
@@ -233,7 +252,8 @@ Status HashList::CheckIndex() {
   size_t cnt = 0;
   DLListRecoveryUtils<HashList> recovery_utils(pmem_allocator_);
   while (true) {
-    DLRecord* curr = pmem_allocator_->offset2addr_checked<DLRecord>(prev->next);
+    DLRecord* curr =
+        pmem_allocator_->offset2addr_checked<DLRecord>(prev->GetNext());
     if (curr == HeaderRecord()) {
       break;
     }
@@ -281,7 +301,8 @@ void HashList::Destroy() {
   if (header) {
     DLRecord* to_destroy = nullptr;
     do {
-      to_destroy = pmem_allocator_->offset2addr_checked<DLRecord>(header->next);
+      to_destroy =
+          pmem_allocator_->offset2addr_checked<DLRecord>(header->GetNext());
       StringView key = to_destroy->Key();
       auto ul = hash_table_->AcquireLock(key);
       if (dl_list_.Remove(to_destroy)) {
@@ -306,7 +327,7 @@ void HashList::Destroy() {
           }
         }
 
-        to_destroy->Destroy();
+        to_destroy->Destroy(pmem_allocator_->GetPersistPolicy());
         to_free.emplace_back(pmem_allocator_->addr2offset_checked(to_destroy),
                              to_destroy->GetRecordSize());
         if (to_free.size() > kMaxCachedOldRecords) {
@@ -325,7 +346,8 @@ void HashList::DestroyAll() {
   DLRecord* to_destroy = nullptr;
   kvdk_assert(header != nullptr, "");
   do {
-    to_destroy = pmem_allocator_->offset2addr_checked<DLRecord>(header->next);
+    to_destroy =
+        pmem_allocator_->offset2addr_checked<DLRecord>(header->GetNext());
     StringView key = to_destroy->Key();
     auto ul = hash_table_->AcquireLock(key);
     if (dl_list_.Remove(to_destroy)) {
@@ -350,18 +372,18 @@ void HashList::DestroyAll() {
         }
       }
       auto old_record =
-          pmem_allocator_->offset2addr<DLRecord>(to_destroy->old_version);
+          pmem_allocator_->offset2addr<DLRecord>(to_destroy->GetOldVersion());
       while (old_record) {
-        auto old_version = old_record->old_version;
+        auto old_version = old_record->GetOldVersion();
         to_free.emplace_back(pmem_allocator_->addr2offset_checked(old_record),
                              old_record->GetRecordSize());
-        old_record->Destroy();
+        old_record->Destroy(pmem_allocator_->GetPersistPolicy());
         old_record = pmem_allocator_->offset2addr<DLRecord>(old_version);
       }
 
       to_free.emplace_back(pmem_allocator_->addr2offset_checked(to_destroy),
                            to_destroy->GetRecordSize());
-      to_destroy->Destroy();
+      to_destroy->Destroy(pmem_allocator_->GetPersistPolicy());
       if (to_free.size() > kMaxCachedOldRecords) {
         pmem_allocator_->BatchFree(to_free);
         to_free.clear();
@@ -393,8 +415,10 @@ HashList::WriteResult HashList::putPrepared(
     Status s = push_back ? dl_list_.PushBack(args) : dl_list_.PushFront(args);
     kvdk_assert(s == Status::Ok, "");
   }
+  Tracer::Stage("persist");
   hash_table_->Insert(lookup_result, RecordType::HashElem, RecordStatus::Normal,
                       ret.write_record, PointerType::DLRecord);
+  Tracer::Stage("publish");
   return ret;
 }
 
@@ -407,7 +431,7 @@ HashList::WriteResult HashList::deletePrepared(
                   lookup_result.entry.GetRecordType() == RecordType::HashElem &&
                   lookup_result.entry.GetRecordStatus() == RecordStatus::Normal,
               "");
-  assert(space.size >= DLRecord::RecordSize(internal_key, ""));
+  assert(space.size >= elemRecordSize(internal_key, ""));
   ret.existing_record = lookup_result.entry.GetIndex().dl_record;
   kvdk_assert(timestamp > ret.existing_record->GetTimestamp(), "");
   DLList::WriteArgs args(internal_key, "", RecordType::HashElem,
@@ -415,11 +439,13 @@ HashList::WriteResult HashList::deletePrepared(
   while ((ret.s = dl_list_.Update(args, ret.existing_record)) != Status::Ok) {
     kvdk_assert(ret.s == Status::Fail, "");
   }
+  Tracer::Stage("persist");
   ret.write_record =
       pmem_allocator_->offset2addr_checked<DLRecord>(space.offset);
   hash_table_->Insert(lookup_result, RecordType::HashElem,
                       RecordStatus::Outdated, ret.write_record,
                       PointerType::DLRecord);
+  Tracer::Stage("publish");
   return ret;
 }
 
@@ -3,6 +3,8 @@
 #include "../dl_list.hpp"
 #include "../hash_table.hpp"
 #include "kvdk/types.hpp"
+#include "score_index.hpp"
+#include "time_series.hpp"
 
 namespace KVDK_NAMESPACE {
 
@@ -17,10 +19,24 @@ struct HashWriteArgs {
   SpaceEntry space;
   TimestampType ts;
   HashTable::LookupResult lookup_result;
+  // Extra space allocated after the record of a put, which is not covered by
+  // the record checksum, see TimeSeriesTail
+  uint32_t padding = 0;
 };
 
 class HashList : public Collection {
  public:
+  // Kind of collection indexed by a hash list. A set stores members as keys
+  // of elems with empty values, a sorted set stores members as keys of elems
+  // with encoded scores as values, a time series stores time buckets as elems
+  // with packed samples as values
+  enum class Kind : uint8_t {
+    Hash = 0,
+    Set = 1,
+    ZSet = 2,
+    TimeSeries = 3,
+  };
+
   struct WriteResult {
     Status s = Status::Ok;
     DLRecord* existing_record = nullptr;
@@ -35,7 +51,12 @@ class HashList : public Collection {
         dl_list_(header, pmem_allocator, lock_table),
         size_(0),
         pmem_allocator_(pmem_allocator),
-        hash_table_(hash_table) {}
+        hash_table_(hash_table),
+        kind_(DecodeKind(header->Value())),
+        score_index_(kind_ == Kind::ZSet ? new ScoreIndex() : nullptr),
+        ts_index_(kind_ == Kind::TimeSeries
+                      ? new TimeSeriesIndex(DecodeBucketWidth(header->Value()))
+                      : nullptr) {}
 
   ~HashList() final = default;
 
@@ -56,6 +77,18 @@ class HashList : public Collection {
   // Return number of valid data record in this hash list
   size_t Size() { return size_; }
 
+  Kind GetKind() const { return kind_; }
+
+  // Return the (score, member) index of a sorted set, or nullptr for other
+  // kinds
+  ScoreIndex* GetScoreIndex() { return score_index_.get(); }
+
+  // Return the bucket directory of a time series, or nullptr for other kinds
+  TimeSeriesIndex* GetTimeSeriesIndex() { return ts_index_.get(); }
+
+  // Check if "key" exists in the hash list without copying its value
+  bool Contains(const StringView& key);
+
   // Put "key, value" to the hash list
   //
   // Args:
@@ -171,6 +204,40 @@ class HashList : public Collection {
 
   static CollectionIDType FetchID(const DLRecord* record);
 
+  // Encode value of header record, which is the collection id followed by
+  // the kind and its arguments if it's not a plain hash for compatibility
+  static std::string EncodeHeaderValue(CollectionIDType id, Kind kind,
+                                       const StringView& kind_args = "") {
+    std::string value = EncodeID(id);
+    if (kind != Kind::Hash) {
+      value.push_back(static_cast<char>(kind));
+      value.append(kind_args.data(), kind_args.size());
+    }
+    return value;
+  }
+
+  // Return arguments of the kind in header value, e.g. bucket width of a
+  // time series
+  static StringView DecodeKindArgs(const StringView& header_value) {
+    constexpr size_t offset = sizeof(CollectionIDType) + sizeof(Kind);
+    return header_value.size() > offset
+               ? StringView(header_value.data() + offset,
+                            header_value.size() - offset)
+               : StringView();
+  }
+
+  static int64_t DecodeBucketWidth(const StringView& header_value) {
+    uint64_t width = 0;
+    DecodeUint64(DecodeKindArgs(header_value), &width);
+    return width > 0 ? static_cast<int64_t>(width) : 1;
+  }
+
+  static Kind DecodeKind(const StringView& header_value) {
+    return header_value.size() > sizeof(CollectionIDType)
+               ? static_cast<Kind>(header_value[sizeof(CollectionIDType)])
+               : Kind::Hash;
+  }
+
   static bool MatchType(const DLRecord* record) {
     RecordType type = record->GetRecordType();
     return type == RecordType::HashElem || type == RecordType::HashRecord;
@@ -182,9 +249,23 @@ class HashList : public Collection {
   std::atomic<size_t> size_;
   PMEMAllocator* pmem_allocator_;
   HashTable* hash_table_;
+  const Kind kind_;
+  std::unique_ptr<ScoreIndex> score_index_;
+  std::unique_ptr<TimeSeriesIndex> ts_index_;
   // to avoid illegal access caused by cleaning skiplist by multi-thread
   SpinMutex cleaning_lock_;
 
+  // Size of space to allocate for an elem record. Members of a set have no
+  // value, so they are always stored in the compact layout if supported,
+  // which nearly halves space of a short member
+  uint32_t elemRecordSize(const StringView& internal_key,
+                          const StringView& value) const {
+    return kind_ == Kind::Set && pmem_allocator_->CompactRecordsSupported()
+               ? DLRecord::CompactRecordSize(internal_key, value)
+               : pmem_allocator_->DLRecordSize(RecordType::HashElem,
+                                               internal_key, value);
+  }
+
   WriteResult putPrepared(const HashTable::LookupResult& lookup_result,
                           const StringView& key, const StringView& value,
                           TimestampType timestamp, const SpaceEntry& space);
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <future>
+#include <unordered_set>
 
 #include "../alias.hpp"
 #include "../write_batch_impl.hpp"
@@ -22,15 +23,25 @@ class HashListRebuilder {
         rebuilt_hlists;
   };
 
+  // segment_based_rebuild: split hash lists into segments at sampled elems
+  // and rebuild segments in parallel, optimized for a few large hash lists
+  // num_restore_threads: number of threads that add records to rebuilder
+  // num_rebuild_threads: max number of threads that rebuild index in Rebuild()
+  // first_rebuild_tid: rebuild threads use thread ids in [first_rebuild_tid,
+  // first_rebuild_tid + num_rebuild_threads)
   HashListRebuilder(PMEMAllocator* pmem_allocator, HashTable* hash_table,
-                    LockTable* lock_table, uint64_t num_rebuild_threads,
-                    const CheckPoint& checkpoint)
+                    LockTable* lock_table, bool segment_based_rebuild,
+                    uint64_t num_restore_threads, uint64_t num_rebuild_threads,
+                    uint64_t first_rebuild_tid, const CheckPoint& checkpoint)
       : recovery_utils_(pmem_allocator),
-        rebuilder_thread_cache_(num_rebuild_threads),
+        rebuilder_thread_cache_(
+            std::max(num_restore_threads, num_rebuild_threads)),
         pmem_allocator_(pmem_allocator),
         hash_table_(hash_table),
         lock_table_(lock_table),
+        segment_based_rebuild_(segment_based_rebuild),
         num_rebuild_threads_(num_rebuild_threads),
+        first_rebuild_tid_(first_rebuild_tid),
         checkpoint_(checkpoint) {}
 
   Status AddElem(DLRecord* elem_record) {
@@ -44,6 +55,8 @@ class HashListRebuilder {
       } else {
         pmem_allocator_->PurgeAndFree<DLRecord>(elem_record);
       }
+    } else if (segment_based_rebuild_) {
+      maybeAddRecoverySegment(elem_record);
     }
     return Status::Ok;
   }
@@ -60,33 +73,37 @@ class HashListRebuilder {
         pmem_allocator_->PurgeAndFree<DLRecord>(header_record);
       }
     } else {
+      std::lock_guard<SpinMutex> lg(lock_);
       linked_headers_.emplace_back(header_record);
     }
     return Status::Ok;
   }
 
+  // Build collection structs and hash index for valid headers, so ids of
+  // recovered collections are known before elems are indexed. It's called by
+  // Rebuild() if not called in advance
+  Status Prepare() {
+    if (!prepared_) {
+      Status s = initRebuildLists();
+      if (s != Status::Ok) {
+        return s;
+      }
+      prepared_ = true;
+    }
+    return Status::Ok;
+  }
+
+  // Max id of recovered collections, valid after Prepare()
+  CollectionIDType MaxRecoveredID() { return max_recovered_id_; }
+
   RebuildResult Rebuild() {
     RebuildResult ret;
-    ret.s = initRebuildLists();
+    ret.s = Prepare();
     if (ret.s != Status::Ok) {
       return ret;
     }
-    std::vector<std::future<Status>> fs;
-    size_t i = 0;
-    for (auto hlist : rebuild_hlists_) {
-      i++;
-      fs.push_back(std::async(&HashListRebuilder::rebuildIndex, this,
-                              hlist.second.get()));
-      if (i % num_rebuild_threads_ == 0 || i == rebuild_hlists_.size()) {
-        for (auto& f : fs) {
-          ret.s = f.get();
-          if (ret.s != Status::Ok) {
-            break;
-          }
-        }
-        fs.clear();
-      }
-    }
+    ret.s = segment_based_rebuild_ ? segmentBasedIndexRebuild()
+                                   : listBasedIndexRebuild();
 
     if (ret.s == Status::Ok) {
       ret.rebuilt_hlists.swap(rebuild_hlists_);
@@ -100,11 +117,13 @@ class HashListRebuilder {
     DLRecord* elem = pmem_allocator_->offset2addr_checked<DLRecord>(log.offset);
     // We only check prev linkage as a valid prev linkage indicate valid prev
     // and next pointers on the record, so we can safely do remove/replace
-    if (elem->Validate() && recovery_utils_.CheckPrevLinkage(elem)) {
-      if (elem->old_version != kNullPMemOffset) {
+    if (elem->Validate(pmem_allocator_->GetPersistPolicy()) &&
+        recovery_utils_.CheckPrevLinkage(elem)) {
+      if (elem->GetOldVersion() != kNullPMemOffset) {
         bool success = DLList::Replace(
             elem,
-            pmem_allocator_->offset2addr_checked<DLRecord>(elem->old_version),
+            pmem_allocator_->offset2addr_checked<DLRecord>(
+                elem->GetOldVersion()),
             pmem_allocator_, lock_table_);
         kvdk_assert(success, "Replace should success as we checked linkage");
       } else {
@@ -113,7 +132,7 @@ class HashListRebuilder {
       }
     }
 
-    elem->Destroy();
+    elem->Destroy(pmem_allocator_->GetPersistPolicy());
     return Status::Ok;
   }
 
@@ -140,15 +159,16 @@ class HashListRebuilder {
         // There are newer version of this header, it indicates system crashed
         // while updating header of a empty skiplist in previous run before
         // break header linkage.
-        kvdk_assert(header_record->prev == header_record->next &&
-                        header_record->prev ==
+        kvdk_assert(header_record->GetPrev() == header_record->GetNext() &&
+                        header_record->GetPrev() ==
                             pmem_allocator_->addr2offset(header_record),
                     "outdated header record with valid linkage should always "
                     "point to it self");
         // Break the linkage
         auto newer_offset =
             pmem_allocator_->addr2offset(linked_headers_[i + 1]);
-        header_record->PersistPrevNT(newer_offset);
+        header_record->PersistPrevNT(
+            pmem_allocator_->GetPersistPolicy(), newer_offset);
         kvdk_assert(!recovery_utils_.CheckPrevLinkage(header_record) &&
                         !recovery_utils_.CheckNextLinkage(header_record),
                     "");
@@ -199,7 +219,8 @@ class HashListRebuilder {
           }
         }
         // TODO no need always to persist old version
-        valid_version_record->PersistOldVersion(kNullPMemOffset);
+        valid_version_record->PersistOldVersion(
+            pmem_allocator_->GetPersistPolicy(), kNullPMemOffset);
 
         if (!outdated) {
           auto lookup_result = hash_table_->Insert(
@@ -236,8 +257,9 @@ class HashListRebuilder {
     DLRecord* curr = pmem_record;
     while (curr != nullptr &&
            curr->GetTimestamp() > checkpoint_.CheckpointTS()) {
-      curr = pmem_allocator_->offset2addr<DLRecord>(curr->old_version);
-      kvdk_assert(curr == nullptr || curr->Validate(),
+      curr = pmem_allocator_->offset2addr<DLRecord>(curr->GetOldVersion());
+      kvdk_assert(curr == nullptr ||
+                      curr->Validate(pmem_allocator_->GetPersistPolicy()),
                   "Broken checkpoint: invalid older version sorted record");
       kvdk_assert(
           curr == nullptr || equal_string_view(curr->Key(), pmem_record->Key()),
@@ -251,8 +273,83 @@ class HashListRebuilder {
     return curr;
   }
 
+  // Rebuild index of every hlist in a thread
+  Status listBasedIndexRebuild() {
+    Status s = Status::Ok;
+    std::vector<std::future<Status>> fs;
+    size_t i = 0;
+    for (auto hlist : rebuild_hlists_) {
+      i++;
+      fs.push_back(std::async(&HashListRebuilder::rebuildIndex, this,
+                              hlist.second.get()));
+      if (i % num_rebuild_threads_ == 0 || i == rebuild_hlists_.size()) {
+        for (auto& f : fs) {
+          s = f.get();
+          if (s != Status::Ok) {
+            break;
+          }
+        }
+        fs.clear();
+      }
+    }
+    return s;
+  }
+
+  // Rebuild index of hlist segments in parallel, a segment starts from a
+  // header or a sampled elem, and ends before start of next segment
+  Status segmentBasedIndexRebuild() {
+    GlobalLogger.Info("segment based hash list rebuild start\n");
+    for (auto& hlist : rebuild_hlists_) {
+      recovery_segments_.insert(hlist.second->HeaderRecord());
+    }
+    std::vector<DLRecord*> segment_starts(recovery_segments_.begin(),
+                                          recovery_segments_.end());
+    std::atomic<size_t> next_segment{0};
+
+    auto rebuild_segments_index = [&]() -> Status {
+      this_thread.id = first_rebuild_tid_ +
+                       next_tid_.fetch_add(1) % num_rebuild_threads_;
+      while (true) {
+        size_t i = next_segment.fetch_add(1);
+        if (i >= segment_starts.size()) {
+          return Status::Ok;
+        }
+        auto hlist_iter =
+            rebuild_hlists_.find(HashList::FetchID(segment_starts[i]));
+        if (hlist_iter == rebuild_hlists_.end()) {
+          // this start point belong to a invalid hlist
+          continue;
+        }
+        Status s =
+            rebuildSegmentIndex(segment_starts[i], hlist_iter->second.get());
+        if (s != Status::Ok) {
+          return s;
+        }
+      }
+    };
+
+    std::vector<std::future<Status>> fs;
+    for (uint32_t i = 0; i < num_rebuild_threads_; i++) {
+      fs.push_back(std::async(rebuild_segments_index));
+    }
+    Status ret = Status::Ok;
+    for (auto& f : fs) {
+      Status s = f.get();
+      if (s != Status::Ok) {
+        ret = s;
+      }
+    }
+    recovery_segments_.clear();
+    GlobalLogger.Info("segment based hash list rebuild done\n");
+    return ret;
+  }
+
   Status rebuildIndex(HashList* hlist) {
-    this_thread.id = next_tid_.fetch_add(1);
+    // Keep ids of rebuild threads in [first_rebuild_tid_, first_rebuild_tid_ +
+    // num_rebuild_threads_), so they only touch thread caches reserved for
+    // recovery
+    this_thread.id =
+        first_rebuild_tid_ + next_tid_.fetch_add(1) % num_rebuild_threads_;
 
     size_t num_elems = 0;
 
@@ -261,49 +358,98 @@ class HashListRebuilder {
     while (iter->Valid()) {
       DLRecord* curr = iter->Record();
       iter->Next();
-      auto internal_key = curr->Key();
-      auto ul = hash_table_->AcquireLock(internal_key);
-      DLRecord* valid_version_record = findCheckpointVersion(curr);
-      if (valid_version_record == nullptr ||
-          valid_version_record->GetRecordStatus() == RecordStatus::Outdated) {
-        bool success = hlist->GetDLList()->Remove(curr);
+      Status s = rebuildElemIndex(hlist, curr, &num_elems);
+      if (s != Status::Ok) {
+        return s;
+      }
+    }
+    hlist->UpdateSize(num_elems);
+    return Status::Ok;
+  }
+
+  Status rebuildSegmentIndex(DLRecord* start_record, HashList* hlist) {
+    size_t num_elems = 0;
+    DLRecord* header = hlist->HeaderRecord();
+    DLRecord* curr = start_record;
+    if (start_record == header) {
+      curr = pmem_allocator_->offset2addr_checked<DLRecord>(header->GetNext());
+    }
+    // Start record of a segment is always a valid version, so it is never
+    // removed or replaced by other rebuild threads
+    while (curr != header &&
+           (curr == start_record || recovery_segments_.count(curr) == 0)) {
+      DLRecord* next =
+          pmem_allocator_->offset2addr_checked<DLRecord>(curr->GetNext());
+      Status s = rebuildElemIndex(hlist, curr, &num_elems);
+      if (s != Status::Ok) {
+        return s;
+      }
+      curr = next;
+    }
+    hlist->UpdateSize(num_elems);
+    return Status::Ok;
+  }
+
+  // Remove or repair "elem" on "hlist" with its checkpoint version, and index
+  // the valid version in hash table
+  Status rebuildElemIndex(HashList* hlist, DLRecord* elem, size_t* num_elems) {
+    auto internal_key = elem->Key();
+    auto ul = hash_table_->AcquireLock(internal_key);
+    DLRecord* valid_version_record = findCheckpointVersion(elem);
+    if (valid_version_record == nullptr ||
+        valid_version_record->GetRecordStatus() == RecordStatus::Outdated) {
+      bool success = hlist->GetDLList()->Remove(elem);
+      kvdk_assert(success, "elems in rebuild should passed linkage check");
+      addUnlinkedRecord(elem);
+    } else {
+      if (valid_version_record != elem) {
+        bool success = hlist->GetDLList()->Replace(elem, valid_version_record);
         kvdk_assert(success, "elems in rebuild should passed linkage check");
-        addUnlinkedRecord(curr);
-      } else {
-        if (valid_version_record != curr) {
-          bool success =
-              hlist->GetDLList()->Replace(curr, valid_version_record);
-          kvdk_assert(success, "elems in rebuild should passed linkage check");
-          addUnlinkedRecord(curr);
+        addUnlinkedRecord(elem);
+      }
+      (*num_elems)++;
+
+      auto lookup_result = hash_table_->Insert(
+          internal_key, RecordType::HashElem, RecordStatus::Normal,
+          valid_version_record, PointerType::DLRecord);
+      switch (lookup_result.s) {
+        case Status::Ok: {
+          GlobalLogger.Error(
+              "Rebuild hlist error, hash entry of hlist records should "
+              "not be inserted before rebuild\n");
+          return Status::Abort;
         }
-        num_elems++;
-
-        auto lookup_result = hash_table_->Insert(
-            internal_key, RecordType::HashElem, RecordStatus::Normal,
-            valid_version_record, PointerType::DLRecord);
-        switch (lookup_result.s) {
-          case Status::Ok: {
-            GlobalLogger.Error(
-                "Rebuild hlist error, hash entry of hlist records should "
-                "not be inserted before rebuild\n");
-            return Status::Abort;
-          }
 
-          case Status::NotFound: {
-            break;
-          }
-          default: {
-            return lookup_result.s;
-          }
+        case Status::NotFound: {
+          break;
+        }
+        default: {
+          return lookup_result.s;
         }
-
-        valid_version_record->PersistOldVersion(kNullPMemOffset);
       }
+
+      valid_version_record->PersistOldVersion(
+          pmem_allocator_->GetPersistPolicy(), kNullPMemOffset);
     }
-    hlist->UpdateSize(num_elems);
     return Status::Ok;
   }
 
+  // Select a linked elem as a recovery segment start point every
+  // kRestoreListStride elems per hlist
+  void maybeAddRecoverySegment(DLRecord* elem_record) {
+    auto& thread_cache =
+        rebuilder_thread_cache_[ThreadManager::ThreadID() %
+                                rebuilder_thread_cache_.size()];
+    if (++thread_cache.visited_lists[HashList::FetchID(elem_record)] %
+                kRestoreListStride ==
+            0 &&
+        elem_record->GetRecordStatus() == RecordStatus::Normal &&
+        findCheckpointVersion(elem_record) == elem_record) {
+      std::lock_guard<SpinMutex> lg(lock_);
+      recovery_segments_.insert(elem_record);
+    }
+  }
+
   void addUnlinkedRecord(DLRecord* pmem_record) {
     kvdk_assert(ThreadManager::ThreadID() >= 0, "");
     rebuilder_thread_cache_[ThreadManager::ThreadID() %
@@ -318,7 +464,7 @@ class HashListRebuilder {
     for (auto& thread_cache : rebuilder_thread_cache_) {
       for (DLRecord* pmem_record : thread_cache.unlinked_records) {
         if (!recovery_utils_.CheckLinkage(pmem_record)) {
-          pmem_record->Destroy();
+          pmem_record->Destroy(pmem_allocator_->GetPersistPolicy());
           to_free.emplace_back(
               pmem_allocator_->addr2offset_checked(pmem_record),
               pmem_record->GetRecordSize());
@@ -337,6 +483,9 @@ class HashListRebuilder {
   }
 
   struct ThreadCache {
+    // For segment based rebuild
+    std::unordered_map<CollectionIDType, uint64_t> visited_lists{};
+
     std::vector<DLRecord*> unlinked_records{};
   };
 
@@ -346,18 +495,27 @@ class HashListRebuilder {
   PMEMAllocator* pmem_allocator_;
   HashTable* hash_table_;
   LockTable* lock_table_;
+  const bool segment_based_rebuild_;
   const size_t num_rebuild_threads_;
+  const uint64_t first_rebuild_tid_;
   CheckPoint checkpoint_;
   SpinMutex lock_;
   std::unordered_map<CollectionIDType, std::shared_ptr<HashList>>
       invalid_hlists_;
   std::unordered_map<CollectionIDType, std::shared_ptr<HashList>>
       rebuild_hlists_;
-  CollectionIDType max_recovered_id_;
+  // Start records of segments for segment based rebuild
+  std::unordered_set<DLRecord*> recovery_segments_;
+  CollectionIDType max_recovered_id_ = 0;
+  bool prepared_ = false;
 
   // We manually allocate recovery thread id for no conflict in multi-thread
   // recovering
   // Todo: do not hard code
   std::atomic<uint64_t> next_tid_{0};
+
+  // Select elements as a segment start point for segment based rebuild every
+  // kRestoreListStride elements per hlist
+  const uint64_t kRestoreListStride = 10000;
 };
 }  // namespace KVDK_NAMESPACE
\ No newline at end of file
@@ -0,0 +1,129 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#pragma once
+
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "../alias.hpp"
+#include "../utils/utils.hpp"
+
+namespace KVDK_NAMESPACE {
+
+// DRAM index of a sorted set ordered by (score, member).
+//
+// Members and their scores are persisted as elems of a hash list, which also
+// indexes members by the hash table. This index is an order statistics tree
+// over the same members, so range and rank queries cost O(log n) rather than
+// a scan of the hash list. It's not persisted and built from the hash list on
+// first access after recovery.
+//
+// Writers should update the index after persisting the elem while holding
+// lock of the member, queries see a consistent view under the shared lock.
+class ScoreIndex {
+ public:
+  using Entry = std::pair<double, std::string>;
+
+  // Insert all members visited by "scan" if not built, "scan" should call its
+  // argument on each (score, member) of the newest version of the hash list.
+  //
+  // Notice: the newest version should be fetched inside "scan", so writers
+  // updated the index before building have their elems scanned
+  template <typename ScanFunc>
+  void Build(ScanFunc&& scan) {
+    std::lock_guard<RWLock> lg(lock_);
+    if (built_) {
+      return;
+    }
+    scan([&](double score, const StringView& member) {
+      tree_.insert(Entry(score, string_view_2_string(member)));
+    });
+    built_ = true;
+  }
+
+  bool Built() {
+    auto sl = LockShared(lock_);
+    return built_;
+  }
+
+  // Replace (old_score, member) with (new_score, member), old one is skipped
+  // if not "existed". Do nothing if the index is not built yet, as the member
+  // will be scanned by Build()
+  void Update(const StringView& member, bool existed, double old_score,
+              double new_score) {
+    std::string m = string_view_2_string(member);
+    std::lock_guard<RWLock> lg(lock_);
+    if (!built_) {
+      return;
+    }
+    if (existed) {
+      tree_.erase(Entry(old_score, m));
+    }
+    tree_.insert(Entry(new_score, std::move(m)));
+  }
+
+  void Erase(const StringView& member, double score) {
+    std::lock_guard<RWLock> lg(lock_);
+    if (built_) {
+      tree_.erase(Entry(score, string_view_2_string(member)));
+    }
+  }
+
+  // Store 0-based rank of (score, member) in *rank, return false if it's not
+  // indexed, e.g. a writer updated the member but not the index yet
+  bool Rank(const StringView& member, double score, size_t* rank) {
+    Entry entry(score, string_view_2_string(member));
+    auto sl = LockShared(lock_);
+    auto iter = tree_.find(entry);
+    if (iter == tree_.end()) {
+      return false;
+    }
+    *rank = tree_.order_of_key(entry);
+    return true;
+  }
+
+  // Call "visitor" on each (score, member) with score in [min_score,
+  // max_score] in ascending order, stop if it returns false
+  template <typename Visitor>
+  void RangeByScore(double min_score, double max_score, Visitor&& visitor) {
+    auto sl = LockShared(lock_);
+    for (auto iter = tree_.lower_bound(Entry(min_score, std::string()));
+         iter != tree_.end() && iter->first <= max_score; ++iter) {
+      if (!visitor(iter->first, StringView(iter->second))) {
+        break;
+      }
+    }
+  }
+
+  static std::string EncodeScore(double score) {
+    std::string ret(sizeof(double), 0);
+    memcpy(&ret[0], &score, sizeof(double));
+    return ret;
+  }
+
+  static bool DecodeScore(const StringView& src, double* score) {
+    if (src.size() != sizeof(double)) {
+      return false;
+    }
+    memcpy(score, src.data(), sizeof(double));
+    return true;
+  }
+
+ private:
+  using Tree = __gnu_pbds::tree<Entry, __gnu_pbds::null_type, std::less<Entry>,
+                                __gnu_pbds::rb_tree_tag,
+                                __gnu_pbds::tree_order_statistics_node_update>;
+
+  RWLock lock_;
+  bool built_ = false;
+  Tree tree_;
+};
+
+}  // namespace KVDK_NAMESPACE
@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#pragma once
+
+#include <immintrin.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "../alias.hpp"
+
+namespace KVDK_NAMESPACE {
+
+// Intersect two ascending arrays of unique integers, store common ones to
+// "out" in ascending order.
+//
+// Each element of "a" is compared with a block of 4 elements of "b" at a time
+// with AVX2, which branches much less than a scalar merge. Put the smaller
+// array in "a" for the best performance.
+inline void IntersectSortedUint64(const uint64_t* a, size_t na,
+                                  const uint64_t* b, size_t nb,
+                                  std::vector<uint64_t>* out) {
+  size_t i = 0;
+  size_t j = 0;
+#ifdef __AVX2__
+  // Elems of b before j are all smaller than a[i]
+  while (i < na && j + 4 <= nb) {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+    __m256i target = _mm256_set1_epi64x(static_cast<long long>(a[i]));
+    int match = _mm256_movemask_pd(
+        _mm256_castsi256_pd(_mm256_cmpeq_epi64(target, block)));
+    if (a[i] > b[j + 3]) {
+      j += 4;
+    } else {
+      if (match) {
+        out->push_back(a[i]);
+      }
+      i++;
+    }
+  }
+#endif
+  while (i < na && j < nb) {
+    if (a[i] < b[j]) {
+      i++;
+    } else if (a[i] > b[j]) {
+      j++;
+    } else {
+      out->push_back(a[i]);
+      i++;
+      j++;
+    }
+  }
+}
+
+}  // namespace KVDK_NAMESPACE
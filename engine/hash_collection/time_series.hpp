@@ -0,0 +1,319 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#pragma once
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../alias.hpp"
+#include "../data_record.hpp"
+#include "../utils/codec.hpp"
+#include "../utils/utils.hpp"
+
+namespace KVDK_NAMESPACE {
+
+// Bounds of number of samples of a tail reserved when a bucket is written
+constexpr size_t kMinTimeSeriesTail = 16;
+constexpr size_t kMaxTimeSeriesTail = 4096;
+
+// Samples of a time bucket in columnar layout, ascending by timestamp. It's
+// encoded as value of a hash list elem: all timestamps followed by all values,
+// and samples appended later are in the TimeSeriesTail of the elem record
+struct TimeSeriesBucket {
+  std::vector<int64_t> timestamps;
+  std::vector<double> values;
+
+  size_t Size() const { return timestamps.size(); }
+
+  // Insert a sample, or overwrite value of an existing timestamp
+  void Insert(int64_t timestamp, double value) {
+    auto iter =
+        std::lower_bound(timestamps.begin(), timestamps.end(), timestamp);
+    size_t pos = iter - timestamps.begin();
+    if (iter != timestamps.end() && *iter == timestamp) {
+      values[pos] = value;
+    } else {
+      timestamps.insert(iter, timestamp);
+      values.insert(values.begin() + pos, value);
+    }
+  }
+
+  std::string Encode() const {
+    std::string ret(Size() * (sizeof(int64_t) + sizeof(double)), 0);
+    memcpy(&ret[0], timestamps.data(), Size() * sizeof(int64_t));
+    memcpy(&ret[Size() * sizeof(int64_t)], values.data(),
+           Size() * sizeof(double));
+    return ret;
+  }
+
+  bool Decode(const StringView& src) {
+    if (src.size() % (sizeof(int64_t) + sizeof(double)) != 0) {
+      return false;
+    }
+    size_t n = src.size() / (sizeof(int64_t) + sizeof(double));
+    timestamps.resize(n);
+    values.resize(n);
+    memcpy(timestamps.data(), src.data(), n * sizeof(int64_t));
+    memcpy(values.data(), src.data() + n * sizeof(int64_t),
+           n * sizeof(double));
+    return true;
+  }
+
+  // Decode samples of a bucket elem record, including its tail
+  bool Load(const DLRecord* record);
+
+  // Get the last timestamp of an encoded bucket, return false if it's empty
+  static bool LastTimestamp(const StringView& src, int64_t* timestamp) {
+    size_t n = src.size() / (sizeof(int64_t) + sizeof(double));
+    if (n == 0) {
+      return false;
+    }
+    memcpy(timestamp, src.data() + (n - 1) * sizeof(int64_t),
+           sizeof(int64_t));
+    return true;
+  }
+};
+
+// Samples appended in place to a bucket elem record, so appending in
+// timestamp order doesn't rewrite the bucket. They are stored as fixed
+// capacity timestamp and value columns in padding reserved after the record
+// data, which is not covered by the record checksum, headed by a word of a
+// tag and the number of samples. A sample is persisted before the word that
+// counts it, so it's either appended or not after a crash.
+//
+// The tag is derived from the record timestamp, so the padding of a record
+// written without a tail, e.g. by restoring a backup, is not taken as one.
+class TimeSeriesTail {
+ public:
+  static constexpr size_t kSampleSize = sizeof(int64_t) + sizeof(double);
+
+  explicit TimeSeriesTail(const DLRecord* record)
+      : TimeSeriesTail(
+            reinterpret_cast<const char*>(record), record->GetRecordSize(),
+            DLRecord::RecordSize(record->Key(), record->Value()),
+            record->GetTimestamp()) {}
+
+  // Padding to reserve after a record in the full layout for a tail of
+  // "capacity" samples
+  static uint32_t ReserveSize(size_t capacity) {
+    return alignof(uint64_t) - 1 + sizeof(uint64_t) + capacity * kSampleSize;
+  }
+
+  // Init an empty tail in the padding of a record of "data_size" bytes in the
+  // full layout, which will be persisted to "addr" with "record_size" bytes
+  // and "timestamp". Should be called before the record is persisted
+  static void Init(const PersistPolicy& policy, char* addr,
+                   uint32_t record_size, uint32_t data_size,
+                   TimestampType timestamp) {
+    TimeSeriesTail tail(addr, record_size, data_size, timestamp);
+    if (tail.capacity_ > 0) {
+      policy.StoreNT(tail.word_, tail.encode(0));
+    }
+  }
+
+  size_t Capacity() const { return capacity_; }
+
+  size_t Size() const {
+    if (capacity_ == 0) {
+      return 0;
+    }
+    uint64_t word = __atomic_load_n(word_, __ATOMIC_ACQUIRE);
+    if ((word >> 32) != tag_ || (word & UINT32_MAX) > capacity_) {
+      return 0;
+    }
+    return word & UINT32_MAX;
+  }
+
+  // Get the last timestamp of the tail, return false if it's empty
+  bool LastTimestamp(int64_t* timestamp) const {
+    size_t n = Size();
+    if (n == 0) {
+      return false;
+    }
+    *timestamp = timestamps()[n - 1];
+    return true;
+  }
+
+  // Append a sample, return false if the tail is full. Appending should be
+  // serialized and in timestamp order, while reading is lockless
+  bool Append(const PersistPolicy& policy, int64_t timestamp, double value) {
+    size_t n = Size();
+    if (n >= capacity_) {
+      return false;
+    }
+    timestamps()[n] = timestamp;
+    values()[n] = value;
+    policy.Persist(&timestamps()[n], sizeof(int64_t));
+    policy.Persist(&values()[n], sizeof(double));
+    policy.StoreNT(word_, encode(n + 1));
+    return true;
+  }
+
+  // Append samples of the tail to "bucket"
+  void AppendTo(TimeSeriesBucket* bucket) const {
+    size_t n = Size();
+    bucket->timestamps.insert(bucket->timestamps.end(), timestamps(),
+                              timestamps() + n);
+    bucket->values.insert(bucket->values.end(), values(), values() + n);
+  }
+
+ private:
+  static constexpr uint32_t kMagic = 0x4c494154;  // "TAIL"
+
+  TimeSeriesTail(const char* addr, uint32_t record_size, uint32_t data_size,
+                 TimestampType timestamp)
+      : tag_(static_cast<uint32_t>(timestamp ^ (timestamp >> 32)) ^ kMagic) {
+    uintptr_t begin = reinterpret_cast<uintptr_t>(addr) + data_size;
+    begin = (begin + alignof(uint64_t) - 1) & ~(alignof(uint64_t) - 1);
+    uintptr_t end = reinterpret_cast<uintptr_t>(addr) + record_size;
+    word_ = reinterpret_cast<uint64_t*>(begin);
+    capacity_ = end >= begin + sizeof(uint64_t)
+                    ? (end - begin - sizeof(uint64_t)) / kSampleSize
+                    : 0;
+  }
+
+  uint64_t encode(size_t size) const {
+    return (static_cast<uint64_t>(tag_) << 32) | size;
+  }
+
+  int64_t* timestamps() const { return reinterpret_cast<int64_t*>(word_ + 1); }
+
+  double* values() const {
+    return reinterpret_cast<double*>(word_ + 1 + capacity_);
+  }
+
+  uint64_t* word_;
+  size_t capacity_;
+  uint32_t tag_;
+};
+
+inline bool TimeSeriesBucket::Load(const DLRecord* record) {
+  if (!Decode(record->Value())) {
+    return false;
+  }
+  TimeSeriesTail(record).AppendTo(this);
+  return true;
+}
+
+// Sum, min and max of "n" doubles. Reduced 4 lanes at a time with AVX2,
+// which is the hot loop of aggregating packed buckets
+inline void ReduceDoubles(const double* values, size_t n, double* sum,
+                          double* min, double* max) {
+  double s = 0;
+  double mn = std::numeric_limits<double>::infinity();
+  double mx = -std::numeric_limits<double>::infinity();
+  size_t i = 0;
+#ifdef __AVX2__
+  if (n >= 4) {
+    __m256d vs = _mm256_setzero_pd();
+    __m256d vmn = _mm256_set1_pd(mn);
+    __m256d vmx = _mm256_set1_pd(mx);
+    for (; i + 4 <= n; i += 4) {
+      __m256d v = _mm256_loadu_pd(values + i);
+      vs = _mm256_add_pd(vs, v);
+      vmn = _mm256_min_pd(vmn, v);
+      vmx = _mm256_max_pd(vmx, v);
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, vs);
+    s = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm256_store_pd(lanes, vmn);
+    mn = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+    _mm256_store_pd(lanes, vmx);
+    mx = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+  }
+#endif
+  for (; i < n; i++) {
+    s += values[i];
+    mn = std::min(mn, values[i]);
+    mx = std::max(mx, values[i]);
+  }
+  *sum = s;
+  *min = mn;
+  *max = mx;
+}
+
+// DRAM directory of a time series, which tracks ids of existing buckets in
+// order so range queries visit only non-empty buckets. Bucket i holds
+// samples with timestamp in [i * bucket_width, (i + 1) * bucket_width).
+//
+// It's not persisted and built from the hash list on first access after
+// recovery, writers add new buckets after persisting them.
+class TimeSeriesIndex {
+ public:
+  explicit TimeSeriesIndex(int64_t bucket_width)
+      : bucket_width_(bucket_width) {}
+
+  int64_t BucketWidth() const { return bucket_width_; }
+
+  int64_t BucketOf(int64_t timestamp) const {
+    int64_t q = timestamp / bucket_width_;
+    // Round toward negative infinity for negative timestamps
+    return (timestamp % bucket_width_ != 0 && timestamp < 0) ? q - 1 : q;
+  }
+
+  // Insert buckets visited by "scan" if not built, "scan" should call its
+  // argument on each bucket id of the newest version of the hash list
+  template <typename ScanFunc>
+  void Build(ScanFunc&& scan) {
+    std::lock_guard<RWLock> lg(lock_);
+    if (built_) {
+      return;
+    }
+    scan([&](int64_t bucket) { buckets_.insert(bucket); });
+    built_ = true;
+  }
+
+  bool Built() {
+    auto sl = LockShared(lock_);
+    return built_;
+  }
+
+  // Add a bucket if the index is built, otherwise it will be scanned by
+  // Build()
+  void AddBucket(int64_t bucket) {
+    std::lock_guard<RWLock> lg(lock_);
+    if (built_) {
+      buckets_.insert(bucket);
+    }
+  }
+
+  // Ids of existing buckets overlapped with [start, end]
+  std::vector<int64_t> BucketsIn(int64_t start, int64_t end) {
+    std::vector<int64_t> ret;
+    auto sl = LockShared(lock_);
+    for (auto iter = buckets_.lower_bound(BucketOf(start));
+         iter != buckets_.end() && *iter <= BucketOf(end); ++iter) {
+      ret.push_back(*iter);
+    }
+    return ret;
+  }
+
+  static std::string EncodeBucketKey(int64_t bucket) {
+    return EncodeUint64(static_cast<uint64_t>(bucket));
+  }
+
+  static int64_t DecodeBucketKey(const StringView& key) {
+    uint64_t bucket = 0;
+    DecodeUint64(key, &bucket);
+    return static_cast<int64_t>(bucket);
+  }
+
+ private:
+  const int64_t bucket_width_;
+  RWLock lock_;
+  bool built_ = false;
+  std::set<int64_t> buckets_;
+};
+
+}  // namespace KVDK_NAMESPACE
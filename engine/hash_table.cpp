@@ -97,6 +97,7 @@ HashTable::LookupResult HashTable::Lookup(const StringView& key,
   LookupResult ret;
   HashEntry* empty_entry = nullptr;
   auto hint = getHint(key);
+  hot_keys_.SampleLookup(key, hint.hash, may_insert);
   ret.key_hash_prefix = hint.key_hash_prefix;
 
   HashBucket* bucket_ptr = &hash_buckets_[hint.bucket];
@@ -150,6 +151,20 @@ HashTable::LookupResult HashTable::Lookup(const StringView& key,
   return ret;
 }
 
+void HashTable::PrefetchIndex(const StringView& key, uint8_t type_mask) {
+  auto hint = getHint(key);
+  HashBucketIterator iter(this, hint.bucket);
+  while (iter.Valid()) {
+    HashEntry entry(*iter);
+    if ((entry.header_.record_type & type_mask) &&
+        entry.header_.key_prefix == hint.key_hash_prefix &&
+        !entry.Empty() && !entry.Allocated()) {
+      _mm_prefetch(entry.GetIndex().ptr, _MM_HINT_T0);
+    }
+    iter++;
+  }
+}
+
 template HashTable::LookupResult HashTable::Lookup<true>(const StringView&,
                                                          uint8_t);
 template HashTable::LookupResult HashTable::Lookup<false>(const StringView&,
@@ -196,6 +211,57 @@ Status HashTable::allocateEntry(HashBucketIterator& bucket_iter) {
   return Status::Ok;
 }
 
+void HashTable::SampleStats(uint64_t max_samples, Statistics* stats) {
+  uint64_t step = std::max<uint64_t>(num_hash_buckets_ / max_samples, 1);
+  uint64_t samples = 0;
+  uint64_t used_entries = 0;
+  uint64_t chained_buckets = 0;
+  uint64_t max_chain_length = 0;
+  for (uint64_t b = 0; b < num_hash_buckets_; b += step) {
+    uint64_t allocated = hash_bucket_entries_[b];
+    HashBucketIterator iter(this, b);
+    while (iter.Valid()) {
+      if (!iter->Empty()) {
+        used_entries++;
+      }
+      iter++;
+    }
+    uint64_t chain_length =
+        allocated == 0 ? 1 : (allocated - 1) / kNumEntryPerBucket + 1;
+    chained_buckets += chain_length;
+    max_chain_length = std::max(max_chain_length, chain_length);
+    samples++;
+  }
+  stats->hash_buckets = num_hash_buckets_;
+  stats->hash_load_factor =
+      static_cast<double>(used_entries) / (samples * kNumEntryPerBucket);
+  stats->hash_avg_chain_length = static_cast<double>(chained_buckets) / samples;
+  stats->hash_max_chain_length = max_chain_length;
+}
+
+std::unique_lock<KeyMutex> HashTable::lockSlot(uint32_t slot) {
+  Slot& s = slots_[slot];
+  if (!s.spin.try_lock()) {
+    hot_keys_.Contended(
+        slot, s.contentions.fetch_add(1, std::memory_order_relaxed) + 1);
+    s.spin.lock();
+  }
+  return std::unique_lock<KeyMutex>(s.spin, std::adopt_lock);
+}
+
+HotKeys HashTable::GetHotKeys(uint32_t k) {
+  HotKeys hot_keys;
+  hot_keys_.Get(k, &hot_keys);
+  return hot_keys;
+}
+
+void HashTable::ResetHotKeys() {
+  hot_keys_.Reset();
+  for (uint64_t i = 0; i < slots_.size(); i++) {
+    slots_[i].contentions.store(0, std::memory_order_relaxed);
+  }
+}
+
 HashTableIterator HashTable::GetIterator(uint64_t start_slot_idx,
                                          uint64_t end_slot_idx) {
   return HashTableIterator{this, start_slot_idx, end_slot_idx};
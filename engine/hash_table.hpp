@@ -15,6 +15,7 @@
 #include "kvdk/engine.hpp"
 #include "pmem_allocator/pmem_allocator.hpp"
 #include "structures.hpp"
+#include "utils/hot_keys.hpp"
 
 namespace KVDK_NAMESPACE {
 
@@ -48,7 +49,8 @@ struct alignas(16) HashEntry {
   HashEntry(uint32_t key_hash_prefix, RecordType record_type,
             RecordStatus record_status, void* _index, PointerType index_type)
       : index_(_index),
-        header_({key_hash_prefix, record_type, record_status, index_type}) {}
+        header_({key_hash_prefix, record_type, record_status, index_type,
+                 kInitialHeat}) {}
 
   bool Empty() { return header_.index_type == PointerType::Empty; }
 
@@ -67,6 +69,44 @@ struct alignas(16) HashEntry {
 
   RecordStatus GetRecordStatus() const { return header_.record_status; }
 
+  // Heat of the indexed key is its read frequency in the low 4 bits, and the
+  // cooling period it was last visited in by the cleaner in the high 4 bits.
+  // Reads raise the frequency, and the cleaner halves it at most once per
+  // cooling period. A key whose frequency stays 0 for a whole period is cold,
+  // see Configs::cold_tier_cooling_period
+  uint8_t GetHeat() const {
+    return __atomic_load_n(&header_.heat, __ATOMIC_RELAXED);
+  }
+
+  // Sample a read of the indexed key. It may be called without lock, an
+  // update lost in a race doesn't matter. The period of the key is reset, so
+  // the frequency isn't halved in the period it's read
+  void Heat() {
+    uint8_t frequency = GetHeat() & kFrequencyMask;
+    if (frequency < kFrequencyMask) {
+      frequency++;
+    }
+    __atomic_store_n(&header_.heat, kUnvisited | frequency, __ATOMIC_RELAXED);
+  }
+
+  // Decay heat of the indexed key as the cleaner visits it in cooling period
+  // "period", return true if the key is cold
+  bool Cool(uint64_t period) {
+    uint8_t heat = GetHeat();
+    uint8_t mark = (period % (kUnvisited >> kPeriodShift)) << kPeriodShift;
+    uint8_t visited = heat & ~kFrequencyMask;
+    if (visited == mark) {
+      return false;
+    }
+    uint8_t frequency = heat & kFrequencyMask;
+    // Only mark the period on the first visit after a write or read, so the
+    // key stays in it for a whole period
+    __atomic_store_n(&header_.heat,
+                     mark | (visited == kUnvisited ? frequency : frequency >> 1),
+                     __ATOMIC_RELAXED);
+    return visited != kUnvisited && frequency == 0;
+  }
+
   // Check if "key" of data type "target_type" is indexed by "this". If
   // matches, copy data entry of data record of "key" to "data_entry_metadata"
   // and return true, otherwise return false.
@@ -77,11 +117,21 @@ struct alignas(16) HashEntry {
              DataEntry* data_entry_metadata);
 
  private:
+  static constexpr uint8_t kFrequencyMask = 0x0f;
+  static constexpr uint8_t kPeriodShift = 4;
+  // Period mark of a new, updated or read entry
+  static constexpr uint8_t kUnvisited = 0xf0;
+  // A new or updated entry is cooled for at least two periods before it's
+  // cold, i.e. it's kept on PMem for a whole period without reads
+  static constexpr uint8_t kInitialHeat = kUnvisited | 1;
+
   struct EntryHeader {
     uint32_t key_prefix;
     RecordType record_type;
     RecordStatus record_status;
     PointerType index_type;
+    // Stored in the padding byte
+    uint8_t heat;
   };
 
   Index index_;
@@ -112,7 +162,10 @@ struct HashCache {
 
 struct Slot {
   HashCache hash_cache;
-  SpinMutex spin;
+  KeyMutex spin;
+  // Acquisitions of "spin" that found it held, counted while hot key
+  // detection is enabled. It fits in padding of a SpinMutex slot
+  std::atomic<uint32_t> contentions{0};
 };
 
 struct HashTableIterator;
@@ -180,30 +233,95 @@ class HashTable {
     entry_ptr->Clear();
   }
 
-  std::unique_lock<SpinMutex> AcquireLock(StringView const& key) {
-    return std::unique_lock<SpinMutex>{*getHint(key).spin};
+  // Lookups of the calling thread while it's alive are sampled as writes,
+  // see HotKeyDetector::WriteScope
+  using WriteScope = HotKeyDetector::WriteScope;
+
+  // Lock of a hash slot held to write keys in it, which is also a WriteScope
+  class SlotLock {
+   public:
+    explicit SlotLock(std::unique_lock<KeyMutex>&& lock)
+        : lock_(std::move(lock)) {}
+
+    void unlock() {
+      lock_.unlock();
+      scope_.Exit();
+    }
+
+    KeyMutex* mutex() const { return lock_.mutex(); }
+
+   private:
+    std::unique_lock<KeyMutex> lock_;
+    WriteScope scope_;
+  };
+
+  // Lock slot of "key" to write it. While hot key detection is enabled,
+  // contention of the slot lock is counted
+  SlotLock AcquireLock(StringView const& key) {
+    auto hint = getHint(key);
+    if (hot_keys_.Enabled()) {
+      return SlotLock(lockSlot(hint.slot));
+    }
+    return SlotLock(std::unique_lock<KeyMutex>{*hint.spin});
+  }
+
+  KeyMutex* GetLock(StringView const& key) { return getHint(key).spin; }
+
+  // Prefetch hash bucket of key to overlap its cache miss with other work
+  // before a following lookup
+  void Prefetch(const StringView& key) {
+    auto hint = getHint(key);
+    _mm_prefetch(&hash_buckets_[hint.bucket], _MM_HINT_T0);
+    _mm_prefetch(&hash_bucket_entries_[hint.bucket], _MM_HINT_T0);
   }
 
-  SpinMutex* GetLock(StringView const& key) { return getHint(key).spin; }
+  // Prefetch indexes of hash entries that may index "key" of masked types,
+  // i.e. PMem records or DRAM collections and skiplist nodes. This only reads
+  // the hash bucket, so call Prefetch() first to not stall on it
+  void PrefetchIndex(const StringView& key, uint8_t type_mask);
 
   HashTableIterator GetIterator(uint64_t start_slot_idx, uint64_t end_slot_idx);
 
   size_t GetSlotsNum() { return slots_.size(); }
 
-  // StringAlike is std::string or StringView
+  // Estimate load factor and chain lengths of the hash table by sampling at
+  // most "max_samples" evenly spread buckets, without locking them
+  void SampleStats(uint64_t max_samples, Statistics* stats);
+
+  // Sample 1 in "interval" key accesses of each thread to detect hot keys,
+  // and count contentions of slot locks, 0 to disable
+  void SetHotKeySampleInterval(uint64_t interval) {
+    hot_keys_.SetSampleInterval(interval);
+  }
+
+  // Get the hottest "k" keys of reads and writes, and the most contended "k"
+  // slots
+  HotKeys GetHotKeys(uint32_t k);
+
+  // Forget sampled keys and contentions
+  void ResetHotKeys();
+
+  // StringAlike is std::string or StringView. Hold a WriteScope while
+  // writing the keys for hot key detection
   template <typename StringAlike>
-  std::vector<std::unique_lock<SpinMutex>> RangeLock(
+  std::vector<std::unique_lock<KeyMutex>> RangeLock(
       std::vector<StringAlike> const& keys) {
-    std::vector<SpinMutex*> spins;
+    bool detect_hot_keys = hot_keys_.Enabled();
+    // Locking slots in order of index is in order of their addresses
+    std::vector<uint32_t> slots;
     for (auto const& key : keys) {
-      spins.push_back(getHint(key).spin);
+      slots.push_back(getHint(key).slot);
     }
-    std::sort(spins.begin(), spins.end());
-    auto end = std::unique(spins.begin(), spins.end());
-
-    std::vector<std::unique_lock<SpinMutex>> guard;
-    for (auto iter = spins.begin(); iter != end; ++iter) {
-      guard.emplace_back(**iter);
+    std::sort(slots.begin(), slots.end());
+    auto end = std::unique(slots.begin(), slots.end());
+
+    std::vector<std::unique_lock<KeyMutex>> guard;
+    for (auto iter = slots.begin(); iter != end; ++iter) {
+      if (detect_hot_keys) {
+        guard.push_back(lockSlot(*iter));
+      } else {
+        guard.emplace_back(slots_[*iter].spin);
+      }
     }
     return guard;
   }
@@ -224,7 +342,8 @@ class HashTable {
     uint32_t slot;
     // hash value stored on hash entry
     uint32_t key_hash_prefix;
-    SpinMutex* spin;
+    KeyMutex* spin;
+    uint64_t hash;
   };
 
   KeyHashHint getHint(const StringView& key) {
@@ -234,6 +353,7 @@ class HashTable {
     hint.bucket = get_bucket_num(hash_val);
     hint.slot = get_slot_num(hint.bucket);
     hint.spin = &slots_[hint.slot].spin;
+    hint.hash = hash_val;
     return hint;
   }
 
@@ -247,6 +367,9 @@ class HashTable {
 
   Status allocateEntry(HashBucketIterator& bucket_iter);
 
+  // Lock "slot" and count its contention
+  std::unique_lock<KeyMutex> lockSlot(uint32_t slot);
+
   const uint64_t num_hash_buckets_;
   const uint32_t num_buckets_per_slot_;
   const PMEMAllocator* pmem_allocator_;
@@ -255,6 +378,7 @@ class HashTable {
   std::vector<uint64_t> hash_bucket_entries_;
   Array<HashBucket> hash_buckets_;
   void* main_buckets_;
+  HotKeyDetector hot_keys_;
 };
 
 // Iterator all hash entries in a hash table bucket
@@ -388,9 +512,9 @@ struct HashTableIterator {
         current_slot_idx_(start_slot_idx),
         end_slot_idx_(end_slot_idx) {}
 
-  std::unique_lock<SpinMutex> AcquireSlotLock() {
-    SpinMutex* slot_lock = GetSlotLock();
-    return std::unique_lock<SpinMutex>(*slot_lock);
+  std::unique_lock<KeyMutex> AcquireSlotLock() {
+    KeyMutex* slot_lock = GetSlotLock();
+    return std::unique_lock<KeyMutex>(*slot_lock);
   }
 
   void Next() {
@@ -405,13 +529,13 @@ struct HashTableIterator {
     return HashSlotIterator{hash_table_, current_slot_idx_};
   }
 
-  SpinMutex* GetSlotLock() {
+  KeyMutex* GetSlotLock() {
     return &hash_table_->slots_[current_slot_idx_].spin;
   }
 
  private:
   // lock current access slot
-  std::unique_lock<SpinMutex> iter_lock_slot_;
+  std::unique_lock<KeyMutex> iter_lock_slot_;
   // current slot id
   HashTable* hash_table_;
   uint64_t current_slot_idx_;
@@ -31,27 +31,38 @@
 namespace KVDK_NAMESPACE {
 // fsdax mode align to 2MB by default.
 constexpr uint64_t kPMEMMapSizeUnit = (1 << 21);
+// Hash buckets sampled by GetStatistics()
+constexpr uint64_t kHashStatsSamples = (1 << 16);
 
-void PendingBatch::PersistFinish() {
+void PendingBatch::PersistFinish(const PersistPolicy& policy) {
   num_kv = 0;
   stage = Stage::Finish;
-  pmem_persist(this, sizeof(PendingBatch));
+  policy.Persist(this, sizeof(PendingBatch));
 }
 
-void PendingBatch::PersistProcessing(const std::vector<PMemOffsetType>& records,
+void PendingBatch::PersistProcessing(const PersistPolicy& policy,
+                                     const std::vector<PMemOffsetType>& records,
                                      TimestampType ts) {
-  pmem_memcpy_persist(record_offsets, records.data(), records.size() * 8);
+  memcpy(record_offsets, records.data(), records.size() * 8);
+  policy.Persist(record_offsets, records.size() * 8);
   timestamp = ts;
   num_kv = records.size();
   stage = Stage::Processing;
-  pmem_persist(this, sizeof(PendingBatch));
+  policy.Persist(this, sizeof(PendingBatch));
 }
 
 KVEngine::~KVEngine() {
   GlobalLogger.Info("Closing instance ... \n");
   GlobalLogger.Info("Waiting bg threads exit ... \n");
   closing_ = true;
+  if (recovery_thread_.joinable()) {
+    recovery_thread_.join();
+  }
+  async_executor_.reset();
   terminateBackgroundWorks();
+  if (relaxed_durability_) {
+    flushRelaxedWrites();
+  }
   // deleteCollections();
   ReportPMemUsage();
   GlobalLogger.Info("Instance closed\n");
@@ -65,12 +76,16 @@ Status KVEngine::Open(const StringView engine_path, Engine** engine_ptr,
   KVEngine* engine = new KVEngine(configs);
   Status s = engine->init(engine_path_str, configs);
   if (s == Status::Ok) {
-    s = engine->restoreExistingData();
+    s = configs.lazy_recovery ? engine->startLazyRecovery()
+                              : engine->restoreExistingData();
   }
   if (s == Status::Ok) {
     *engine_ptr = engine;
-    engine->startBackgroundWorks();
-    engine->ReportPMemUsage();
+    if (!configs.lazy_recovery) {
+      // Started by recovery thread in lazy recovery
+      engine->startBackgroundWorks();
+      engine->ReportPMemUsage();
+    }
   } else {
     GlobalLogger.Error("Init kvdk instance failed: %d\n", s);
     delete engine;
@@ -91,9 +106,13 @@ Status KVEngine::Restore(const StringView engine_path,
   if (s == Status::Ok) {
     s = engine->restoreDataFromBackup(backup_log_str);
   }
+  if (s == Status::Ok) {
+    engine->resetDurableTimestamp();
+  }
 
   if (s == Status::Ok) {
     *engine_ptr = engine;
+    engine->recovery_progress_.finished.store(true);
     engine->startBackgroundWorks();
     engine->ReportPMemUsage();
   } else {
@@ -118,10 +137,29 @@ void KVEngine::ReportPMemUsage() {
 }
 
 void KVEngine::startBackgroundWorks() {
-  std::unique_lock<SpinMutex> ul(bg_work_signals_.terminating_lock);
+  // Enabled after recovery, so restored keys are not sampled as writes
+  hash_table_->SetHotKeySampleInterval(configs_.hot_key_sample_interval);
   bg_work_signals_.terminating = false;
-  bg_threads_.emplace_back(&KVEngine::backgroundPMemAllocatorOrgnizer, this);
-  bg_threads_.emplace_back(&KVEngine::backgroundPMemUsageReporter, this);
+  double budget = configs_.background_task_budget;
+  bg_tasks_.push_back(bg_executor_.AddTask(
+      "pmem_allocator_organizer", configs_.background_work_interval, budget,
+      [this](const TaskBudget& b) {
+        return this->backgroundPMemAllocatorOrgnizer(b);
+      }));
+  bg_tasks_.push_back(bg_executor_.AddTask(
+      "pmem_usage_reporter", configs_.report_pmem_usage_interval, budget,
+      [this](const TaskBudget& b) {
+        return this->backgroundPMemUsageReporter(b);
+      }));
+  if (relaxed_durability_) {
+    relaxed_flush_task_ = bg_executor_.AddTask(
+        "relaxed_flusher", configs_.relaxed_flush_interval_us / 1000000.0,
+        budget, [this](const TaskBudget&) {
+          this->flushRelaxedWrites();
+          return false;
+        });
+    bg_tasks_.push_back(relaxed_flush_task_);
+  }
 
   bool close_reclaimer = false;
   TEST_SYNC_POINT_CALLBACK("KVEngine::backgroundCleaner::NothingToDo",
@@ -133,21 +171,36 @@ void KVEngine::startBackgroundWorks() {
 
 void KVEngine::terminateBackgroundWorks() {
   cleaner_.Close();
-  {
-    std::unique_lock<SpinMutex> ul(bg_work_signals_.terminating_lock);
-    bg_work_signals_.terminating = true;
-    bg_work_signals_.dram_cleaner_cv.notify_all();
-    bg_work_signals_.pmem_allocator_organizer_cv.notify_all();
-    bg_work_signals_.pmem_usage_reporter_cv.notify_all();
-  }
-  for (auto& t : bg_threads_) {
-    t.join();
+  bg_work_signals_.terminating = true;
+  for (auto id : bg_tasks_) {
+    bg_executor_.RemoveTask(id);
   }
+  bg_tasks_.clear();
+  bg_executor_.Close();
 }
 
 Status KVEngine::init(const std::string& name, const Configs& configs) {
   Status s;
-  if (!configs.use_devdax_mode) {
+  if (configs.volatile_mode && configs.emulate_pmem) {
+    GlobalLogger.Error("Volatile mode can't be used with emulated PMem\n");
+    return Status::InvalidConfiguration;
+  }
+  persist_mode_ = configs.volatile_mode  ? PersistMode::Volatile
+                  : configs.emulate_pmem ? PersistMode::Emulated
+                                         : PersistMode::PMem;
+  stats_.Enable(configs.enable_statistics);
+  tracer_.SetSampleInterval(configs.trace_sample_interval);
+
+  if (configs.volatile_mode) {
+    if (configs.use_devdax_mode) {
+      GlobalLogger.Error("Volatile mode can't be used with devdax mode\n");
+      return Status::InvalidConfiguration;
+    }
+    // Nothing is written to the path
+    configs_ = configs;
+    dir_ = format_dir_path(name);
+    data_file_ = data_file();
+  } else if (!configs.use_devdax_mode) {
     dir_ = format_dir_path(name);
     int res = create_dir_if_missing(dir_);
     if (res != 0) {
@@ -183,27 +236,55 @@ Status KVEngine::init(const std::string& name, const Configs& configs) {
     }
   }
 
-  s = persistOrRecoverImmutableConfigs();
+  s = configs_.volatile_mode ? checkConfigs(configs_)
+                             : persistOrRecoverImmutableConfigs();
   if (s != Status::Ok) {
     return s;
   }
 
   pmem_allocator_.reset(PMEMAllocator::NewPMEMAllocator(
       data_file_, configs_.pmem_file_size, configs_.pmem_segment_blocks,
-      configs_.pmem_block_size, configs_.max_access_threads,
+      configs_.pmem_block_size, maxConcurrentThreads(configs_),
       configs_.populate_pmem_space, configs_.use_devdax_mode,
-      &version_controller_));
+      &version_controller_, numThreadCaches(), persist_mode_,
+      configs_.volatile_hugepage, pmemEmulation(configs_)));
   hash_table_.reset(HashTable::NewHashTable(
       configs_.hash_bucket_num, configs_.num_buckets_per_slot,
-      pmem_allocator_.get(), configs_.max_access_threads));
+      pmem_allocator_.get(), numThreadCaches()));
   dllist_locks_.reset(new LockTable{1UL << 20});
   if (pmem_allocator_ == nullptr || hash_table_ == nullptr ||
       dllist_locks_ == nullptr) {
     GlobalLogger.Error("Init kvdk basic components error\n");
     return Status::Abort;
   }
+  uint8_t compact_types =
+      (configs_.compact_hash_elems ? RecordType::HashElem : 0) |
+      (configs_.compact_sorted_elems ? RecordType::SortedElem : 0) |
+      (configs_.compact_list_elems ? RecordType::ListElem : 0);
+  if (compact_types != 0 &&
+      pmem_allocator_->EnableCompactRecords(compact_types) != compact_types) {
+    GlobalLogger.Info(
+        "Compact records disabled as PMem space can't be addressed by 32-bit "
+        "offsets\n");
+  }
+  if (configs_.xpline_aware_allocation && !configs_.volatile_mode &&
+      !pmem_allocator_->EnableXPLineAlignment()) {
+    GlobalLogger.Info(
+        "XPLine aware allocation disabled as pmem_block_size doesn't divide "
+        "XPLine size\n");
+  }
+  if (!configs_.cold_tier_path.empty()) {
+    cold_tier_.reset(ColdTier::Open(configs_.cold_tier_path,
+                                    configs_.cold_tier_max_file_size));
+    if (cold_tier_ == nullptr) {
+      return Status::IOError;
+    }
+  }
 
   s = initOrRestoreCheckpoint();
+  if (s == Status::Ok) {
+    s = initDurableTimestamp();
+  }
 
   registerComparator("default", compare_string_view);
   return s;
@@ -212,19 +293,21 @@ Status KVEngine::init(const std::string& name, const Configs& configs) {
 Status KVEngine::restoreData() {
   this_thread.id = next_recovery_tid_.fetch_add(1);
 
-  EngineThreadCache& engine_thread_cache =
-      engine_thread_cache_[ThreadManager::ThreadID() %
-                           configs_.max_access_threads];
-
   SpaceEntry segment_recovering;
   DataEntry data_entry_cached;
   uint64_t cnt = 0;
+  TimestampType newest_restored_ts = 0;
   Status s;
   while (true) {
     if (segment_recovering.size == 0) {
+      // Report progress of the last segment
+      restored_.fetch_add(cnt, std::memory_order_relaxed);
+      cnt = 0;
       if (!pmem_allocator_->FetchSegment(&segment_recovering)) {
         break;
       }
+      recovery_progress_.restored_segments.fetch_add(1,
+                                                     std::memory_order_relaxed);
       assert(segment_recovering.size % configs_.pmem_block_size == 0);
     }
 
@@ -238,10 +321,11 @@ Status KVEngine::restoreData() {
           static_cast<DataEntry*>(recovering_pmem_record);
       uint64_t padding_size = segment_recovering.size;
       recovering_pmem_data_entry->meta.type = RecordType::Empty;
-      pmem_persist(&recovering_pmem_data_entry->meta.type, sizeof(RecordType));
+      persistPolicy().Persist(&recovering_pmem_data_entry->meta.type,
+                              sizeof(RecordType));
       recovering_pmem_data_entry->header.record_size = padding_size;
-      pmem_persist(&recovering_pmem_data_entry->header.record_size,
-                   sizeof(uint32_t));
+      persistPolicy().Persist(&recovering_pmem_data_entry->header.record_size,
+                              sizeof(uint32_t));
       data_entry_cached = *recovering_pmem_data_entry;
     }
 
@@ -255,9 +339,19 @@ Status KVEngine::restoreData() {
       case RecordType::HashRecord:
       case RecordType::HashElem:
       case RecordType::ListRecord:
-      case RecordType::ListElem: {
+      case RecordType::ListElem:
+      case RecordType::Extent: {
         if (data_entry_cached.meta.status == RecordStatus::Dirty) {
           data_entry_cached.meta.type = RecordType::Empty;
+        } else if (data_entry_cached.meta.type == RecordType::String &&
+                   recovery_durable_ts_ != 0 &&
+                   data_entry_cached.meta.timestamp >= recovery_durable_ts_) {
+          // Written in relaxed durability after the last group flush, which
+          // may be torn or newer than lost writes. Destroy it so it's not
+          // restored by later recoveries of larger durable timestamps
+          static_cast<DataEntry*>(recovering_pmem_record)
+              ->Destroy(persistPolicy());
+          data_entry_cached.meta.type = RecordType::Empty;
         } else {
           if (!validateRecord(recovering_pmem_record)) {
             // Checksum dismatch, mark as padding to be Freed
@@ -296,9 +390,8 @@ Status KVEngine::restoreData() {
     // Continue to restore the Record
     cnt++;
 
-    engine_thread_cache.newest_restored_ts =
-        std::max(data_entry_cached.meta.timestamp,
-                 engine_thread_cache.newest_restored_ts);
+    newest_restored_ts =
+        std::max(data_entry_cached.meta.timestamp, newest_restored_ts);
 
     switch (data_entry_cached.meta.type) {
       case RecordType::SortedElem: {
@@ -331,6 +424,11 @@ Status KVEngine::restoreData() {
         s = restoreHashElem(static_cast<DLRecord*>(recovering_pmem_record));
         break;
       }
+      case RecordType::Extent: {
+        s = restoreExtentRecord(
+            static_cast<ExtentRecord*>(recovering_pmem_record));
+        break;
+      }
       default: {
         GlobalLogger.Error(
             "Invalid Record type when recovering. Trying "
@@ -344,6 +442,7 @@ Status KVEngine::restoreData() {
     }
   }
   restored_.fetch_add(cnt);
+  compare_excange_if_larger(newest_restored_ts_, newest_restored_ts);
   return s;
 }
 
@@ -352,7 +451,8 @@ bool KVEngine::validateRecord(void* data_record) {
   DataEntry* entry = static_cast<DataEntry*>(data_record);
   switch (entry->meta.type) {
     case RecordType::String: {
-      return static_cast<StringRecord*>(data_record)->Validate();
+      return static_cast<StringRecord*>(data_record)
+          ->Validate(persistPolicy());
     }
     case RecordType::SortedRecord:
     case RecordType::SortedElem:
@@ -360,7 +460,11 @@ bool KVEngine::validateRecord(void* data_record) {
     case RecordType::HashElem:
     case RecordType::ListRecord:
     case RecordType::ListElem: {
-      return static_cast<DLRecord*>(data_record)->Validate();
+      return static_cast<DLRecord*>(data_record)->Validate(persistPolicy());
+    }
+    case RecordType::Extent: {
+      return static_cast<ExtentRecord*>(data_record)
+          ->Validate(persistPolicy());
     }
     default:
       kvdk_assert(false, "Unsupported type in validateRecord()!");
@@ -377,10 +481,11 @@ Status KVEngine::persistOrRecoverImmutableConfigs() {
   ImmutableConfigs* configs = (ImmutableConfigs*)pmem_map_file(
       config_file().c_str(), len, PMEM_FILE_CREATE, 0666, &mapped_len,
       &is_pmem);
-  if (configs == nullptr || !is_pmem || mapped_len != len) {
+  if (configs == nullptr || !mappedPMem(is_pmem) || mapped_len != len) {
     GlobalLogger.Error(
         "Open immutable configs file error %s\n",
-        !is_pmem ? (dir_ + "is not a valid pmem path").c_str() : "");
+        !mappedPMem(is_pmem) ? (dir_ + "is not a valid pmem path").c_str()
+                             : "");
     return Status::IOError;
   }
   if (configs->Valid()) {
@@ -397,6 +502,10 @@ Status KVEngine::persistOrRecoverImmutableConfigs() {
 
 Status KVEngine::Backup(const pmem::obj::string_view backup_log,
                         const Snapshot* snapshot) {
+  Status recovery_status = maybeWaitRecovery(PrimaryRecordType);
+  if (recovery_status != Status::Ok) {
+    return recovery_status;
+  }
   std::string backup_log_file = string_view_2_string(backup_log);
   BackupLog backup;
   Status s = backup.Init(backup_log_file);
@@ -421,8 +530,12 @@ Status KVEngine::Backup(const pmem::obj::string_view backup_log,
           }
           if (record && record->GetRecordStatus() == RecordStatus::Normal &&
               !record->HasExpired()) {
-            s = backup.Append(RecordType::String, record->Key(),
-                              record->Value(), record->GetExpireTime());
+            std::string value;
+            s = readStringValue(record, &value);
+            if (s == Status::Ok) {
+              s = backup.Append(RecordType::String, record->Key(), value,
+                                record->GetExpireTime());
+            }
           }
           break;
         }
@@ -430,7 +543,7 @@ Status KVEngine::Backup(const pmem::obj::string_view backup_log,
           DLRecord* header = slot_iter->GetIndex().skiplist->HeaderRecord();
           while (header != nullptr && header->GetTimestamp() > backup_ts) {
             header =
-                pmem_allocator_->offset2addr<DLRecord>(header->old_version);
+                pmem_allocator_->offset2addr<DLRecord>(header->GetOldVersion());
           }
           if (header && header->GetRecordStatus() == RecordStatus::Normal &&
               !header->HasExpired()) {
@@ -460,7 +573,7 @@ Status KVEngine::Backup(const pmem::obj::string_view backup_log,
           DLRecord* header = slot_iter->GetIndex().hlist->HeaderRecord();
           while (header != nullptr && header->GetTimestamp() > backup_ts) {
             header =
-                pmem_allocator_->offset2addr<DLRecord>(header->old_version);
+                pmem_allocator_->offset2addr<DLRecord>(header->GetOldVersion());
           }
           if (header && header->GetRecordStatus() == RecordStatus::Normal &&
               !header->HasExpired()) {
@@ -475,8 +588,18 @@ Status KVEngine::Backup(const pmem::obj::string_view backup_log,
                   false);
               for (hlist_iter.SeekToFirst(); hlist_iter.Valid();
                    hlist_iter.Next()) {
+                std::string value = hlist_iter.Value();
+                if (hlist->GetKind() == HashList::Kind::TimeSeries) {
+                  // Samples appended in place are in tail of the bucket
+                  TimeSeriesBucket bucket;
+                  if (!bucket.Load(hlist_iter.dl_iter_.Record())) {
+                    s = Status::Abort;
+                    break;
+                  }
+                  value = bucket.Encode();
+                }
                 s = backup.Append(RecordType::HashElem, hlist_iter.Key(),
-                                  hlist_iter.Value(), kPersistTime);
+                                  value, kPersistTime);
                 if (s != Status::Ok) {
                   break;
                 }
@@ -489,7 +612,7 @@ Status KVEngine::Backup(const pmem::obj::string_view backup_log,
           DLRecord* header = slot_iter->GetIndex().list->HeaderRecord();
           while (header != nullptr && header->GetTimestamp() > backup_ts) {
             header =
-                pmem_allocator_->offset2addr<DLRecord>(header->old_version);
+                pmem_allocator_->offset2addr<DLRecord>(header->GetOldVersion());
           }
           if (header && header->GetRecordStatus() == RecordStatus::Normal &&
               !header->HasExpired()) {
@@ -533,12 +656,17 @@ Status KVEngine::Backup(const pmem::obj::string_view backup_log,
 }
 
 Status KVEngine::initOrRestoreCheckpoint() {
+  if (configs_.volatile_mode) {
+    volatile_checkpoint_.reset(new CheckPoint());
+    persist_checkpoint_ = volatile_checkpoint_.get();
+    return Status::Ok;
+  }
   size_t mapped_len;
   int is_pmem;
   persist_checkpoint_ = static_cast<CheckPoint*>(
       pmem_map_file(checkpoint_file().c_str(), sizeof(CheckPoint),
                     PMEM_FILE_CREATE, 0666, &mapped_len, &is_pmem));
-  if (persist_checkpoint_ == nullptr || !is_pmem ||
+  if (persist_checkpoint_ == nullptr || !mappedPMem(is_pmem) ||
       mapped_len != sizeof(CheckPoint)) {
     GlobalLogger.Error("Map persistent checkpoint file %s failed\n",
                        checkpoint_file().c_str());
@@ -547,6 +675,58 @@ Status KVEngine::initOrRestoreCheckpoint() {
   return Status::Ok;
 }
 
+Status KVEngine::initDurableTimestamp() {
+  if (configs_.volatile_mode) {
+    return Status::Ok;
+  }
+  size_t mapped_len;
+  int is_pmem;
+  durable_ts_ = static_cast<TimestampType*>(
+      pmem_map_file(durable_ts_file().c_str(), sizeof(TimestampType),
+                    PMEM_FILE_CREATE, 0666, &mapped_len, &is_pmem));
+  if (durable_ts_ == nullptr || !mappedPMem(is_pmem) ||
+      mapped_len != sizeof(TimestampType)) {
+    GlobalLogger.Error("Map durable timestamp file %s failed\n",
+                       durable_ts_file().c_str());
+    durable_ts_ = nullptr;
+    return Status::IOError;
+  }
+  recovery_durable_ts_ = *durable_ts_;
+  return Status::Ok;
+}
+
+void KVEngine::resetDurableTimestamp() {
+  if (durable_ts_ == nullptr) {
+    return;
+  }
+  // All restored records are durable now
+  TimestampType ts =
+      configs_.relaxed_durability ? version_controller_.GetCurrentTimestamp()
+                                  : 0;
+  persistPolicy().StoreNT(durable_ts_, ts);
+  if (configs_.relaxed_durability) {
+    version_controller_.SetDurableTimestamp(ts);
+    relaxed_durability_ = true;
+  }
+}
+
+void KVEngine::flushRelaxedWrites() {
+  std::lock_guard<std::mutex> lg(relaxed_flush_lock_);
+  TimestampType ts = persistPolicy().FlushDeferred(
+      [this]() { return version_controller_.GetCurrentTimestamp(); });
+  if (ts > *durable_ts_) {
+    persistPolicy().StoreNT(durable_ts_, ts);
+    version_controller_.SetDurableTimestamp(ts);
+  }
+}
+
+Status KVEngine::Flush() {
+  if (relaxed_durability_) {
+    flushRelaxedWrites();
+  }
+  return Status::Ok;
+}
+
 Status KVEngine::restoreDataFromBackup(const std::string& backup_log) {
   // TODO: make this multi-thread
   BackupLog backup;
@@ -619,7 +799,9 @@ Status KVEngine::restoreDataFromBackup(const std::string& backup_log) {
       case RecordType::HashRecord: {
         std::shared_ptr<HashList> hlist = nullptr;
         if (!expired) {
-          s = buildHashlist(record.key, hlist);
+          s = buildHashlist(record.key, hlist,
+                            HashList::DecodeKind(record.val),
+                            HashList::DecodeKindArgs(record.val));
           if (s == Status::Ok && wo.ttl_time != kPersistTime) {
             hlist->SetExpireTime(wo.ttl_time,
                                  version_controller_.GetCurrentTimestamp());
@@ -652,7 +834,7 @@ Status KVEngine::restoreDataFromBackup(const std::string& backup_log) {
       case RecordType::ListRecord: {
         std::shared_ptr<List> list = nullptr;
         if (!expired) {
-          s = buildList(record.key, list);
+          s = buildList(record.key, list, List::DecodeKind(record.val));
           if (s == Status::Ok && wo.ttl_time != kPersistTime) {
             list->SetExpireTime(wo.ttl_time,
                                 version_controller_.GetCurrentTimestamp());
@@ -711,109 +893,379 @@ Status KVEngine::restoreDataFromBackup(const std::string& backup_log) {
 }
 
 Status KVEngine::restoreExistingData() {
+  Status s = prepareRecovery(numRecoveryThreads(), 0);
+  if (s != Status::Ok) {
+    return s;
+  }
+
+  s = restoreDataSegments();
+  if (s != Status::Ok) {
+    return s;
+  }
+
+  for (RecordType type : {RecordType::SortedRecord, RecordType::ListRecord,
+                          RecordType::HashRecord}) {
+    s = rebuildCollections(type);
+    if (s != Status::Ok) {
+      return s;
+    }
+  }
+
+  return finishRecovery();
+}
+
+Status KVEngine::prepareRecovery(uint64_t num_rebuild_threads,
+                                 uint64_t first_rebuild_tid) {
   sorted_rebuilder_.reset(new SortedCollectionRebuilder(
-      this, configs_.opt_large_sorted_collection_recovery,
-      configs_.max_access_threads, *persist_checkpoint_));
+      this, configs_.opt_large_sorted_collection_recovery, numRecoveryThreads(),
+      num_rebuild_threads, first_rebuild_tid, *persist_checkpoint_));
   hash_rebuilder_.reset(new HashListRebuilder(
       pmem_allocator_.get(), hash_table_.get(), dllist_locks_.get(),
-      configs_.max_access_threads, *persist_checkpoint_));
+      configs_.opt_large_hash_collection_recovery, numRecoveryThreads(),
+      num_rebuild_threads, first_rebuild_tid, *persist_checkpoint_));
   list_rebuilder_.reset(new ListRebuilder(
       pmem_allocator_.get(), hash_table_.get(), dllist_locks_.get(),
-      configs_.max_access_threads, *persist_checkpoint_));
+      configs_.opt_large_list_recovery, numRecoveryThreads(),
+      num_rebuild_threads, first_rebuild_tid, *persist_checkpoint_));
 
-  Status s = batchWriteRollbackLogs();
-  if (s != Status::Ok) {
-    return s;
-  }
+  return batchWriteRollbackLogs();
+}
 
+Status KVEngine::restoreDataSegments() {
+  Status s = Status::Ok;
   std::vector<std::future<Status>> fs;
-  GlobalLogger.Info("Start restore data\n");
-  for (uint32_t i = 0; i < configs_.max_access_threads; i++) {
-    fs.push_back(std::async(&KVEngine::restoreData, this));
+  uint64_t num_recovery_threads = numRecoveryThreads();
+  std::vector<int> pus;
+  if (configs_.numa_bind_recovery_threads) {
+    int numa_node = get_pmem_numa_node(data_file_, configs_.use_devdax_mode);
+    if (numa_node >= 0) {
+      pus = get_numa_node_pus(numa_node);
+    }
+    if (pus.empty()) {
+      GlobalLogger.Info(
+          "NUMA node of PMem not detected, recovery threads are not bound\n");
+    } else {
+      GlobalLogger.Info("Bind recovery threads to %lu PUs of NUMA node %d\n",
+                        pus.size(), numa_node);
+    }
+  }
+
+  recovery_progress_.total_segments.store(
+      pmem_allocator_->EstimateSegmentsToFetch());
+  recovery_progress_.start_time.store(TimeUtils::microseconds_time());
+  GlobalLogger.Info("Start restore data with %lu threads, %lu segments\n",
+                    num_recovery_threads,
+                    recovery_progress_.total_segments.load());
+  for (uint32_t i = 0; i < num_recovery_threads; i++) {
+    fs.push_back(std::async(std::launch::async, [&]() {
+      if (!pus.empty() && bind_thread_to_pus(pus) != 0) {
+        GlobalLogger.Error("Bind recovery thread failed\n");
+      }
+      return restoreData();
+    }));
   }
 
+  auto report_interval = std::chrono::microseconds(static_cast<int64_t>(
+      configs_.report_recovery_progress_interval * 1000000));
   for (auto& f : fs) {
-    s = f.get();
-    if (s != Status::Ok) {
-      return s;
+    if (report_interval.count() > 0) {
+      while (f.wait_for(report_interval) != std::future_status::ready) {
+        reportRecoveryProgress();
+      }
+    }
+    Status ret = f.get();
+    if (s == Status::Ok) {
+      s = ret;
     }
   }
   fs.clear();
+  recovery_progress_.end_time.store(TimeUtils::microseconds_time());
+  if (s != Status::Ok) {
+    return s;
+  }
 
   GlobalLogger.Info("RestoreData done: iterated %lu records\n",
                     restored_.load());
+  reportRecoveryProgress();
 
-  // restore skiplist by two optimization strategy
-  auto s_ret = sorted_rebuilder_->Rebuild();
-  if (s_ret.s != Status::Ok) {
-    return s_ret.s;
-  }
-  if (collection_id_.load() <= s_ret.max_id) {
-    collection_id_.store(s_ret.max_id + 1);
+  s = restoreExtents();
+  if (s != Status::Ok) {
+    return s;
   }
-  skiplists_.swap(s_ret.rebuild_skiplits);
-
-  GlobalLogger.Info("Rebuild skiplist done\n");
-  sorted_rebuilder_.reset(nullptr);
 
-  auto l_ret = list_rebuilder_->Rebuild();
-  if (l_ret.s != Status::Ok) {
-    return l_ret.s;
+  // Index collection headers before any element rebuilt, so new collections
+  // never reuse a recovered id or name
+  s = sorted_rebuilder_->Prepare();
+  if (s == Status::Ok) {
+    s = list_rebuilder_->Prepare();
   }
-  if (collection_id_.load() <= l_ret.max_id) {
-    collection_id_.store(l_ret.max_id + 1);
+  if (s == Status::Ok) {
+    s = hash_rebuilder_->Prepare();
   }
-  lists_.swap(l_ret.rebuilt_lists);
-  GlobalLogger.Info("Rebuild Lists done\n");
-  list_rebuilder_.reset(nullptr);
-
-  auto h_ret = hash_rebuilder_->Rebuild();
-  if (h_ret.s != Status::Ok) {
-    return h_ret.s;
+  if (s != Status::Ok) {
+    return s;
   }
-  if (collection_id_.load() <= h_ret.max_id) {
-    collection_id_.store(h_ret.max_id + 1);
+  CollectionIDType max_id = std::max({sorted_rebuilder_->MaxRecoveredID(),
+                                      list_rebuilder_->MaxRecoveredID(),
+                                      hash_rebuilder_->MaxRecoveredID()});
+  if (collection_id_.load() <= max_id) {
+    collection_id_.store(max_id + 1);
   }
-  hlists_.swap(h_ret.rebuilt_hlists);
-  GlobalLogger.Info("Rebuild HashLists done\n");
-  hash_rebuilder_.reset(nullptr);
 
+  version_controller_.Init(newest_restored_ts_.load());
+  resetDurableTimestamp();
+  return Status::Ok;
+}
+
+Status KVEngine::rebuildCollections(RecordType type) {
+  switch (type) {
+    case RecordType::SortedRecord: {
+      // restore skiplist by two optimization strategy
+      auto s_ret = sorted_rebuilder_->Rebuild();
+      if (s_ret.s != Status::Ok) {
+        return s_ret.s;
+      }
+      skiplists_.Reset(std::move(s_ret.rebuild_skiplits));
+      GlobalLogger.Info("Rebuild skiplist done\n");
+      sorted_rebuilder_.reset(nullptr);
 #if KVDK_DEBUG_LEVEL > 0
-  for (auto skiplist : skiplists_) {
-    Status s = skiplist.second->CheckIndex();
-    if (s != Status::Ok) {
-      GlobalLogger.Error("Check skiplist index error\n");
-      return s;
+      for (auto skiplist : skiplists_.Snapshot()) {
+        Status s = skiplist.second->CheckIndex();
+        if (s != Status::Ok) {
+          GlobalLogger.Error("Check skiplist index error\n");
+          return s;
+        }
+      }
+#endif
+      break;
     }
-  }
-
-  for (auto hlist : hlists_) {
-    Status s = hlist.second->CheckIndex();
-    if (s != Status::Ok) {
-      GlobalLogger.Error("Check hash index error\n");
-      return s;
+    case RecordType::ListRecord: {
+      auto l_ret = list_rebuilder_->Rebuild();
+      if (l_ret.s != Status::Ok) {
+        return l_ret.s;
+      }
+      lists_.Reset(std::move(l_ret.rebuilt_lists));
+      GlobalLogger.Info("Rebuild Lists done\n");
+      list_rebuilder_.reset(nullptr);
+      break;
     }
-  }
+    case RecordType::HashRecord: {
+      auto h_ret = hash_rebuilder_->Rebuild();
+      if (h_ret.s != Status::Ok) {
+        return h_ret.s;
+      }
+      hlists_.Reset(std::move(h_ret.rebuilt_hlists));
+      GlobalLogger.Info("Rebuild HashLists done\n");
+      hash_rebuilder_.reset(nullptr);
+#if KVDK_DEBUG_LEVEL > 0
+      for (auto hlist : hlists_.Snapshot()) {
+        Status s = hlist.second->CheckIndex();
+        if (s != Status::Ok) {
+          GlobalLogger.Error("Check hash index error\n");
+          return s;
+        }
+      }
 #endif
-
-  uint64_t latest_version_ts = 0;
-  if (restored_.load() > 0) {
-    for (size_t i = 0; i < engine_thread_cache_.size(); i++) {
-      auto& engine_thread_cache = engine_thread_cache_[i];
-      latest_version_ts =
-          std::max(engine_thread_cache.newest_restored_ts, latest_version_ts);
+      break;
+    }
+    default: {
+      kvdk_assert(false, "Invalid collection type in rebuildCollections()");
+      return Status::Abort;
     }
   }
+  return Status::Ok;
+}
 
+Status KVEngine::finishRecovery() {
   persist_checkpoint_->Release();
-  pmem_persist(persist_checkpoint_, sizeof(CheckPoint));
+  persistPolicy().Persist(persist_checkpoint_, sizeof(CheckPoint));
 
-  version_controller_.Init(latest_version_ts);
   old_records_cleaner_.TryGlobalClean();
   kvdk_assert(pmem_allocator_->PMemUsageInBytes() >= 0, "Invalid PMem Usage");
+  recovery_progress_.finished.store(true);
+  return Status::Ok;
+}
+
+RecoveryStats KVEngine::GetRecoveryStats() {
+  RecoveryStats stats;
+  stats.finished = recovery_progress_.finished.load();
+  stats.restored_segments = recovery_progress_.restored_segments.load();
+  stats.restored_records = restored_.load();
+  stats.total_segments = std::max(recovery_progress_.total_segments.load(),
+                                  stats.restored_segments);
+  int64_t start_time = recovery_progress_.start_time.load();
+  int64_t end_time = recovery_progress_.end_time.load();
+  stats.segments_restored = end_time != 0;
+  if (start_time != 0) {
+    int64_t now =
+        stats.segments_restored ? end_time : TimeUtils::microseconds_time();
+    stats.elapsed_seconds = (now - start_time) / 1000000.0;
+  }
+  if (stats.elapsed_seconds > 0) {
+    stats.segments_per_second = stats.restored_segments / stats.elapsed_seconds;
+    stats.records_per_second = stats.restored_records / stats.elapsed_seconds;
+  }
+  if (!stats.segments_restored && stats.segments_per_second > 0) {
+    stats.eta_seconds = (stats.total_segments - stats.restored_segments) /
+                        stats.segments_per_second;
+  }
+  return stats;
+}
+
+Statistics KVEngine::GetStatistics() {
+  Statistics stats;
+  stats.enabled = stats_.Enabled();
+  stats_.Collect(stats.ops);
+
+  stats.pmem_capacity_bytes = pmem_allocator_->PMemCapacityInBytes();
+  stats.pmem_usage_bytes =
+      std::max<int64_t>(pmem_allocator_->PMemUsageInBytes(), 0);
+  stats.pmem_segment_bytes = pmem_allocator_->SegmentBytes();
+
+  Cleaner::Stats& cleaner_stats = cleaner_.GetStats();
+  stats.cleaner_workers = cleaner_.ActiveThreadNum();
+  stats.cleaner_scanned_slots = cleaner_stats.scanned_slots.load();
+  stats.cleaner_purged_records = cleaner_stats.purged_records.load();
+  stats.cleaner_destroyed_collections =
+      cleaner_stats.destroyed_collections.load();
+
+  hash_table_->SampleStats(kHashStatsSamples, &stats);
+  stats.recovery = GetRecoveryStats();
+  return stats;
+}
+
+void KVEngine::reportRecoveryProgress() {
+  RecoveryStats stats = GetRecoveryStats();
+  GlobalLogger.Info(
+      "Recovery progress: %lu/%lu segments, %lu records in %.1f s, %.1f "
+      "segments/s, %.1f records/s, ETA %.1f s\n",
+      stats.restored_segments, stats.total_segments, stats.restored_records,
+      stats.elapsed_seconds, stats.segments_per_second,
+      stats.records_per_second, stats.eta_seconds);
+}
+
+Status KVEngine::startLazyRecovery() {
+  // Rebuild threads use thread ids after the ones of access threads, so they
+  // never share thread caches or access thread slots with the first
+  // max_access_threads access threads
+  Status s = prepareRecovery(numLazyRebuildThreads(configs_),
+                             configs_.max_access_threads);
+  if (s != Status::Ok) {
+    return s;
+  }
+
+  recovery_signals_.restored_types.store(0, std::memory_order_release);
+  recovery_thread_ = std::thread(&KVEngine::backgroundLazyRecovery, this);
   return Status::Ok;
 }
 
+void KVEngine::backgroundLazyRecovery() {
+  auto publish = [&](uint8_t types) {
+    std::lock_guard<std::mutex> lg(recovery_signals_.mu);
+    recovery_signals_.restored_types.fetch_or(types,
+                                              std::memory_order_release);
+    recovery_signals_.cv.notify_all();
+  };
+
+  // No access thread is running until data segments restored
+  Status s = restoreDataSegments();
+  if (s == Status::Ok) {
+    publish(RecordType::String);
+    GlobalLogger.Info("String records are accessible\n");
+  }
+
+  std::vector<RecordType> to_rebuild{RecordType::SortedRecord,
+                                     RecordType::ListRecord,
+                                     RecordType::HashRecord};
+  while (s == Status::Ok && !to_rebuild.empty()) {
+    // Rebuild the first accessed collection type first
+    auto next = to_rebuild.begin();
+    {
+      std::lock_guard<std::mutex> lg(recovery_signals_.mu);
+      for (RecordType type : recovery_signals_.demanded_types) {
+        auto iter = std::find(to_rebuild.begin(), to_rebuild.end(), type);
+        if (iter != to_rebuild.end()) {
+          next = iter;
+          break;
+        }
+      }
+    }
+    RecordType type = *next;
+    to_rebuild.erase(next);
+
+    s = runInRecoverySlots([&]() { return rebuildCollections(type); });
+    if (s == Status::Ok) {
+      uint8_t elem_type = type == RecordType::SortedRecord
+                              ? RecordType::SortedElem
+                              : type == RecordType::ListRecord
+                                    ? RecordType::ListElem
+                                    : RecordType::HashElem;
+      publish(type | elem_type);
+    }
+  }
+
+  if (s == Status::Ok) {
+    s = runInRecoverySlots([&]() { return finishRecovery(); });
+  }
+
+  if (s != Status::Ok) {
+    // Open() already returned, so report the failure to requests of types not
+    // restored yet, the restored ones are still served
+    GlobalLogger.Error("Lazy recovery failed: %d\n", s);
+    std::lock_guard<std::mutex> lg(recovery_signals_.mu);
+    recovery_signals_.status = s;
+    recovery_signals_.cv.notify_all();
+    return;
+  }
+
+  startBackgroundWorks();
+  publish(0xff);
+  GlobalLogger.Info("Lazy recovery done\n");
+  ReportPMemUsage();
+}
+
+Status KVEngine::runInRecoverySlots(std::function<Status()> func) {
+  // Rebuild threads use thread ids in [max_access_threads,
+  // max_access_threads + numLazyRebuildThreads()), access threads leased
+  // these ids, e.g. elastic ones or any beyond max_access_threads, wait on
+  // the slots until func done
+  uint64_t first_tid = configs_.max_access_threads;
+  return std::async(std::launch::async, [&]() {
+           std::vector<std::unique_ptr<AccessThreadCV::Holder>> holders;
+           for (uint64_t i = 0; i < numLazyRebuildThreads(configs_); i++) {
+             holders.emplace_back(new AccessThreadCV::Holder(
+                 &access_thread_cv_[first_tid + i],
+                 AccessThreadCV::kRecoveryHolder));
+           }
+           this_thread.id = first_tid;
+           Status s = func();
+           TEST_SYNC_POINT_CALLBACK("KVEngine::runInRecoverySlots", &s);
+           return s;
+         }).get();
+}
+
+Status KVEngine::waitRecovery(uint8_t type_mask) {
+  std::unique_lock<std::mutex> ul(recovery_signals_.mu);
+  for (RecordType type : {RecordType::SortedRecord, RecordType::ListRecord,
+                          RecordType::HashRecord}) {
+    if ((type_mask & type) &&
+        !(recovery_signals_.restored_types.load() & type) &&
+        std::find(recovery_signals_.demanded_types.begin(),
+                  recovery_signals_.demanded_types.end(),
+                  type) == recovery_signals_.demanded_types.end()) {
+      recovery_signals_.demanded_types.push_back(type);
+    }
+  }
+  recovery_signals_.cv.wait(ul, [&]() {
+    return (recovery_signals_.restored_types.load() & type_mask) ==
+               type_mask ||
+           recovery_signals_.status != Status::Ok;
+  });
+  return (recovery_signals_.restored_types.load() & type_mask) == type_mask
+             ? Status::Ok
+             : recovery_signals_.status;
+}
+
 Status KVEngine::checkConfigs(const Configs& configs) {
   auto is_2pown = [](uint64_t n) { return (n > 0) && (n & (n - 1)) == 0; };
 
@@ -844,11 +1296,12 @@ Status KVEngine::checkConfigs(const Configs& configs) {
   }
 
   if (configs.pmem_segment_blocks * configs.pmem_block_size *
-          configs.max_access_threads >
+          maxConcurrentThreads(configs) >
       configs.pmem_file_size) {
     GlobalLogger.Error(
         "pmem file too small, should larger than pmem_segment_blocks * "
-        "pmem_block_size * max_access_threads\n");
+        "pmem_block_size * max(max_access_threads, "
+        "max_elastic_access_threads)\n");
     return Status::InvalidConfiguration;
   }
 
@@ -875,7 +1328,11 @@ Status KVEngine::checkConfigs(const Configs& configs) {
 
 Status KVEngine::maybeInitBatchLogFile() {
   kvdk_assert(ThreadManager::ThreadID() >= 0, "");
-  auto work_id = ThreadManager::ThreadID() % configs_.max_access_threads;
+  if (configs_.volatile_mode) {
+    // Batch writes are not logged, see BatchWriteLog::EncodeTo()
+    return Status::Ok;
+  }
+  auto work_id = ThreadManager::ThreadID() % engine_thread_cache_.size();
   auto& tc = engine_thread_cache_[work_id];
   if (tc.batch_log == nullptr) {
     int is_pmem;
@@ -887,13 +1344,16 @@ Status KVEngine::maybeInitBatchLogFile() {
       GlobalLogger.Error("Fail to Init BatchLog file. %s\n", strerror(errno));
       return Status::PMemMapFileError;
     }
-    kvdk_assert(is_pmem != 0 && mapped_len >= BatchWriteLog::MaxBytes(), "");
+    kvdk_assert(
+        mappedPMem(is_pmem) && mapped_len >= BatchWriteLog::MaxBytes(), "");
     tc.batch_log = static_cast<char*>(addr);
   }
   return Status::Ok;
 }
 
 Status KVEngine::BatchWrite(std::unique_ptr<WriteBatch> const& batch) {
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpBatchWrite);
+  Tracer::Op trace_op(&tracer_, "BatchWrite");
   const WriteBatchImpl* batch_impl =
       dynamic_cast<const WriteBatchImpl*>(batch.get());
   if (batch_impl == nullptr) {
@@ -915,7 +1375,10 @@ Status KVEngine::batchWriteImpl(WriteBatchImpl const& batch, bool lock_key) {
     return Status::InvalidBatchSize;
   }
 
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(PrimaryRecordType);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   Status s = maybeInitBatchLogFile();
   if (s != Status::Ok) {
@@ -965,6 +1428,7 @@ Status KVEngine::batchWriteImpl(WriteBatchImpl const& batch, bool lock_key) {
     hash_args.emplace_back(
         hlist->InitWriteArgs(hash_op.key, hash_op.value, hash_op.op));
   }
+  Tracer::Stage("lookup");
 
   // Keys/internal keys to be locked on HashTable
   std::vector<std::string> keys_to_lock;
@@ -980,7 +1444,9 @@ Status KVEngine::batchWriteImpl(WriteBatchImpl const& batch, bool lock_key) {
     }
   }
 
+  HashTable::WriteScope write_scope;
   auto guard = hash_table_->RangeLock(keys_to_lock);
+  Tracer::Stage("lock");
   keys_to_lock.clear();
 
   // Lookup keys, allocate space according to result.
@@ -1044,7 +1510,7 @@ Status KVEngine::batchWriteImpl(WriteBatchImpl const& batch, bool lock_key) {
   BatchWriteLog log;
   log.SetTimestamp(bw_token.Timestamp());
   auto& tc = engine_thread_cache_[ThreadManager::ThreadID() %
-                                  configs_.max_access_threads];
+                                  engine_thread_cache_.size()];
   for (auto& args : string_args) {
     if (args.space.size == 0) {
       continue;
@@ -1077,9 +1543,10 @@ Status KVEngine::batchWriteImpl(WriteBatchImpl const& batch, bool lock_key) {
     }
   }
 
-  log.EncodeTo(tc.batch_log);
+  log.EncodeTo(persistPolicy(), tc.batch_log);
 
-  BatchWriteLog::MarkProcessing(tc.batch_log);
+  BatchWriteLog::MarkProcessing(persistPolicy(), tc.batch_log);
+  Tracer::Stage("log");
 
   // After preparation stage, no runtime error is allowed for now,
   // otherwise we have to perform runtime rollback.
@@ -1113,7 +1580,12 @@ Status KVEngine::batchWriteImpl(WriteBatchImpl const& batch, bool lock_key) {
 
   TEST_CRASH_POINT("KVEngine::batchWriteImpl::BeforeCommit", "");
 
-  BatchWriteLog::MarkCommitted(tc.batch_log);
+  // The batch is committed after relaxed writes before it are durable, and
+  // its string records are not discarded in recovery
+  orderStrictWrite();
+
+  BatchWriteLog::MarkCommitted(persistPolicy(), tc.batch_log);
+  Tracer::Stage("commit");
 
   // Publish stages is where Strings and Collections make BatchWrite
   // visible to other threads.
@@ -1156,6 +1628,9 @@ Status KVEngine::batchWriteImpl(WriteBatchImpl const& batch, bool lock_key) {
 }
 
 Status KVEngine::batchWriteRollbackLogs() {
+  if (configs_.volatile_mode) {
+    return Status::Ok;
+  }
   DIR* dir = opendir(batch_log_dir_.c_str());
   if (dir == NULL) {
     GlobalLogger.Error("Fail to opendir in batchWriteRollbackLogs. %s\n",
@@ -1178,7 +1653,8 @@ Status KVEngine::batchWriteRollbackLogs() {
                          strerror(errno));
       return Status::PMemMapFileError;
     }
-    kvdk_assert(is_pmem != 0 && mapped_len >= BatchWriteLog::MaxBytes(), "");
+    kvdk_assert(
+        mappedPMem(is_pmem) && mapped_len >= BatchWriteLog::MaxBytes(), "");
 
     BatchWriteLog log;
     log.DecodeFrom(static_cast<char*>(addr));
@@ -1212,7 +1688,7 @@ Status KVEngine::batchWriteRollbackLogs() {
         return s;
       }
     }
-    log.MarkInitializing(static_cast<char*>(addr));
+    log.MarkInitializing(persistPolicy(), static_cast<char*>(addr));
     if (pmem_unmap(addr, mapped_len) != 0) {
       GlobalLogger.Error("Fail to Rollback BatchLog file. %s\n",
                          strerror(errno));
@@ -1228,6 +1704,10 @@ Status KVEngine::batchWriteRollbackLogs() {
 
 Status KVEngine::GetTTL(const StringView key, TTLType* ttl_time) {
   *ttl_time = kInvalidTTL;
+  Status recovery_status = maybeWaitRecovery(ExpirableRecordType);
+  if (recovery_status != Status::Ok) {
+    return recovery_status;
+  }
   auto ul = hash_table_->AcquireLock(key);
   auto res = lookupKey<false>(key, ExpirableRecordType);
 
@@ -1261,6 +1741,10 @@ Status KVEngine::GetTTL(const StringView key, TTLType* ttl_time) {
 }
 
 Status KVEngine::TypeOf(StringView key, ValueType* type) {
+  Status recovery_status = maybeWaitRecovery(ExpirableRecordType);
+  if (recovery_status != Status::Ok) {
+    return recovery_status;
+  }
   auto res = lookupKey<false>(key, ExpirableRecordType);
 
   if (res.s == Status::Ok) {
@@ -1270,11 +1754,25 @@ Status KVEngine::TypeOf(StringView key, ValueType* type) {
         break;
       }
       case PointerType::List: {
-        *type = ValueType::List;
+        *type = res.entry_ptr->GetIndex().list->GetKind() == List::Kind::Stream
+                    ? ValueType::Stream
+                    : ValueType::List;
         break;
       }
       case PointerType::HashList: {
-        *type = ValueType::HashCollection;
+        switch (res.entry_ptr->GetIndex().hlist->GetKind()) {
+          case HashList::Kind::Set:
+            *type = ValueType::Set;
+            break;
+          case HashList::Kind::ZSet:
+            *type = ValueType::ZSet;
+            break;
+          case HashList::Kind::TimeSeries:
+            *type = ValueType::TimeSeries;
+            break;
+          default:
+            *type = ValueType::HashCollection;
+        }
         break;
       }
       case PointerType::StringRecord: {
@@ -1290,7 +1788,12 @@ Status KVEngine::TypeOf(StringView key, ValueType* type) {
 }
 
 Status KVEngine::Expire(const StringView key, TTLType ttl_time) {
-  auto thread_holder = AcquireAccessThread();
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpExpire);
+  Tracer::Op trace_op(&tracer_, "Expire");
+  auto thread_holder = AcquireAccessThread(PrimaryRecordType);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   int64_t base_time = TimeUtils::millisecond_time();
   if (!TimeUtils::CheckTTL(ttl_time, base_time)) {
@@ -1307,22 +1810,16 @@ Status KVEngine::Expire(const StringView key, TTLType ttl_time) {
   }
 
   if (lookup_result.s == Status::Ok) {
-    WriteOptions write_option{ttl_time};
     switch (lookup_result.entry_ptr->GetIndexType()) {
       case PointerType::StringRecord: {
         ul.unlock();
         version_controller_.ReleaseLocalSnapshot();
-        lookup_result.s = Modify(
-            key,
-            [](const std::string* old_val, std::string* new_val, void*) {
-              new_val->assign(*old_val);
-              return ModifyOperation::Write;
-            },
-            nullptr, write_option);
+        lookup_result.s = stringExpireImpl(key, expired_time);
         break;
       }
       case PointerType::Skiplist: {
         auto new_ts = snapshot_holder.Timestamp();
+        orderStrictWrite();
         Skiplist* skiplist = lookup_result.entry_ptr->GetIndex().skiplist;
         std::unique_lock<std::mutex> skiplist_lock(skiplists_mu_);
         expirable_skiplists_.erase(skiplist);
@@ -1333,6 +1830,7 @@ Status KVEngine::Expire(const StringView key, TTLType ttl_time) {
       }
       case PointerType::HashList: {
         auto new_ts = snapshot_holder.Timestamp();
+        orderStrictWrite();
         HashList* hlist = lookup_result.entry_ptr->GetIndex().hlist;
         std::unique_lock<std::mutex> hlist_lock(hlists_mu_);
         expirable_hlists_.erase(hlist);
@@ -1342,6 +1840,7 @@ Status KVEngine::Expire(const StringView key, TTLType ttl_time) {
       }
       case PointerType::List: {
         auto new_ts = snapshot_holder.Timestamp();
+        orderStrictWrite();
         List* list = lookup_result.entry_ptr->GetIndex().list;
         lookup_result.s = list->SetExpireTime(expired_time, new_ts).s;
         break;
@@ -1434,22 +1933,23 @@ T* KVEngine::removeOutDatedVersion(T* record, TimestampType min_snapshot_ts) {
   auto old_record = record;
   while (old_record && old_record->GetTimestamp() > min_snapshot_ts) {
     old_record =
-        static_cast<T*>(pmem_allocator_->offset2addr(old_record->old_version));
+        static_cast<T*>(
+            pmem_allocator_->offset2addr(old_record->GetOldVersion()));
   }
 
   // the snapshot should access the old record, so we need to purge and free the
   // older version of the old record
-  if (old_record && old_record->old_version != kNullPMemOffset) {
+  if (old_record && old_record->GetOldVersion() != kNullPMemOffset) {
     T* remove_record =
-        pmem_allocator_->offset2addr_checked<T>(old_record->old_version);
+        pmem_allocator_->offset2addr_checked<T>(old_record->GetOldVersion());
     ret = remove_record;
-    old_record->PersistOldVersion(kNullPMemOffset);
+    old_record->PersistOldVersion(persistPolicy(), kNullPMemOffset);
     while (remove_record != nullptr) {
       if (remove_record->GetRecordStatus() == RecordStatus::Normal) {
-        remove_record->PersistStatus(RecordStatus::Dirty);
+        remove_record->PersistStatus(persistPolicy(), RecordStatus::Dirty);
       }
       remove_record =
-          pmem_allocator_->offset2addr<T>(remove_record->old_version);
+          pmem_allocator_->offset2addr<T>(remove_record->GetOldVersion());
     }
   }
   return ret;
@@ -1460,6 +1960,21 @@ template StringRecord* KVEngine::removeOutDatedVersion<StringRecord>(
 template DLRecord* KVEngine::removeOutDatedVersion<DLRecord>(DLRecord*,
                                                              TimestampType);
 
+std::unique_ptr<AsyncQueue> KVEngine::AsyncQueueCreate(
+    size_t queue_depth, AsyncCallback callback) {
+  if (configs_.async_threads == 0 || queue_depth == 0) {
+    return nullptr;
+  }
+  {
+    std::lock_guard<std::mutex> lg(async_executor_mu_);
+    if (async_executor_ == nullptr) {
+      async_executor_.reset(new AsyncExecutor(this, configs_.async_threads));
+    }
+  }
+  return std::unique_ptr<AsyncQueue>(new AsyncQueueImpl(
+      async_executor_.get(), queue_depth, std::move(callback)));
+}
+
 }  // namespace KVDK_NAMESPACE
 
 // Snapshot, delayFree and background work
@@ -1467,43 +1982,36 @@ namespace KVDK_NAMESPACE {
 
 /// TODO: move this into VersionController.
 Snapshot* KVEngine::GetSnapshot(bool make_checkpoint) {
+  // Checkpoint is released at the end of recovery
+  if (maybeWaitRecovery(make_checkpoint ? uint8_t(PrimaryRecordType)
+                                        : uint8_t(RecordType::String)) !=
+      Status::Ok) {
+    return nullptr;
+  }
   Snapshot* ret = version_controller_.NewGlobalSnapshot();
 
   if (make_checkpoint) {
     std::lock_guard<std::mutex> lg(checkpoint_lock_);
     persist_checkpoint_->MakeCheckpoint(ret);
-    pmem_persist(persist_checkpoint_, sizeof(CheckPoint));
+    persistPolicy().Persist(persist_checkpoint_, sizeof(CheckPoint));
   }
 
   return ret;
 }
 
-void KVEngine::backgroundPMemUsageReporter() {
-  auto interval = std::chrono::milliseconds{
-      static_cast<std::uint64_t>(configs_.report_pmem_usage_interval * 1000)};
-  while (!bg_work_signals_.terminating) {
-    {
-      std::unique_lock<SpinMutex> ul(bg_work_signals_.terminating_lock);
-      if (!bg_work_signals_.terminating) {
-        bg_work_signals_.pmem_usage_reporter_cv.wait_for(ul, interval);
-      }
-    }
-    ReportPMemUsage();
-    GlobalLogger.Info("Cleaner Thread Num: %ld\n", cleaner_.ActiveThreadNum());
+bool KVEngine::backgroundPMemUsageReporter(const TaskBudget&) {
+  ReportPMemUsage();
+  GlobalLogger.Info("Cleaner Thread Num: %ld\n", cleaner_.ActiveThreadNum());
+  for (auto& stats : bg_executor_.GetStats()) {
+    GlobalLogger.Info(
+        "Background task %s: %lu runs, %lu over budget, %.3f busy seconds\n",
+        stats.name.c_str(), stats.runs, stats.overruns, stats.busy_seconds);
   }
+  return false;
 }
 
-void KVEngine::backgroundPMemAllocatorOrgnizer() {
-  auto interval = std::chrono::milliseconds{
-      static_cast<std::uint64_t>(configs_.background_work_interval * 1000)};
-  while (!bg_work_signals_.terminating) {
-    {
-      std::unique_lock<SpinMutex> ul(bg_work_signals_.terminating_lock);
-      if (!bg_work_signals_.terminating) {
-        bg_work_signals_.pmem_allocator_organizer_cv.wait_for(ul, interval);
-      }
-    }
-    pmem_allocator_->BackgroundWork();
-  }
+bool KVEngine::backgroundPMemAllocatorOrgnizer(const TaskBudget&) {
+  pmem_allocator_->BackgroundWork();
+  return false;
 }
 }  // namespace KVDK_NAMESPACE
@@ -10,6 +10,7 @@
 #include <cstdint>
 #include <ctime>
 #include <deque>
+#include <functional>
 #include <iostream>
 #include <list>
 #include <memory>
@@ -20,6 +21,10 @@
 #include <vector>
 
 #include "alias.hpp"
+#include "async_impl.hpp"
+#include "background_executor.hpp"
+#include "cold_tier.hpp"
+#include "collection_registry.hpp"
 #include "data_record.hpp"
 #include "dram_allocator.hpp"
 #include "hash_collection/hash_list.hpp"
@@ -36,6 +41,8 @@
 #include "structures.hpp"
 #include "thread_manager.hpp"
 #include "transaction_impl.hpp"
+#include "utils/statistics.hpp"
+#include "utils/trace.hpp"
 #include "utils/utils.hpp"
 #include "version/old_records_cleaner.hpp"
 #include "version/version_controller.hpp"
@@ -71,6 +78,30 @@ class KVEngine : public Engine {
   }
   void ReportPMemUsage();
 
+  RecoveryStats GetRecoveryStats() final;
+
+  Status Flush() final;
+
+  Statistics GetStatistics() final;
+
+  void EnableStatistics(bool enable) final { stats_.Enable(enable); }
+
+  void SetTraceSampleInterval(uint64_t interval) final {
+    tracer_.SetSampleInterval(interval);
+  }
+
+  Status DumpTrace(const std::string& path) final {
+    return tracer_.Dump(path);
+  }
+
+  HotKeys GetHotKeys(uint32_t k) final { return hash_table_->GetHotKeys(k); }
+
+  void SetHotKeySampleInterval(uint64_t interval) final {
+    hash_table_->SetHotKeySampleInterval(interval);
+  }
+
+  void ResetHotKeys() final { hash_table_->ResetHotKeys(); }
+
   // Expire str after ttl_time
   //
   // Notice:
@@ -89,6 +120,8 @@ class KVEngine : public Engine {
 
   // String
   Status Get(const StringView key, std::string* value) final;
+  Status GetChunks(const StringView key, ValueChunkFunc chunk_func,
+                   void* chunk_args) final;
   Status Put(const StringView key, const StringView value,
              const WriteOptions& write_options) final;
   Status Delete(const StringView key) final;
@@ -157,6 +190,58 @@ class KVEngine : public Engine {
                                    Status* s) final;
   void HashIteratorRelease(HashIterator*) final;
 
+  // Set
+  Status SetCreate(StringView set) final;
+  Status SetDestroy(StringView set) final;
+  Status SetAdd(StringView set, StringView member) final;
+  Status SetRemove(StringView set, StringView member) final;
+  Status SetIsMember(StringView set, StringView member,
+                     bool* is_member) final;
+  Status SetCard(StringView set, size_t* card) final;
+  Status SetScan(StringView set,
+                 std::function<bool(StringView member)> visitor) final;
+  Status SetIntersect(const std::vector<StringView>& sets,
+                      std::vector<std::string>* members,
+                      bool integer_members) final;
+  Status SetUnion(const std::vector<StringView>& sets,
+                  std::vector<std::string>* members) final;
+
+  // Sorted Set
+  Status ZSetCreate(StringView zset) final;
+  Status ZSetDestroy(StringView zset) final;
+  Status ZAdd(StringView zset, StringView member, double score) final;
+  Status ZIncrBy(StringView zset, StringView member, double increment,
+                 double* new_score) final;
+  Status ZRem(StringView zset, StringView member) final;
+  Status ZScore(StringView zset, StringView member, double* score) final;
+  Status ZCard(StringView zset, size_t* card) final;
+  Status ZRank(StringView zset, StringView member, size_t* rank) final;
+  Status ZRangeByScore(StringView zset, double min_score, double max_score,
+                       std::vector<std::pair<std::string, double>>* members,
+                       size_t limit) final;
+
+  // Stream
+  Status StreamCreate(StringView stream) final;
+  Status StreamDestroy(StringView stream) final;
+  Status XAdd(StringView stream, StringView entry, uint64_t* id) final;
+  Status XLen(StringView stream, size_t* len) final;
+  Status XRange(StringView stream, uint64_t start_id, uint64_t end_id,
+                std::vector<std::pair<uint64_t, std::string>>* entries,
+                size_t count) final;
+  Status XRead(StringView stream, uint64_t last_id, size_t count,
+               std::vector<std::pair<uint64_t, std::string>>* entries) final;
+  Status XTrim(StringView stream, uint64_t min_id, size_t* trimmed) final;
+
+  // Time Series
+  Status TSCreate(StringView series, int64_t bucket_width) final;
+  Status TSDestroy(StringView series) final;
+  Status TSAppend(StringView series, int64_t timestamp, double value) final;
+  Status TSRange(StringView series, int64_t start, int64_t end,
+                 std::vector<std::pair<int64_t, double>>* samples) final;
+  Status TSAggregate(StringView series, int64_t start, int64_t end,
+                     int64_t window,
+                     std::vector<TimeSeriesAggregate>* aggregates) final;
+
   // BatchWrite
   // It takes 3 stages
   // Stage 1: Preparation
@@ -175,9 +260,16 @@ class KVEngine : public Engine {
   }
 
   std::unique_ptr<Transaction> TransactionCreate() final {
+    // Transaction locks keys in hash table, so wait recovery before it starts
+    if (maybeWaitRecovery(PrimaryRecordType) != Status::Ok) {
+      return nullptr;
+    }
     return std::unique_ptr<Transaction>(new TransactionImpl(this));
   }
 
+  std::unique_ptr<AsyncQueue> AsyncQueueCreate(size_t queue_depth,
+                                               AsyncCallback callback) final;
+
   // Call this function before doing collection related transaction to avoid
   // collection be destroyed during transaction
   std::unique_ptr<CollectionTransactionCV::TransactionToken>
@@ -189,26 +281,33 @@ class KVEngine : public Engine {
   Status CommitTransaction(TransactionImpl* txn);
 
   // For test cases
-  const std::unordered_map<CollectionIDType, std::shared_ptr<Skiplist>>&
+  std::unordered_map<CollectionIDType, std::shared_ptr<Skiplist>>
   GetSkiplists() {
-    return skiplists_;
+    return skiplists_.Snapshot();
   };
   Cleaner* EngineCleaner() { return &cleaner_; }
   HashTable* GetHashTable() { return hash_table_.get(); }
   void TestCleanOutDated(size_t start_slot_idx, size_t end_slot_idx);
+  // Visit all string keys as the cleaner does in the next cooling period to
+  // demote cold values, see Configs::cold_tier_path
+  void TestDemoteColdStrings();
 
  private:
   friend OldRecordsCleaner;
   friend Cleaner;
 
   KVEngine(const Configs& configs)
-      : access_thread_cv_(configs.max_access_threads),
-        engine_thread_cache_(configs.max_access_threads),
-        cleaner_thread_cache_(configs.max_access_threads),
-        version_controller_(configs.max_access_threads),
-        old_records_cleaner_(this, configs.max_access_threads),
-        cleaner_(this, configs.clean_threads),
-        comparators_(configs.comparator){};
+      : access_thread_cv_(numAccessSlots(configs)),
+        engine_thread_cache_(numThreadCaches(configs)),
+        cleaner_thread_cache_(numThreadCaches(configs)),
+        bg_executor_(numBackgroundThreads(configs), configs.background_cpus,
+                     configs.background_nice),
+        version_controller_(numThreadCaches(configs)),
+        old_records_cleaner_(this, numThreadCaches(configs)),
+        cleaner_(this, configs.clean_threads, &bg_executor_),
+        comparators_(configs.comparator),
+        stats_(numThreadCaches(configs)),
+        tracer_(numThreadCaches(configs), configs.trace_buffer_events){};
 
   struct EngineThreadCache {
     EngineThreadCache() = default;
@@ -216,7 +315,6 @@ class KVEngine : public Engine {
     char* batch_log = nullptr;
 
     // Info used in recovery
-    uint64_t newest_restored_ts = 0;
     std::unordered_map<uint64_t, int> visited_skiplist_ids{};
   };
 
@@ -238,40 +336,108 @@ class KVEngine : public Engine {
 
   struct AccessThreadCV {
    public:
+    // Holder ids of a slot besides thread ids of access threads, which are
+    // never negative. Lazy rebuild threads hold slots by kRecoveryHolder, so
+    // an access thread that shares thread caches with them always waits
+    enum : int64_t { kFreeHolder = -1, kRecoveryHolder = -2 };
+
     struct Holder {
      public:
-      Holder(AccessThreadCV* cv) : cv_(cv) { cv->Acquire(); }
-      ~Holder() { cv_->Release(); }
+      Holder(AccessThreadCV* cv)
+          : Holder(cv, ThreadManager::ThreadID()) {}
+      // Hold the slot on behalf of "owner" rather than id of this thread,
+      // "owner" should be negative so no access thread re-enters the slot.
+      // A nested holder of the same owner releases nothing
+      Holder(AccessThreadCV* cv, int64_t owner)
+          : cv_(cv->Acquire(owner) ? cv : nullptr), status_(Status::Ok) {}
+      // Hold no slot as the access failed with "status"
+      Holder(Status status) : cv_(nullptr), status_(status) {}
+      ~Holder() {
+        if (cv_ != nullptr) {
+          cv_->Release();
+        }
+      }
+
+      // Status::Ok if the slot is held, otherwise error that the access should
+      // return, i.e. failure of lazy recovery
+      Status status() const { return status_; }
 
      private:
       AccessThreadCV* cv_;
+      Status status_;
     };
 
    private:
-    void Acquire() {
+    // Return false if "id" already holds the slot
+    bool Acquire(int64_t id) {
+      int64_t holder = kFreeHolder;
+      // Fast path: the slot is free or already held by "id", which is the
+      // common case if threads are less than slots
+      if (tryAcquire(id, &holder)) {
+        return true;
+      }
+      if (holder == id) {
+        return false;
+      }
       std::unique_lock<SpinMutex> ul(spin_);
-      while (holder_id_ != ThreadManager::ThreadID() && holder_id_ != -1) {
+      waiters_.fetch_add(1);
+      while (!tryAcquire(id, &holder)) {
         cv_.wait(ul);
       }
-      holder_id_ = ThreadManager::ThreadID();
+      waiters_.fetch_sub(1);
+      return true;
     }
 
     void Release() {
-      std::unique_lock<SpinMutex> ul(spin_);
-      holder_id_ = -1;
-      cv_.notify_one();
+      holder_id_.store(kFreeHolder);
+      if (waiters_.load() > 0) {
+        std::unique_lock<SpinMutex> ul(spin_);
+        cv_.notify_one();
+      }
     }
 
-    int64_t holder_id_ = -1;
+    bool tryAcquire(int64_t id, int64_t* holder) {
+      *holder = kFreeHolder;
+      return holder_id_.compare_exchange_strong(*holder, id);
+    }
+
+    std::atomic<int64_t> holder_id_{kFreeHolder};
+    std::atomic<uint64_t> waiters_{0};
     SpinMutex spin_;
     std::condition_variable_any cv_;
   };
 
-  AccessThreadCV::Holder AcquireAccessThread() {
+  // Acquire access thread slot of this thread. "type_mask" indicates record
+  // types the request accesses, it will wait until these types are restored
+  // in lazy recovery, and hold no slot if lazy recovery failed before that,
+  // check status() of the returned holder
+  AccessThreadCV::Holder AcquireAccessThread(uint8_t type_mask) {
+    Status s = maybeWaitRecovery(type_mask);
+    if (s != Status::Ok) {
+      return AccessThreadCV::Holder(s);
+    }
     return AccessThreadCV::Holder(&access_thread_cv_[ThreadManager::ThreadID() %
                                                      access_thread_cv_.size()]);
   }
 
+  // Wait until record types in "type_mask" are restored, return immediately
+  // if the instance is not in lazy recovery. Return error of lazy recovery if
+  // it failed before these types restored
+  Status maybeWaitRecovery(uint8_t type_mask) {
+    if ((recovery_signals_.restored_types.load(std::memory_order_acquire) &
+         type_mask) != type_mask) {
+      return waitRecovery(type_mask);
+    }
+    return Status::Ok;
+  }
+
+  Status waitRecovery(uint8_t type_mask);
+
+  // Persistence primitives of the instance, see PersistPolicy
+  PersistPolicy& persistPolicy() {
+    return pmem_allocator_->GetPersistPolicy();
+  }
+
   bool checkKeySize(const StringView& key) { return key.size() <= UINT16_MAX; }
 
   bool checkValueSize(const StringView& value) {
@@ -418,6 +584,93 @@ class KVEngine : public Engine {
 
   Status stringDeleteImpl(const StringView& key);
 
+  // If value of "key" should be stored in extents rather than its record,
+  // either as a large value or a blob
+  bool storeInExtents(const StringView& key, const StringView& value) {
+    return (configs_.large_value_threshold > 0 &&
+            value.size() >= configs_.large_value_threshold) ||
+           (configs_.blob_value_threshold > 0 &&
+            value.size() >= configs_.blob_value_threshold) ||
+           key.size() + value.size() + sizeof(StringRecord) >
+               pmem_allocator_->SegmentSize();
+  }
+
+  // Persist "value" to a chain of extents and store the encoded ExtentRef to
+  // "extent_ref", which should be persisted as value of the string record
+  Status persistExtents(const StringView& value, std::string* extent_ref);
+
+  // Add a reference to extents starting at "first", as a new version of a
+  // string record shares them with the existing one
+  void shareExtents(PMemOffsetType first);
+
+  // Drop a reference to extents starting at "first" as its record is purged,
+  // and free them if it's the last one
+  void releaseExtents(PMemOffsetType first);
+
+  // Update expire time of string "key" by a new record, which shares value
+  // of the existing one if it's stored in extents
+  Status stringExpireImpl(const StringView& key, ExpireTimeType expired_time);
+
+  // Free extents persisted by persistExtents() but not referenced by any
+  // record, as writing the record failed
+  void abandonExtents(const std::string& extent_ref);
+
+  // Encode "value" of string "key" to be persisted in its record, which may
+  // compress it (see Configs::value_compression) and persist it to extents.
+  // "record_value" is set to the bytes to store in the record, which point
+  // to either "value" or "buffer", and "value_flags" to flags of the record
+  Status encodeStringValue(const StringView& key, const StringView& value,
+                           const WriteOptions& write_options,
+                           StringView* record_value, std::string* buffer,
+                           uint8_t* value_flags);
+
+  // Call "chunk_func" on each chunk of bytes of "record" as stored in PMem,
+  // which are compressed if the record IsCompressed()
+  void visitStoredValue(
+      const StringRecord* record,
+      const std::function<bool(const StringView&)>& chunk_func);
+
+  // Call "chunk_func" on each chunk of value of "record" in order, until it
+  // returns false. A compressed value is decompressed to a single chunk
+  Status visitStringValue(
+      const StringRecord* record,
+      const std::function<bool(const StringView&)>& chunk_func);
+
+  // Copy value of "record" to "value", a compressed value is decompressed
+  // directly into it
+  Status readStringValue(const StringRecord* record, std::string* value);
+
+  // A string key picked by the cleaner to demote its value to the cold tier
+  struct ColdCandidate {
+    std::string key;
+    StringRecord* record;
+    TimestampType ts;
+  };
+
+  // Index of the current cooling period, see
+  // Configs::cold_tier_cooling_period
+  uint64_t coolingPeriod() const {
+    uint64_t period_ms = std::max<uint64_t>(
+        1, static_cast<uint64_t>(configs_.cold_tier_cooling_period * 1000));
+    return static_cast<uint64_t>(TimeUtils::millisecond_time()) / period_ms +
+           test_cooling_periods_.load(std::memory_order_relaxed);
+  }
+
+  // Decay heat of the string key indexed by "entry" as the cleaner visits it
+  // in cooling period "period", return true if its value should be demoted to
+  // the cold tier
+  bool coolString(HashEntry* entry, uint64_t period);
+
+  // Demote values of "candidates" to the cold tier, a key updated after it's
+  // picked is skipped. A value promoted from the cold tier reuses its entry
+  // if it's unchanged
+  void demoteColdStrings(const std::vector<ColdCandidate>& candidates);
+
+  // Write "value" of cold "record" of "key" back to PMem with a ColdCopy,
+  // unless the key is updated after "record" is read
+  void promoteString(const StringView& key, const StringRecord* record,
+                     TimestampType ts, const StringView& value);
+
   Status stringWritePrepare(StringWriteArgs& args, TimestampType ts);
   Status stringWrite(StringWriteArgs& args);
   Status stringWritePublish(StringWriteArgs const& args);
@@ -431,6 +684,93 @@ class KVEngine : public Engine {
 
   Status restoreExistingData();
 
+  // Create rebuilders, whose rebuild threads use thread ids in
+  // [first_rebuild_tid, first_rebuild_tid + num_rebuild_threads), and rollback
+  // unfinished batch writes
+  Status prepareRecovery(uint64_t num_rebuild_threads,
+                         uint64_t first_rebuild_tid);
+
+  // Scan data segments to restore string records and index collection
+  // headers, string records are accessible after this done
+  Status restoreDataSegments();
+
+  // Rebuild index of collections with header type "type"
+  Status rebuildCollections(RecordType type);
+
+  Status finishRecovery();
+
+  void reportRecoveryProgress();
+
+  // Number of threads to restore data in recovery
+  static uint64_t numRecoveryThreads(const Configs& configs) {
+    return configs.recovery_threads == 0 ? configs.max_access_threads
+                                         : configs.recovery_threads;
+  }
+  uint64_t numRecoveryThreads() const { return numRecoveryThreads(configs_); }
+
+  // Number of threads to rebuild collections in lazy recovery, they use
+  // thread ids in [max_access_threads, max_access_threads + this number)
+  static uint64_t numLazyRebuildThreads(const Configs& configs) {
+    return std::max<uint64_t>(1, configs.max_access_threads / 2);
+  }
+
+  // Number of per-thread caches of engine components. Recovery threads,
+  // lazy rebuild threads and elastic access threads may be more than
+  // max_access_threads, so it's rounded up to a multiple of
+  // max_access_threads, thus threads sharing a cache always share an access
+  // thread slot as well
+  static uint64_t numThreadCaches(const Configs& configs) {
+    uint64_t n = configs.max_access_threads;
+    uint64_t num_threads = std::max({n, numRecoveryThreads(configs),
+                                     configs.max_elastic_access_threads});
+    if (configs.lazy_recovery) {
+      num_threads = std::max(num_threads, n + numLazyRebuildThreads(configs));
+    }
+    return (num_threads + n - 1) / n * n;
+  }
+  uint64_t numThreadCaches() const { return numThreadCaches(configs_); }
+
+  // Max number of access threads alive at the same time, each of them may
+  // hold a PMem segment
+  static uint64_t maxConcurrentThreads(const Configs& configs) {
+    return std::max(configs.max_access_threads,
+                    configs.max_elastic_access_threads);
+  }
+
+  // Cost model of PersistMode::Emulated, see Configs::emulate_pmem
+  static PMemEmulation pmemEmulation(const Configs& configs) {
+    PMemEmulation emulation;
+    emulation.msync = configs.emulate_pmem_msync;
+    emulation.write_latency_ns = configs.emulate_pmem_write_latency_ns;
+    emulation.write_bandwidth_mb = configs.emulate_pmem_write_bandwidth_mb;
+    return emulation;
+  }
+
+  static uint64_t numBackgroundThreads(const Configs& configs) {
+    return configs.background_threads == 0 ? configs.clean_threads + 1
+                                           : configs.background_threads;
+  }
+
+  // Number of access thread slots, threads share a slot only if there are
+  // more than this number of threads
+  static uint64_t numAccessSlots(const Configs& configs) {
+    return configs.max_elastic_access_threads > configs.max_access_threads ||
+                   configs.lazy_recovery
+               ? numThreadCaches(configs)
+               : configs.max_access_threads;
+  }
+
+  // Return after batch write logs rolled back, and do the rest recovery in
+  // background
+  Status startLazyRecovery();
+
+  void backgroundLazyRecovery();
+
+  // Run "func" in a thread with lazy rebuild thread id, while holding access
+  // thread slots of lazy rebuild threads, so access threads sharing thread
+  // caches with them wait
+  Status runInRecoverySlots(std::function<Status()> func);
+
   Status restoreDataFromBackup(const std::string& backup_log);
   Status sortedWritePrepare(SortedWriteArgs& args, TimestampType ts);
   Status sortedWrite(SortedWriteArgs& args);
@@ -446,10 +786,53 @@ class KVEngine : public Engine {
   Status restoreStringRecord(StringRecord* pmem_record,
                              const DataEntry& cached_entry);
 
+  Status restoreExtentRecord(ExtentRecord* pmem_record);
+
+  // Free restored extents not referenced by any restored string record. It
+  // iterates the hash table, so run it after all data segments are restored
+  Status restoreExtents();
+
   bool validateRecord(void* data_record);
 
   Status initOrRestoreCheckpoint();
 
+  // Map the durable timestamp file, whose timestamp bounds string records
+  // restored in recovery if written in relaxed durability
+  Status initDurableTimestamp();
+
+  // Persist the durable timestamp after data segments restored, and start to
+  // defer persists of writes if relaxed durability is configured
+  void resetDurableTimestamp();
+
+  // Group flush deferred persists and advance the durable timestamp
+  void flushRelaxedWrites();
+
+  // Order a write that is durable on return after string writes of relaxed
+  // durability. Called after the write took its timestamp and before it's
+  // persisted or committed, so it's never recovered without relaxed writes
+  // before it, and its string records are never discarded in recovery
+  void orderStrictWrite() {
+    if (relaxed_durability_) {
+      flushRelaxedWrites();
+    }
+  }
+
+  // Timestamp of a write that is durable on return, see orderStrictWrite()
+  TimestampType strictWriteTimestamp() {
+    TimestampType ts = version_controller_.GetCurrentTimestamp();
+    orderStrictWrite();
+    return ts;
+  }
+
+  // Wake the group flush if deferred persists of this thread exceed
+  // Configs::relaxed_flush_bytes
+  void maybeWakeRelaxedFlush() {
+    if (relaxed_durability_ &&
+        persistPolicy().ThreadDeferredBytes() >= configs_.relaxed_flush_bytes) {
+      bg_executor_.Wake(relaxed_flush_task_);
+    }
+  }
+
   Status persistOrRecoverImmutableConfigs();
 
   Status batchWriteImpl(WriteBatchImpl const& batch, bool lock_key);
@@ -459,7 +842,8 @@ class KVEngine : public Engine {
   /// List helper functions
   // Find and lock the list. Initialize non-existing if required.
   // Guarantees always return a valid List and lockes it if returns Status::Ok
-  Status listFind(StringView key, List** list);
+  Status listFind(StringView key, List** list,
+                  List::Kind kind = List::Kind::List);
 
   Status listRestoreElem(DLRecord* pmp_record);
 
@@ -469,10 +853,56 @@ class KVEngine : public Engine {
                            std::vector<StringView> const& elems);
   Status listBatchPopImpl(StringView list_name, ListPos pos, size_t n,
                           std::vector<std::string>* elems);
+
+  // Pop "n" elems from "pos" of "list" in a batch, store them in "elems" if
+  // it's not nullptr. Should be called with lock of "list"
+  Status listPopN(List* list, ListPos pos, size_t n,
+                  std::vector<std::string>* elems);
   Status listRollback(BatchWriteLog::ListLogEntry const& entry);
 
   /// Hash helper funtions
-  Status hashListFind(StringView key, HashList** hlist);
+  Status hashListFind(StringView key, HashList** hlist,
+                      HashList::Kind kind = HashList::Kind::Hash);
+
+  // Put "key, value" to "hlist", or do nothing if "skip_existing" and key
+  // already exists
+  Status hashListPut(HashList* hlist, StringView key, StringView value,
+                     bool skip_existing);
+
+  Status hashListDelete(HashList* hlist, StringView key);
+
+  /// Set helper functions
+  // Fetch all members of each set in "sets" at "snapshot"
+  Status setFetchMembers(const std::vector<StringView>& sets,
+                         const SnapshotImpl* snapshot,
+                         std::vector<std::vector<std::string>>* members);
+
+  /// Sorted set helper functions
+  // Find sorted set "zset" and build its score index if not built
+  Status zsetFind(StringView zset, HashList** hlist);
+
+  // Write score of "member" in "hlist", the score is "delta" added to the
+  // existing score if "incr", otherwise "delta" itself. Store the written
+  // score in *new_score if not nullptr
+  Status zsetWrite(HashList* hlist, StringView member, double delta, bool incr,
+                   double* new_score);
+
+  /// Stream helper functions
+  // Return sparse index of "list" of a stream, build it if not built. Should
+  // be called with lock of "list"
+  StreamIndex* streamIndex(List* list);
+
+  /// Time series helper functions
+  // Find time series "series" and build its bucket directory if not built
+  Status tsFind(StringView series, HashList** hlist);
+
+  // Return the elem record of bucket "bucket_key" in "hlist", or nullptr if
+  // it not exists
+  DLRecord* tsBucketRecord(HashList* hlist, StringView bucket_key);
+
+  // Fetch buckets of "hlist" overlapped with [start, end] in ascending order
+  Status tsFetchBuckets(HashList* hlist, int64_t start, int64_t end,
+                        std::vector<TimeSeriesBucket>* buckets);
 
   Status restoreHashElem(DLRecord* rec);
 
@@ -486,10 +916,25 @@ class KVEngine : public Engine {
   /// Other
   Status checkConfigs(const Configs& configs);
 
+  // Whether a file mapped by pmem_map_file() can be used as PMem, regular
+  // files emulate PMem in emulated mode
+  bool mappedPMem(int is_pmem) const {
+    return is_pmem != 0 || persist_mode_ == PersistMode::Emulated;
+  }
+
   void purgeAndFreeStringRecords(const std::vector<StringRecord*>& old_offset);
 
   void purgeAndFreeDLRecords(const std::vector<DLRecord*>& old_offset);
 
+  // First extent of value of a record to purge, or kNullPMemOffset if the
+  // value is stored in the record
+  PMemOffsetType firstExtent(const StringRecord* record) {
+    return record->HasExtents() ? record->GetExtentRef().first
+                                : kNullPMemOffset;
+  }
+
+  PMemOffsetType firstExtent(const DLRecord*) { return kNullPMemOffset; }
+
   // remove outdated records which without snapshot hold.
   template <typename T>
   T* removeOutDatedVersion(T* record, TimestampType min_snapshot_ts);
@@ -512,59 +957,45 @@ class KVEngine : public Engine {
     return version_controller_.GetCurrentTimestamp();
   }
 
-  void removeSkiplist(CollectionIDType id) {
-    std::lock_guard<std::mutex> lg(skiplists_mu_);
-    skiplists_.erase(id);
-  }
+  void removeSkiplist(CollectionIDType id) { skiplists_.Remove(id); }
 
   void addSkiplistToMap(std::shared_ptr<Skiplist> skiplist) {
-    std::lock_guard<std::mutex> lg(skiplists_mu_);
-    skiplists_.emplace(skiplist->ID(), skiplist);
+    skiplists_.Add(skiplist);
   }
 
   std::shared_ptr<Skiplist> getSkiplist(CollectionIDType id) {
-    std::lock_guard<std::mutex> lg(skiplists_mu_);
-    return skiplists_[id];
+    return skiplists_.Get(id);
   }
 
-  void removeHashlist(CollectionIDType id) {
-    std::lock_guard<std::mutex> lg(hlists_mu_);
-    hlists_.erase(id);
-  }
+  void removeHashlist(CollectionIDType id) { hlists_.Remove(id); }
 
   void addHashlistToMap(std::shared_ptr<HashList> hlist) {
-    std::lock_guard<std::mutex> lg(hlists_mu_);
-    hlists_.emplace(hlist->ID(), hlist);
+    hlists_.Add(hlist);
   }
 
   std::shared_ptr<HashList> getHashlist(CollectionIDType id) {
-    std::lock_guard<std::mutex> lg(hlists_mu_);
-    return hlists_[id];
+    return hlists_.Get(id);
   }
 
-  void removeList(CollectionIDType id) {
-    std::lock_guard<std::mutex> lg(lists_mu_);
-    lists_.erase(id);
-  }
+  void removeList(CollectionIDType id) { lists_.Remove(id); }
 
-  void addListToMap(std::shared_ptr<List> list) {
-    std::lock_guard<std::mutex> lg(hlists_mu_);
-    lists_.emplace(list->ID(), list);
-  }
+  void addListToMap(std::shared_ptr<List> list) { lists_.Add(list); }
 
-  std::shared_ptr<List> getList(CollectionIDType id) {
-    std::lock_guard<std::mutex> lg(lists_mu_);
-    return lists_[id];
-  }
+  std::shared_ptr<List> getList(CollectionIDType id) { return lists_.Get(id); }
 
   Status buildSkiplist(const StringView& name,
                        const SortedCollectionConfigs& s_configs,
                        std::shared_ptr<Skiplist>& skiplist);
 
-  Status buildHashlist(const StringView& name,
-                       std::shared_ptr<HashList>& hlist);
+  Status buildHashlist(const StringView& name, std::shared_ptr<HashList>& hlist,
+                       HashList::Kind kind, const StringView& kind_args = "");
+
+  Status destroyHashlist(StringView name, HashList::Kind kind);
+
+  Status buildList(const StringView& name, std::shared_ptr<List>& list,
+                   List::Kind kind);
 
-  Status buildList(const StringView& name, std::shared_ptr<List>& list);
+  Status destroyList(StringView name, List::Kind kind);
 
   inline std::string data_file() { return data_file(dir_); }
 
@@ -578,6 +1009,12 @@ class KVEngine : public Engine {
     return format_dir_path(instance_path) + "checkpoint";
   }
 
+  inline std::string durable_ts_file() { return durable_ts_file(dir_); }
+
+  inline static std::string durable_ts_file(const std::string& instance_path) {
+    return format_dir_path(instance_path) + "durable_ts";
+  }
+
   inline std::string config_file() { return config_file(dir_); }
 
   inline static std::string config_file(const std::string& instance_path) {
@@ -589,11 +1026,11 @@ class KVEngine : public Engine {
     return configs_.recover_to_checkpoint && persist_checkpoint_->Valid();
   }
 
-  // Run in background to report PMem usage regularly
-  void backgroundPMemUsageReporter();
+  // Background task to report PMem usage regularly
+  bool backgroundPMemUsageReporter(const TaskBudget& budget);
 
-  // Run in background to merge and balance free space of PMem Allocator
-  void backgroundPMemAllocatorOrgnizer();
+  // Background task to merge and balance free space of PMem Allocator
+  bool backgroundPMemAllocatorOrgnizer(const TaskBudget& budget);
 
   /* functions for cleaner thread cache */
   // Remove old version records from version chain of new_record and cache it
@@ -621,20 +1058,39 @@ class KVEngine : public Engine {
 
   // restored kvs in reopen
   std::atomic<uint64_t> restored_{0};
+  std::atomic<TimestampType> newest_restored_ts_{0};
+  // Extents met in restoring data segments, protected by
+  // recovered_extents_spin_
+  std::vector<SpaceEntry> recovered_extents_;
+  SpinMutex recovered_extents_spin_;
+  // Number of extra references of extents shared by versions of a string
+  // record, extents absent here are referenced by a single record. It's not
+  // persisted as only the newest version is restored in recovery. Protected by
+  // shared_extents_spin_
+  std::unordered_map<PMemOffsetType, uint64_t> shared_extents_;
+  SpinMutex shared_extents_spin_;
+  // File that cold string values are demoted to, nullptr if tiering is
+  // disabled
+  std::unique_ptr<ColdTier> cold_tier_;
+  // Cooling periods skipped by TestDemoteColdStrings()
+  std::atomic<uint64_t> test_cooling_periods_{0};
   std::atomic<CollectionIDType> collection_id_{0};
 
   std::unique_ptr<HashTable> hash_table_;
 
+  CollectionRegistry<Skiplist> skiplists_;
+  // Protect expirable_skiplists_
   std::mutex skiplists_mu_;
-  std::unordered_map<CollectionIDType, std::shared_ptr<Skiplist>> skiplists_;
   std::set<Skiplist*, Collection::TTLCmp> expirable_skiplists_;
 
+  CollectionRegistry<List> lists_;
+  // Protect expirable_lists_
   std::mutex lists_mu_;
-  std::unordered_map<CollectionIDType, std::shared_ptr<List>> lists_;
   std::set<List*, Collection::TTLCmp> expirable_lists_;
 
+  CollectionRegistry<HashList> hlists_;
+  // Protect expirable_hlists_
   std::mutex hlists_mu_;
-  std::unordered_map<CollectionIDType, std::shared_ptr<HashList>> hlists_;
   std::set<HashList*, Collection::TTLCmp> expirable_hlists_;
 
   std::unique_ptr<LockTable> dllist_locks_;
@@ -645,7 +1101,9 @@ class KVEngine : public Engine {
   std::unique_ptr<PMEMAllocator> pmem_allocator_;
   Configs configs_;
   bool closing_{false};
-  std::vector<std::thread> bg_threads_;
+  // Runs all background works, declared before cleaner_ which adds tasks to it
+  BackgroundExecutor bg_executor_;
+  std::vector<BackgroundExecutor::TaskID> bg_tasks_;
 
   std::unique_ptr<SortedCollectionRebuilder> sorted_rebuilder_;
   std::unique_ptr<HashListRebuilder> hash_rebuilder_;
@@ -656,26 +1114,79 @@ class KVEngine : public Engine {
 
   ComparatorTable comparators_;
 
+  StatsCollector stats_;
+
+  Tracer tracer_;
+
   struct BackgroundWorkSignals {
     BackgroundWorkSignals() = default;
     BackgroundWorkSignals(const BackgroundWorkSignals&) = delete;
 
-    std::condition_variable_any pmem_usage_reporter_cv;
-    std::condition_variable_any pmem_allocator_organizer_cv;
-    std::condition_variable_any dram_cleaner_cv;
+    std::atomic<bool> terminating{false};
+  };
+
+  struct RecoverySignals {
+    RecoverySignals() = default;
+    RecoverySignals(const RecoverySignals&) = delete;
 
-    SpinMutex terminating_lock;
-    bool terminating = false;
+    // Mask of restored record types, requests wait until their types restored
+    std::atomic<uint8_t> restored_types{0xff};
+    // Collection types requested before restored, in order of first access
+    std::vector<RecordType> demanded_types;
+    // Error of lazy recovery, requests of record types not restored before
+    // the failure return it
+    Status status = Status::Ok;
+
+    std::mutex mu;
+    std::condition_variable cv;
+  };
+
+  RecoverySignals recovery_signals_;
+  std::thread recovery_thread_;
+
+  struct RecoveryProgress {
+    std::atomic<uint64_t> restored_segments{0};
+    std::atomic<uint64_t> total_segments{0};
+    // Time of restoring data segments in microseconds
+    std::atomic<int64_t> start_time{0};
+    std::atomic<int64_t> end_time{0};
+    std::atomic<bool> finished{false};
   };
 
+  RecoveryProgress recovery_progress_;
+
   CheckPoint* persist_checkpoint_;
+  // Owns persist_checkpoint_ in volatile mode, which is not mapped from PMem
+  std::unique_ptr<CheckPoint> volatile_checkpoint_;
   std::mutex checkpoint_lock_;
 
+  // Persisted timestamp that string records of relaxed durability before it
+  // are durable, 0 if all writes are durable on return. nullptr in volatile
+  // mode
+  TimestampType* durable_ts_ = nullptr;
+  // Durable timestamp of last run, string records newer than it are
+  // discarded in recovery
+  TimestampType recovery_durable_ts_ = 0;
+  // Persists of string writes are deferred to group flushes, see
+  // Configs::relaxed_durability
+  bool relaxed_durability_ = false;
+  BackgroundExecutor::TaskID relaxed_flush_task_ = 0;
+  // Serializes group flushes, so the durable timestamp never goes back
+  std::mutex relaxed_flush_lock_;
+
+  // How the data space and metadata files are persisted, see
+  // PMEMAllocator::GetPersistPolicy()
+  PersistMode persist_mode_ = PersistMode::PMem;
+
   BackgroundWorkSignals bg_work_signals_;
 
   std::atomic<int64_t> round_robin_id_{0};
 
   CollectionTransactionCV ct_cv_;
+
+  // Created on first AsyncQueueCreate()
+  std::unique_ptr<AsyncExecutor> async_executor_;
+  std::mutex async_executor_mu_;
   // We manually allocate recovery thread id for no conflict in multi-thread
   // recovering
   // Todo: do not hard code
@@ -19,7 +19,8 @@ void KVEngine::removeOutdatedCollection(T* collection) {
   auto cur_head_record = collection->HeaderRecord();
   while (cur_head_record) {
     auto old_head_record =
-        pmem_allocator_->offset2addr<DLRecord>(cur_head_record->old_version);
+        pmem_allocator_->offset2addr<DLRecord>(
+            cur_head_record->GetOldVersion());
     if (old_head_record) {
       auto old_collection_id = T::FetchID(old_head_record);
       if (old_collection_id != cur_id) {
@@ -32,7 +33,7 @@ void KVEngine::removeOutdatedCollection(T* collection) {
                         getHashlist(old_collection_id) != nullptr ||
                         getList(old_collection_id) != nullptr,
                     "collection should not be destroyed yet!");
-        cur_head_record->PersistOldVersion(kNullPMemOffset);
+        cur_head_record->PersistOldVersion(persistPolicy(), kNullPMemOffset);
         cur_id = old_collection_id;
       }
     }
@@ -46,7 +47,7 @@ void KVEngine::removeAndCacheOutdatedVersion(T* record) {
                 std::is_same<T, DLRecord>::value);
   kvdk_assert(ThreadManager::ThreadID() >= 0, "");
   auto& tc = cleaner_thread_cache_[ThreadManager::ThreadID() %
-                                   configs_.max_access_threads];
+                                   cleaner_thread_cache_.size()];
   if (std::is_same<T, StringRecord>::value) {
     StringRecord* old_record = removeOutDatedVersion<StringRecord>(
         (StringRecord*)record, version_controller_.GlobalOldestSnapshotTs());
@@ -76,13 +77,15 @@ void KVEngine::cleanOutdatedRecordImpl(T* old_record) {
   static_assert(std::is_same<T, StringRecord>::value ||
                 std::is_same<T, DLRecord>::value);
   while (old_record) {
-    T* next = pmem_allocator_->offset2addr<T>(old_record->old_version);
+    T* next = pmem_allocator_->offset2addr<T>(old_record->GetOldVersion());
     auto record_size = old_record->GetRecordSize();
+    PMemOffsetType extents = firstExtent(old_record);
     if (old_record->GetRecordStatus() == RecordStatus::Normal) {
-      old_record->Destroy();
+      old_record->Destroy(persistPolicy());
     }
     pmem_allocator_->Free(SpaceEntry(
         pmem_allocator_->addr2offset_checked(old_record), record_size));
+    releaseExtents(extents);
     old_record = next;
   }
 }
@@ -90,7 +93,7 @@ void KVEngine::cleanOutdatedRecordImpl(T* old_record) {
 void KVEngine::tryCleanCachedOutdatedRecord() {
   kvdk_assert(ThreadManager::ThreadID() >= 0, "");
   auto& tc = cleaner_thread_cache_[ThreadManager::ThreadID() %
-                                   configs_.max_access_threads];
+                                   cleaner_thread_cache_.size()];
   // Regularly update local oldest snapshot
   thread_local uint64_t round = 0;
   if (++round % kForegroundUpdateSnapshotInterval == 0) {
@@ -128,14 +131,20 @@ void KVEngine::purgeAndFreeStringRecords(
     while (old_record) {
       StringRecord* next =
           pmem_allocator_->offset2addr<StringRecord>(old_record->old_version);
+      PMemOffsetType extents = firstExtent(old_record);
       if (old_record->GetRecordStatus() == RecordStatus::Normal) {
-        old_record->Destroy();
+        old_record->Destroy(persistPolicy());
       }
       entries.emplace_back(pmem_allocator_->addr2offset(old_record),
                            old_record->GetRecordSize());
+      // Extents are freed after the record destroyed, so a crash in between
+      // leaves unreferenced extents which are freed in recovery
+      releaseExtents(extents);
       old_record = next;
     }
   }
+  cleaner_.GetStats().purged_records.fetch_add(entries.size(),
+                                               std::memory_order_relaxed);
   pmem_allocator_->BatchFree(entries);
 }
 
@@ -146,7 +155,7 @@ void KVEngine::purgeAndFreeDLRecords(
   for (auto pmem_record : old_records) {
     while (pmem_record) {
       DLRecord* next_record =
-          pmem_allocator_->offset2addr<DLRecord>(pmem_record->old_version);
+          pmem_allocator_->offset2addr<DLRecord>(pmem_record->GetOldVersion());
       RecordType type = pmem_record->GetRecordType();
       RecordStatus record_status = pmem_record->GetRecordStatus();
       switch (type) {
@@ -156,7 +165,7 @@ void KVEngine::purgeAndFreeDLRecords(
           entries.emplace_back(pmem_allocator_->addr2offset(pmem_record),
                                pmem_record->GetRecordSize());
           if (record_status == RecordStatus::Normal) {
-            pmem_record->Destroy();
+            pmem_record->Destroy(persistPolicy());
           }
           break;
         }
@@ -166,19 +175,19 @@ void KVEngine::purgeAndFreeDLRecords(
             entries.emplace_back(
                 pmem_allocator_->addr2offset_checked(pmem_record),
                 pmem_record->GetRecordSize());
-            pmem_record->Destroy();
+            pmem_record->Destroy(persistPolicy());
           } else {
             auto skiplist_id = Skiplist::FetchID(pmem_record);
-            kvdk_assert(skiplists_.find(skiplist_id) != skiplists_.end(),
+            kvdk_assert(skiplists_.Contains(skiplist_id),
                         "Skiplist should not be removed.");
             auto head_record = getSkiplist(skiplist_id)->HeaderRecord();
             if (head_record != pmem_record) {
               entries.emplace_back(
                   pmem_allocator_->addr2offset_checked(pmem_record),
                   pmem_record->GetRecordSize());
-              pmem_record->Destroy();
+              pmem_record->Destroy(persistPolicy());
             } else {
-              pmem_record->PersistOldVersion(kNullPMemOffset);
+              pmem_record->PersistOldVersion(persistPolicy(), kNullPMemOffset);
             }
           }
           break;
@@ -189,19 +198,19 @@ void KVEngine::purgeAndFreeDLRecords(
             entries.emplace_back(
                 pmem_allocator_->addr2offset_checked(pmem_record),
                 pmem_record->GetRecordSize());
-            pmem_record->Destroy();
+            pmem_record->Destroy(persistPolicy());
           } else {
             auto hash_id = HashList::FetchID(pmem_record);
-            kvdk_assert(hlists_.find(hash_id) != hlists_.end(),
+            kvdk_assert(hlists_.Contains(hash_id),
                         "Hashlist should not be removed.");
             auto head_record = getHashlist(hash_id)->HeaderRecord();
             if (head_record != pmem_record) {
               entries.emplace_back(
                   pmem_allocator_->addr2offset_checked(pmem_record),
                   pmem_record->GetRecordSize());
-              pmem_record->Destroy();
+              pmem_record->Destroy(persistPolicy());
             } else {
-              pmem_record->PersistOldVersion(kNullPMemOffset);
+              pmem_record->PersistOldVersion(persistPolicy(), kNullPMemOffset);
             }
           }
           break;
@@ -212,19 +221,19 @@ void KVEngine::purgeAndFreeDLRecords(
             entries.emplace_back(
                 pmem_allocator_->addr2offset_checked(pmem_record),
                 pmem_record->GetRecordSize());
-            pmem_record->Destroy();
+            pmem_record->Destroy(persistPolicy());
           } else {
             auto list_id = List::FetchID(pmem_record);
-            kvdk_assert(lists_.find(list_id) != lists_.end(),
+            kvdk_assert(lists_.Contains(list_id),
                         "Hashlist should not be removed.");
             auto header_record = getList(list_id)->HeaderRecord();
             if (header_record != pmem_record) {
               entries.emplace_back(
                   pmem_allocator_->addr2offset_checked(pmem_record),
                   pmem_record->GetRecordSize());
-              pmem_record->Destroy();
+              pmem_record->Destroy(persistPolicy());
             } else {
-              pmem_record->PersistOldVersion(kNullPMemOffset);
+              pmem_record->PersistOldVersion(persistPolicy(), kNullPMemOffset);
             }
           }
           break;
@@ -236,6 +245,8 @@ void KVEngine::purgeAndFreeDLRecords(
       pmem_record = next_record;
     }
   }
+  cleaner_.GetStats().purged_records.fetch_add(entries.size(),
+                                               std::memory_order_relaxed);
   pmem_allocator_->BatchFree(entries);
 }
 
@@ -356,6 +367,8 @@ void KVEngine::purgeAndFree(PendingCleanRecords& pending_clean_records) {
           skiplist->TryCleaningLock()) {
         skiplist->DestroyAll();
         removeSkiplist(skiplist->ID());
+        cleaner_.GetStats().destroyed_collections.fetch_add(
+            1, std::memory_order_relaxed);
         skiplist->ReleaseCleaningLock();
         pending_clean_records.outdated_skiplists.pop_front();
       } else {
@@ -375,6 +388,8 @@ void KVEngine::purgeAndFree(PendingCleanRecords& pending_clean_records) {
           list->DestroyAll();
         }
         removeList(list->ID());
+        cleaner_.GetStats().destroyed_collections.fetch_add(
+            1, std::memory_order_relaxed);
         list->ReleaseCleaningLock();
         pending_clean_records.outdated_lists.pop_front();
       } else {
@@ -391,6 +406,8 @@ void KVEngine::purgeAndFree(PendingCleanRecords& pending_clean_records) {
           hlist->TryCleaningLock()) {
         hlist->DestroyAll();
         removeHashlist(hlist->ID());
+        cleaner_.GetStats().destroyed_collections.fetch_add(
+            1, std::memory_order_relaxed);
         hlist->ReleaseCleaningLock();
         pending_clean_records.outdated_hlists.pop_front();
       } else {
@@ -417,7 +434,7 @@ void KVEngine::fetchCachedOutdatedVersion(
     PendingCleanRecords& pending_clean_records,
     std::vector<StringRecord*>& purge_string_records,
     std::vector<DLRecord*>& purge_dl_records) {
-  size_t i = round_robin_id_.fetch_add(1) % configs_.max_access_threads;
+  size_t i = round_robin_id_.fetch_add(1) % cleaner_thread_cache_.size();
   auto& tc = cleaner_thread_cache_[i];
   std::deque<CleanerThreadCache::OutdatedRecord<StringRecord>>
       outdated_string_records;
@@ -475,6 +492,7 @@ double KVEngine::cleanOutDated(PendingCleanRecords& pending_clean_records,
 
   std::vector<StringRecord*> purge_string_records;
   std::vector<DLRecord*> purge_dl_records;
+  std::vector<ColdCandidate> cold_candidates;
 
   fetchCachedOutdatedVersion(pending_clean_records, purge_string_records,
                              purge_dl_records);
@@ -487,10 +505,13 @@ double KVEngine::cleanOutDated(PendingCleanRecords& pending_clean_records,
     end_slot_idx = hash_table_->GetSlotsNum();
   }
   auto hashtable_iter = hash_table_->GetIterator(start_slot_idx, end_slot_idx);
+  cleaner_.GetStats().scanned_slots.fetch_add(end_slot_idx - start_slot_idx,
+                                              std::memory_order_relaxed);
   while (hashtable_iter.Valid() && !closing_) {
     {  // Slot lock section
       auto min_snapshot_ts = version_controller_.GlobalOldestSnapshotTs();
       auto now = TimeUtils::millisecond_time();
+      uint64_t cooling_period = cold_tier_ ? coolingPeriod() : 0;
 
       auto slot_lock(hashtable_iter.AcquireSlotLock());
       auto slot_iter = hashtable_iter.Slot();
@@ -512,6 +533,10 @@ double KVEngine::cleanOutDated(PendingCleanRecords& pending_clean_records,
                 hash_table_->Erase(&(*slot_iter));
                 purge_string_records.emplace_back(string_record);
                 need_purge_num++;
+              } else if (cold_tier_ && coolString(&(*slot_iter), cooling_period)) {
+                cold_candidates.push_back(
+                    {string_view_2_string(string_record->Key()), string_record,
+                     string_record->GetTimestamp()});
               }
               break;
             }
@@ -625,6 +650,10 @@ double KVEngine::cleanOutDated(PendingCleanRecords& pending_clean_records,
 
   }  // Finsh iterating hash table
 
+  if (!cold_candidates.empty()) {
+    demoteColdStrings(cold_candidates);
+  }
+
   // Push the remaining need purged records to global pool.
   auto new_ts = version_controller_.GetCurrentTimestamp();
   if (!purge_string_records.empty()) {
@@ -657,31 +686,78 @@ void KVEngine::TestCleanOutDated(size_t start_slot_idx, size_t end_slot_idx) {
 
 Cleaner::OutDatedCollections::~OutDatedCollections() {}
 
-void Cleaner::cleanWork() {
-  PendingCleanRecords pending_clean_records;
-  std::int64_t start_pos = start_slot_.fetch_add(kSlotBlockUnit) %
-                           (kv_engine_->hash_table_->GetSlotsNum());
-  kv_engine_->cleanOutDated(pending_clean_records, start_pos, kSlotBlockUnit);
+void Cleaner::Start() {
+  std::lock_guard<std::mutex> lg(workers_mu_);
+  if (close_ || min_thread_num_ == 0 || main_worker_.started) {
+    return;
+  }
+  double budget = kv_engine_->configs_.background_task_budget;
+  for (size_t i = 0; i < clean_workers_.size(); i++) {
+    clean_workers_[i].task_id = executor_->AddTask(
+        "clean_worker_" + std::to_string(i), kCleanInterval, budget,
+        [this, i](const TaskBudget& b) { return this->cleanWork(i, b); });
+    clean_workers_[i].started = true;
+  }
+  main_worker_.task_id = executor_->AddTask(
+      "cleaner", kCleanInterval, budget,
+      [this](const TaskBudget& b) { return this->mainWork(b); });
+  main_worker_.started = true;
+  executor_->Wake(main_worker_.task_id);
+}
 
+void Cleaner::Close() {
+  close_ = true;
+  std::lock_guard<std::mutex> lg(workers_mu_);
+  if (main_worker_.started) {
+    executor_->RemoveTask(main_worker_.task_id);
+    main_worker_.started = false;
+  }
+  for (auto& w : clean_workers_) {
+    if (w.started) {
+      executor_->RemoveTask(w.task_id);
+      w.started = false;
+    }
+  }
+}
+
+bool Cleaner::purgePending(PendingCleanRecords& pending_clean_records,
+                           const TaskBudget& budget) {
   while (pending_clean_records.Size() != 0 && !close_.load()) {
     kv_engine_->version_controller_.UpdateLocalOldestSnapshot();
     kv_engine_->purgeAndFree(pending_clean_records);
+    if (budget.Exhausted()) {
+      break;
+    }
   }
+  return pending_clean_records.Size() != 0 && !close_.load();
+}
+
+bool Cleaner::cleanWork(size_t worker_idx, const TaskBudget& budget) {
+  if (close_.load()) {
+    return false;
+  }
+  PendingCleanRecords& pending_clean_records =
+      clean_workers_[worker_idx].pending_clean_records;
+  bool active = worker_idx < active_clean_workers_.load();
+  // A stopped worker still finishes its pending records
+  if (active && pending_clean_records.Size() == 0) {
+    std::int64_t start_pos = start_slot_.fetch_add(kSlotBlockUnit) %
+                             (kv_engine_->hash_table_->GetSlotsNum());
+    kv_engine_->cleanOutDated(pending_clean_records, start_pos,
+                              kSlotBlockUnit);
+  }
+
+  bool pending_left = purgePending(pending_clean_records, budget);
+  return pending_left || worker_idx < active_clean_workers_.load();
 }
 
 void Cleaner::AdjustCleanWorkers(size_t advice_wokers_num) {
   kvdk_assert(advice_wokers_num <= clean_workers_.size(), "");
-  auto active_workers_num = active_clean_workers_.load();
-  if (active_workers_num < advice_wokers_num) {
-    for (size_t i = active_workers_num; i < advice_wokers_num; ++i) {
-      clean_workers_[i].Run();
-    }
-  } else if (active_workers_num > advice_wokers_num) {
-    for (size_t i = advice_wokers_num; i < active_workers_num; ++i) {
-      clean_workers_[i].Stop();
-    }
+  auto active_workers_num = active_clean_workers_.exchange(advice_wokers_num);
+  // Stopped workers return after their current run
+  for (size_t i = active_workers_num; i < advice_wokers_num; ++i) {
+    executor_->Wake(clean_workers_[i].task_id);
   }
-  active_clean_workers_ = advice_wokers_num;
 }
 
 double Cleaner::SearchOutdatedCollections() {
@@ -835,33 +911,37 @@ void Cleaner::FetchOutdatedCollections(
   }
 }
 
-void Cleaner::mainWork() {
-  PendingCleanRecords pending_clean_records;
-  std::int64_t start_pos = start_slot_.fetch_add(kSlotBlockUnit) %
-                           (kv_engine_->hash_table_->GetSlotsNum());
+bool Cleaner::mainWork(const TaskBudget& budget) {
+  if (close_.load()) {
+    return false;
+  }
+  PendingCleanRecords& pending_clean_records =
+      main_worker_.pending_clean_records;
+  double outdated_ratio = 0;
+  if (pending_clean_records.Size() == 0) {
+    std::int64_t start_pos = start_slot_.fetch_add(kSlotBlockUnit) %
+                             (kv_engine_->hash_table_->GetSlotsNum());
 
-  double outdated_ratio = kv_engine_->cleanOutDated(pending_clean_records,
-                                                    start_pos, kSlotBlockUnit);
+    outdated_ratio = kv_engine_->cleanOutDated(pending_clean_records,
+                                               start_pos, kSlotBlockUnit);
 
-  size_t advice_thread_num = min_thread_num_;
-  if (outdated_ratio >= kWakeUpThreshold) {
-    advice_thread_num = std::ceil(outdated_ratio * max_thread_num_);
-    advice_thread_num =
-        std::min(std::max(min_thread_num_, advice_thread_num), max_thread_num_);
-  }
-  TEST_SYNC_POINT_CALLBACK("KVEngine::Cleaner::AdjustCleanWorkers",
-                           &advice_thread_num);
-  size_t advice_clean_workers =
-      advice_thread_num > 0 ? advice_thread_num - 1 : 0;
+    size_t advice_thread_num = min_thread_num_;
+    if (outdated_ratio >= kWakeUpThreshold) {
+      advice_thread_num = std::ceil(outdated_ratio * max_thread_num_);
+      advice_thread_num = std::min(std::max(min_thread_num_, advice_thread_num),
+                                   max_thread_num_);
+    }
+    TEST_SYNC_POINT_CALLBACK("KVEngine::Cleaner::AdjustCleanWorkers",
+                             &advice_thread_num);
+    size_t advice_clean_workers =
+        advice_thread_num > 0 ? advice_thread_num - 1 : 0;
 
-  AdjustCleanWorkers(advice_clean_workers);
-  if (outdated_ratio < kWakeUpThreshold) {
-    sleep(1);
+    AdjustCleanWorkers(advice_clean_workers);
   }
 
-  while (pending_clean_records.Size() != 0 && !close_.load()) {
-    kv_engine_->version_controller_.UpdateLocalOldestSnapshot();
-    kv_engine_->purgeAndFree(pending_clean_records);
-  }
+  bool pending_left = purgePending(pending_clean_records, budget);
+  // Keep scanning without waiting for the interval if there are many
+  // outdated records
+  return pending_left || outdated_ratio >= kWakeUpThreshold;
 }
 }  // namespace KVDK_NAMESPACE
@@ -16,6 +16,7 @@
 #include <vector>
 
 #include "alias.hpp"
+#include "background_executor.hpp"
 #include "collection.hpp"
 #include "hash_table.hpp"
 #include "utils/utils.hpp"
@@ -76,116 +77,63 @@ class Cleaner {
  public:
   static constexpr int64_t kSlotBlockUnit = 1024;
   static constexpr double kWakeUpThreshold = 0.1;
+  // Interval of idle clean workers in seconds
+  static constexpr double kCleanInterval = 1.0;
 
-  Cleaner(KVEngine* kv_engine, int64_t max_cleaner_threads)
+  Cleaner(KVEngine* kv_engine, int64_t max_cleaner_threads,
+          BackgroundExecutor* executor)
       : kv_engine_(kv_engine),
+        executor_(executor),
         max_thread_num_(max_cleaner_threads),
         min_thread_num_(1),
         close_(false),
         start_slot_(0),
         active_clean_workers_(0),
-        main_worker_([this]() { this->mainWork(); }),
-        clean_workers_(max_thread_num_ - 1 /*1 for main worker*/) {
-    for (auto& w : clean_workers_) {
-      w.Init([this]() { this->cleanWork(); });
-    }
-  }
+        clean_workers_(max_thread_num_ - 1 /*1 for main worker*/) {}
 
   ~Cleaner() { Close(); }
 
-  void Start() {
-    if (!close_ && min_thread_num_ > 0) {
-      main_worker_.Run();
-    }
-  }
+  // Add clean workers to the background executor
+  void Start();
 
-  void Close() {
-    close_ = true;
-    main_worker_.Join();
-    for (auto& w : clean_workers_) {
-      w.Join();
-    }
-  }
+  // Remove clean workers from the background executor, wait for running ones
+  void Close();
 
   void AdjustCleanWorkers(size_t advice_workers_num);
 
   size_t ActiveThreadNum() { return active_clean_workers_.load() + 1; }
 
+  // Progress counters of cleaning, see Engine::GetStatistics()
+  struct Stats {
+    std::atomic<uint64_t> scanned_slots{0};
+    std::atomic<uint64_t> purged_records{0};
+    std::atomic<uint64_t> destroyed_collections{0};
+  };
+
+  Stats& GetStats() { return stats_; }
+
   double SearchOutdatedCollections();
   void FetchOutdatedCollections(PendingCleanRecords& pending_clean_records);
 
  private:
-  class Worker {
-   public:
-    ~Worker() { Join(); }
-
-    Worker(std::function<void()> f) { Init(f); }
-
-    Worker() = default;
-
-    void Init(std::function<void()> f) {
-      Join();
-      func = f;
-      std::unique_lock<SpinMutex> ul(spin);
-      join_ = false;
-      keep_work_ = false;
-
-      auto work = [&]() {
-        while (true) {
-          {
-            std::unique_lock<SpinMutex> ul(spin);
-            while (!keep_work_ && !join_) {
-              cv.wait(ul);
-            }
-            if (join_) {
-              return;
-            }
-          }
-          func();
-        }
-      };
-      worker_thread = std::thread(work);
-    }
-
-    void Run() {
-      std::unique_lock<SpinMutex> ul(spin);
-      keep_work_ = true;
-      cv.notify_all();
-    }
-
-    void Stop() {
-      std::unique_lock<SpinMutex> ul(spin);
-      keep_work_ = false;
-    }
-
-    void Join() {
-      {
-        std::unique_lock<SpinMutex> ul(spin);
-        keep_work_ = false;
-        join_ = true;
-        cv.notify_all();
-      }
-      if (worker_thread.joinable()) {
-        worker_thread.join();
-      }
-    }
-
-   private:
-    bool keep_work_;
-    bool join_;
-    std::condition_variable_any cv;
-    SpinMutex spin;
-    std::thread worker_thread;
-    std::function<void(void)> func;
+  // A clean worker runs as a task of the background executor. Its pending
+  // records are kept between runs, so a run can stop at its time budget
+  struct Worker {
+    BackgroundExecutor::TaskID task_id;
+    bool started = false;
+    PendingCleanRecords pending_clean_records;
   };
 
   KVEngine* kv_engine_;
+  BackgroundExecutor* executor_;
 
   size_t max_thread_num_;
   size_t min_thread_num_;
   std::atomic<bool> close_;
   std::atomic<int64_t> start_slot_;
   std::atomic<size_t> active_clean_workers_;
+  // Protect adding and removing workers
+  std::mutex workers_mu_;
   Worker main_worker_;
   std::vector<Worker> clean_workers_;
 
@@ -215,10 +163,17 @@ class Cleaner {
   };
 
   OutDatedCollections outdated_collections_;
+  Stats stats_;
 
  private:
-  void cleanWork();
-  void mainWork();
+  // Return true if the worker has more work to do
+  bool cleanWork(size_t worker_idx, const TaskBudget& budget);
+  bool mainWork(const TaskBudget& budget);
+
+  // Purge and free pending records until they are all freed or budget is
+  // exhausted, return true if some records left
+  bool purgePending(PendingCleanRecords& pending_clean_records,
+                    const TaskBudget& budget);
 };
 
 }  // namespace KVDK_NAMESPACE
\ No newline at end of file
@@ -7,21 +7,27 @@
 
 namespace KVDK_NAMESPACE {
 Status KVEngine::HashCreate(StringView collection) {
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   if (!checkKeySize(collection)) {
     return Status::InvalidDataSize;
   }
 
   std::shared_ptr<HashList> hlist = nullptr;
-  return buildHashlist(collection, hlist);
+  return buildHashlist(collection, hlist, HashList::Kind::Hash);
 }
 
 Status KVEngine::buildHashlist(const StringView& collection,
-                               std::shared_ptr<HashList>& hlist) {
+                               std::shared_ptr<HashList>& hlist,
+                               HashList::Kind kind,
+                               const StringView& kind_args) {
   auto ul = hash_table_->AcquireLock(collection);
   auto holder = version_controller_.GetLocalSnapshotHolder();
   TimestampType new_ts = holder.Timestamp();
+  orderStrictWrite();
   auto lookup_result = lookupKey<true>(collection, RecordType::HashRecord);
   if (lookup_result.s == Status::NotFound ||
       lookup_result.s == Status::Outdated) {
@@ -31,7 +37,7 @@ Status KVEngine::buildHashlist(const StringView& collection,
             ? lookup_result.entry.GetIndex().hlist->HeaderRecord()
             : nullptr;
     CollectionIDType id = collection_id_.fetch_add(1);
-    std::string value_str = HashList::EncodeID(id);
+    std::string value_str = HashList::EncodeHeaderValue(id, kind, kind_args);
     SpaceEntry space =
         pmem_allocator_->Allocate(DLRecord::RecordSize(collection, value_str));
     if (space.size == 0) {
@@ -40,8 +46,8 @@ Status KVEngine::buildHashlist(const StringView& collection,
     // dl list is circular, so the next and prev pointers of
     // header point to itself
     DLRecord* pmem_record = DLRecord::PersistDLRecord(
-        pmem_allocator_->offset2addr_checked(space.offset), space.size, new_ts,
-        RecordType::HashRecord, RecordStatus::Normal,
+        persistPolicy(), pmem_allocator_->offset2addr_checked(space.offset),
+        space.size, new_ts, RecordType::HashRecord, RecordStatus::Normal,
         pmem_allocator_->addr2offset(existing_header), space.offset,
         space.offset, collection, value_str);
     hlist = std::make_shared<HashList>(pmem_record, collection, id,
@@ -52,23 +58,34 @@ Status KVEngine::buildHashlist(const StringView& collection,
     insertKeyOrElem(lookup_result, RecordType::HashRecord, RecordStatus::Normal,
                     hlist.get());
     return Status::Ok;
+  } else if (lookup_result.s == Status::Ok) {
+    return lookup_result.entry.GetIndex().hlist->GetKind() == kind
+               ? Status::Existed
+               : Status::WrongType;
   } else {
-    return lookup_result.s == Status::Ok ? Status::Existed : lookup_result.s;
+    return lookup_result.s;
   }
 }
 
 Status KVEngine::HashDestroy(StringView collection) {
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   if (!checkKeySize(collection)) {
     return Status::InvalidDataSize;
   }
+  return destroyHashlist(collection, HashList::Kind::Hash);
+}
 
+Status KVEngine::destroyHashlist(StringView collection, HashList::Kind kind) {
   auto ul = hash_table_->AcquireLock(collection);
   auto snapshot_holder = version_controller_.GetLocalSnapshotHolder();
   auto new_ts = snapshot_holder.Timestamp();
+  orderStrictWrite();
   HashList* hlist;
-  Status s = hashListFind(collection, &hlist);
+  Status s = hashListFind(collection, &hlist, kind);
   if (s == Status::Ok) {
     auto destroy = acquireCollectionCreateOrDestroyLock();
     DLRecord* header = hlist->HeaderRecord();
@@ -80,10 +97,10 @@ Status KVEngine::HashDestroy(StringView collection) {
       return Status::PmemOverflow;
     }
     DLRecord* pmem_record = DLRecord::PersistDLRecord(
-        pmem_allocator_->offset2addr_checked(space.offset), space.size, new_ts,
-        RecordType::HashRecord, RecordStatus::Outdated,
-        pmem_allocator_->addr2offset_checked(header), header->prev,
-        header->next, collection, value);
+        persistPolicy(), pmem_allocator_->offset2addr_checked(space.offset),
+        space.size, new_ts, RecordType::HashRecord, RecordStatus::Outdated,
+        pmem_allocator_->addr2offset_checked(header), header->GetPrev(),
+        header->GetNext(), collection, value);
     bool success = hlist->Replace(header, pmem_record);
     kvdk_assert(success, "existing header should be linked on its hlist");
     hash_table_->Insert(collection, RecordType::HashRecord,
@@ -100,7 +117,10 @@ Status KVEngine::HashSize(StringView collection, size_t* len) {
   if (!checkKeySize(collection)) {
     return Status::InvalidDataSize;
   }
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   auto token = version_controller_.GetLocalSnapshotHolder();
   HashList* hlist;
@@ -114,7 +134,11 @@ Status KVEngine::HashSize(StringView collection, size_t* len) {
 
 Status KVEngine::HashGet(StringView collection, StringView key,
                          std::string* value) {
-  auto thread_holder = AcquireAccessThread();
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpHashGet);
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   // Hold current snapshot in this thread
   auto holder = version_controller_.GetLocalSnapshotHolder();
@@ -129,63 +153,90 @@ Status KVEngine::HashGet(StringView collection, StringView key,
 
 Status KVEngine::HashPut(StringView collection, StringView key,
                          StringView value) {
-  auto thread_holder = AcquireAccessThread();
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpHashPut);
+  Tracer::Op trace_op(&tracer_, "HashPut");
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   // Hold current snapshot in this thread
   auto holder = version_controller_.GetLocalSnapshotHolder();
 
   HashList* hlist;
   Status s = hashListFind(collection, &hlist);
+  Tracer::Stage("lookup");
   if (s == Status::Ok) {
-    std::string collection_key(hlist->InternalKey(key));
-    if (!checkKeySize(collection_key) || !checkValueSize(value)) {
-      s = Status::InvalidDataSize;
-    } else {
-      auto ul = hash_table_->AcquireLock(collection_key);
-      auto ret =
-          hlist->Put(key, value, version_controller_.GetCurrentTimestamp());
-      if (ret.s == Status::Ok && ret.existing_record &&
-          hlist->TryCleaningLock()) {
-        removeAndCacheOutdatedVersion<DLRecord>(ret.write_record);
-        hlist->ReleaseCleaningLock();
-      }
-      tryCleanCachedOutdatedRecord();
-      s = ret.s;
-    }
+    s = hashListPut(hlist, key, value, false);
   }
   return s;
 }
 
+Status KVEngine::hashListPut(HashList* hlist, StringView key, StringView value,
+                             bool skip_existing) {
+  std::string collection_key(hlist->InternalKey(key));
+  if (!checkKeySize(collection_key) || !checkValueSize(value)) {
+    return Status::InvalidDataSize;
+  }
+  auto ul = hash_table_->AcquireLock(collection_key);
+  Tracer::Stage("lock");
+  if (skip_existing && hlist->Contains(key)) {
+    return Status::Ok;
+  }
+  auto ret = hlist->Put(key, value, strictWriteTimestamp());
+  if (ret.s == Status::Ok && ret.existing_record && hlist->TryCleaningLock()) {
+    removeAndCacheOutdatedVersion<DLRecord>(ret.write_record);
+    hlist->ReleaseCleaningLock();
+  }
+  tryCleanCachedOutdatedRecord();
+  Tracer::Stage("clean");
+  return ret.s;
+}
+
 Status KVEngine::HashDelete(StringView collection, StringView key) {
-  auto thread_holder = AcquireAccessThread();
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpHashDelete);
+  Tracer::Op trace_op(&tracer_, "HashDelete");
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   // Hold current snapshot in this thread
   auto holder = version_controller_.GetLocalSnapshotHolder();
 
   HashList* hlist;
   Status s = hashListFind(collection, &hlist);
+  Tracer::Stage("lookup");
   if (s == Status::Ok) {
-    std::string collection_key(hlist->InternalKey(key));
-    if (!checkKeySize(collection_key)) {
-      s = Status::InvalidDataSize;
-    } else {
-      auto ul = hash_table_->AcquireLock(collection_key);
-      auto ret = hlist->Delete(key, version_controller_.GetCurrentTimestamp());
-      if (ret.s == Status::Ok && ret.existing_record && ret.write_record &&
-          hlist->TryCleaningLock()) {
-        removeAndCacheOutdatedVersion(ret.write_record);
-        hlist->ReleaseCleaningLock();
-      }
-      tryCleanCachedOutdatedRecord();
-      s = ret.s;
-    }
+    s = hashListDelete(hlist, key);
   }
   return s;
 }
 
+Status KVEngine::hashListDelete(HashList* hlist, StringView key) {
+  std::string collection_key(hlist->InternalKey(key));
+  if (!checkKeySize(collection_key)) {
+    return Status::InvalidDataSize;
+  }
+  auto ul = hash_table_->AcquireLock(collection_key);
+  Tracer::Stage("lock");
+  auto ret = hlist->Delete(key, strictWriteTimestamp());
+  if (ret.s == Status::Ok && ret.existing_record && ret.write_record &&
+      hlist->TryCleaningLock()) {
+    removeAndCacheOutdatedVersion(ret.write_record);
+    hlist->ReleaseCleaningLock();
+  }
+  tryCleanCachedOutdatedRecord();
+  Tracer::Stage("clean");
+  return ret.s;
+}
+
 Status KVEngine::HashModify(StringView collection, StringView key,
                             ModifyFunc modify_func, void* cb_args) {
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   // Hold current snapshot in this thread
   auto holder = version_controller_.GetLocalSnapshotHolder();
@@ -195,7 +246,7 @@ Status KVEngine::HashModify(StringView collection, StringView key,
     std::string internal_key(hlist->InternalKey(key));
     auto ul = hash_table_->AcquireLock(internal_key);
     auto ret = hlist->Modify(key, modify_func, cb_args,
-                             version_controller_.GetCurrentTimestamp());
+                             strictWriteTimestamp());
     s = ret.s;
     if (s == Status::Ok && ret.existing_record && ret.write_record &&
         hlist->TryCleaningLock()) {
@@ -209,9 +260,9 @@ Status KVEngine::HashModify(StringView collection, StringView key,
 
 HashIterator* KVEngine::HashIteratorCreate(StringView collection,
                                            Snapshot* snapshot, Status* status) {
-  Status s{Status::Ok};
+  Status s = maybeWaitRecovery(RecordType::HashRecord);
   HashIterator* ret(nullptr);
-  if (!checkKeySize(collection)) {
+  if (s == Status::Ok && !checkKeySize(collection)) {
     s = Status::InvalidDataSize;
   }
 
@@ -247,7 +298,8 @@ void KVEngine::HashIteratorRelease(HashIterator* hash_iter) {
   delete iter;
 }
 
-Status KVEngine::hashListFind(StringView collection, HashList** hlist) {
+Status KVEngine::hashListFind(StringView collection, HashList** hlist,
+                              HashList::Kind kind) {
   // Callers should acquire the access token or snapshot.
   // Lockless lookup for the collection
   auto result = lookupKey<false>(collection, RecordType::HashRecord);
@@ -257,6 +309,9 @@ Status KVEngine::hashListFind(StringView collection, HashList** hlist) {
   if (result.s != Status::Ok) {
     return result.s;
   }
+  if (result.entry.GetIndex().hlist->GetKind() != kind) {
+    return Status::WrongType;
+  }
   (*hlist) = result.entry.GetIndex().hlist;
   return Status::Ok;
 }
@@ -4,21 +4,25 @@
 
 namespace KVDK_NAMESPACE {
 Status KVEngine::ListCreate(StringView list_name) {
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   if (!checkKeySize(list_name)) {
     return Status::InvalidDataSize;
   }
 
   std::shared_ptr<List> list = nullptr;
-  return buildList(list_name, list);
+  return buildList(list_name, list, List::Kind::List);
 }
 
 Status KVEngine::buildList(const StringView& list_name,
-                           std::shared_ptr<List>& list) {
+                           std::shared_ptr<List>& list, List::Kind kind) {
   auto ul = hash_table_->AcquireLock(list_name);
   auto holder = version_controller_.GetLocalSnapshotHolder();
   TimestampType new_ts = holder.Timestamp();
+  orderStrictWrite();
   auto lookup_result = lookupKey<true>(list_name, RecordType::ListRecord);
   if (lookup_result.s == Status::NotFound ||
       lookup_result.s == Status::Outdated) {
@@ -28,7 +32,7 @@ Status KVEngine::buildList(const StringView& list_name,
             ? lookup_result.entry.GetIndex().hlist->HeaderRecord()
             : nullptr;
     CollectionIDType id = collection_id_.fetch_add(1);
-    std::string value_str = List::EncodeID(id);
+    std::string value_str = List::EncodeHeaderValue(id, kind);
     SpaceEntry space =
         pmem_allocator_->Allocate(DLRecord::RecordSize(list_name, value_str));
     if (space.size == 0) {
@@ -37,8 +41,8 @@ Status KVEngine::buildList(const StringView& list_name,
     // dl list is circular, so the next and prev pointers of
     // header point to itself
     DLRecord* pmem_record = DLRecord::PersistDLRecord(
-        pmem_allocator_->offset2addr_checked(space.offset), space.size, new_ts,
-        RecordType::ListRecord, RecordStatus::Normal,
+        persistPolicy(), pmem_allocator_->offset2addr_checked(space.offset),
+        space.size, new_ts, RecordType::ListRecord, RecordStatus::Normal,
         pmem_allocator_->addr2offset(existing_header), space.offset,
         space.offset, list_name, value_str);
     list = std::make_shared<List>(pmem_record, list_name, id,
@@ -48,8 +52,12 @@ Status KVEngine::buildList(const StringView& list_name,
     insertKeyOrElem(lookup_result, RecordType::ListRecord, RecordStatus::Normal,
                     list.get());
     return Status::Ok;
+  } else if (lookup_result.s == Status::Ok) {
+    return lookup_result.entry.GetIndex().list->GetKind() == kind
+               ? Status::Existed
+               : Status::WrongType;
   } else {
-    return lookup_result.s == Status::Ok ? Status::Existed : lookup_result.s;
+    return lookup_result.s;
   }
 }
 
@@ -57,13 +65,20 @@ Status KVEngine::ListDestroy(StringView collection) {
   if (!checkKeySize(collection)) {
     return Status::InvalidDataSize;
   }
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+  return destroyList(collection, List::Kind::List);
+}
 
+Status KVEngine::destroyList(StringView collection, List::Kind kind) {
   auto ul = hash_table_->AcquireLock(collection);
   auto snapshot_holder = version_controller_.GetLocalSnapshotHolder();
   auto new_ts = snapshot_holder.Timestamp();
+  orderStrictWrite();
   List* list;
-  Status s = listFind(collection, &list);
+  Status s = listFind(collection, &list, kind);
   if (s == Status::Ok) {
     auto destroy_token = acquireCollectionCreateOrDestroyLock();
     DLRecord* header = list->HeaderRecord();
@@ -75,10 +90,10 @@ Status KVEngine::ListDestroy(StringView collection) {
       return Status::PmemOverflow;
     }
     DLRecord* pmem_record = DLRecord::PersistDLRecord(
-        pmem_allocator_->offset2addr_checked(space.offset), space.size, new_ts,
-        RecordType::ListRecord, RecordStatus::Outdated,
-        pmem_allocator_->addr2offset_checked(header), header->prev,
-        header->next, collection, value);
+        persistPolicy(), pmem_allocator_->offset2addr_checked(space.offset),
+        space.size, new_ts, RecordType::ListRecord, RecordStatus::Outdated,
+        pmem_allocator_->addr2offset_checked(header), header->GetPrev(),
+        header->GetNext(), collection, value);
     bool success = list->Replace(header, pmem_record);
     kvdk_assert(success, "existing header should be linked on its list");
     hash_table_->Insert(collection, RecordType::ListRecord,
@@ -95,7 +110,10 @@ Status KVEngine::ListSize(StringView list_name, size_t* sz) {
   if (!checkKeySize(list_name)) {
     return Status::InvalidDataSize;
   }
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   auto token = version_controller_.GetLocalSnapshotHolder();
 
@@ -110,10 +128,14 @@ Status KVEngine::ListSize(StringView list_name, size_t* sz) {
 }
 
 Status KVEngine::ListPushFront(StringView collection, StringView elem) {
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpListPush);
   if (!checkKeySize(collection) || !checkValueSize(elem)) {
     return Status::InvalidDataSize;
   }
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   auto token = version_controller_.GetLocalSnapshotHolder();
   List* list;
@@ -123,14 +145,18 @@ Status KVEngine::ListPushFront(StringView collection, StringView elem) {
   }
   auto guard = list->AcquireLock();
 
-  return list->PushFront(elem, version_controller_.GetCurrentTimestamp()).s;
+  return list->PushFront(elem, strictWriteTimestamp()).s;
 }
 
 Status KVEngine::ListPushBack(StringView list_name, StringView elem) {
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpListPush);
   if (!checkKeySize(list_name) || !checkValueSize(elem)) {
     return Status::InvalidDataSize;
   }
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   auto token = version_controller_.GetLocalSnapshotHolder();
   List* list;
@@ -140,14 +166,18 @@ Status KVEngine::ListPushBack(StringView list_name, StringView elem) {
   }
   auto guard = list->AcquireLock();
 
-  return list->PushBack(elem, version_controller_.GetCurrentTimestamp()).s;
+  return list->PushBack(elem, strictWriteTimestamp()).s;
 }
 
 Status KVEngine::ListPopFront(StringView list_name, std::string* elem) {
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpListPop);
   if (!checkKeySize(list_name)) {
     return Status::InvalidDataSize;
   }
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   auto token = version_controller_.GetLocalSnapshotHolder();
   List* list;
@@ -157,7 +187,7 @@ Status KVEngine::ListPopFront(StringView list_name, std::string* elem) {
   }
   auto guard = list->AcquireLock();
 
-  auto ret = list->PopFront(version_controller_.GetCurrentTimestamp());
+  auto ret = list->PopFront(strictWriteTimestamp());
 
   if (ret.s == Status::Ok) {
     kvdk_assert(ret.existing_record && ret.write_record, "");
@@ -175,10 +205,14 @@ Status KVEngine::ListPopFront(StringView list_name, std::string* elem) {
 }
 
 Status KVEngine::ListPopBack(StringView list_name, std::string* elem) {
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpListPop);
   if (!checkKeySize(list_name)) {
     return Status::InvalidDataSize;
   }
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   auto token = version_controller_.GetLocalSnapshotHolder();
   List* list;
@@ -188,7 +222,7 @@ Status KVEngine::ListPopBack(StringView list_name, std::string* elem) {
   }
   auto guard = list->AcquireLock();
 
-  auto ret = list->PopBack(version_controller_.GetCurrentTimestamp());
+  auto ret = list->PopBack(strictWriteTimestamp());
   if (ret.existing_record == nullptr) {
     /// TODO: NotFound does not properly describe the situation
     return Status::NotFound;
@@ -218,6 +252,7 @@ Status KVEngine::ListBatchPushFront(StringView list_name,
 
 Status KVEngine::ListBatchPushFront(StringView list_name,
                                     std::vector<StringView> const& elems) {
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpListPush);
   if (!checkKeySize(list_name)) {
     return Status::InvalidDataSize;
   }
@@ -229,7 +264,10 @@ Status KVEngine::ListBatchPushFront(StringView list_name,
       return Status::InvalidDataSize;
     }
   }
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   Status s = maybeInitBatchLogFile();
   if (s != Status::Ok) {
@@ -246,6 +284,7 @@ Status KVEngine::ListBatchPushBack(StringView list_name,
 
 Status KVEngine::ListBatchPushBack(StringView list_name,
                                    std::vector<StringView> const& elems) {
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpListPush);
   if (!checkKeySize(list_name)) {
     return Status::InvalidDataSize;
   }
@@ -257,7 +296,10 @@ Status KVEngine::ListBatchPushBack(StringView list_name,
       return Status::InvalidDataSize;
     }
   }
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   Status s = maybeInitBatchLogFile();
   if (s != Status::Ok) {
@@ -268,10 +310,14 @@ Status KVEngine::ListBatchPushBack(StringView list_name,
 
 Status KVEngine::ListBatchPopFront(StringView list_name, size_t n,
                                    std::vector<std::string>* elems) {
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpListPop);
   if (!checkKeySize(list_name)) {
     return Status::InvalidDataSize;
   }
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   Status s = maybeInitBatchLogFile();
   if (s != Status::Ok) {
@@ -282,10 +328,14 @@ Status KVEngine::ListBatchPopFront(StringView list_name, size_t n,
 
 Status KVEngine::ListBatchPopBack(StringView list_name, size_t n,
                                   std::vector<std::string>* elems) {
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpListPop);
   if (!checkKeySize(list_name)) {
     return Status::InvalidDataSize;
   }
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
   Status s = maybeInitBatchLogFile();
   if (s != Status::Ok) {
     return s;
@@ -299,7 +349,10 @@ Status KVEngine::ListMove(StringView src, ListPos src_pos, StringView dst,
   if (!checkKeySize(src) || !checkKeySize(dst)) {
     return Status::InvalidDataSize;
   }
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   Status s = maybeInitBatchLogFile();
   if (s != Status::Ok) {
@@ -347,6 +400,7 @@ Status KVEngine::ListMove(StringView src, ListPos src_pos, StringView dst,
   auto bw_token = version_controller_.GetBatchWriteToken();
   BatchWriteLog log;
   log.SetTimestamp(bw_token.Timestamp());
+  orderStrictWrite();
   std::vector<std::string> elems;
 
   auto pop_args =
@@ -366,10 +420,10 @@ Status KVEngine::ListMove(StringView src, ListPos src_pos, StringView dst,
   log.ListDelete(pop_args.spaces[0].offset);
   log.ListEmplace(push_args.spaces[0].offset);
   auto& tc = engine_thread_cache_[ThreadManager::ThreadID() %
-                                  configs_.max_access_threads];
-  log.EncodeTo(tc.batch_log);
+                                  engine_thread_cache_.size()];
+  log.EncodeTo(persistPolicy(), tc.batch_log);
 
-  BatchWriteLog::MarkProcessing(tc.batch_log);
+  BatchWriteLog::MarkProcessing(persistPolicy(), tc.batch_log);
 
   s = src_list->PopN(pop_args);
   kvdk_assert(s == Status::Ok, "pop n always success");
@@ -377,7 +431,7 @@ Status KVEngine::ListMove(StringView src, ListPos src_pos, StringView dst,
   s = dst_list->PushN(push_args);
   kvdk_assert(s == Status::Ok, "push n always success");
 
-  BatchWriteLog::MarkCommitted(tc.batch_log);
+  BatchWriteLog::MarkCommitted(persistPolicy(), tc.batch_log);
   return Status::Ok;
 }
 
@@ -386,7 +440,10 @@ Status KVEngine::ListInsertAt(StringView list_name, StringView elem,
   if (!checkValueSize(elem)) {
     return Status::InvalidDataSize;
   }
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   auto token = version_controller_.GetLocalSnapshotHolder();
   List* list;
@@ -395,8 +452,7 @@ Status KVEngine::ListInsertAt(StringView list_name, StringView elem,
     return s;
   }
   auto guard = list->AcquireLock();
-  return list->InsertAt(elem, index, version_controller_.GetCurrentTimestamp())
-      .s;
+  return list->InsertAt(elem, index, strictWriteTimestamp()).s;
 }
 
 Status KVEngine::ListInsertBefore(StringView list_name, StringView elem,
@@ -404,7 +460,10 @@ Status KVEngine::ListInsertBefore(StringView list_name, StringView elem,
   if (!checkValueSize(elem)) {
     return Status::InvalidDataSize;
   }
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   auto token = version_controller_.GetLocalSnapshotHolder();
   List* list;
@@ -414,9 +473,7 @@ Status KVEngine::ListInsertBefore(StringView list_name, StringView elem,
   }
   auto guard = list->AcquireLock();
 
-  return list
-      ->InsertBefore(elem, pos, version_controller_.GetCurrentTimestamp())
-      .s;
+  return list->InsertBefore(elem, pos, strictWriteTimestamp()).s;
 }
 
 Status KVEngine::ListInsertAfter(StringView collection, StringView elem,
@@ -424,7 +481,10 @@ Status KVEngine::ListInsertAfter(StringView collection, StringView elem,
   if (!checkValueSize(elem)) {
     return Status::InvalidDataSize;
   }
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   auto token = version_controller_.GetLocalSnapshotHolder();
   List* list;
@@ -434,13 +494,15 @@ Status KVEngine::ListInsertAfter(StringView collection, StringView elem,
   }
   auto guard = list->AcquireLock();
 
-  return list->InsertAfter(elem, dst, version_controller_.GetCurrentTimestamp())
-      .s;
+  return list->InsertAfter(elem, dst, strictWriteTimestamp()).s;
 }
 
 Status KVEngine::ListErase(StringView list_name, long index,
                            std::string* elem) {
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   auto token = version_controller_.GetLocalSnapshotHolder();
   List* list;
@@ -449,7 +511,7 @@ Status KVEngine::ListErase(StringView list_name, long index,
     return s;
   }
   auto guard = list->AcquireLock();
-  auto ret = list->Erase(index, version_controller_.GetCurrentTimestamp());
+  auto ret = list->Erase(index, strictWriteTimestamp());
   if (ret.s == Status::Ok) {
     kvdk_assert(ret.existing_record && ret.write_record, "");
     if (elem) {
@@ -468,7 +530,10 @@ Status KVEngine::ListErase(StringView list_name, long index,
 // Replace the element at pos
 Status KVEngine::ListReplace(StringView collection, long index,
                              StringView elem) {
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   auto token = version_controller_.GetLocalSnapshotHolder();
   List* list;
@@ -477,14 +542,14 @@ Status KVEngine::ListReplace(StringView collection, long index,
     return s;
   }
   auto guard = list->AcquireLock();
-  return list->Update(index, elem, version_controller_.GetCurrentTimestamp()).s;
+  return list->Update(index, elem, strictWriteTimestamp()).s;
 }
 
 ListIterator* KVEngine::ListIteratorCreate(StringView collection,
                                            Snapshot* snapshot, Status* status) {
-  Status s{Status::Ok};
+  Status s = maybeWaitRecovery(RecordType::ListRecord);
   ListIterator* ret(nullptr);
-  if (!checkKeySize(collection)) {
+  if (s == Status::Ok && !checkKeySize(collection)) {
     s = Status::InvalidDataSize;
   }
 
@@ -529,7 +594,7 @@ Status KVEngine::listRestoreList(DLRecord* pmp_record) {
   return list_rebuilder_->AddHeader(pmp_record);
 }
 
-Status KVEngine::listFind(StringView list_name, List** list) {
+Status KVEngine::listFind(StringView list_name, List** list, List::Kind kind) {
   auto result = lookupKey<false>(list_name, RecordType::ListRecord);
   if (result.s == Status::Outdated) {
     return Status::NotFound;
@@ -537,6 +602,9 @@ Status KVEngine::listFind(StringView list_name, List** list) {
   if (result.s != Status::Ok) {
     return result.s;
   }
+  if (result.entry.GetIndex().list->GetKind() != kind) {
+    return Status::WrongType;
+  }
   (*list) = result.entry.GetIndex().list;
   return Status::Ok;
 }
@@ -554,6 +622,7 @@ Status KVEngine::listBatchPushImpl(StringView list_name, ListPos pos,
   auto bw_token = version_controller_.GetBatchWriteToken();
   BatchWriteLog log;
   log.SetTimestamp(bw_token.Timestamp());
+  orderStrictWrite();
 
   auto push_n_args = list->PreparePushN(pos, elems, bw_token.Timestamp());
   if (push_n_args.s != Status::Ok) {
@@ -565,13 +634,13 @@ Status KVEngine::listBatchPushImpl(StringView list_name, ListPos pos,
   }
 
   auto& tc = engine_thread_cache_[ThreadManager::ThreadID() %
-                                  configs_.max_access_threads];
-  log.EncodeTo(tc.batch_log);
-  BatchWriteLog::MarkProcessing(tc.batch_log);
+                                  engine_thread_cache_.size()];
+  log.EncodeTo(persistPolicy(), tc.batch_log);
+  BatchWriteLog::MarkProcessing(persistPolicy(), tc.batch_log);
 
   s = list->PushN(push_n_args);
   kvdk_assert(s == Status::Ok, "PushN always success");
-  BatchWriteLog::MarkCommitted(tc.batch_log);
+  BatchWriteLog::MarkCommitted(persistPolicy(), tc.batch_log);
   return s;
 }
 
@@ -584,10 +653,15 @@ Status KVEngine::listBatchPopImpl(StringView list_name, ListPos pos, size_t n,
     return s;
   }
   auto guard = list->AcquireLock();
+  return listPopN(list, pos, n, elems);
+}
 
+Status KVEngine::listPopN(List* list, ListPos pos, size_t n,
+                          std::vector<std::string>* elems) {
   auto bw_token = version_controller_.GetBatchWriteToken();
   BatchWriteLog log;
   log.SetTimestamp(bw_token.Timestamp());
+  orderStrictWrite();
 
   auto pop_n_args = list->PreparePopN(pos, n, bw_token.Timestamp(), elems);
   if (pop_n_args.s != Status::Ok) {
@@ -599,13 +673,13 @@ Status KVEngine::listBatchPopImpl(StringView list_name, ListPos pos, size_t n,
   }
 
   auto& tc = engine_thread_cache_[ThreadManager::ThreadID() %
-                                  configs_.max_access_threads];
-  log.EncodeTo(tc.batch_log);
-  BatchWriteLog::MarkProcessing(tc.batch_log);
+                                  engine_thread_cache_.size()];
+  log.EncodeTo(persistPolicy(), tc.batch_log);
+  BatchWriteLog::MarkProcessing(persistPolicy(), tc.batch_log);
 
-  s = list->PopN(pop_n_args);
+  Status s = list->PopN(pop_n_args);
   kvdk_assert(s == Status::Ok, "PopN always success with lock");
-  BatchWriteLog::MarkCommitted(tc.batch_log);
+  BatchWriteLog::MarkCommitted(persistPolicy(), tc.batch_log);
   return s;
 }
 
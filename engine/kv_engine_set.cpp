@@ -0,0 +1,257 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "hash_collection/iterator.hpp"
+#include "hash_collection/set_ops.hpp"
+#include "kv_engine.hpp"
+
+namespace KVDK_NAMESPACE {
+Status KVEngine::SetCreate(StringView set) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  if (!checkKeySize(set)) {
+    return Status::InvalidDataSize;
+  }
+
+  std::shared_ptr<HashList> hlist = nullptr;
+  return buildHashlist(set, hlist, HashList::Kind::Set);
+}
+
+Status KVEngine::SetDestroy(StringView set) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  if (!checkKeySize(set)) {
+    return Status::InvalidDataSize;
+  }
+  return destroyHashlist(set, HashList::Kind::Set);
+}
+
+Status KVEngine::SetAdd(StringView set, StringView member) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  // Hold current snapshot in this thread
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+
+  HashList* hlist;
+  Status s = hashListFind(set, &hlist, HashList::Kind::Set);
+  if (s == Status::Ok) {
+    // Re-adding an existing member writes nothing
+    s = hashListPut(hlist, member, "", true);
+  }
+  return s;
+}
+
+Status KVEngine::SetRemove(StringView set, StringView member) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  // Hold current snapshot in this thread
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+
+  HashList* hlist;
+  Status s = hashListFind(set, &hlist, HashList::Kind::Set);
+  if (s == Status::Ok) {
+    s = hashListDelete(hlist, member);
+  }
+  return s;
+}
+
+Status KVEngine::SetIsMember(StringView set, StringView member,
+                             bool* is_member) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  // Hold current snapshot in this thread
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+
+  HashList* hlist;
+  Status s = hashListFind(set, &hlist, HashList::Kind::Set);
+  if (s == Status::Ok) {
+    *is_member = hlist->Contains(member);
+  }
+  return s;
+}
+
+Status KVEngine::SetCard(StringView set, size_t* card) {
+  if (!checkKeySize(set)) {
+    return Status::InvalidDataSize;
+  }
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+  HashList* hlist;
+  Status s = hashListFind(set, &hlist, HashList::Kind::Set);
+  if (s == Status::Ok) {
+    *card = hlist->Size();
+  }
+  return s;
+}
+
+Status KVEngine::SetScan(StringView set,
+                         std::function<bool(StringView member)> visitor) {
+  Status recovery_status = maybeWaitRecovery(RecordType::HashRecord);
+  if (recovery_status != Status::Ok) {
+    return recovery_status;
+  }
+  if (!checkKeySize(set)) {
+    return Status::InvalidDataSize;
+  }
+
+  Snapshot* snapshot = GetSnapshot(false);
+  defer(ReleaseSnapshot(snapshot));
+  HashList* hlist;
+  Status s = hashListFind(set, &hlist, HashList::Kind::Set);
+  if (s == Status::Ok) {
+    HashIteratorImpl iter(hlist, static_cast<SnapshotImpl*>(snapshot), false);
+    for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+      if (!visitor(iter.Key())) {
+        break;
+      }
+    }
+  }
+  return s;
+}
+
+Status KVEngine::setFetchMembers(
+    const std::vector<StringView>& sets, const SnapshotImpl* snapshot,
+    std::vector<std::vector<std::string>>* members) {
+  members->clear();
+  members->resize(sets.size());
+  for (size_t i = 0; i < sets.size(); i++) {
+    HashList* hlist;
+    Status s = hashListFind(sets[i], &hlist, HashList::Kind::Set);
+    if (s != Status::Ok) {
+      return s;
+    }
+    (*members)[i].reserve(hlist->Size());
+    HashIteratorImpl iter(hlist, snapshot, false);
+    for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+      (*members)[i].emplace_back(iter.Key());
+    }
+  }
+  return Status::Ok;
+}
+
+Status KVEngine::SetIntersect(const std::vector<StringView>& sets,
+                              std::vector<std::string>* members,
+                              bool integer_members) {
+  Status recovery_status = maybeWaitRecovery(RecordType::HashRecord);
+  if (recovery_status != Status::Ok) {
+    return recovery_status;
+  }
+  members->clear();
+  if (sets.empty()) {
+    return Status::Ok;
+  }
+
+  Snapshot* snapshot = GetSnapshot(false);
+  defer(ReleaseSnapshot(snapshot));
+  if (integer_members) {
+    std::vector<std::vector<std::string>> all_members;
+    Status s = setFetchMembers(sets, static_cast<SnapshotImpl*>(snapshot),
+                               &all_members);
+    if (s != Status::Ok) {
+      return s;
+    }
+    std::vector<std::vector<uint64_t>> arrays(all_members.size());
+    for (size_t i = 0; i < all_members.size(); i++) {
+      arrays[i].reserve(all_members[i].size());
+      for (auto& m : all_members[i]) {
+        uint64_t v;
+        if (m.size() != sizeof(uint64_t) || !DecodeUint64(m, &v)) {
+          return Status::InvalidArgument;
+        }
+        arrays[i].push_back(v);
+      }
+      std::sort(arrays[i].begin(), arrays[i].end());
+    }
+    // Intersect from the smallest set to keep intermediate results small
+    std::sort(arrays.begin(), arrays.end(),
+              [](const std::vector<uint64_t>& a,
+                 const std::vector<uint64_t>& b) { return a.size() < b.size(); });
+    std::vector<uint64_t> result = std::move(arrays[0]);
+    for (size_t i = 1; i < arrays.size() && !result.empty(); i++) {
+      std::vector<uint64_t> next;
+      IntersectSortedUint64(result.data(), result.size(), arrays[i].data(),
+                            arrays[i].size(), &next);
+      result.swap(next);
+    }
+    members->reserve(result.size());
+    for (uint64_t v : result) {
+      members->push_back(EncodeUint64(v));
+    }
+    return Status::Ok;
+  }
+
+  // Probe members of the smallest set in others
+  std::vector<HashList*> hlists(sets.size());
+  for (size_t i = 0; i < sets.size(); i++) {
+    Status s = hashListFind(sets[i], &hlists[i], HashList::Kind::Set);
+    if (s != Status::Ok) {
+      return s;
+    }
+  }
+  std::sort(hlists.begin(), hlists.end(),
+            [](HashList* a, HashList* b) { return a->Size() < b->Size(); });
+  HashIteratorImpl iter(hlists[0], static_cast<SnapshotImpl*>(snapshot),
+                        false);
+  for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+    std::string member = iter.Key();
+    bool in_all = true;
+    for (size_t i = 1; i < hlists.size() && in_all; i++) {
+      in_all = hlists[i]->Contains(member);
+    }
+    if (in_all) {
+      members->push_back(std::move(member));
+    }
+  }
+  return Status::Ok;
+}
+
+Status KVEngine::SetUnion(const std::vector<StringView>& sets,
+                          std::vector<std::string>* members) {
+  Status recovery_status = maybeWaitRecovery(RecordType::HashRecord);
+  if (recovery_status != Status::Ok) {
+    return recovery_status;
+  }
+  members->clear();
+
+  Snapshot* snapshot = GetSnapshot(false);
+  defer(ReleaseSnapshot(snapshot));
+  std::vector<std::vector<std::string>> all_members;
+  Status s = setFetchMembers(sets, static_cast<SnapshotImpl*>(snapshot),
+                             &all_members);
+  if (s != Status::Ok) {
+    return s;
+  }
+  std::unordered_set<std::string> merged;
+  for (auto& set_members : all_members) {
+    for (auto& m : set_members) {
+      if (merged.insert(m).second) {
+        members->push_back(std::move(m));
+      }
+    }
+  }
+  return Status::Ok;
+}
+}  // namespace KVDK_NAMESPACE
@@ -8,7 +8,10 @@
 namespace KVDK_NAMESPACE {
 Status KVEngine::SortedCreate(const StringView collection_name,
                               const SortedCollectionConfigs& s_configs) {
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::SortedRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   if (!checkKeySize(collection_name)) {
     return Status::InvalidDataSize;
@@ -25,6 +28,7 @@ Status KVEngine::buildSkiplist(const StringView& collection_name,
   auto ul = hash_table_->AcquireLock(collection_name);
   auto holder = version_controller_.GetLocalSnapshotHolder();
   TimestampType new_ts = holder.Timestamp();
+  orderStrictWrite();
   auto lookup_result =
       lookupKey<true>(collection_name, RecordType::SortedRecord);
   if (lookup_result.s == NotFound || lookup_result.s == Outdated) {
@@ -52,10 +56,10 @@ Status KVEngine::buildSkiplist(const StringView& collection_name,
     // PMem level of dl list is circular, so the next and prev pointers of
     // header point to itself
     DLRecord* pmem_record = DLRecord::PersistDLRecord(
-        pmem_allocator_->offset2addr(space_entry.offset), space_entry.size,
-        new_ts, RecordType::SortedRecord, RecordStatus::Normal,
-        pmem_allocator_->addr2offset(existing_header), space_entry.offset,
-        space_entry.offset, collection_name, value_str);
+        persistPolicy(), pmem_allocator_->offset2addr(space_entry.offset),
+        space_entry.size, new_ts, RecordType::SortedRecord,
+        RecordStatus::Normal, pmem_allocator_->addr2offset(existing_header),
+        space_entry.offset, space_entry.offset, collection_name, value_str);
 
     skiplist = std::make_shared<Skiplist>(
         pmem_record, string_view_2_string(collection_name), id, comparator,
@@ -71,11 +75,15 @@ Status KVEngine::buildSkiplist(const StringView& collection_name,
 }
 
 Status KVEngine::SortedDestroy(const StringView collection_name) {
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::SortedRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   auto ul = hash_table_->AcquireLock(collection_name);
   auto snapshot_holder = version_controller_.GetLocalSnapshotHolder();
   auto new_ts = snapshot_holder.Timestamp();
+  orderStrictWrite();
   auto lookup_result =
       lookupKey<false>(collection_name, RecordType::SortedRecord);
   if (lookup_result.s == Status::Ok) {
@@ -91,10 +99,11 @@ Status KVEngine::SortedDestroy(const StringView collection_name) {
       return Status::PmemOverflow;
     }
     DLRecord* pmem_record = DLRecord::PersistDLRecord(
+        persistPolicy(),
         pmem_allocator_->offset2addr_checked(space_entry.offset),
         space_entry.size, new_ts, RecordType::SortedRecord,
         RecordStatus::Outdated, pmem_allocator_->addr2offset_checked(header),
-        header->prev, header->next, collection_name, value, 0);
+        header->GetPrev(), header->GetNext(), collection_name, value, 0);
     bool success =
         Skiplist::Replace(header, pmem_record, skiplist->HeaderNode(),
                           pmem_allocator_.get(), dllist_locks_.get());
@@ -113,7 +122,10 @@ Status KVEngine::SortedDestroy(const StringView collection_name) {
 }
 
 Status KVEngine::SortedSize(const StringView collection, size_t* size) {
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::SortedRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   auto holder = version_controller_.GetLocalSnapshotHolder();
 
@@ -132,7 +144,11 @@ Status KVEngine::SortedSize(const StringView collection, size_t* size) {
 
 Status KVEngine::SortedGet(const StringView collection,
                            const StringView user_key, std::string* value) {
-  auto thread_holder = AcquireAccessThread();
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpSortedGet);
+  auto thread_holder = AcquireAccessThread(RecordType::SortedRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   // Hold current snapshot in this thread
   auto holder = version_controller_.GetLocalSnapshotHolder();
@@ -153,13 +169,19 @@ Status KVEngine::SortedGet(const StringView collection,
 
 Status KVEngine::SortedPut(const StringView collection,
                            const StringView user_key, const StringView value) {
-  auto thread_holder = AcquireAccessThread();
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpSortedPut);
+  Tracer::Op trace_op(&tracer_, "SortedPut");
+  auto thread_holder = AcquireAccessThread(RecordType::SortedRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   auto snapshot_holder = version_controller_.GetLocalSnapshotHolder();
 
   Skiplist* skiplist = nullptr;
 
   auto ret = lookupKey<false>(collection, RecordType::SortedRecord);
+  Tracer::Stage("lookup");
   if (ret.s != Status::Ok) {
     return ret.s == Status::Outdated ? Status::NotFound : ret.s;
   }
@@ -172,13 +194,19 @@ Status KVEngine::SortedPut(const StringView collection,
 
 Status KVEngine::SortedDelete(const StringView collection,
                               const StringView user_key) {
-  auto thread_holder = AcquireAccessThread();
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpSortedDelete);
+  Tracer::Op trace_op(&tracer_, "SortedDelete");
+  auto thread_holder = AcquireAccessThread(RecordType::SortedRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   // Hold current snapshot in this thread
   auto holder = version_controller_.GetLocalSnapshotHolder();
 
   Skiplist* skiplist = nullptr;
   auto ret = lookupKey<false>(collection, RecordType::SortedRecord);
+  Tracer::Stage("lookup");
   if (ret.s != Status::Ok) {
     return (ret.s == Status::Outdated || ret.s == Status::NotFound)
                ? Status::NotFound
@@ -194,6 +222,13 @@ Status KVEngine::SortedDelete(const StringView collection,
 
 SortedIterator* KVEngine::SortedIteratorCreate(const StringView collection,
                                                Snapshot* snapshot, Status* s) {
+  Status recovery_status = maybeWaitRecovery(RecordType::SortedRecord);
+  if (recovery_status != Status::Ok) {
+    if (s != nullptr) {
+      *s = recovery_status;
+    }
+    return nullptr;
+  }
   Skiplist* skiplist;
   bool create_snapshot = snapshot == nullptr;
   if (create_snapshot) {
@@ -237,7 +272,8 @@ Status KVEngine::sortedDeleteImpl(Skiplist* skiplist,
   }
 
   auto ul = hash_table_->AcquireLock(collection_key);
-  TimestampType new_ts = version_controller_.GetCurrentTimestamp();
+  Tracer::Stage("lock");
+  TimestampType new_ts = strictWriteTimestamp();
 
   auto ret = skiplist->Delete(user_key, new_ts);
 
@@ -246,6 +282,7 @@ Status KVEngine::sortedDeleteImpl(Skiplist* skiplist,
     skiplist->ReleaseCleaningLock();
   }
   tryCleanCachedOutdatedRecord();
+  Tracer::Stage("clean");
 
   return ret.s;
 }
@@ -258,7 +295,8 @@ Status KVEngine::sortedPutImpl(Skiplist* skiplist, const StringView& user_key,
   }
 
   auto ul = hash_table_->AcquireLock(collection_key);
-  TimestampType new_ts = version_controller_.GetCurrentTimestamp();
+  Tracer::Stage("lock");
+  TimestampType new_ts = strictWriteTimestamp();
   auto ret = skiplist->Put(user_key, value, new_ts);
 
   // Collect outdated version records
@@ -267,6 +305,7 @@ Status KVEngine::sortedPutImpl(Skiplist* skiplist, const StringView& user_key,
     skiplist->ReleaseCleaningLock();
   }
   tryCleanCachedOutdatedRecord();
+  Tracer::Stage("clean");
 
   return ret.s;
 }
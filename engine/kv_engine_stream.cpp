@@ -0,0 +1,183 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include "kv_engine.hpp"
+
+namespace KVDK_NAMESPACE {
+Status KVEngine::StreamCreate(StringView stream) {
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  if (!checkKeySize(stream)) {
+    return Status::InvalidDataSize;
+  }
+
+  std::shared_ptr<List> list = nullptr;
+  return buildList(stream, list, List::Kind::Stream);
+}
+
+Status KVEngine::StreamDestroy(StringView stream) {
+  if (!checkKeySize(stream)) {
+    return Status::InvalidDataSize;
+  }
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+  return destroyList(stream, List::Kind::Stream);
+}
+
+Status KVEngine::XAdd(StringView stream, StringView entry, uint64_t* id) {
+  if (!checkKeySize(stream) ||
+      entry.size() > UINT32_MAX - sizeof(StreamID)) {
+    return Status::InvalidDataSize;
+  }
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  auto token = version_controller_.GetLocalSnapshotHolder();
+  List* list;
+  Status s = listFind(stream, &list, List::Kind::Stream);
+  if (s != Status::Ok) {
+    return s;
+  }
+  auto guard = list->AcquireLock();
+  StreamIndex* index = streamIndex(list);
+  TimestampType ts = strictWriteTimestamp();
+  StreamID new_id = index->NextID(ts);
+  auto ret = list->PushBack(StreamIndex::EncodeEntry(new_id, entry), ts);
+  if (ret.s == Status::Ok) {
+    index->Append(new_id, list->Size() - 1);
+    if (id) {
+      *id = new_id;
+    }
+  }
+  return ret.s;
+}
+
+Status KVEngine::XLen(StringView stream, size_t* len) {
+  if (!checkKeySize(stream)) {
+    return Status::InvalidDataSize;
+  }
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  auto token = version_controller_.GetLocalSnapshotHolder();
+  List* list;
+  Status s = listFind(stream, &list, List::Kind::Stream);
+  if (s != Status::Ok) {
+    return s;
+  }
+  auto guard = list->AcquireLock();
+  *len = list->Size();
+  return Status::Ok;
+}
+
+Status KVEngine::XRange(StringView stream, uint64_t start_id, uint64_t end_id,
+                        std::vector<std::pair<uint64_t, std::string>>* entries,
+                        size_t count) {
+  entries->clear();
+  if (!checkKeySize(stream)) {
+    return Status::InvalidDataSize;
+  }
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  auto token = version_controller_.GetLocalSnapshotHolder();
+  List* list;
+  Status s = listFind(stream, &list, List::Kind::Stream);
+  if (s != Status::Ok) {
+    return s;
+  }
+  auto guard = list->AcquireLock();
+  StreamIndex* index = streamIndex(list);
+  // Locate the index interval in DRAM, then scan PMem records from its
+  // start
+  for (size_t pos = index->SeekPosition(start_id);
+       pos < list->Size() && entries->size() < count; pos++) {
+    StringView value = list->LiveRecordAt(pos)->Value();
+    StreamID id = StreamIndex::DecodeID(value);
+    if (id < start_id) {
+      continue;
+    }
+    if (id > end_id) {
+      break;
+    }
+    entries->emplace_back(
+        id, string_view_2_string(StreamIndex::DecodeContent(value)));
+  }
+  return Status::Ok;
+}
+
+Status KVEngine::XRead(StringView stream, uint64_t last_id, size_t count,
+                       std::vector<std::pair<uint64_t, std::string>>* entries) {
+  if (last_id == UINT64_MAX) {
+    entries->clear();
+    return Status::Ok;
+  }
+  return XRange(stream, last_id + 1, UINT64_MAX, entries, count);
+}
+
+Status KVEngine::XTrim(StringView stream, uint64_t min_id, size_t* trimmed) {
+  if (!checkKeySize(stream)) {
+    return Status::InvalidDataSize;
+  }
+  auto thread_holder = AcquireAccessThread(RecordType::ListRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  auto token = version_controller_.GetLocalSnapshotHolder();
+  List* list;
+  Status s = listFind(stream, &list, List::Kind::Stream);
+  if (s != Status::Ok) {
+    return s;
+  }
+  auto guard = list->AcquireLock();
+  StreamIndex* index = streamIndex(list);
+  size_t num_intervals = index->IntervalsBefore(min_id);
+  size_t num_entries =
+      std::min(num_intervals * StreamIndex::kIndexInterval, list->Size());
+  if (num_entries > 0) {
+    // Pop entries of whole intervals in one batch
+    s = listPopN(list, ListPos::Front, num_entries, nullptr);
+    if (s != Status::Ok) {
+      return s;
+    }
+    index->PopIntervals(num_intervals);
+  }
+  if (trimmed) {
+    *trimmed = num_entries;
+  }
+  return Status::Ok;
+}
+
+StreamIndex* KVEngine::streamIndex(List* list) {
+  StreamIndex* index = list->GetStreamIndex();
+  if (!index->Built()) {
+    // Index is not persisted, build it on first access after recovery by
+    // reading id of every indexed entry
+    size_t size = list->Size();
+    for (size_t pos = 0; pos < size; pos += StreamIndex::kIndexInterval) {
+      index->Append(StreamIndex::DecodeID(list->LiveRecordAt(pos)->Value()),
+                    pos);
+    }
+    if (size > 0 && (size - 1) % StreamIndex::kIndexInterval != 0) {
+      index->Append(
+          StreamIndex::DecodeID(list->LiveRecordAt(size - 1)->Value()),
+          size - 1);
+    }
+    index->MarkBuilt();
+  }
+  return index;
+}
+}  // namespace KVDK_NAMESPACE
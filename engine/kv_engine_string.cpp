@@ -3,23 +3,32 @@
  */
 
 #include "kv_engine.hpp"
+#include "utils/compression.hpp"
 #include "utils/sync_point.hpp"
 
 namespace KVDK_NAMESPACE {
 
 Status KVEngine::Modify(const StringView key, ModifyFunc modify_func,
                         void* modify_args, const WriteOptions& write_options) {
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpModify);
+  Tracer::Op trace_op(&tracer_, "Modify");
   int64_t base_time = TimeUtils::millisecond_time();
   if (!TimeUtils::CheckTTL(write_options.ttl_time, base_time)) {
     return Status::InvalidArgument;
   }
 
-  auto thread_holder = AcquireAccessThread();
+  auto thread_holder = AcquireAccessThread(RecordType::String);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   auto ul = hash_table_->AcquireLock(key);
+  Tracer::Stage("lock");
   auto holder = version_controller_.GetLocalSnapshotHolder();
   TimestampType new_ts = holder.Timestamp();
+  orderStrictWrite();
   auto lookup_result = lookupKey<true>(key, RecordType::String);
+  Tracer::Stage("lookup");
 
   StringRecord* existing_record = nullptr;
   std::string existing_value;
@@ -27,8 +36,10 @@ Status KVEngine::Modify(const StringView key, ModifyFunc modify_func,
   // push it into cleaner
   if (lookup_result.s == Status::Ok) {
     existing_record = lookup_result.entry.GetIndex().string_record;
-    existing_value.assign(existing_record->Value().data(),
-                          existing_record->Value().size());
+    Status s = readStringValue(existing_record, &existing_value);
+    if (s != Status::Ok) {
+      return s;
+    }
   } else if (lookup_result.s == Status::Outdated) {
     existing_record = lookup_result.entry.GetIndex().string_record;
   } else if (lookup_result.s == Status::NotFound) {
@@ -51,22 +62,49 @@ Status KVEngine::Modify(const StringView key, ModifyFunc modify_func,
               ? existing_record->GetExpireTime()
               : TimeUtils::TTLToExpireTime(write_options.ttl_time, base_time);
 
-      SpaceEntry space_entry =
-          pmem_allocator_->Allocate(StringRecord::RecordSize(key, new_value));
+      StringView record_value;
+      std::string buffer;
+      uint8_t value_flags;
+      // Reuse stored bytes of an unchanged value rather than encoding it
+      // again, extents of it are shared
+      bool reuse_stored = lookup_result.s == Status::Ok &&
+                          existing_record->GetValueFlags() !=
+                              ValueFlag::Inline &&
+                          new_value == existing_value;
+      bool share_extents = reuse_stored && existing_record->HasExtents();
+      if (reuse_stored) {
+        record_value = existing_record->Value();
+        value_flags = existing_record->GetValueFlags();
+      } else {
+        Status s = encodeStringValue(key, new_value, write_options,
+                                     &record_value, &buffer, &value_flags);
+        if (s != Status::Ok) {
+          return s;
+        }
+      }
+
+      SpaceEntry space_entry = pmem_allocator_->Allocate(
+          StringRecord::RecordSize(key, record_value));
       if (space_entry.size == 0) {
+        if (!share_extents && (value_flags & ValueFlag::Extents)) {
+          abandonExtents(buffer);
+        }
         return Status::PmemOverflow;
       }
+      if (share_extents) {
+        shareExtents(existing_record->GetExtentRef().first);
+      }
 
       StringRecord* new_record =
           pmem_allocator_->offset2addr_checked<StringRecord>(
               space_entry.offset);
       StringRecord::PersistStringRecord(
-          new_record, space_entry.size, new_ts, RecordType::String,
-          RecordStatus::Normal,
+          persistPolicy(), new_record, space_entry.size, new_ts,
+          RecordType::String, RecordStatus::Normal,
           existing_record == nullptr
               ? kNullPMemOffset
               : pmem_allocator_->addr2offset_checked(existing_record),
-          key, new_value, expired_time);
+          key, record_value, expired_time, value_flags);
       insertKeyOrElem(lookup_result, RecordType::String, RecordStatus::Normal,
                       new_record);
       break;
@@ -82,8 +120,8 @@ Status KVEngine::Modify(const StringView key, ModifyFunc modify_func,
         void* pmem_ptr =
             pmem_allocator_->offset2addr_checked(space_entry.offset);
         StringRecord::PersistStringRecord(
-            pmem_ptr, space_entry.size, new_ts, RecordType::String,
-            RecordStatus::Outdated,
+            persistPolicy(), pmem_ptr, space_entry.size, new_ts,
+            RecordType::String, RecordStatus::Outdated,
             pmem_allocator_->addr2offset_checked(existing_record), key, "");
         insertKeyOrElem(lookup_result, RecordType::String,
                         RecordStatus::Outdated, pmem_ptr);
@@ -103,56 +141,120 @@ Status KVEngine::Modify(const StringView key, ModifyFunc modify_func,
 
 Status KVEngine::Put(const StringView key, const StringView value,
                      const WriteOptions& options) {
-  auto thread_holder = AcquireAccessThread();
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpPut);
+  Tracer::Op trace_op(&tracer_, "Put");
+  auto thread_holder = AcquireAccessThread(RecordType::String);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   if (!checkKeySize(key) || !checkValueSize(value)) {
     return Status::InvalidDataSize;
   }
 
-  return stringPutImpl(key, value, options);
+  Status s = stringPutImpl(key, value, options);
+  maybeWakeRelaxedFlush();
+  return s;
 }
 
 Status KVEngine::Get(const StringView key, std::string* value) {
-  auto thread_holder = AcquireAccessThread();
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpGet);
+  auto thread_holder = AcquireAccessThread(RecordType::String);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   if (!checkKeySize(key)) {
     return Status::InvalidDataSize;
   }
-  auto holder = version_controller_.GetLocalSnapshotHolder();
-  auto ret = lookupKey<false>(key, RecordType::String);
-  if (ret.s == Status::Ok) {
+  StringRecord* cold_record;
+  TimestampType cold_ts;
+  {
+    auto holder = version_controller_.GetLocalSnapshotHolder();
+    auto ret = lookupKey<false>(key, RecordType::String);
+    if (ret.s != Status::Ok) {
+      return ret.s == Status::Outdated ? Status::NotFound : ret.s;
+    }
     StringRecord* string_record = ret.entry.GetIndex().string_record;
     kvdk_assert(string_record->GetRecordType() == RecordType::String &&
                     string_record->GetRecordStatus() != RecordStatus::Outdated,
                 "Got wrong data type in string get");
-    kvdk_assert(string_record->ValidOrDirty(), "Corrupted data in string get");
-    value->assign(string_record->Value().data(), string_record->Value().size());
-    return Status::Ok;
+    kvdk_assert(string_record->ValidOrDirty(persistPolicy()),
+                "Corrupted data in string get");
+    if (cold_tier_) {
+      ret.entry_ptr->Heat();
+    }
+    Status s = readStringValue(string_record, value);
+    if (s != Status::Ok || !string_record->IsCold() ||
+        !configs_.cold_tier_promote) {
+      return s;
+    }
+    cold_record = string_record;
+    cold_ts = string_record->GetTimestamp();
+  }
+  // Promote the value after releasing the snapshot, as it writes a new record
+  promoteString(key, cold_record, cold_ts, *value);
+  return Status::Ok;
+}
+
+Status KVEngine::GetChunks(const StringView key, ValueChunkFunc chunk_func,
+                           void* chunk_args) {
+  auto thread_holder = AcquireAccessThread(RecordType::String);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  if (!checkKeySize(key)) {
+    return Status::InvalidDataSize;
+  }
+  // Holding the snapshot keeps the record and its extents from being freed
+  // while chunks are read
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+  auto ret = lookupKey<false>(key, RecordType::String);
+  if (ret.s == Status::Ok) {
+    if (cold_tier_) {
+      ret.entry_ptr->Heat();
+    }
+    return visitStringValue(ret.entry.GetIndex().string_record,
+                            [&](const StringView& chunk) {
+                              return chunk_func(chunk, chunk_args);
+                            });
   } else {
     return ret.s == Status::Outdated ? Status::NotFound : ret.s;
   }
 }
 
 Status KVEngine::Delete(const StringView key) {
-  auto thread_holder = AcquireAccessThread();
+  StatsCollector::Timer stats_timer(&stats_, KVDKStatOpDelete);
+  Tracer::Op trace_op(&tracer_, "Delete");
+  auto thread_holder = AcquireAccessThread(RecordType::String);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
 
   if (!checkKeySize(key)) {
     return Status::InvalidDataSize;
   }
 
-  return stringDeleteImpl(key);
+  Status s = stringDeleteImpl(key);
+  maybeWakeRelaxedFlush();
+  return s;
 }
 
 Status KVEngine::stringDeleteImpl(const StringView& key) {
   auto ul = hash_table_->AcquireLock(key);
+  Tracer::Stage("lock");
+  PersistPolicy::DeferScope defer_scope(persistPolicy(), relaxed_durability_);
   auto holder = version_controller_.GetLocalSnapshotHolder();
   TimestampType new_ts = holder.Timestamp();
 
   auto lookup_result = lookupKey<false>(key, RecordType::String);
+  Tracer::Stage("lookup");
   if (lookup_result.s == Status::Ok) {
     // We only write delete record if key exist
     auto request_size = key.size() + sizeof(StringRecord);
     SpaceEntry space_entry = pmem_allocator_->Allocate(request_size);
+    Tracer::Stage("allocate");
     if (space_entry.size == 0) {
       return Status::PmemOverflow;
     }
@@ -160,17 +262,20 @@ Status KVEngine::stringDeleteImpl(const StringView& key) {
     StringRecord* pmem_ptr =
         pmem_allocator_->offset2addr_checked<StringRecord>(space_entry.offset);
     StringRecord::PersistStringRecord(
-        pmem_ptr, space_entry.size, new_ts, RecordType::String,
+        persistPolicy(), pmem_ptr, space_entry.size, new_ts, RecordType::String,
         RecordStatus::Outdated,
         pmem_allocator_->addr2offset_checked(
             lookup_result.entry.GetIndex().string_record),
         key, "");
+    Tracer::Stage("persist");
     insertKeyOrElem(lookup_result, RecordType::String, RecordStatus::Outdated,
                     pmem_ptr);
+    Tracer::Stage("publish");
 
     removeAndCacheOutdatedVersion(pmem_ptr);
   }
   tryCleanCachedOutdatedRecord();
+  Tracer::Stage("clean");
 
   return (lookup_result.s == Status::NotFound ||
           lookup_result.s == Status::Outdated)
@@ -185,15 +290,34 @@ Status KVEngine::stringPutImpl(const StringView& key, const StringView& value,
     return Status::InvalidArgument;
   }
 
+  // Compress the value and persist a large value to extents before locking
+  // the key, as they are the most time consuming part
+  StringView record_value;
+  std::string buffer;
+  uint8_t value_flags;
+  Status s = encodeStringValue(key, value, write_options, &record_value,
+                               &buffer, &value_flags);
+  if (s != Status::Ok) {
+    return s;
+  }
+  Tracer::Stage("encode");
+
   TEST_SYNC_POINT("KVEngine::stringPutImpl::BeforeLock");
   auto ul = hash_table_->AcquireLock(key);
+  Tracer::Stage("lock");
+  // Opened after the key locked, as a group flush waits for it
+  PersistPolicy::DeferScope defer_scope(persistPolicy(), relaxed_durability_);
   auto holder = version_controller_.GetLocalSnapshotHolder();
   TimestampType new_ts = holder.Timestamp();
 
   // Lookup key in hashtable
   auto lookup_result = lookupKey<true>(key, RecordType::String);
+  Tracer::Stage("lookup");
   if (lookup_result.s == Status::MemoryOverflow ||
       lookup_result.s == Status::WrongType) {
+    if (value_flags & ValueFlag::Extents) {
+      abandonExtents(buffer);
+    }
     return lookup_result.s;
   }
 
@@ -215,29 +339,82 @@ Status KVEngine::stringPutImpl(const StringView& key, const StringView& value,
 
   // Persist key-value pair to PMem
   SpaceEntry space_entry =
-      pmem_allocator_->Allocate(StringRecord::RecordSize(key, value));
+      pmem_allocator_->Allocate(StringRecord::RecordSize(key, record_value));
+  Tracer::Stage("allocate");
   if (space_entry.size == 0) {
+    if (value_flags & ValueFlag::Extents) {
+      abandonExtents(buffer);
+    }
     return Status::PmemOverflow;
   }
 
   StringRecord* new_record =
       pmem_allocator_->offset2addr_checked<StringRecord>(space_entry.offset);
   StringRecord::PersistStringRecord(
-      new_record, space_entry.size, new_ts, RecordType::String,
+      persistPolicy(), new_record, space_entry.size, new_ts, RecordType::String,
       RecordStatus::Normal, pmem_allocator_->addr2offset(existing_record), key,
-      value, expired_time);
+      record_value, expired_time, value_flags);
+  Tracer::Stage("persist");
 
   insertKeyOrElem(lookup_result, RecordType::String, RecordStatus::Normal,
                   new_record);
+  Tracer::Stage("publish");
 
   if (existing_record) {
     removeAndCacheOutdatedVersion(new_record);
   }
   tryCleanCachedOutdatedRecord();
+  Tracer::Stage("clean");
 
   return Status::Ok;
 }
 
+Status KVEngine::stringExpireImpl(const StringView& key,
+                                  ExpireTimeType expired_time) {
+  auto ul = hash_table_->AcquireLock(key);
+  Tracer::Stage("lock");
+  PersistPolicy::DeferScope defer_scope(persistPolicy(), relaxed_durability_);
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+  TimestampType new_ts = holder.Timestamp();
+
+  auto lookup_result = lookupKey<true>(key, RecordType::String);
+  Tracer::Stage("lookup");
+  if (lookup_result.s != Status::Ok) {
+    return lookup_result.s == Status::Outdated ? Status::NotFound
+                                               : lookup_result.s;
+  }
+  StringRecord* existing_record = lookup_result.entry.GetIndex().string_record;
+  // Only the record is rewritten, a value in extents is shared with the
+  // existing record
+  StringView record_value = existing_record->Value();
+  SpaceEntry space_entry =
+      pmem_allocator_->Allocate(StringRecord::RecordSize(key, record_value));
+  Tracer::Stage("allocate");
+  if (space_entry.size == 0) {
+    return Status::PmemOverflow;
+  }
+  if (existing_record->HasExtents()) {
+    shareExtents(existing_record->GetExtentRef().first);
+  }
+
+  StringRecord* new_record =
+      pmem_allocator_->offset2addr_checked<StringRecord>(space_entry.offset);
+  StringRecord::PersistStringRecord(
+      persistPolicy(), new_record, space_entry.size, new_ts, RecordType::String,
+      RecordStatus::Normal,
+      pmem_allocator_->addr2offset_checked(existing_record), key, record_value,
+      expired_time, existing_record->GetValueFlags());
+  Tracer::Stage("persist");
+  insertKeyOrElem(lookup_result, RecordType::String, RecordStatus::Normal,
+                  new_record);
+  Tracer::Stage("publish");
+
+  removeAndCacheOutdatedVersion(new_record);
+  tryCleanCachedOutdatedRecord();
+  Tracer::Stage("clean");
+  return Status::Ok;
+}
+
 Status KVEngine::restoreStringRecord(StringRecord* pmem_record,
                                      const DataEntry& cached_entry) {
   assert(pmem_record->GetRecordType() == RecordType::String);
@@ -265,7 +442,7 @@ Status KVEngine::restoreStringRecord(StringRecord* pmem_record,
 
   insertKeyOrElem(lookup_result, cached_entry.meta.type,
                   cached_entry.meta.status, pmem_record);
-  pmem_record->PersistOldVersion(kNullPMemOffset);
+  pmem_record->PersistOldVersion(persistPolicy(), kNullPMemOffset);
 
   if (lookup_result.s == Status::Ok) {
     pmem_allocator_->PurgeAndFree<StringRecord>(
@@ -275,8 +452,417 @@ Status KVEngine::restoreStringRecord(StringRecord* pmem_record,
   return Status::Ok;
 }
 
+Status KVEngine::restoreExtentRecord(ExtentRecord* pmem_record) {
+  // Whether an extent is referenced is only known after all string records
+  // restored, see restoreExtents()
+  PMemOffsetType offset = pmem_allocator_->addr2offset_checked(pmem_record);
+  std::lock_guard<SpinMutex> lg(recovered_extents_spin_);
+  recovered_extents_.emplace_back(offset, pmem_record->GetRecordSize());
+  return Status::Ok;
+}
+
+Status KVEngine::restoreExtents() {
+  if (recovered_extents_.empty()) {
+    return Status::Ok;
+  }
+  std::unordered_map<PMemOffsetType, uint64_t> unreferenced;
+  for (const SpaceEntry& extent : recovered_extents_) {
+    unreferenced.emplace(extent.offset, extent.size);
+  }
+  recovered_extents_ = std::vector<SpaceEntry>();
+
+  uint64_t num_broken = 0;
+  auto hashtable_iter = hash_table_->GetIterator(0, hash_table_->GetSlotsNum());
+  while (hashtable_iter.Valid()) {
+    auto slot_iter = hashtable_iter.Slot();
+    while (slot_iter.Valid()) {
+      if (!slot_iter->Empty() &&
+          slot_iter->GetIndexType() == PointerType::StringRecord &&
+          slot_iter->GetIndex().string_record->HasExtents()) {
+        StringRecord* record = slot_iter->GetIndex().string_record;
+        ExtentRef ref = record->GetExtentRef();
+        std::vector<SpaceEntry> chain;
+        uint64_t chain_size = 0;
+        PMemOffsetType offset = ref.first;
+        while (offset != kNullPMemOffset) {
+          auto iter = unreferenced.find(offset);
+          if (iter == unreferenced.end()) {
+            break;
+          }
+          chain.emplace_back(iter->first, iter->second);
+          unreferenced.erase(iter);
+          ExtentRecord* extent =
+              pmem_allocator_->offset2addr_checked<ExtentRecord>(offset);
+          chain_size += extent->Data().size();
+          offset = extent->next;
+        }
+        if (offset != kNullPMemOffset || chain_size != ref.size) {
+          // Some extents are missing or corrupted, drop the record
+          for (const SpaceEntry& extent : chain) {
+            unreferenced.emplace(extent.offset, extent.size);
+          }
+          hash_table_->Erase(&(*slot_iter));
+          pmem_allocator_->PurgeAndFree<StringRecord>(record);
+          num_broken++;
+        }
+      }
+      slot_iter++;
+    }
+    hashtable_iter.Next();
+  }
+  if (num_broken > 0) {
+    GlobalLogger.Error("Drop %lu string records with broken extents\n",
+                       num_broken);
+  }
+
+  std::vector<SpaceEntry> to_free;
+  for (auto& extent : unreferenced) {
+    pmem_allocator_->offset2addr_checked<ExtentRecord>(extent.first)->Destroy(
+        persistPolicy());
+    to_free.emplace_back(extent.first, extent.second);
+  }
+  pmem_allocator_->BatchFree(to_free);
+  return Status::Ok;
+}
+
+Status KVEngine::persistExtents(const StringView& value,
+                                std::string* extent_ref) {
+  uint64_t extent_capacity =
+      pmem_allocator_->SegmentSize() - sizeof(ExtentRecord);
+  uint64_t num_extents = (value.size() + extent_capacity - 1) / extent_capacity;
+  // A blob is allocated from the segment of this thread like records, while
+  // a large value is allocated apart from it
+  bool is_blob = value.size() <= extent_capacity &&
+                 (configs_.large_value_threshold == 0 ||
+                  value.size() < configs_.large_value_threshold);
+  TimestampType ts = version_controller_.GetCurrentTimestamp();
+  // Persist extents from the last one, so each extent links to a persisted
+  // successor
+  PMemOffsetType next = kNullPMemOffset;
+  for (uint64_t i = num_extents; i > 0; i--) {
+    uint64_t begin = (i - 1) * extent_capacity;
+    uint64_t size = std::min(extent_capacity, value.size() - begin);
+    uint64_t record_size = ExtentRecord::RecordSize(size);
+    SpaceEntry space_entry = is_blob
+                                 ? pmem_allocator_->Allocate(record_size)
+                                 : pmem_allocator_->AllocateExtent(record_size);
+    if (space_entry.size == 0) {
+      pmem_allocator_->PurgeAndFreeExtents(next);
+      return Status::PmemOverflow;
+    }
+    ExtentRecord::PersistExtentRecord(
+        persistPolicy(),
+        pmem_allocator_->offset2addr_checked(space_entry.offset),
+        space_entry.size, ts, next, StringView(value.data() + begin, size));
+    next = space_entry.offset;
+  }
+  *extent_ref = ExtentRef{next, value.size()}.Encode();
+  return Status::Ok;
+}
+
+void KVEngine::shareExtents(PMemOffsetType first) {
+  std::lock_guard<SpinMutex> lg(shared_extents_spin_);
+  shared_extents_[first]++;
+}
+
+void KVEngine::releaseExtents(PMemOffsetType first) {
+  if (first == kNullPMemOffset) {
+    return;
+  }
+  {
+    std::lock_guard<SpinMutex> lg(shared_extents_spin_);
+    auto iter = shared_extents_.find(first);
+    if (iter != shared_extents_.end()) {
+      if (--iter->second == 0) {
+        shared_extents_.erase(iter);
+      }
+      return;
+    }
+  }
+  pmem_allocator_->PurgeAndFreeExtents(first);
+}
+
+void KVEngine::abandonExtents(const std::string& extent_ref) {
+  ExtentRef ref;
+  if (ExtentRef::Decode(extent_ref, &ref)) {
+    pmem_allocator_->PurgeAndFreeExtents(ref.first);
+  }
+}
+
+Status KVEngine::encodeStringValue(const StringView& key,
+                                   const StringView& value,
+                                   const WriteOptions& write_options,
+                                   StringView* record_value,
+                                   std::string* buffer, uint8_t* value_flags) {
+  *record_value = value;
+  *value_flags = ValueFlag::Inline;
+  CompressionType compression =
+      write_options.compression == CompressionType::Default
+          ? configs_.value_compression
+          : write_options.compression;
+  if (compression != CompressionType::Default &&
+      compression != CompressionType::None &&
+      value.size() >= configs_.compression_threshold) {
+    std::string compressed;
+    if (CompressValue(compression, value, &compressed)) {
+      buffer->swap(compressed);
+      *record_value = *buffer;
+      *value_flags |= ValueFlag::Compressed;
+    }
+  }
+  if (storeInExtents(key, *record_value)) {
+    std::string extent_ref;
+    Status s = persistExtents(*record_value, &extent_ref);
+    if (s != Status::Ok) {
+      return s;
+    }
+    buffer->swap(extent_ref);
+    *record_value = *buffer;
+    *value_flags |= ValueFlag::Extents;
+  }
+  return Status::Ok;
+}
+
+void KVEngine::visitStoredValue(
+    const StringRecord* record,
+    const std::function<bool(const StringView&)>& chunk_func) {
+  kvdk_assert(!record->IsCold(), "Visit stored bytes of a cold value");
+  if (!record->HasExtents()) {
+    chunk_func(record->Value());
+    return;
+  }
+  for (PMemOffsetType offset = record->GetExtentRef().first;
+       offset != kNullPMemOffset;) {
+    ExtentRecord* extent =
+        pmem_allocator_->offset2addr_checked<ExtentRecord>(offset);
+    if (!chunk_func(extent->Data())) {
+      return;
+    }
+    offset = extent->next;
+  }
+}
+
+Status KVEngine::visitStringValue(
+    const StringRecord* record,
+    const std::function<bool(const StringView&)>& chunk_func) {
+  if (!record->IsCompressed() && !record->IsCold()) {
+    visitStoredValue(record, chunk_func);
+    return Status::Ok;
+  }
+  std::string value;
+  Status s = readStringValue(record, &value);
+  if (s == Status::Ok) {
+    chunk_func(value);
+  }
+  return s;
+}
+
+Status KVEngine::readStringValue(const StringRecord* record,
+                                 std::string* value) {
+  if (record->GetValueFlags() == ValueFlag::Inline) {
+    value->assign(record->Value().data(), record->Value().size());
+    return Status::Ok;
+  }
+  std::string stored;
+  std::string* dst = record->IsCompressed() ? &stored : value;
+  if (record->IsCold()) {
+    if (!cold_tier_) {
+      GlobalLogger.Error(
+          "Value of string %s is in the cold tier, but it's not configured\n",
+          string_view_2_string(record->Key()).c_str());
+      return Status::InvalidConfiguration;
+    }
+    Status s = cold_tier_->Read(record->GetColdRef(), record->Key(), dst);
+    if (s != Status::Ok) {
+      return s;
+    }
+  } else if (record->HasExtents()) {
+    dst->clear();
+    dst->reserve(record->GetExtentRef().size);
+    visitStoredValue(record, [&](const StringView& chunk) {
+      dst->append(chunk.data(), chunk.size());
+      return true;
+    });
+  }
+  if (record->IsCompressed()) {
+    StringView compressed =
+        record->HasExtents() || record->IsCold() ? stored : record->Value();
+    if (!DecompressValue(compressed, value)) {
+      GlobalLogger.Error("Corrupted compressed value of string %s\n",
+                         string_view_2_string(record->Key()).c_str());
+      return Status::Abort;
+    }
+  }
+  return Status::Ok;
+}
+
+bool KVEngine::coolString(HashEntry* entry, uint64_t period) {
+  if (!entry->Cool(period) ||
+      entry->GetRecordStatus() == RecordStatus::Outdated) {
+    return false;
+  }
+  StringRecord* record = entry->GetIndex().string_record;
+  uint64_t stored_size = record->HasExtents() ? record->GetExtentRef().size
+                                              : record->Value().size();
+  return !record->IsCold() &&
+         record->GetRecordStatus() == RecordStatus::Normal &&
+         stored_size >= configs_.cold_tier_min_value_size;
+}
+
+void KVEngine::demoteColdStrings(const std::vector<ColdCandidate>& candidates) {
+  auto thread_holder = AcquireAccessThread(RecordType::String);
+  if (thread_holder.status() != Status::Ok) {
+    return;
+  }
+
+  // Append values to the cold tier without holding locks of keys, and make
+  // them durable by a single sync before records refer to them
+  std::vector<std::string> cold_refs(candidates.size());
+  bool appended = false;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    const ColdCandidate& candidate = candidates[i];
+    std::string stored;
+    {
+      auto ul = hash_table_->AcquireLock(candidate.key);
+      auto lookup_result = lookupKey<false>(candidate.key, RecordType::String);
+      if (lookup_result.s != Status::Ok ||
+          lookup_result.entry.GetIndex().string_record != candidate.record ||
+          candidate.record->GetTimestamp() != candidate.ts) {
+        continue;
+      }
+      visitStoredValue(candidate.record, [&](const StringView& chunk) {
+        stored.append(chunk.data(), chunk.size());
+        return true;
+      });
+    }
+    ColdRef ref;
+    if (!ColdCopy::Read(candidate.record, &ref) ||
+        !cold_tier_->Holds(ref, candidate.key, stored)) {
+      Status s = cold_tier_->Append(candidate.key, stored, &ref);
+      if (s == Status::OutOfRange) {
+        // The cold tier is full, only values with reusable entries are
+        // demoted
+        continue;
+      }
+      if (s != Status::Ok) {
+        return;
+      }
+      appended = true;
+    }
+    cold_refs[i] = ref.Encode();
+  }
+  if (appended && cold_tier_->Sync() != Status::Ok) {
+    return;
+  }
+
+  for (size_t i = 0; i < candidates.size(); i++) {
+    if (cold_refs[i].empty()) {
+      continue;
+    }
+    const ColdCandidate& candidate = candidates[i];
+    auto ul = hash_table_->AcquireLock(candidate.key);
+    auto holder = version_controller_.GetLocalSnapshotHolder();
+    TimestampType new_ts = holder.Timestamp();
+    orderStrictWrite();
+    auto lookup_result = lookupKey<true>(candidate.key, RecordType::String);
+    if (lookup_result.s != Status::Ok ||
+        lookup_result.entry.GetIndex().string_record != candidate.record ||
+        candidate.record->GetTimestamp() != candidate.ts) {
+      continue;
+    }
+    SpaceEntry space_entry = pmem_allocator_->Allocate(
+        StringRecord::RecordSize(candidate.key, cold_refs[i]));
+    if (space_entry.size == 0) {
+      return;
+    }
+    uint8_t value_flags =
+        (candidate.record->GetValueFlags() & ValueFlag::Compressed) |
+        ValueFlag::Cold;
+    StringRecord* new_record =
+        pmem_allocator_->offset2addr_checked<StringRecord>(space_entry.offset);
+    StringRecord::PersistStringRecord(
+        persistPolicy(), new_record, space_entry.size, new_ts,
+        RecordType::String, RecordStatus::Normal,
+        pmem_allocator_->addr2offset_checked(candidate.record), candidate.key,
+        cold_refs[i], candidate.record->GetExpireTime(), value_flags);
+    insertKeyOrElem(lookup_result, RecordType::String, RecordStatus::Normal,
+                    new_record);
+    removeAndCacheOutdatedVersion(new_record);
+  }
+}
+
+void KVEngine::promoteString(const StringView& key, const StringRecord* record,
+                             TimestampType ts, const StringView& value) {
+  StringView record_value;
+  std::string buffer;
+  uint8_t value_flags;
+  if (encodeStringValue(key, value, WriteOptions(), &record_value, &buffer,
+                        &value_flags) != Status::Ok) {
+    return;
+  }
+
+  auto ul = hash_table_->AcquireLock(key);
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+  TimestampType new_ts = holder.Timestamp();
+  orderStrictWrite();
+  auto lookup_result = lookupKey<true>(key, RecordType::String);
+  SpaceEntry space_entry;
+  if (lookup_result.s == Status::Ok &&
+      lookup_result.entry.GetIndex().string_record == record &&
+      record->GetTimestamp() == ts) {
+    space_entry =
+        pmem_allocator_->Allocate(ColdCopy::RecordSize(key, record_value));
+  }
+  if (space_entry.size == 0) {
+    // The key is updated or PMem is full, keep it cold
+    if (value_flags & ValueFlag::Extents) {
+      abandonExtents(buffer);
+    }
+    return;
+  }
+  StringRecord* new_record =
+      pmem_allocator_->offset2addr_checked<StringRecord>(space_entry.offset);
+  ColdCopy::Persist(persistPolicy(), new_record, key, record_value,
+                    record->GetColdRef());
+  StringRecord::PersistStringRecord(
+      persistPolicy(), new_record, space_entry.size, new_ts, RecordType::String,
+      RecordStatus::Normal, pmem_allocator_->addr2offset_checked(record), key,
+      record_value, record->GetExpireTime(), value_flags);
+  insertKeyOrElem(lookup_result, RecordType::String, RecordStatus::Normal,
+                  new_record);
+  removeAndCacheOutdatedVersion(new_record);
+  tryCleanCachedOutdatedRecord();
+}
+
+void KVEngine::TestDemoteColdStrings() {
+  if (!cold_tier_) {
+    return;
+  }
+  test_cooling_periods_.fetch_add(1);
+  uint64_t period = coolingPeriod();
+  std::vector<ColdCandidate> candidates;
+  auto hashtable_iter = hash_table_->GetIterator(0, hash_table_->GetSlotsNum());
+  while (hashtable_iter.Valid()) {
+    auto slot_lock(hashtable_iter.AcquireSlotLock());
+    auto slot_iter = hashtable_iter.Slot();
+    while (slot_iter.Valid()) {
+      if (!slot_iter->Empty() &&
+          slot_iter->GetIndexType() == PointerType::StringRecord &&
+          coolString(&(*slot_iter), period)) {
+        StringRecord* record = slot_iter->GetIndex().string_record;
+        candidates.push_back({string_view_2_string(record->Key()), record,
+                              record->GetTimestamp()});
+      }
+      slot_iter++;
+    }
+    hashtable_iter.Next();
+  }
+  demoteColdStrings(candidates);
+}
+
 Status KVEngine::stringWritePrepare(StringWriteArgs& args, TimestampType ts) {
   args.res = lookupKey<true>(args.key, RecordType::String);
+  Tracer::Stage("lookup");
   if (args.res.s != Status::Ok && args.res.s != Status::NotFound &&
       args.res.s != Status::Outdated) {
     return args.res.s;
@@ -287,6 +873,7 @@ Status KVEngine::stringWritePrepare(StringWriteArgs& args, TimestampType ts) {
   }
   args.space =
       pmem_allocator_->Allocate(StringRecord::RecordSize(args.key, args.value));
+  Tracer::Stage("allocate");
   if (args.space.size == 0) {
     return Status::PmemOverflow;
   }
@@ -307,8 +894,9 @@ Status KVEngine::stringWrite(StringWriteArgs& args) {
         args.res.entry.GetIndex().string_record);
   }
   args.new_rec = StringRecord::PersistStringRecord(
-      new_addr, args.space.size, args.ts, RecordType::String, record_status,
-      old_off, args.key, args.value);
+      persistPolicy(), new_addr, args.space.size, args.ts, RecordType::String,
+      record_status, old_off, args.key, args.value);
+  Tracer::Stage("persist");
   return Status::Ok;
 }
 
@@ -317,13 +905,14 @@ Status KVEngine::stringWritePublish(StringWriteArgs const& args) {
       args.op == WriteOp::Put ? RecordStatus::Normal : RecordStatus::Outdated;
   insertKeyOrElem(args.res, RecordType::String, record_status,
                   const_cast<StringRecord*>(args.new_rec));
+  Tracer::Stage("publish");
   return Status::Ok;
 }
 
 Status KVEngine::stringRollback(TimestampType,
                                 BatchWriteLog::StringLogEntry const& log) {
   static_cast<DataEntry*>(pmem_allocator_->offset2addr_checked(log.offset))
-      ->Destroy();
+      ->Destroy(persistPolicy());
   return Status::Ok;
 }
 
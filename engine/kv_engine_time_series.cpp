@@ -0,0 +1,269 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include <functional>
+
+#include "hash_collection/iterator.hpp"
+#include "kv_engine.hpp"
+
+namespace KVDK_NAMESPACE {
+Status KVEngine::TSCreate(StringView series, int64_t bucket_width) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  if (!checkKeySize(series)) {
+    return Status::InvalidDataSize;
+  }
+  if (bucket_width <= 0) {
+    return Status::InvalidArgument;
+  }
+
+  std::shared_ptr<HashList> hlist = nullptr;
+  return buildHashlist(series, hlist, HashList::Kind::TimeSeries,
+                       EncodeUint64(bucket_width));
+}
+
+Status KVEngine::TSDestroy(StringView series) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  if (!checkKeySize(series)) {
+    return Status::InvalidDataSize;
+  }
+  return destroyHashlist(series, HashList::Kind::TimeSeries);
+}
+
+Status KVEngine::TSAppend(StringView series, int64_t timestamp, double value) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  // Hold current snapshot in this thread
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+
+  HashList* hlist;
+  Status s = tsFind(series, &hlist);
+  if (s != Status::Ok) {
+    return s;
+  }
+  TimeSeriesIndex* index = hlist->GetTimeSeriesIndex();
+  int64_t bucket_id = index->BucketOf(timestamp);
+  std::string bucket_key = TimeSeriesIndex::EncodeBucketKey(bucket_id);
+  std::string internal_key(hlist->InternalKey(bucket_key));
+  // Hold lock of the bucket as appending is a read-modify-write of it
+  auto ul = hash_table_->AcquireLock(internal_key);
+  DLRecord* existing_record = tsBucketRecord(hlist, bucket_key);
+  bool existed = existing_record != nullptr;
+  if (existed) {
+    // A sample later than the bucket is appended to the tail of its record
+    // in place
+    TimeSeriesTail tail(existing_record);
+    int64_t last;
+    if ((tail.LastTimestamp(&last) ||
+         TimeSeriesBucket::LastTimestamp(existing_record->Value(), &last)) &&
+        timestamp > last) {
+      orderStrictWrite();
+      if (tail.Append(persistPolicy(), timestamp, value)) {
+        return Status::Ok;
+      }
+    }
+  }
+
+  // Otherwise rewrite the bucket with a new tail as large as it, so the cost
+  // of rewriting is amortized over in order appends
+  TimeSeriesBucket bucket;
+  if (existed && !bucket.Load(existing_record)) {
+    return Status::Abort;
+  }
+  bucket.Insert(timestamp, value);
+  std::string bucket_value = bucket.Encode();
+  if (!checkValueSize(bucket_value)) {
+    return Status::InvalidDataSize;
+  }
+  size_t capacity = std::min(
+      std::max(bucket.Size(), kMinTimeSeriesTail), kMaxTimeSeriesTail);
+  uint32_t data_size = DLRecord::RecordSize(internal_key, bucket_value);
+  HashWriteArgs args =
+      hlist->InitWriteArgs(bucket_key, bucket_value, WriteOp::Put);
+  args.padding = data_size + TimeSeriesTail::ReserveSize(capacity) -
+                 pmem_allocator_->DLRecordSize(RecordType::HashElem,
+                                               internal_key, bucket_value);
+  TimestampType ts = strictWriteTimestamp();
+  s = hlist->PrepareWrite(args, ts);
+  if (s == Status::PmemOverflow) {
+    // Write the bucket without a tail if there is no space for it
+    args.padding = 0;
+    s = hlist->PrepareWrite(args, ts);
+  }
+  if (s != Status::Ok) {
+    return s;
+  }
+  TimeSeriesTail::Init(
+      persistPolicy(),
+      pmem_allocator_->offset2addr_checked<char>(args.space.offset),
+      args.space.size, data_size, ts);
+  auto ret = hlist->Write(args);
+  if (ret.s == Status::Ok) {
+    if (!existed) {
+      index->AddBucket(bucket_id);
+    }
+    if (ret.existing_record && hlist->TryCleaningLock()) {
+      removeAndCacheOutdatedVersion<DLRecord>(ret.write_record);
+      hlist->ReleaseCleaningLock();
+    }
+  }
+  tryCleanCachedOutdatedRecord();
+  return ret.s;
+}
+
+Status KVEngine::TSRange(StringView series, int64_t start, int64_t end,
+                         std::vector<std::pair<int64_t, double>>* samples) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  samples->clear();
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+  HashList* hlist;
+  Status s = tsFind(series, &hlist);
+  if (s != Status::Ok) {
+    return s;
+  }
+  std::vector<TimeSeriesBucket> buckets;
+  s = tsFetchBuckets(hlist, start, end, &buckets);
+  if (s != Status::Ok) {
+    return s;
+  }
+  for (auto& bucket : buckets) {
+    size_t i = std::lower_bound(bucket.timestamps.begin(),
+                                bucket.timestamps.end(), start) -
+               bucket.timestamps.begin();
+    for (; i < bucket.Size() && bucket.timestamps[i] <= end; i++) {
+      samples->emplace_back(bucket.timestamps[i], bucket.values[i]);
+    }
+  }
+  return Status::Ok;
+}
+
+Status KVEngine::TSAggregate(StringView series, int64_t start, int64_t end,
+                             int64_t window,
+                             std::vector<TimeSeriesAggregate>* aggregates) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  aggregates->clear();
+  if (window <= 0) {
+    return Status::InvalidArgument;
+  }
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+  HashList* hlist;
+  Status s = tsFind(series, &hlist);
+  if (s != Status::Ok) {
+    return s;
+  }
+  std::vector<TimeSeriesBucket> buckets;
+  s = tsFetchBuckets(hlist, start, end, &buckets);
+  if (s != Status::Ok) {
+    return s;
+  }
+  for (auto& bucket : buckets) {
+    auto ts_begin = bucket.timestamps.begin();
+    auto ts_end = bucket.timestamps.end();
+    auto iter = std::lower_bound(ts_begin, ts_end, start);
+    while (iter != ts_end && *iter <= end) {
+      // Offsets are computed unsigned to not overflow on wide ranges
+      uint64_t offset_in_range = static_cast<uint64_t>(*iter) - start;
+      int64_t window_start =
+          start + offset_in_range / window * static_cast<uint64_t>(window);
+      // Samples of this window in the bucket are contiguous
+      auto window_end = std::partition_point(iter, ts_end, [&](int64_t ts) {
+        return ts <= end && static_cast<uint64_t>(ts) - window_start <
+                                static_cast<uint64_t>(window);
+      });
+      size_t offset = iter - ts_begin;
+      size_t count = window_end - iter;
+      double sum, min, max;
+      ReduceDoubles(bucket.values.data() + offset, count, &sum, &min, &max);
+      // A window may span buckets
+      if (aggregates->empty() ||
+          aggregates->back().window_start != window_start) {
+        aggregates->emplace_back();
+        aggregates->back().window_start = window_start;
+        aggregates->back().min = min;
+        aggregates->back().max = max;
+      }
+      TimeSeriesAggregate& agg = aggregates->back();
+      agg.count += count;
+      agg.sum += sum;
+      agg.min = std::min(agg.min, min);
+      agg.max = std::max(agg.max, max);
+      iter = window_end;
+    }
+  }
+  return Status::Ok;
+}
+
+Status KVEngine::tsFind(StringView series, HashList** hlist) {
+  Status s = hashListFind(series, hlist, HashList::Kind::TimeSeries);
+  if (s != Status::Ok) {
+    return s;
+  }
+  TimeSeriesIndex* index = (*hlist)->GetTimeSeriesIndex();
+  if (!index->Built()) {
+    // Directory is not persisted, build it on first access after recovery
+    index->Build([&](const std::function<void(int64_t)>& insert) {
+      Snapshot* snapshot = version_controller_.NewGlobalSnapshot();
+      defer(ReleaseSnapshot(snapshot));
+      HashIteratorImpl iter(*hlist, static_cast<SnapshotImpl*>(snapshot),
+                            false);
+      for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+        insert(TimeSeriesIndex::DecodeBucketKey(iter.Key()));
+      }
+    });
+  }
+  return Status::Ok;
+}
+
+Status KVEngine::tsFetchBuckets(HashList* hlist, int64_t start, int64_t end,
+                                std::vector<TimeSeriesBucket>* buckets) {
+  if (start > end) {
+    return Status::Ok;
+  }
+  for (int64_t bucket_id :
+       hlist->GetTimeSeriesIndex()->BucketsIn(start, end)) {
+    DLRecord* record =
+        tsBucketRecord(hlist, TimeSeriesIndex::EncodeBucketKey(bucket_id));
+    if (record == nullptr) {
+      continue;
+    }
+    buckets->emplace_back();
+    if (!buckets->back().Load(record)) {
+      return Status::Abort;
+    }
+  }
+  return Status::Ok;
+}
+
+DLRecord* KVEngine::tsBucketRecord(HashList* hlist, StringView bucket_key) {
+  std::string internal_key(hlist->InternalKey(bucket_key));
+  auto lookup_result =
+      hash_table_->Lookup<false>(internal_key, RecordType::HashElem);
+  if (lookup_result.s != Status::Ok ||
+      lookup_result.entry.GetRecordStatus() == RecordStatus::Outdated) {
+    return nullptr;
+  }
+  DLRecord* record = lookup_result.entry.GetIndex().dl_record;
+  // As lookup is lockless, the elem may be deleted after we get it
+  return record->GetRecordStatus() == RecordStatus::Outdated ? nullptr
+                                                             : record;
+}
+}  // namespace KVDK_NAMESPACE
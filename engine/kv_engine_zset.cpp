@@ -0,0 +1,282 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include <cmath>
+#include <functional>
+
+#include "hash_collection/iterator.hpp"
+#include "kv_engine.hpp"
+
+namespace KVDK_NAMESPACE {
+Status KVEngine::ZSetCreate(StringView zset) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  if (!checkKeySize(zset)) {
+    return Status::InvalidDataSize;
+  }
+
+  std::shared_ptr<HashList> hlist = nullptr;
+  return buildHashlist(zset, hlist, HashList::Kind::ZSet);
+}
+
+Status KVEngine::ZSetDestroy(StringView zset) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  if (!checkKeySize(zset)) {
+    return Status::InvalidDataSize;
+  }
+  return destroyHashlist(zset, HashList::Kind::ZSet);
+}
+
+Status KVEngine::ZAdd(StringView zset, StringView member, double score) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  // Hold current snapshot in this thread
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+
+  HashList* hlist;
+  Status s = zsetFind(zset, &hlist);
+  if (s == Status::Ok) {
+    s = zsetWrite(hlist, member, score, false, nullptr);
+  }
+  return s;
+}
+
+Status KVEngine::ZIncrBy(StringView zset, StringView member, double increment,
+                         double* new_score) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  // Hold current snapshot in this thread
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+
+  HashList* hlist;
+  Status s = zsetFind(zset, &hlist);
+  if (s == Status::Ok) {
+    s = zsetWrite(hlist, member, increment, true, new_score);
+  }
+  return s;
+}
+
+Status KVEngine::ZRem(StringView zset, StringView member) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  // Hold current snapshot in this thread
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+
+  HashList* hlist;
+  Status s = zsetFind(zset, &hlist);
+  if (s != Status::Ok) {
+    return s;
+  }
+  std::string internal_key(hlist->InternalKey(member));
+  if (!checkKeySize(internal_key)) {
+    return Status::InvalidDataSize;
+  }
+  auto ul = hash_table_->AcquireLock(internal_key);
+  std::string existing_value;
+  double existing_score;
+  s = hlist->Get(member, &existing_value);
+  if (s == Status::NotFound) {
+    return Status::Ok;
+  }
+  if (s != Status::Ok) {
+    return s;
+  }
+  if (!ScoreIndex::DecodeScore(existing_value, &existing_score)) {
+    return Status::Abort;
+  }
+  auto ret = hlist->Delete(member, strictWriteTimestamp());
+  if (ret.s == Status::Ok) {
+    hlist->GetScoreIndex()->Erase(member, existing_score);
+    if (ret.existing_record && ret.write_record && hlist->TryCleaningLock()) {
+      removeAndCacheOutdatedVersion(ret.write_record);
+      hlist->ReleaseCleaningLock();
+    }
+  }
+  tryCleanCachedOutdatedRecord();
+  return ret.s;
+}
+
+Status KVEngine::ZScore(StringView zset, StringView member, double* score) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  // Hold current snapshot in this thread
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+
+  HashList* hlist;
+  Status s = hashListFind(zset, &hlist, HashList::Kind::ZSet);
+  if (s != Status::Ok) {
+    return s;
+  }
+  std::string value;
+  s = hlist->Get(member, &value);
+  if (s == Status::Ok && !ScoreIndex::DecodeScore(value, score)) {
+    s = Status::Abort;
+  }
+  return s;
+}
+
+Status KVEngine::ZCard(StringView zset, size_t* card) {
+  if (!checkKeySize(zset)) {
+    return Status::InvalidDataSize;
+  }
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+  HashList* hlist;
+  Status s = hashListFind(zset, &hlist, HashList::Kind::ZSet);
+  if (s == Status::Ok) {
+    *card = hlist->Size();
+  }
+  return s;
+}
+
+Status KVEngine::ZRank(StringView zset, StringView member, size_t* rank) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  // Hold current snapshot in this thread
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+
+  HashList* hlist;
+  Status s = zsetFind(zset, &hlist);
+  if (s != Status::Ok) {
+    return s;
+  }
+  // The score may be updated by a writer which has not updated the index
+  // yet, retry with the newer score until it's indexed
+  while (true) {
+    std::string value;
+    double score;
+    s = hlist->Get(member, &value);
+    if (s != Status::Ok) {
+      return s;
+    }
+    if (!ScoreIndex::DecodeScore(value, &score)) {
+      return Status::Abort;
+    }
+    if (hlist->GetScoreIndex()->Rank(member, score, rank)) {
+      return Status::Ok;
+    }
+    pause();
+  }
+}
+
+Status KVEngine::ZRangeByScore(
+    StringView zset, double min_score, double max_score,
+    std::vector<std::pair<std::string, double>>* members, size_t limit) {
+  auto thread_holder = AcquireAccessThread(RecordType::HashRecord);
+  if (thread_holder.status() != Status::Ok) {
+    return thread_holder.status();
+  }
+
+  members->clear();
+  if (std::isnan(min_score) || std::isnan(max_score)) {
+    return Status::InvalidArgument;
+  }
+  auto holder = version_controller_.GetLocalSnapshotHolder();
+  HashList* hlist;
+  Status s = zsetFind(zset, &hlist);
+  if (s == Status::Ok && limit > 0) {
+    hlist->GetScoreIndex()->RangeByScore(
+        min_score, max_score, [&](double score, const StringView& member) {
+          members->emplace_back(string_view_2_string(member), score);
+          return members->size() < limit;
+        });
+  }
+  return s;
+}
+
+Status KVEngine::zsetFind(StringView zset, HashList** hlist) {
+  Status s = hashListFind(zset, hlist, HashList::Kind::ZSet);
+  if (s != Status::Ok) {
+    return s;
+  }
+  ScoreIndex* index = (*hlist)->GetScoreIndex();
+  if (!index->Built()) {
+    // Index is not persisted, build it on first access after recovery
+    index->Build([&](const std::function<void(double, const StringView&)>&
+                         insert) {
+      Snapshot* snapshot = version_controller_.NewGlobalSnapshot();
+      defer(ReleaseSnapshot(snapshot));
+      HashIteratorImpl iter(*hlist, static_cast<SnapshotImpl*>(snapshot),
+                            false);
+      for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+        double score;
+        std::string value = iter.Value();
+        if (ScoreIndex::DecodeScore(value, &score)) {
+          insert(score, iter.Key());
+        }
+      }
+    });
+  }
+  return Status::Ok;
+}
+
+Status KVEngine::zsetWrite(HashList* hlist, StringView member, double delta,
+                           bool incr, double* new_score) {
+  std::string internal_key(hlist->InternalKey(member));
+  if (!checkKeySize(internal_key)) {
+    return Status::InvalidDataSize;
+  }
+  // Hold lock of member from reading existing score to updating the index,
+  // so writes of a member are applied to the index in order
+  auto ul = hash_table_->AcquireLock(internal_key);
+  std::string existing_value;
+  double existing_score = 0;
+  Status s = hlist->Get(member, &existing_value);
+  bool existed = s == Status::Ok;
+  if (s != Status::Ok && s != Status::NotFound) {
+    return s;
+  }
+  if (existed && !ScoreIndex::DecodeScore(existing_value, &existing_score)) {
+    return Status::Abort;
+  }
+  double score = incr ? existing_score + delta : delta;
+  if (std::isnan(score)) {
+    return Status::InvalidArgument;
+  }
+  if (new_score) {
+    *new_score = score;
+  }
+  if (existed && score == existing_score) {
+    return Status::Ok;
+  }
+
+  auto ret = hlist->Put(member, ScoreIndex::EncodeScore(score),
+                        strictWriteTimestamp());
+  if (ret.s == Status::Ok) {
+    hlist->GetScoreIndex()->Update(member, existed, existing_score, score);
+    if (ret.existing_record && hlist->TryCleaningLock()) {
+      removeAndCacheOutdatedVersion<DLRecord>(ret.write_record);
+      hlist->ReleaseCleaningLock();
+    }
+  }
+  tryCleanCachedOutdatedRecord();
+  return ret.s;
+}
+}  // namespace KVDK_NAMESPACE
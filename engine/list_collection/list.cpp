@@ -16,9 +16,11 @@ List::WriteResult List::SetExpireTime(ExpireTimeType expired_time,
     return ret;
   }
   DLRecord* pmem_record = DLRecord::PersistDLRecord(
+      pmem_allocator_->GetPersistPolicy(),
       pmem_allocator_->offset2addr_checked(space.offset), space.size, timestamp,
       RecordType::ListRecord, RecordStatus::Normal,
-      pmem_allocator_->addr2offset_checked(header), header->prev, header->next,
+      pmem_allocator_->addr2offset_checked(header), header->GetPrev(),
+      header->GetNext(),
       header->Key(), header->Value(), expired_time);
   bool success = dl_list_.Replace(header, pmem_record);
   kvdk_assert(success, "existing header should be linked on its list");
@@ -31,7 +33,7 @@ List::WriteResult List::PushFront(const StringView& elem, TimestampType ts) {
   WriteResult ret;
   std::string internal_key(InternalKey(""));
   SpaceEntry space =
-      pmem_allocator_->Allocate(DLRecord::RecordSize(internal_key, elem));
+      pmem_allocator_->Allocate(elemRecordSize(internal_key, elem));
   if (space.size == 0) {
     ret.s = Status::PmemOverflow;
     return ret;
@@ -51,7 +53,7 @@ List::WriteResult List::PushBack(const StringView& elem, TimestampType ts) {
   WriteResult ret;
   std::string internal_key(InternalKey(""));
   SpaceEntry space =
-      pmem_allocator_->Allocate(DLRecord::RecordSize(internal_key, elem));
+      pmem_allocator_->Allocate(elemRecordSize(internal_key, elem));
   if (space.size == 0) {
     ret.s = Status::PmemOverflow;
     return ret;
@@ -75,7 +77,7 @@ List::WriteResult List::PopFront(TimestampType ts) {
     DLRecord* record = live_records_.front();
     kvdk_assert(record->GetRecordStatus() == RecordStatus::Normal, "");
     SpaceEntry space =
-        pmem_allocator_->Allocate(DLRecord::RecordSize(record->Key(), ""));
+        pmem_allocator_->Allocate(elemRecordSize(record->Key(), ""));
     if (space.size == 0) {
       ret.s = Status::PmemOverflow;
       return ret;
@@ -101,7 +103,7 @@ List::WriteResult List::PopBack(TimestampType ts) {
     DLRecord* record = live_records_.back();
     kvdk_assert(record->GetRecordStatus() == RecordStatus::Normal, "");
     SpaceEntry space =
-        pmem_allocator_->Allocate(DLRecord::RecordSize(record->Key(), ""));
+        pmem_allocator_->Allocate(elemRecordSize(record->Key(), ""));
     if (space.size == 0) {
       ret.s = Status::PmemOverflow;
       return ret;
@@ -129,7 +131,7 @@ List::WriteResult List::InsertBefore(const StringView& elem,
   } else {
     std::string internal_key(InternalKey(""));
     SpaceEntry space =
-        pmem_allocator_->Allocate(DLRecord::RecordSize(internal_key, elem));
+        pmem_allocator_->Allocate(elemRecordSize(internal_key, elem));
     if (space.size == 0) {
       ret.s = Status::PmemOverflow;
       return ret;
@@ -156,7 +158,7 @@ List::WriteResult List::InsertAfter(const StringView& elem,
   } else {
     std::string internal_key(InternalKey(""));
     SpaceEntry space =
-        pmem_allocator_->Allocate(DLRecord::RecordSize(internal_key, elem));
+        pmem_allocator_->Allocate(elemRecordSize(internal_key, elem));
     if (space.size == 0) {
       ret.s = Status::PmemOverflow;
       return ret;
@@ -192,7 +194,7 @@ List::WriteResult List::InsertAt(const StringView& elem, long index,
               "");
 
   SpaceEntry space =
-      pmem_allocator_->Allocate(DLRecord::RecordSize(internal_key, elem));
+      pmem_allocator_->Allocate(elemRecordSize(internal_key, elem));
   if (space.size == 0) {
     ret.s = Status::PmemOverflow;
     return ret;
@@ -225,7 +227,7 @@ List::WriteResult List::Erase(long index, TimestampType ts) {
               "");
 
   SpaceEntry space =
-      pmem_allocator_->Allocate(DLRecord::RecordSize(record->Key(), ""));
+      pmem_allocator_->Allocate(elemRecordSize(record->Key(), ""));
   if (space.size == 0) {
     ret.s = Status::PmemOverflow;
     return ret;
@@ -280,7 +282,7 @@ List::WriteResult List::Update(long index, const StringView& elem,
               "");
   std::string internal_key(InternalKey(""));
   SpaceEntry space =
-      pmem_allocator_->Allocate(DLRecord::RecordSize(internal_key, elem));
+      pmem_allocator_->Allocate(elemRecordSize(internal_key, elem));
   if (space.size == 0) {
     ret.s = Status::PmemOverflow;
     return ret;
@@ -308,10 +310,10 @@ List::PushNArgs List::PreparePushN(ListPos pos,
     std::string internal_key(InternalKey(""));
     for (auto& elem : elems) {
       SpaceEntry space =
-          pmem_allocator_->Allocate(DLRecord::RecordSize(internal_key, elem));
+          pmem_allocator_->Allocate(elemRecordSize(internal_key, elem));
       if (space.size == 0) {
         GlobalLogger.Error("Try allocate %lu error\n",
-                           DLRecord::RecordSize(internal_key, elem));
+                           elemRecordSize(internal_key, elem));
         for (auto& sp : args.spaces) {
           pmem_allocator_->Free(sp);
         }
@@ -337,7 +339,7 @@ List::PopNArgs List::PreparePopN(ListPos pos, size_t n, TimestampType ts,
     while (nn > 0) {
       DLRecord* record = *iter;
       SpaceEntry space =
-          pmem_allocator_->Allocate(DLRecord::RecordSize(record->Key(), ""));
+          pmem_allocator_->Allocate(elemRecordSize(record->Key(), ""));
       if (space.size == 0) {
         for (auto& sp : args.spaces) {
           pmem_allocator_->Free(sp);
@@ -421,9 +423,10 @@ void List::Destroy() {
   if (header) {
     DLRecord* to_destroy = nullptr;
     do {
-      to_destroy = pmem_allocator_->offset2addr_checked<DLRecord>(header->next);
+      to_destroy =
+          pmem_allocator_->offset2addr_checked<DLRecord>(header->GetNext());
       if (dl_list_.Remove(to_destroy)) {
-        to_destroy->Destroy();
+        to_destroy->Destroy(pmem_allocator_->GetPersistPolicy());
         to_free.emplace_back(pmem_allocator_->addr2offset_checked(to_destroy),
                              to_destroy->GetRecordSize());
         if (to_free.size() > kMaxCachedOldRecords) {
@@ -442,19 +445,20 @@ void List::DestroyAll() {
   if (header) {
     DLRecord* to_destroy = nullptr;
     do {
-      to_destroy = pmem_allocator_->offset2addr_checked<DLRecord>(header->next);
+      to_destroy =
+          pmem_allocator_->offset2addr_checked<DLRecord>(header->GetNext());
       if (dl_list_.Remove(to_destroy)) {
         auto old_record =
-            pmem_allocator_->offset2addr<DLRecord>(to_destroy->old_version);
+            pmem_allocator_->offset2addr<DLRecord>(to_destroy->GetOldVersion());
         while (old_record) {
-          auto old_version = old_record->old_version;
-          old_record->Destroy();
+          auto old_version = old_record->GetOldVersion();
+          old_record->Destroy(pmem_allocator_->GetPersistPolicy());
           to_free.emplace_back(pmem_allocator_->addr2offset_checked(old_record),
                                old_record->GetRecordSize());
           old_record = pmem_allocator_->offset2addr<DLRecord>(old_version);
         }
 
-        to_destroy->Destroy();
+        to_destroy->Destroy(pmem_allocator_->GetPersistPolicy());
         to_free.emplace_back(pmem_allocator_->addr2offset_checked(to_destroy),
                              to_destroy->GetRecordSize());
         if (to_free.size() > kMaxCachedOldRecords) {
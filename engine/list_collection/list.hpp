@@ -6,19 +6,29 @@
 
 #include "../dl_list.hpp"
 #include "kvdk/types.hpp"
+#include "stream_index.hpp"
 
 namespace KVDK_NAMESPACE {
 class ListIteratorImpl;
 
 class List : public Collection {
  public:
+  // Kind of collection indexed by a list. A stream appends entries prefixed
+  // by their ids at back, see StreamIndex
+  enum class Kind : uint8_t {
+    List = 0,
+    Stream = 1,
+  };
+
   List(DLRecord* header, const StringView& name, CollectionIDType id,
        PMEMAllocator* pmem_allocator, LockTable* lock_table)
       : Collection(name, id),
         list_lock_(),
         dl_list_(header, pmem_allocator, lock_table),
         pmem_allocator_(pmem_allocator),
-        live_records_() {}
+        live_records_(),
+        kind_(DecodeKind(header->Value())),
+        stream_index_(kind_ == Kind::Stream ? new StreamIndex() : nullptr) {}
 
   struct WriteResult {
     Status s = Status::Ok;
@@ -99,6 +109,14 @@ class List : public Collection {
 
   size_t Size() { return live_records_.size(); }
 
+  Kind GetKind() const { return kind_; }
+
+  // Return the sparse index of a stream, or nullptr for other kinds
+  StreamIndex* GetStreamIndex() { return stream_index_.get(); }
+
+  // Return live record at position "pos", should be called with list lock
+  DLRecord* LiveRecordAt(size_t pos) { return live_records_[pos]; }
+
   std::unique_lock<std::recursive_mutex> AcquireLock() {
     return std::unique_lock<std::recursive_mutex>(list_lock_);
   }
@@ -143,7 +161,28 @@ class List : public Collection {
     return type == RecordType::ListElem || type == RecordType::ListRecord;
   }
 
+  // Encode value of header record, which is the collection id followed by
+  // the kind if it's not a plain list for compatibility
+  static std::string EncodeHeaderValue(CollectionIDType id, Kind kind) {
+    std::string value = EncodeID(id);
+    if (kind != Kind::List) {
+      value.push_back(static_cast<char>(kind));
+    }
+    return value;
+  }
+
+  static Kind DecodeKind(const StringView& header_value) {
+    return header_value.size() > sizeof(CollectionIDType)
+               ? static_cast<Kind>(header_value[sizeof(CollectionIDType)])
+               : Kind::List;
+  }
+
  private:
+  // Size of space to allocate for an elem record
+  uint32_t elemRecordSize(const StringView& key, const StringView& elem) {
+    return pmem_allocator_->DLRecordSize(RecordType::ListElem, key, elem);
+  }
+
   // find the first live record of elem
   std::deque<DLRecord*>::iterator findLiveRecord(StringView elem) {
     auto iter = live_records_.begin();
@@ -166,5 +205,7 @@ class List : public Collection {
   // we keep outdated records on list to support mvcc, so we track live records
   // in a deque to support fast write operations
   std::deque<DLRecord*> live_records_;
+  const Kind kind_;
+  std::unique_ptr<StreamIndex> stream_index_;
 };
 }  // namespace KVDK_NAMESPACE
\ No newline at end of file
@@ -21,15 +21,25 @@ class ListRebuilder {
     std::unordered_map<CollectionIDType, std::shared_ptr<List>> rebuilt_lists;
   };
 
+  // segment_based_rebuild: split lists into segments at sampled elems and
+  // rebuild segments in parallel, optimized for a few large lists
+  // num_restore_threads: number of threads that add records to rebuilder
+  // num_rebuild_threads: max number of threads that rebuild index in Rebuild()
+  // first_rebuild_tid: rebuild threads use thread ids in [first_rebuild_tid,
+  // first_rebuild_tid + num_rebuild_threads)
   ListRebuilder(PMEMAllocator* pmem_allocator, HashTable* hash_table,
-                LockTable* lock_table, uint64_t num_rebuild_threads,
-                const CheckPoint& checkpoint)
+                LockTable* lock_table, bool segment_based_rebuild,
+                uint64_t num_restore_threads, uint64_t num_rebuild_threads,
+                uint64_t first_rebuild_tid, const CheckPoint& checkpoint)
       : recovery_utils_(pmem_allocator),
-        rebuilder_thread_cache_(num_rebuild_threads),
+        rebuilder_thread_cache_(
+            std::max(num_restore_threads, num_rebuild_threads)),
         pmem_allocator_(pmem_allocator),
         hash_table_(hash_table),
         lock_table_(lock_table),
+        segment_based_rebuild_(segment_based_rebuild),
         num_rebuild_threads_(num_rebuild_threads),
+        first_rebuild_tid_(first_rebuild_tid),
         checkpoint_(checkpoint) {}
 
   Status AddElem(DLRecord* elem_record) {
@@ -44,6 +54,8 @@ class ListRebuilder {
       } else {
         pmem_allocator_->PurgeAndFree<DLRecord>(elem_record);
       }
+    } else if (segment_based_rebuild_) {
+      maybeAddRecoverySegment(elem_record);
     }
     return Status::Ok;
   }
@@ -60,33 +72,37 @@ class ListRebuilder {
         pmem_allocator_->PurgeAndFree<DLRecord>(header_record);
       }
     } else {
+      std::lock_guard<SpinMutex> lg(lock_);
       linked_headers_.emplace_back(header_record);
     }
     return Status::Ok;
   }
 
+  // Build collection structs and hash index for valid headers, so ids of
+  // recovered collections are known before elems are indexed. It's called by
+  // Rebuild() if not called in advance
+  Status Prepare() {
+    if (!prepared_) {
+      Status s = initRebuildLists();
+      if (s != Status::Ok) {
+        return s;
+      }
+      prepared_ = true;
+    }
+    return Status::Ok;
+  }
+
+  // Max id of recovered collections, valid after Prepare()
+  CollectionIDType MaxRecoveredID() { return max_recovered_id_; }
+
   RebuildResult Rebuild() {
     RebuildResult ret;
-    ret.s = initRebuildLists();
+    ret.s = Prepare();
     if (ret.s != Status::Ok) {
       return ret;
     }
-    std::vector<std::future<Status>> fs;
-    size_t i = 0;
-    for (auto list : rebuild_lists_) {
-      i++;
-      fs.push_back(
-          std::async(&ListRebuilder::rebuildIndex, this, list.second.get()));
-      if (i % num_rebuild_threads_ == 0 || i == rebuild_lists_.size()) {
-        for (auto& f : fs) {
-          ret.s = f.get();
-          if (ret.s != Status::Ok) {
-            break;
-          }
-        }
-        fs.clear();
-      }
-    }
+    ret.s = segment_based_rebuild_ ? segmentBasedIndexRebuild()
+                                   : listBasedIndexRebuild();
 
     if (ret.s == Status::Ok) {
       ret.rebuilt_lists.swap(rebuild_lists_);
@@ -100,11 +116,13 @@ class ListRebuilder {
     DLRecord* elem = pmem_allocator_->offset2addr_checked<DLRecord>(log.offset);
     // We only check prev linkage as a valid prev linkage indicate valid prev
     // and next pointers on the record, so we can safely do remove/replace
-    if (elem->Validate() && recovery_utils_.CheckPrevLinkage(elem)) {
-      if (elem->old_version != kNullPMemOffset) {
+    if (elem->Validate(pmem_allocator_->GetPersistPolicy()) &&
+        recovery_utils_.CheckPrevLinkage(elem)) {
+      if (elem->GetOldVersion() != kNullPMemOffset) {
         bool success = DLList::Replace(
             elem,
-            pmem_allocator_->offset2addr_checked<DLRecord>(elem->old_version),
+            pmem_allocator_->offset2addr_checked<DLRecord>(
+                elem->GetOldVersion()),
             pmem_allocator_, lock_table_);
         kvdk_assert(success, "Replace should success as we checked linkage");
       } else {
@@ -113,11 +131,18 @@ class ListRebuilder {
       }
     }
 
-    elem->Destroy();
+    elem->Destroy(pmem_allocator_->GetPersistPolicy());
     return Status::Ok;
   }
 
  private:
+  struct RebuildSegment {
+    // Valid records of this segment in list order
+    std::vector<DLRecord*> live_records{};
+    // Start record of next segment, or list header if this is the last one
+    DLRecord* next_start = nullptr;
+  };
+
   bool recoverToCheckPoint() { return checkpoint_.Valid(); }
 
   Status initRebuildLists() {
@@ -168,7 +193,8 @@ class ListRebuilder {
           }
         }
         // TODO no need always to persist old version
-        valid_version_record->PersistOldVersion(kNullPMemOffset);
+        valid_version_record->PersistOldVersion(
+            pmem_allocator_->GetPersistPolicy(), kNullPMemOffset);
 
         if (!outdated) {
           auto lookup_result = hash_table_->Insert(
@@ -205,8 +231,9 @@ class ListRebuilder {
     DLRecord* curr = pmem_record;
     while (curr != nullptr &&
            curr->GetTimestamp() > checkpoint_.CheckpointTS()) {
-      curr = pmem_allocator_->offset2addr<DLRecord>(curr->old_version);
-      kvdk_assert(curr == nullptr || curr->Validate(),
+      curr = pmem_allocator_->offset2addr<DLRecord>(curr->GetOldVersion());
+      kvdk_assert(curr == nullptr ||
+                      curr->Validate(pmem_allocator_->GetPersistPolicy()),
                   "Broken checkpoint: invalid older version sorted record");
       kvdk_assert(
           curr == nullptr || equal_string_view(curr->Key(), pmem_record->Key()),
@@ -220,8 +247,100 @@ class ListRebuilder {
     return curr;
   }
 
+  // Rebuild index of every list in a thread
+  Status listBasedIndexRebuild() {
+    Status s = Status::Ok;
+    std::vector<std::future<Status>> fs;
+    size_t i = 0;
+    for (auto list : rebuild_lists_) {
+      i++;
+      fs.push_back(
+          std::async(&ListRebuilder::rebuildIndex, this, list.second.get()));
+      if (i % num_rebuild_threads_ == 0 || i == rebuild_lists_.size()) {
+        for (auto& f : fs) {
+          s = f.get();
+          if (s != Status::Ok) {
+            break;
+          }
+        }
+        fs.clear();
+      }
+    }
+    return s;
+  }
+
+  // Rebuild list segments in parallel, a segment starts from a header or a
+  // sampled elem, and ends before start of next segment. Live records of each
+  // segment are collected separately and then appended to lists in order
+  Status segmentBasedIndexRebuild() {
+    GlobalLogger.Info("segment based list rebuild start\n");
+    for (auto& list : rebuild_lists_) {
+      recovery_segments_[list.second->HeaderRecord()];
+    }
+    std::vector<std::pair<DLRecord* const, RebuildSegment>*> segments;
+    for (auto& segment : recovery_segments_) {
+      segments.push_back(&segment);
+    }
+    std::atomic<size_t> next_segment{0};
+
+    auto rebuild_segments_index = [&]() -> Status {
+      this_thread.id = first_rebuild_tid_ +
+                       next_tid_.fetch_add(1) % num_rebuild_threads_;
+      while (true) {
+        size_t i = next_segment.fetch_add(1);
+        if (i >= segments.size()) {
+          return Status::Ok;
+        }
+        auto list_iter = rebuild_lists_.find(List::FetchID(segments[i]->first));
+        if (list_iter == rebuild_lists_.end()) {
+          // this start point belong to a invalid list
+          continue;
+        }
+        Status s = rebuildSegmentIndex(segments[i]->first, &segments[i]->second,
+                                       list_iter->second.get());
+        if (s != Status::Ok) {
+          return s;
+        }
+      }
+    };
+
+    std::vector<std::future<Status>> fs;
+    for (uint32_t i = 0; i < num_rebuild_threads_; i++) {
+      fs.push_back(std::async(rebuild_segments_index));
+    }
+    Status ret = Status::Ok;
+    for (auto& f : fs) {
+      Status s = f.get();
+      if (s != Status::Ok) {
+        ret = s;
+      }
+    }
+
+    if (ret == Status::Ok) {
+      // Link segments of each list from its header
+      for (auto& list : rebuild_lists_) {
+        DLRecord* header = list.second->HeaderRecord();
+        DLRecord* start = header;
+        do {
+          RebuildSegment& segment = recovery_segments_[start];
+          for (DLRecord* record : segment.live_records) {
+            list.second->AddLiveRecord(record, ListPos::Back);
+          }
+          start = segment.next_start;
+        } while (start != header);
+      }
+    }
+    recovery_segments_.clear();
+    GlobalLogger.Info("segment based list rebuild done\n");
+    return ret;
+  }
+
   Status rebuildIndex(List* list) {
-    this_thread.id = next_tid_.fetch_add(1);
+    // Keep ids of rebuild threads in [first_rebuild_tid_, first_rebuild_tid_ +
+    // num_rebuild_threads_), so they only touch thread caches reserved for
+    // recovery
+    this_thread.id =
+        first_rebuild_tid_ + next_tid_.fetch_add(1) % num_rebuild_threads_;
 
     auto ul = list->AcquireLock();
 
@@ -230,25 +349,74 @@ class ListRebuilder {
     while (iter->Valid()) {
       DLRecord* curr = iter->Record();
       iter->Next();
-      DLRecord* valid_version_record = findCheckpointVersion(curr);
-      if (valid_version_record == nullptr ||
-          valid_version_record->GetRecordStatus() == RecordStatus::Outdated) {
-        bool success = list->GetDLList()->Remove(curr);
-        kvdk_assert(success, "elems in rebuild should passed linkage check");
-        addUnlinkedRecord(curr);
-      } else {
-        if (valid_version_record != curr) {
-          bool success = list->GetDLList()->Replace(curr, valid_version_record);
-          kvdk_assert(success, "elems in rebuild should passed linkage check");
-          addUnlinkedRecord(curr);
-        }
-        valid_version_record->PersistOldVersion(kNullPMemOffset);
+      DLRecord* valid_version_record = rebuildElem(list, curr);
+      if (valid_version_record != nullptr) {
         list->AddLiveRecord(valid_version_record, ListPos::Back);
       }
     }
     return Status::Ok;
   }
 
+  Status rebuildSegmentIndex(DLRecord* start_record, RebuildSegment* segment,
+                             List* list) {
+    DLRecord* header = list->HeaderRecord();
+    DLRecord* curr = start_record;
+    if (start_record == header) {
+      curr = pmem_allocator_->offset2addr_checked<DLRecord>(header->GetNext());
+    }
+    // Start record of a segment is always a valid version, so it is never
+    // removed or replaced by other rebuild threads
+    while (curr != header &&
+           (curr == start_record || recovery_segments_.count(curr) == 0)) {
+      DLRecord* next =
+          pmem_allocator_->offset2addr_checked<DLRecord>(curr->GetNext());
+      DLRecord* valid_version_record = rebuildElem(list, curr);
+      if (valid_version_record != nullptr) {
+        segment->live_records.push_back(valid_version_record);
+      }
+      curr = next;
+    }
+    segment->next_start = curr;
+    return Status::Ok;
+  }
+
+  // Remove or repair "elem" on "list" with its checkpoint version, return the
+  // valid version or nullptr if no valid version exist
+  DLRecord* rebuildElem(List* list, DLRecord* elem) {
+    DLRecord* valid_version_record = findCheckpointVersion(elem);
+    if (valid_version_record == nullptr ||
+        valid_version_record->GetRecordStatus() == RecordStatus::Outdated) {
+      bool success = list->GetDLList()->Remove(elem);
+      kvdk_assert(success, "elems in rebuild should passed linkage check");
+      addUnlinkedRecord(elem);
+      return nullptr;
+    }
+    if (valid_version_record != elem) {
+      bool success = list->GetDLList()->Replace(elem, valid_version_record);
+      kvdk_assert(success, "elems in rebuild should passed linkage check");
+      addUnlinkedRecord(elem);
+    }
+    valid_version_record->PersistOldVersion(
+        pmem_allocator_->GetPersistPolicy(), kNullPMemOffset);
+    return valid_version_record;
+  }
+
+  // Select a linked elem as a recovery segment start point every
+  // kRestoreListStride elems per list
+  void maybeAddRecoverySegment(DLRecord* elem_record) {
+    auto& thread_cache =
+        rebuilder_thread_cache_[ThreadManager::ThreadID() %
+                                rebuilder_thread_cache_.size()];
+    if (++thread_cache.visited_lists[List::FetchID(elem_record)] %
+                kRestoreListStride ==
+            0 &&
+        elem_record->GetRecordStatus() == RecordStatus::Normal &&
+        findCheckpointVersion(elem_record) == elem_record) {
+      std::lock_guard<SpinMutex> lg(lock_);
+      recovery_segments_[elem_record];
+    }
+  }
+
   void addUnlinkedRecord(DLRecord* pmem_record) {
     kvdk_assert(ThreadManager::ThreadID() >= 0, "");
     rebuilder_thread_cache_[ThreadManager::ThreadID() %
@@ -263,7 +431,7 @@ class ListRebuilder {
     for (auto& thread_cache : rebuilder_thread_cache_) {
       for (DLRecord* pmem_record : thread_cache.unlinked_records) {
         if (!recovery_utils_.CheckLinkage(pmem_record)) {
-          pmem_record->Destroy();
+          pmem_record->Destroy(pmem_allocator_->GetPersistPolicy());
           to_free.emplace_back(
               pmem_allocator_->addr2offset_checked(pmem_record),
               pmem_record->GetRecordSize());
@@ -285,6 +453,9 @@ class ListRebuilder {
   }
 
   struct ThreadCache {
+    // For segment based rebuild
+    std::unordered_map<CollectionIDType, uint64_t> visited_lists{};
+
     std::vector<DLRecord*> unlinked_records{};
   };
 
@@ -294,16 +465,25 @@ class ListRebuilder {
   PMEMAllocator* pmem_allocator_;
   HashTable* hash_table_;
   LockTable* lock_table_;
+  const bool segment_based_rebuild_;
   const size_t num_rebuild_threads_;
+  const uint64_t first_rebuild_tid_;
   CheckPoint checkpoint_;
   SpinMutex lock_;
   std::unordered_map<CollectionIDType, std::shared_ptr<List>> invalid_lists_;
   std::unordered_map<CollectionIDType, std::shared_ptr<List>> rebuild_lists_;
-  CollectionIDType max_recovered_id_;
+  // Segments for segment based rebuild, indexed by start record
+  std::unordered_map<DLRecord*, RebuildSegment> recovery_segments_;
+  CollectionIDType max_recovered_id_ = 0;
+  bool prepared_ = false;
 
   // We manually allocate recovery thread id for no conflict in multi-thread
   // recovering
   // Todo: do not hard code
   std::atomic<uint64_t> next_tid_{0};
+
+  // Select elements as a segment start point for segment based rebuild every
+  // kRestoreListStride elements per list
+  const uint64_t kRestoreListStride = 10000;
 };
 }  // namespace KVDK_NAMESPACE
\ No newline at end of file
@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <string>
+
+#include "../alias.hpp"
+#include "../utils/codec.hpp"
+
+namespace KVDK_NAMESPACE {
+
+using StreamID = uint64_t;
+
+// Sparse DRAM index of a stream.
+//
+// Entries of a stream are elems of a list appended at back, each value is the
+// entry id followed by its content. As ids are monotonic, live records of the
+// list are ordered by id. The index keeps id of every kIndexInterval-th live
+// record, so a range read binary searches indexed ids in DRAM and then scans
+// at most kIndexInterval PMem records before its start. Streams are only
+// trimmed by whole intervals from front, so indexed ids stay aligned with
+// positions of live records.
+//
+// Each entry is a list elem record allocated from the writer's thread cache,
+// and trimmed records are freed one by one by the cleaner.
+//
+// The index is not persisted and built on first access after recovery. It's
+// protected by lock of the list.
+class StreamIndex {
+ public:
+  static constexpr size_t kIndexInterval = 64;
+
+  bool Built() const { return built_; }
+
+  void MarkBuilt() { built_ = true; }
+
+  // Index entry "id" appended at position "pos" of live records
+  void Append(StreamID id, size_t pos) {
+    if (pos % kIndexInterval == 0) {
+      indexed_ids_.push_back(id);
+    }
+    last_id_ = std::max(last_id_, id);
+  }
+
+  // Return an id for a new entry, which is "ts" if it's larger than all
+  // existing ids
+  StreamID NextID(TimestampType ts) const {
+    return std::max<StreamID>(ts, last_id_ + 1);
+  }
+
+  StreamID LastID() const { return last_id_; }
+
+  size_t NumIntervals() const { return indexed_ids_.size(); }
+
+  // Return position of the first live record of the interval that may
+  // contain the first entry with id not less than "id"
+  size_t SeekPosition(StreamID id) const {
+    auto iter = std::upper_bound(indexed_ids_.begin(),
+                                 indexed_ids_.end(), id);
+    size_t interval = iter == indexed_ids_.begin()
+                       ? 0
+                       : iter - indexed_ids_.begin() - 1;
+    return interval * kIndexInterval;
+  }
+
+  // Return number of intervals from front whose entries all have ids less
+  // than "min_id"
+  size_t IntervalsBefore(StreamID min_id) const {
+    size_t n = 0;
+    while (n < indexed_ids_.size() &&
+           (n + 1 < indexed_ids_.size() ? indexed_ids_[n + 1] <= min_id
+                                            : last_id_ < min_id)) {
+      n++;
+    }
+    return n;
+  }
+
+  // Remove "n" intervals from front after their records are popped
+  void PopIntervals(size_t n) {
+    indexed_ids_.erase(indexed_ids_.begin(),
+                           indexed_ids_.begin() + n);
+  }
+
+  static std::string EncodeEntry(StreamID id, const StringView& content) {
+    std::string ret = EncodeUint64(id);
+    ret.append(content.data(), content.size());
+    return ret;
+  }
+
+  static StreamID DecodeID(const StringView& entry) {
+    uint64_t id = 0;
+    DecodeUint64(entry, &id);
+    return id;
+  }
+
+  static StringView DecodeContent(const StringView& entry) {
+    return StringView(entry.data() + sizeof(StreamID),
+                      entry.size() - sizeof(StreamID));
+  }
+
+ private:
+  bool built_ = false;
+  StreamID last_id_ = 0;
+  std::deque<StreamID> indexed_ids_;
+};
+
+}  // namespace KVDK_NAMESPACE
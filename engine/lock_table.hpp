@@ -12,7 +12,7 @@ namespace KVDK_NAMESPACE {
 class LockTable {
  public:
   using HashValueType = std::uint64_t;
-  using MutexType = SpinMutex;
+  using MutexType = KeyMutex;
   using ULockType = std::unique_lock<MutexType>;
   using MultiGuardType = std::vector<ULockType>;
 
@@ -7,6 +7,7 @@
 #include <libpmem.h>
 #include <sys/sysmacros.h>
 
+#include <algorithm>
 #include <thread>
 
 #include "../thread_manager.hpp"
@@ -15,15 +16,18 @@ namespace KVDK_NAMESPACE {
 
 PMEMAllocator::PMEMAllocator(char* pmem, uint64_t pmem_size,
                              uint64_t num_segment_blocks, uint32_t block_size,
-                             uint32_t max_access_threads,
-                             VersionController* version_controller)
+                             uint32_t num_thread_caches,
+                             VersionController* version_controller,
+                             PersistMode persist_mode,
+                             const PMemEmulation& emulation)
     : pmem_(pmem),
-      palloc_thread_cache_(max_access_threads),
+      persist_policy_(persist_mode, emulation),
+      palloc_thread_cache_(num_thread_caches),
       block_size_(block_size),
       segment_size_(num_segment_blocks * block_size),
       offset_head_(0),
       pmem_size_(pmem_size),
-      free_list_(num_segment_blocks, block_size, max_access_threads,
+      free_list_(num_segment_blocks, block_size, num_thread_caches,
                  pmem_size / block_size / num_segment_blocks *
                      num_segment_blocks /*num blocks*/,
                  this),
@@ -59,19 +63,61 @@ void PMEMAllocator::populateSpace() {
   GlobalLogger.Info("Populating done\n");
 }
 
-PMEMAllocator::~PMEMAllocator() { pmem_unmap(pmem_, pmem_size_); }
+PMEMAllocator::~PMEMAllocator() {
+  if (anonymous_) {
+    munmap(pmem_, pmem_size_);
+  } else {
+    pmem_unmap(pmem_, pmem_size_);
+  }
+}
+
+char* PMEMAllocator::mapAnonymousSpace(uint64_t size, bool use_hugepage) {
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+  void* addr = MAP_FAILED;
+  if (use_hugepage) {
+    addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1,
+                0);
+    if (addr == MAP_FAILED) {
+      GlobalLogger.Info(
+          "Map %lu bytes of huge pages failed: %s, use transparent huge pages "
+          "instead\n",
+          size, strerror(errno));
+    }
+  }
+  if (addr == MAP_FAILED) {
+    addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (addr == MAP_FAILED) {
+      GlobalLogger.Error("Map %lu bytes of DRAM failed: %s\n", size,
+                         strerror(errno));
+      return nullptr;
+    }
+    if (use_hugepage) {
+      madvise(addr, size, MADV_HUGEPAGE);
+    }
+  }
+  return static_cast<char*>(addr);
+}
 
 PMEMAllocator* PMEMAllocator::NewPMEMAllocator(
     const std::string& pmem_file, uint64_t pmem_size,
     uint64_t num_segment_blocks, uint32_t block_size,
     uint32_t max_access_threads, bool populate_space_on_new_file,
-    bool use_devdax_mode, VersionController* version_controller) {
+    bool use_devdax_mode, VersionController* version_controller,
+    uint32_t num_thread_caches, PersistMode persist_mode, bool use_hugepage,
+    const PMemEmulation& emulation) {
   int is_pmem;
   uint64_t mapped_size;
   char* pmem;
+  bool anonymous = persist_mode == PersistMode::Volatile;
   // TODO jiayu: Should we clear map failed file?
-  bool pmem_file_exist = file_exist(pmem_file);
-  if (!use_devdax_mode) {
+  bool pmem_file_exist = anonymous || file_exist(pmem_file);
+  if (anonymous) {
+    // Anonymous space is zeroed, so there is nothing to recover or populate
+    if ((pmem = mapAnonymousSpace(pmem_size, use_hugepage)) == nullptr) {
+      return nullptr;
+    }
+    mapped_size = pmem_size;
+  } else if (!use_devdax_mode) {
     if ((pmem = (char*)pmem_map_file(pmem_file.c_str(), pmem_size,
                                      PMEM_FILE_CREATE, 0666, &mapped_size,
                                      &is_pmem)) == nullptr) {
@@ -80,7 +126,8 @@ PMEMAllocator* PMEMAllocator::NewPMEMAllocator(
       return nullptr;
     }
 
-    if (!is_pmem) {
+    // A regular file or tmpfs emulates PMem in emulated mode
+    if (!is_pmem && persist_mode != PersistMode::Emulated) {
       GlobalLogger.Error("%s is not a pmem path\n", pmem_file.c_str());
       return nullptr;
     }
@@ -136,13 +183,19 @@ PMEMAllocator* PMEMAllocator::NewPMEMAllocator(
     return nullptr;
   }
 
+  // Threads other than access threads may also use thread caches, e.g.
+  // recovery threads
+  num_thread_caches = std::max(num_thread_caches, max_access_threads);
+
   PMEMAllocator* allocator = nullptr;
   // We need to allocate a byte map in pmem allocator which require a large
   // memory, so we catch exception here
   try {
     allocator =
         new PMEMAllocator(pmem, pmem_size, num_segment_blocks, block_size,
-                          max_access_threads, version_controller);
+                          num_thread_caches, version_controller, persist_mode,
+                          emulation);
+    allocator->anonymous_ = anonymous;
   } catch (std::bad_alloc& err) {
     GlobalLogger.Error("Error while initialize PMEMAllocator: %s\n",
                        err.what());
@@ -172,6 +225,23 @@ bool PMEMAllocator::FetchSegment(SpaceEntry* segment_space_entry) {
   return false;
 }
 
+uint64_t PMEMAllocator::EstimateSegmentsToFetch() {
+  std::lock_guard<SpinMutex> lg(offset_head_lock_);
+  // Binary search the first never used segment
+  uint64_t lo = offset_head_ / segment_size_;
+  uint64_t hi = pmem_size_ / segment_size_;
+  uint64_t head = lo;
+  while (lo < hi) {
+    uint64_t mid = lo + (hi - lo) / 2;
+    if (offset2addr<DataHeader>(mid * segment_size_)->record_size != 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo - head;
+}
+
 bool PMEMAllocator::allocateSegmentSpace(SpaceEntry* segment_entry) {
   std::lock_guard<SpinMutex> lg(offset_head_lock_);
   if (offset_head_ <= pmem_size_ - segment_size_) {
@@ -239,7 +309,9 @@ SpaceEntry PMEMAllocator::Allocate(uint64_t size) {
   }
   auto& palloc_thread_cache = palloc_thread_cache_[ThreadManager::ThreadID() %
                                                    palloc_thread_cache_.size()];
-  while (palloc_thread_cache.segment_entry.size < aligned_size) {
+  while (palloc_thread_cache.segment_entry.size <
+         aligned_size + xplinePadding(palloc_thread_cache.segment_entry.offset,
+                                      aligned_size)) {
     // allocate from free list space
     if (palloc_thread_cache.free_entry.size >= aligned_size) {
       // Padding remaining space
@@ -288,6 +360,19 @@ SpaceEntry PMEMAllocator::Allocate(uint64_t size) {
       return space_entry;
     }
   }
+  uint64_t padding =
+      xplinePadding(palloc_thread_cache.segment_entry.offset, aligned_size);
+  if (padding > 0) {
+    // Leave rest of the current XPLine as padding, it's still reusable from
+    // the free list
+    SpaceEntry padding_entry(palloc_thread_cache.segment_entry.offset,
+                             padding);
+    persistSpaceEntry(padding_entry.offset, padding_entry.size);
+    palloc_thread_cache.segment_entry.offset += padding;
+    palloc_thread_cache.segment_entry.size -= padding;
+    LogAllocation(ThreadManager::ThreadID(), padding);
+    Free(padding_entry);
+  }
   space_entry = palloc_thread_cache.segment_entry;
   space_entry.size = aligned_size;
 
@@ -300,11 +385,64 @@ SpaceEntry PMEMAllocator::Allocate(uint64_t size) {
   return space_entry;
 }
 
+uint8_t PMEMAllocator::EnableCompactRecords(uint8_t record_types) {
+  compact_record_types_ = 0;
+  if (!CompactRecordsSupported()) {
+    return compact_record_types_;
+  }
+  for (uint8_t type : {RecordType::SortedElem, RecordType::HashElem,
+                       RecordType::ListElem}) {
+    if (record_types & type) {
+      compact_record_types_ |= type;
+    }
+  }
+  return compact_record_types_;
+}
+
+SpaceEntry PMEMAllocator::AllocateExtent(uint64_t size) {
+  SpaceEntry space_entry;
+  uint64_t aligned_size = size_2_block_size(size) * block_size_;
+  if (aligned_size > segment_size_) {
+    return space_entry;
+  }
+  if (!free_list_.Get(aligned_size, &space_entry)) {
+    if (!allocateSegmentSpace(&space_entry)) {
+      GlobalLogger.Error("PMem OVERFLOW!\n");
+      return SpaceEntry();
+    }
+  }
+  LogAllocation(ThreadManager::ThreadID(), space_entry.size);
+  auto extra_space = space_entry.size - aligned_size;
+  if (extra_space > 0) {
+    // Mark the remaining part firstly for correctness in recovery, then
+    // return it to the free list
+    persistSpaceEntry(space_entry.offset + aligned_size, extra_space);
+    Free(SpaceEntry(space_entry.offset + aligned_size, extra_space));
+  }
+  space_entry.size = aligned_size;
+  persistSpaceEntry(space_entry.offset, space_entry.size);
+  return space_entry;
+}
+
+void PMEMAllocator::PurgeAndFreeExtents(PMemOffsetType first) {
+  std::vector<SpaceEntry> entries;
+  while (first != kNullPMemOffset) {
+    ExtentRecord* extent = offset2addr_checked<ExtentRecord>(first);
+    PMemOffsetType next = extent->next;
+    entries.emplace_back(first, extent->GetRecordSize());
+    extent->Destroy(persist_policy_);
+    first = next;
+  }
+  BatchFree(entries);
+}
+
 void PMEMAllocator::persistSpaceEntry(PMemOffsetType offset, uint64_t size) {
   std::uint32_t sz = static_cast<std::uint32_t>(size);
   kvdk_assert(size == static_cast<std::uint64_t>(sz), "Integer Overflow!");
   DataEntry padding{
       0, sz, TimestampType{}, RecordType::Empty, RecordStatus::Normal, 0, 0};
-  pmem_memcpy_persist(offset2addr_checked(offset), &padding, sizeof(DataEntry));
+  void* addr = offset2addr_checked(offset);
+  memcpy(addr, &padding, sizeof(DataEntry));
+  persist_policy_.Persist(addr, sizeof(DataEntry));
 }
 }  // namespace KVDK_NAMESPACE
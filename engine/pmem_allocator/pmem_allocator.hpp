@@ -20,8 +20,9 @@
 
 namespace KVDK_NAMESPACE {
 
-constexpr PMemOffsetType kNullPMemOffset = UINT64_MAX;
 constexpr uint64_t kMinPaddingBlocks = 8;
+// Internal write unit of Optane PMem media
+constexpr uint64_t kXPLineSize = 256;
 
 // Manage allocation/de-allocation of PMem space at block unit
 //
@@ -36,7 +37,16 @@ class PMEMAllocator : public Allocator {
       const std::string& pmem_file, uint64_t pmem_size,
       uint64_t num_segment_blocks, uint32_t block_size,
       uint32_t max_access_threads, bool populate_pmem_space_on_new_file,
-      bool use_devdax_mode, VersionController* version_controller);
+      bool use_devdax_mode, VersionController* version_controller,
+      uint32_t num_thread_caches = 0,
+      PersistMode persist_mode = PersistMode::PMem, bool use_hugepage = false,
+      const PMemEmulation& emulation = PMemEmulation());
+
+  // Persistence primitives of the space, all writes to it and to metadata
+  // of the instance should go through it
+  PersistPolicy& GetPersistPolicy() { return persist_policy_; }
+
+  const PersistPolicy& GetPersistPolicy() const { return persist_policy_; }
 
   // Allocate a PMem space, return offset and actually allocated space in bytes
   SpaceEntry Allocate(uint64_t size) override;
@@ -44,13 +54,54 @@ class PMEMAllocator : public Allocator {
   // Free a PMem space entry. The entry should be allocated by this allocator
   void Free(const SpaceEntry& entry) override;
 
+  // Allocate a PMem space for an extent of a large value, which should not be
+  // larger than a segment. Unlike Allocate(), it's fetched from the free list
+  // or a new segment directly, so large values never consume or split the
+  // segment cached by the writing thread
+  SpaceEntry AllocateExtent(uint64_t size);
+
+  // Purge and free a chain of extents starting at "first" as a unit
+  void PurgeAndFreeExtents(PMemOffsetType first);
+
+  uint64_t SegmentSize() const { return segment_size_; }
+
+  // Store DLRecords of "record_types" in the compact layout if it saves
+  // space, which requires all offsets of the space CompactEncodable(). Return
+  // record types actually enabled
+  uint8_t EnableCompactRecords(uint8_t record_types);
+
+  // If DLRecords can be stored in the compact layout, i.e. all offsets of
+  // the space are CompactEncodable()
+  bool CompactRecordsSupported() const {
+    return block_size_ % DLRecord::kCompactOffsetUnit == 0 &&
+           DLRecord::CompactEncodable(pmem_size_ - block_size_);
+  }
+
+  // Allocate space from thread segments so that a record spans as few
+  // XPLines as its size requires, by leaving the rest of a partially
+  // allocated XPLine as padding. Space reused from the free list is not
+  // realigned. Return false if block size doesn't divide a XPLine
+  bool EnableXPLineAlignment() {
+    xpline_aligned_ = kXPLineSize % block_size_ == 0 &&
+                      segment_size_ % kXPLineSize == 0;
+    return xpline_aligned_;
+  }
+
+  // Size of space to allocate for a DLRecord of "type"
+  uint32_t DLRecordSize(RecordType type, const StringView& key,
+                        const StringView& value) const {
+    return (compact_record_types_ & type)
+               ? DLRecord::CompactRecordSize(key, value)
+               : DLRecord::RecordSize(key, value);
+  }
+
   // Purge a kvdk data record and free it
   template <typename T>
   void PurgeAndFree(T* pmem_record) {
     static_assert(std::is_same<T, DLRecord>::value ||
                       std::is_same<T, StringRecord>::value,
                   "");
-    pmem_record->Destroy();
+    pmem_record->Destroy(persist_policy_);
     Free(SpaceEntry(addr2offset_checked(pmem_record),
                     pmem_record->GetRecordSize()));
   }
@@ -106,6 +157,12 @@ class PMEMAllocator : public Allocator {
   // Notice: Please only use this function in recovery
   bool FetchSegment(SpaceEntry* segment_space_entry);
 
+  // Estimate number of used segments left to fetch by FetchSegment(), as
+  // segments are always used in order of offset
+  //
+  // Notice: Please only use this function in recovery
+  uint64_t EstimateSegmentsToFetch();
+
   // Regularly execute by background thread of KVDK
   void BackgroundWork() { free_list_.OrganizeFreeSpace(); }
 
@@ -138,6 +195,14 @@ class PMEMAllocator : public Allocator {
 
   std::int64_t PMemUsageInBytes();
 
+  uint64_t PMemCapacityInBytes() const { return pmem_size_; }
+
+  // Space of segments ever handed out to threads and extents
+  uint64_t SegmentBytes() {
+    std::lock_guard<SpinMutex> lg(offset_head_lock_);
+    return offset_head_;
+  }
+
   // Notice: This function is only for unit test
   Freelist* GetFreeList() { return &free_list_; }
 
@@ -145,8 +210,9 @@ class PMEMAllocator : public Allocator {
   friend Freelist;
 
   PMEMAllocator(char* pmem, uint64_t pmem_size, uint64_t num_segment_blocks,
-                uint32_t block_size, uint32_t max_access_threads,
-                VersionController* version_controller);
+                uint32_t block_size, uint32_t num_thread_caches,
+                VersionController* version_controller, PersistMode persist_mode,
+                const PMemEmulation& emulation);
   // Access threads cache a dedicated PMem segment and a free space to
   // avoid contention
   struct alignas(64) PAllocThreadCache {
@@ -166,6 +232,10 @@ class PMEMAllocator : public Allocator {
   // Warning! this will zero the entire PMem space
   void populateSpace();
 
+  // Map "size" bytes of anonymous DRAM as the data space of a volatile
+  // instance, return nullptr on failure
+  static char* mapAnonymousSpace(uint64_t size, bool use_hugepage);
+
   void init_data_size_2_block_size() {
     data_size_2_block_size_.resize(4096);
     for (size_t i = 0; i < data_size_2_block_size_.size(); i++) {
@@ -184,7 +254,22 @@ class PMEMAllocator : public Allocator {
   // Mark and persist a space entry on PMem
   void persistSpaceEntry(PMemOffsetType offset, uint64_t size);
 
+  // Padding to skip before allocating "size" bytes at "offset" of a thread
+  // segment, see EnableXPLineAlignment()
+  inline uint64_t xplinePadding(PMemOffsetType offset, uint64_t size) const {
+    uint64_t in_line = offset % kXPLineSize;
+    if (!xpline_aligned_ || in_line == 0) {
+      return 0;
+    }
+    uint64_t lines = (size + kXPLineSize - 1) / kXPLineSize;
+    uint64_t touched = (in_line + size + kXPLineSize - 1) / kXPLineSize;
+    return touched > lines ? kXPLineSize - in_line : 0;
+  }
+
   char* pmem_;
+  PersistPolicy persist_policy_;
+  // The space is anonymous DRAM rather than a mapped PMem file
+  bool anonymous_ = false;
   std::vector<PAllocThreadCache, AlignedAllocator<PAllocThreadCache>>
       palloc_thread_cache_;
   const uint32_t block_size_;
@@ -197,6 +282,8 @@ class PMEMAllocator : public Allocator {
   // For quickly get corresponding block size of a requested data size
   std::vector<uint16_t> data_size_2_block_size_;
   VersionController* version_controller_;
+  uint8_t compact_record_types_ = 0;
+  bool xpline_aligned_ = false;
   std::atomic<std::int64_t> global_allocated_size_{0};
 };
 }  // namespace KVDK_NAMESPACE
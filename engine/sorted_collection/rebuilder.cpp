@@ -11,22 +11,36 @@
 namespace KVDK_NAMESPACE {
 SortedCollectionRebuilder::SortedCollectionRebuilder(
     KVEngine* kv_engine, bool segment_based_rebuild,
-    uint64_t num_rebuild_threads, const CheckPoint& checkpoint)
+    uint64_t num_restore_threads, uint64_t num_rebuild_threads,
+    uint64_t first_rebuild_tid, const CheckPoint& checkpoint)
     : kv_engine_(kv_engine),
       recovery_utils_(kv_engine->pmem_allocator_.get()),
       checkpoint_(checkpoint),
       segment_based_rebuild_(segment_based_rebuild),
-      num_rebuild_threads_(std::min(num_rebuild_threads,
-                                    kv_engine->configs_.max_access_threads)),
+      num_rebuild_threads_(num_rebuild_threads),
+      first_rebuild_tid_(first_rebuild_tid),
       recovery_segments_(),
       rebuild_skiplits_(),
       invalid_skiplists_() {
-  rebuilder_thread_cache_.resize(num_rebuild_threads_);
+  // Thread caches are also accessed by restore threads in AddElement()
+  rebuilder_thread_cache_.resize(
+      std::max(num_rebuild_threads_, num_restore_threads));
+}
+
+Status SortedCollectionRebuilder::Prepare() {
+  if (!prepared_) {
+    Status s = initRebuildLists();
+    if (s != Status::Ok) {
+      return s;
+    }
+    prepared_ = true;
+  }
+  return Status::Ok;
 }
 
 SortedCollectionRebuilder::RebuildResult SortedCollectionRebuilder::Rebuild() {
   RebuildResult ret;
-  ret.s = initRebuildLists();
+  ret.s = Prepare();
   if (ret.s == Status::Ok && rebuild_skiplits_.size() > 0) {
     ret.s = segment_based_rebuild_ ? segmentBasedIndexRebuild()
                                    : listBasedIndexRebuild();
@@ -99,11 +113,12 @@ Status SortedCollectionRebuilder::Rollback(
   DLRecord* elem = pmem_allocator->offset2addr_checked<DLRecord>(log.offset);
   // We only check prev linkage as a valid prev linkage indicate valid prev
   // and next pointers on the record, so we can safely do remove/replace
-  if (elem->Validate() && recovery_utils_.CheckPrevLinkage(elem)) {
-    if (elem->old_version != kNullPMemOffset) {
+  if (elem->Validate(kv_engine_->persistPolicy()) &&
+      recovery_utils_.CheckPrevLinkage(elem)) {
+    if (elem->GetOldVersion() != kNullPMemOffset) {
       bool success = Skiplist::Replace(
           elem,
-          pmem_allocator->offset2addr_checked<DLRecord>(elem->old_version),
+          pmem_allocator->offset2addr_checked<DLRecord>(elem->GetOldVersion()),
           nullptr, pmem_allocator, lock_table);
       kvdk_assert(success, "Replace should success as we checked linkage");
     } else {
@@ -112,7 +127,7 @@ Status SortedCollectionRebuilder::Rollback(
       kvdk_assert(success, "Remove should success as we checked linkage");
     }
   }
-  elem->Destroy();
+  elem->Destroy(kv_engine_->persistPolicy());
   return Status::Ok;
 }
 
@@ -139,13 +154,14 @@ Status SortedCollectionRebuilder::initRebuildLists() {
       // while updating header of a empty skiplist in previous run before break
       // header linkage.
       kvdk_assert(
-          header_record->prev == header_record->next &&
-              header_record->prev == pmem_allocator->addr2offset(header_record),
+          header_record->GetPrev() == header_record->GetNext() &&
+              header_record->GetPrev() ==
+                  pmem_allocator->addr2offset(header_record),
           "outdated header record with valid linkage should always "
           "point to it self");
       // Break the linkage
       auto newer_offset = pmem_allocator->addr2offset(linked_headers_[i + 1]);
-      header_record->PersistPrevNT(newer_offset);
+      header_record->PersistPrevNT(kv_engine_->persistPolicy(), newer_offset);
       kvdk_assert(!recovery_utils_.CheckPrevLinkage(header_record) &&
                       !recovery_utils_.CheckNextLinkage(header_record),
                   "");
@@ -230,7 +246,8 @@ Status SortedCollectionRebuilder::initRebuildLists() {
           addRecoverySegment(skiplist->HeaderNode());
         }
 
-        valid_version_record->PersistOldVersion(kNullPMemOffset);
+        valid_version_record->PersistOldVersion(
+            kv_engine_->persistPolicy(), kNullPMemOffset);
         // Always build hash index for skiplist
         s = insertHashIndex(skiplist->Name(), skiplist.get(),
                             PointerType::Skiplist);
@@ -250,7 +267,8 @@ Status SortedCollectionRebuilder::segmentBasedIndexRebuild() {
   std::vector<std::future<Status>> fs;
 
   auto rebuild_segments_index = [&]() -> Status {
-    this_thread.id = next_tid_.fetch_add(1);
+    this_thread.id =
+        first_rebuild_tid_ + next_tid_.fetch_add(1) % num_rebuild_threads_;
     for (auto iter = this->recovery_segments_.begin();
          iter != this->recovery_segments_.end(); iter++) {
       if (!iter->second.visited) {
@@ -330,6 +348,8 @@ Status SortedCollectionRebuilder::rebuildSegmentIndex(SkiplistNode* start_node,
                 "Wrong start node of skiplist segment");
     num_elems++;
     if (build_hash_index) {
+      // Access threads may write the hash table in lazy recovery
+      auto ul = kv_engine_->hash_table_->AcquireLock(start_node->record->Key());
       s = insertHashIndex(start_node->record->Key(), start_node,
                           PointerType::SkiplistNode);
       if (s != Status::Ok) {
@@ -339,14 +359,15 @@ Status SortedCollectionRebuilder::rebuildSegmentIndex(SkiplistNode* start_node,
   }
   kvdk_assert(findCheckpointVersion(start_node->record) == start_node->record,
               "start node of a recovery segment must be valid verion");
-  start_node->record->PersistOldVersion(kNullPMemOffset);
+  start_node->record->PersistOldVersion(
+      kv_engine_->persistPolicy(), kNullPMemOffset);
 
   SkiplistNode* cur_node = start_node;
   DLRecord* cur_record = cur_node->record;
   while (true) {
     DLRecord* next_record =
         kv_engine_->pmem_allocator_->offset2addr_checked<DLRecord>(
-            cur_record->next);
+            cur_record->GetNext());
     if (next_record == segment_owner->HeaderRecord()) {
       cur_node->RelaxedSetNext(1, nullptr);
       break;
@@ -399,7 +420,8 @@ Status SortedCollectionRebuilder::rebuildSegmentIndex(SkiplistNode* start_node,
             return s;
           }
         }
-        valid_version_record->PersistOldVersion(kNullPMemOffset);
+        valid_version_record->PersistOldVersion(
+            kv_engine_->persistPolicy(), kNullPMemOffset);
         cur_record = valid_version_record;
       }
     } else {
@@ -460,7 +482,8 @@ void SortedCollectionRebuilder::linkSegmentDramNodes(SkiplistNode* start_node,
 }
 
 Status SortedCollectionRebuilder::linkHighDramNodes(Skiplist* skiplist) {
-  this_thread.id = next_tid_.fetch_add(1);
+  this_thread.id =
+      first_rebuild_tid_ + next_tid_.fetch_add(1) % num_rebuild_threads_;
 
   Splice splice(skiplist);
   for (uint8_t i = 1; i <= kMaxHeight; i++) {
@@ -487,7 +510,8 @@ Status SortedCollectionRebuilder::linkHighDramNodes(Skiplist* skiplist) {
 }
 
 Status SortedCollectionRebuilder::rebuildSkiplistIndex(Skiplist* skiplist) {
-  this_thread.id = next_tid_.fetch_add(1);
+  this_thread.id =
+      first_rebuild_tid_ + next_tid_.fetch_add(1) % num_rebuild_threads_;
   size_t num_elems = 0;
 
   Splice splice(skiplist);
@@ -497,7 +521,7 @@ Status SortedCollectionRebuilder::rebuildSkiplistIndex(Skiplist* skiplist) {
   }
 
   while (true) {
-    uint64_t next_offset = splice.prev_pmem_record->next;
+    uint64_t next_offset = splice.prev_pmem_record->GetNext();
     DLRecord* next_record =
         kv_engine_->pmem_allocator_->offset2addr_checked<DLRecord>(next_offset);
     if (next_record == skiplist->HeaderRecord()) {
@@ -556,7 +580,8 @@ Status SortedCollectionRebuilder::rebuildSkiplistIndex(Skiplist* skiplist) {
         }
       }
 
-      valid_version_record->PersistOldVersion(kNullPMemOffset);
+      valid_version_record->PersistOldVersion(
+          kv_engine_->persistPolicy(), kNullPMemOffset);
       splice.prev_pmem_record = valid_version_record;
     }
   }
@@ -593,7 +618,7 @@ void SortedCollectionRebuilder::cleanInvalidRecords() {
     for (DLRecord* pmem_record : thread_cache.unlinked_records) {
       if (!Skiplist::MatchType(pmem_record) ||
           !recovery_utils_.CheckLinkage(pmem_record)) {
-        pmem_record->Destroy();
+        pmem_record->Destroy(kv_engine_->persistPolicy());
         to_free.emplace_back(
             kv_engine_->pmem_allocator_->addr2offset_checked(pmem_record),
             pmem_record->GetRecordSize());
@@ -684,9 +709,10 @@ DLRecord* SortedCollectionRebuilder::findCheckpointVersion(
   DLRecord* curr = pmem_record;
   while (curr != nullptr && curr->GetTimestamp() > checkpoint_.CheckpointTS()) {
     curr =
-        kv_engine_->pmem_allocator_->offset2addr<DLRecord>(curr->old_version);
+        kv_engine_->pmem_allocator_->offset2addr<DLRecord>(
+            curr->GetOldVersion());
 
-    kvdk_assert(curr == nullptr || curr->Validate(),
+    kvdk_assert(curr == nullptr || curr->Validate(kv_engine_->persistPolicy()),
                 "Broken checkpoint: invalid older version sorted record");
     kvdk_assert(
         curr == nullptr || equal_string_view(curr->Key(), pmem_record->Key()),
@@ -17,13 +17,18 @@ class KVEngine;
 //
 // segment_based_rebuild: use segment based rebuild if set true, otherwise
 // rebuild with list based rebuild
-// num_rebuild_threads: max number of rebuild threads, the parallel rebuild
-// threads is min(kvdk access threads, num_rebuild_threads)
+// num_restore_threads: number of threads that restore data segments and add
+// records to the rebuilder
+// num_rebuild_threads: number of parallel rebuild threads
+// first_rebuild_tid: rebuild threads use thread ids in [first_rebuild_tid,
+// first_rebuild_tid + num_rebuild_threads)
 // checkpoint: rebuild skiplists to the checkpoint version if it's valid
 class SortedCollectionRebuilder {
  public:
   SortedCollectionRebuilder(KVEngine* kv_engine, bool segment_based_rebuild,
+                            uint64_t num_restore_threads,
                             uint64_t num_rebuild_threads,
+                            uint64_t first_rebuild_tid,
                             const CheckPoint& checkpoint);
 
   // Rebuild result of skiplists
@@ -37,6 +42,14 @@ class SortedCollectionRebuilder {
         rebuild_skiplits;
   };
 
+  // Build skiplist structs and hash index for valid headers, so ids of
+  // recovered skiplists are known before elements are indexed. It's called by
+  // Rebuild() if not called in advance
+  Status Prepare();
+
+  // Max id of recovered skiplists, valid after Prepare()
+  CollectionIDType MaxRecoveredID() { return max_recovered_id_; }
+
   // Rebuild DRAM index for skiplists and free invalid records.
   RebuildResult Rebuild();
 
@@ -127,6 +140,7 @@ class SortedCollectionRebuilder {
   CheckPoint checkpoint_;
   bool segment_based_rebuild_;
   uint64_t num_rebuild_threads_;
+  uint64_t first_rebuild_tid_;
   std::vector<ThreadCache> rebuilder_thread_cache_;
   std::unordered_map<DLRecord*, RebuildSegment> recovery_segments_{};
   std::vector<DLRecord*> linked_headers_;
@@ -139,11 +153,14 @@ class SortedCollectionRebuilder {
       invalid_skiplists_{};
   SpinMutex lock_;
   CollectionIDType max_recovered_id_ = 0;
+  bool prepared_ = false;
   // Select elements as a segment start point for segment based rebuild every
   // kRestoreSkiplistStride elements per skiplist
 
   // We manually allocate recovery thread id for no conflict in multi-thread
-  // recovering
+  // recovering, ids are kept in [first_rebuild_tid_, first_rebuild_tid_ +
+  // num_rebuild_threads_) so rebuild threads only touch thread caches reserved
+  // for recovery
   // Todo: do not hard code
   std::atomic<uint64_t> next_tid_{0};
 
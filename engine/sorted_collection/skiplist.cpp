@@ -12,6 +12,7 @@
 #include "../kv_engine.hpp"
 #include "../utils/codec.hpp"
 #include "../utils/sync_point.hpp"
+#include "../utils/trace.hpp"
 #include "../write_batch_impl.hpp"
 
 namespace KVDK_NAMESPACE {
@@ -64,10 +65,12 @@ Skiplist::WriteResult Skiplist::SetExpireTime(ExpireTimeType expired_time,
     return ret;
   }
   DLRecord* pmem_record = DLRecord::PersistDLRecord(
+      pmem_allocator_->GetPersistPolicy(),
       pmem_allocator_->offset2addr_checked(space_entry.offset),
       space_entry.size, timestamp, RecordType::SortedRecord,
       RecordStatus::Normal, pmem_allocator_->addr2offset_checked(header),
-      header->prev, header->next, header->Key(), header->Value(), expired_time);
+      header->GetPrev(), header->GetNext(), header->Key(), header->Value(),
+      expired_time);
   bool success = Skiplist::Replace(header, pmem_record, HeaderNode(),
                                    pmem_allocator_, record_locks_);
   kvdk_assert(success, "existing header should be linked on its skiplist");
@@ -150,11 +153,10 @@ void Skiplist::SeekNode(const StringView& key, SkiplistNode* start_node,
 void Skiplist::linkDLRecord(DLRecord* prev, DLRecord* next, DLRecord* linking,
                             PMEMAllocator* pmem_allocator) {
   uint64_t inserting_record_offset = pmem_allocator->addr2offset(linking);
-  prev->next = inserting_record_offset;
-  pmem_persist(&prev->next, 8);
+  const PersistPolicy& policy = pmem_allocator->GetPersistPolicy();
+  prev->PersistNextCLWB(policy, inserting_record_offset);
   TEST_SYNC_POINT("KVEngine::DLList::LinkDLRecord::HalfLink");
-  next->prev = inserting_record_offset;
-  pmem_persist(&next->prev, 8);
+  next->PersistPrevCLWB(policy, inserting_record_offset);
 }
 
 void Skiplist::Seek(const StringView& key, Splice* result_splice) {
@@ -164,7 +166,8 @@ void Skiplist::Seek(const StringView& key, Splice* result_splice) {
   DLRecord* prev_record = result_splice->prevs[1]->record;
   DLRecord* next_record = nullptr;
   while (1) {
-    next_record = pmem_allocator_->offset2addr<DLRecord>(prev_record->next);
+    next_record =
+        pmem_allocator_->offset2addr<DLRecord>(prev_record->GetNext());
     if (next_record == HeaderRecord()) {
       break;
     }
@@ -203,7 +206,7 @@ Status Skiplist::CheckIndex() {
 
   while (true) {
     DLRecord* next_record = pmem_allocator_->offset2addr_checked<DLRecord>(
-        splice.prev_pmem_record->next);
+        splice.prev_pmem_record->GetNext());
     if (next_record == HeaderRecord()) {
       break;
     }
@@ -258,14 +261,14 @@ LockTable::MultiGuardType Skiplist::lockRecordPosition(
     const DLRecord* record, PMEMAllocator* pmem_allocator,
     LockTable* lock_table) {
   while (1) {
-    PMemOffsetType prev_offset = record->prev;
-    PMemOffsetType next_offset = record->next;
+    PMemOffsetType prev_offset = record->GetPrev();
+    PMemOffsetType next_offset = record->GetNext();
     DLRecord* prev = pmem_allocator->offset2addr_checked<DLRecord>(prev_offset);
 
     auto guard = lock_table->MultiGuard({recordHash(prev), recordHash(record)});
 
     // Check if the linkage has changed before we successfully acquire lock.
-    if (record->prev != prev_offset || record->next != next_offset) {
+    if (record->GetPrev() != prev_offset || record->GetNext() != next_offset) {
       continue;
     }
 
@@ -284,7 +287,8 @@ bool Skiplist::lockInsertPosition(const StringView& inserting_key,
 
   // Check if the linkage has changed before we successfully acquire lock.
   auto check_linkage = [&]() {
-    return prev_record->next == next_offset && next_record->prev == prev_offset;
+    return prev_record->GetNext() == next_offset &&
+           next_record->GetPrev() == prev_offset;
   };
   // Check id and order as prev and next may be both freed, then inserted
   // to another position while keep linkage, before we lock them
@@ -318,7 +322,7 @@ bool Skiplist::lockInsertPosition(const StringView& inserting_key,
     return res;
   };
   if (!check_linkage()) {
-    *prev_record_lock = std::unique_lock<SpinMutex>();
+    *prev_record_lock = LockTable::ULockType();
     return false;
   }
 
@@ -328,8 +332,8 @@ bool Skiplist::lockInsertPosition(const StringView& inserting_key,
               "Check key order of prev and next failed during skiplist "
               "insert\n");
 
-  assert(prev_record->next == next_offset);
-  assert(next_record->prev == prev_offset);
+  assert(prev_record->GetNext() == next_offset);
+  assert(next_record->GetPrev() == prev_offset);
 
   return true;
 }
@@ -405,6 +409,7 @@ Status Skiplist::PrepareWrite(SortedWriteArgs& args, TimestampType ts) {
       args.lookup_result =
           hash_table_->Lookup<true>(internal_key, RecordType::SortedElem);
     }
+    Tracer::Stage("lookup");
     switch (args.lookup_result.s) {
       case Status::Ok: {
         if (op_delete && args.lookup_result.entry.GetRecordStatus() ==
@@ -428,6 +433,7 @@ Status Skiplist::PrepareWrite(SortedWriteArgs& args, TimestampType ts) {
   } else {
     args.seek_result = std::unique_ptr<Splice>(new Splice(args.skiplist));
     Seek(args.key, args.seek_result.get());
+    Tracer::Stage("lookup");
     auto key_exist = [&]() {
       auto type = args.seek_result->next_pmem_record->GetRecordType();
       auto status = args.seek_result->next_pmem_record->GetRecordStatus();
@@ -441,8 +447,10 @@ Status Skiplist::PrepareWrite(SortedWriteArgs& args, TimestampType ts) {
   }
 
   if (allocate_space) {
-    auto request_size = DLRecord::RecordSize(internal_key, args.value);
+    auto request_size = pmem_allocator_->DLRecordSize(
+        RecordType::SortedElem, internal_key, args.value);
     args.space = pmem_allocator_->Allocate(request_size);
+    Tracer::Stage("allocate");
     if (args.space.size == 0) {
       return Status::PmemOverflow;
     }
@@ -601,6 +609,7 @@ Skiplist::WriteResult Skiplist::deletePreparedNoHash(DLRecord* existing_record,
                          RecordStatus::Outdated, timestamp, space);
   while (dl_list_.Update(args, existing_record) != Status::Ok) {
   }
+  Tracer::Stage("persist");
   ret.write_record =
       pmem_allocator_->offset2addr_checked<DLRecord>(space.offset);
 
@@ -618,7 +627,8 @@ Skiplist::WriteResult Skiplist::deletePreparedWithHash(
   assert(lookup_result.s == Status::Ok);
   assert(lookup_result.entry.GetRecordType() == RecordType::SortedElem &&
          lookup_result.entry.GetRecordStatus() == RecordStatus::Normal);
-  assert(space.size >= DLRecord::RecordSize(internal_key, ""));
+  assert(space.size >= pmem_allocator_->DLRecordSize(RecordType::SortedElem,
+                                                     internal_key, ""));
   DLRecord* existing_record;
   SkiplistNode* dram_node;
 
@@ -647,6 +657,7 @@ Skiplist::WriteResult Skiplist::deletePreparedWithHash(
                         RecordStatus::Outdated, ret.dram_node,
                         PointerType::SkiplistNode);
   }
+  Tracer::Stage("publish");
 
   return ret;
 }
@@ -673,6 +684,7 @@ Skiplist::WriteResult Skiplist::putPreparedWithHash(
       assert(timestamp > ret.existing_record->GetTimestamp());
       while (dl_list_.Update(args, ret.existing_record) != Status::Ok) {
       }
+      Tracer::Stage("persist");
 
       ret.write_record =
           pmem_allocator_->offset2addr_checked<DLRecord>(space.offset);
@@ -708,6 +720,7 @@ Skiplist::WriteResult Skiplist::putPreparedWithHash(
                         RecordStatus::Normal, ret.dram_node,
                         PointerType::SkiplistNode);
   }
+  Tracer::Stage("publish");
 
   return ret;
 }
@@ -749,6 +762,7 @@ seek_write_position:
       goto seek_write_position;
     }
   }
+  Tracer::Stage("persist");
 
   ret.write_record =
       pmem_allocator_->offset2addr_checked<DLRecord>(space.offset);
@@ -778,6 +792,7 @@ seek_write_position:
   } else if (ret.dram_node) {
     ret.dram_node->record = ret.write_record;
   }
+  Tracer::Stage("publish");
   return ret;
 }
 
@@ -802,7 +817,8 @@ void Skiplist::destroyAllRecords() {
     DLRecord* to_destroy = nullptr;
     do {
       to_destroy =
-          pmem_allocator_->offset2addr_checked<DLRecord>(header_record->next);
+          pmem_allocator_->offset2addr_checked<DLRecord>(
+              header_record->GetNext());
       StringView key = to_destroy->Key();
       auto ul = hash_table_->AcquireLock(key);
       // We need to purge destroyed records one by one in case engine crashed
@@ -836,18 +852,18 @@ void Skiplist::destroyAllRecords() {
         }
 
         auto old_record = static_cast<DLRecord*>(
-            pmem_allocator_->offset2addr(to_destroy->old_version));
+            pmem_allocator_->offset2addr(to_destroy->GetOldVersion()));
         while (old_record) {
-          auto old_version = old_record->old_version;
+          auto old_version = old_record->GetOldVersion();
           to_free.emplace_back(pmem_allocator_->addr2offset(old_record),
                                old_record->GetRecordSize());
-          old_record->Destroy();
+          old_record->Destroy(pmem_allocator_->GetPersistPolicy());
           old_record = pmem_allocator_->offset2addr<DLRecord>(old_version);
         }
 
         to_free.emplace_back(pmem_allocator_->addr2offset_checked(to_destroy),
                              to_destroy->GetRecordSize());
-        to_destroy->Destroy();
+        to_destroy->Destroy(pmem_allocator_->GetPersistPolicy());
         if (to_free.size() > kMaxCachedOldRecords) {
           pmem_allocator_->BatchFree(to_free);
           to_free.clear();
@@ -900,7 +916,8 @@ void Skiplist::destroyRecords() {
     DLRecord* to_destroy = nullptr;
     do {
       to_destroy =
-          pmem_allocator_->offset2addr_checked<DLRecord>(header_record->next);
+          pmem_allocator_->offset2addr_checked<DLRecord>(
+              header_record->GetNext());
       StringView key = to_destroy->Key();
       auto ul = hash_table_->AcquireLock(key);
       // We need to purge destroyed records one by one in case engine crashed
@@ -932,7 +949,7 @@ void Skiplist::destroyRecords() {
             }
           }
         }
-        to_destroy->Destroy();
+        to_destroy->Destroy(pmem_allocator_->GetPersistPolicy());
 
         to_free.emplace_back(pmem_allocator_->addr2offset_checked(to_destroy),
                              to_destroy->GetRecordSize());
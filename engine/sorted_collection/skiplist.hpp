@@ -451,8 +451,8 @@ class Skiplist : public Collection {
     while (true) {
       auto guard = lockRecordPosition(record, pmem_allocator_, record_locks_);
       DLRecord* prev =
-          pmem_allocator_->offset2addr_checked<DLRecord>(record->prev);
-      if (prev->next == pmem_allocator_->addr2offset_checked(record)) {
+          pmem_allocator_->offset2addr_checked<DLRecord>(record->GetPrev());
+      if (prev->GetNext() == pmem_allocator_->addr2offset_checked(record)) {
         return guard;
       }
     }
@@ -8,6 +8,7 @@
 
 #include "alias.hpp"
 #include "logger.hpp"
+#include "utils/persist.hpp"
 #include "utils/utils.hpp"
 
 namespace KVDK_NAMESPACE {
@@ -111,11 +112,12 @@ struct PendingBatch {
   // Mark batch write as process and record writing offsets.
   // Make sure the struct is on PMem and there is enough space followed the
   // struct to store record
-  void PersistProcessing(const std::vector<PMemOffsetType>& record,
+  void PersistProcessing(const PersistPolicy& policy,
+                         const std::vector<PMemOffsetType>& record,
                          TimestampType ts);
 
   // Mark batch write as finished.
-  void PersistFinish();
+  void PersistFinish(const PersistPolicy& policy);
 
   bool Unfinished() { return stage == Stage::Processing; }
 
@@ -8,8 +8,6 @@
 
 namespace KVDK_NAMESPACE {
 
-constexpr size_t kMaxRecycleID = 1024;
-
 std::shared_ptr<ThreadManager> ThreadManager::manager_(new ThreadManager);
 
 Thread::~Thread() {
@@ -20,29 +18,30 @@ Thread::~Thread() {
 
 void ThreadManager::MaybeInitThread(Thread& t) {
   if (t.id < 0) {
-    if (!recycle_id_.empty()) {
-      std::lock_guard<SpinMutex> lg(spin_);
-      if (!recycle_id_.empty()) {
-        auto it = recycle_id_.begin();
-        t.manager = shared_from_this();
-        t.id = *it;
-        recycle_id_.erase(it);
-        return;
-      }
+    std::lock_guard<SpinMutex> lg(spin_);
+    if (!free_ids_.empty()) {
+      t.id = *free_ids_.begin();
+      free_ids_.erase(free_ids_.begin());
+    } else {
+      t.id = ids_++;
     }
-    int id = ids_.fetch_add(1, std::memory_order_relaxed);
+    t.leased_id = t.id;
     t.manager = shared_from_this();
-    t.id = id;
   }
 }
 
 void ThreadManager::Release(Thread& t) {
-  if (t.manager.get() == this && t.id >= 0 &&
-      recycle_id_.size() < kMaxRecycleID) {
+  if (t.manager.get() == this && t.leased_id >= 0) {
     std::lock_guard<SpinMutex> lg(spin_);
-    recycle_id_.insert(t.id);
+    free_ids_.insert(t.leased_id);
+    // Shrink the id range so new threads get ids from the front
+    while (!free_ids_.empty() && *free_ids_.rbegin() == ids_ - 1) {
+      free_ids_.erase(std::prev(free_ids_.end()));
+      ids_--;
+    }
   }
   t.id = -1;
+  t.leased_id = -1;
   t.manager = nullptr;
 }
 
@@ -4,8 +4,7 @@
 
 #pragma once
 
-#include <atomic>
-#include <unordered_set>
+#include <set>
 
 #include "alias.hpp"
 #include "kvdk/engine.hpp"
@@ -17,8 +16,11 @@ class ThreadManager;
 
 struct Thread {
  public:
-  Thread() : id(-1), manager(nullptr) {}
+  Thread() : id(-1), leased_id(-1), manager(nullptr) {}
   int64_t id;
+  // Id leased by the manager, which is released on exit even if "id" is
+  // overwritten by an internal thread
+  int64_t leased_id;
   std::shared_ptr<ThreadManager> manager;
 
   ~Thread();
@@ -26,6 +28,10 @@ struct Thread {
 
 extern thread_local Thread this_thread;
 
+// Lease thread ids to threads on their first access, and take them back on
+// thread exit. The smallest free id is leased, so ids of live threads stay
+// dense and threads map to distinct per-thread slots by "id % num_slots" as
+// long as live threads are no more than slots.
 class ThreadManager : public std::enable_shared_from_this<ThreadManager> {
  public:
   static ThreadManager* Get() { return manager_.get(); }
@@ -37,11 +43,12 @@ class ThreadManager : public std::enable_shared_from_this<ThreadManager> {
   void Release(Thread& t);
 
  private:
-  ThreadManager() : ids_(0), recycle_id_(), spin_() {}
+  ThreadManager() : ids_(0), free_ids_(), spin_() {}
 
   static std::shared_ptr<ThreadManager> manager_;
-  std::atomic<int64_t> ids_;
-  std::unordered_set<uint32_t> recycle_id_;
+  // Ids in [0, ids_) are leased or free
+  int64_t ids_;
+  std::set<int64_t> free_ids_;
   SpinMutex spin_;
 };
 
@@ -216,7 +216,7 @@ void TransactionImpl::acquireCollectionTransaction() {
   }
 }
 
-bool TransactionImpl::tryLock(SpinMutex* spin) {
+bool TransactionImpl::tryLock(KeyMutex* spin) {
   auto iter = locked_.find(spin);
   if (iter == locked_.end()) {
     if (tryLockImpl(spin)) {
@@ -229,7 +229,7 @@ bool TransactionImpl::tryLock(SpinMutex* spin) {
   }
 }
 
-bool TransactionImpl::tryLockImpl(SpinMutex* spin) {
+bool TransactionImpl::tryLockImpl(KeyMutex* spin) {
   auto now = TimeUtils::microseconds_time();
   while (!spin->try_lock()) {
     if (TimeUtils::microseconds_time() - now > timeout_) {
@@ -246,7 +246,7 @@ Status TransactionImpl::Commit() {
 }
 
 void TransactionImpl::Rollback() {
-  for (SpinMutex* s : locked_) {
+  for (KeyMutex* s : locked_) {
     s->unlock();
   }
   locked_.clear();
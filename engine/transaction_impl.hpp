@@ -130,8 +130,8 @@ class TransactionImpl final : public Transaction {
     std::string value;
   };
 
-  bool tryLock(SpinMutex* spin);
-  bool tryLockImpl(SpinMutex* spin);
+  bool tryLock(KeyMutex* spin);
+  bool tryLockImpl(KeyMutex* spin);
   void acquireCollectionTransaction();
   int64_t randomTimeout();
 
@@ -144,7 +144,7 @@ class TransactionImpl final : public Transaction {
   std::unordered_map<std::string, KVOp> string_kv_;
   std::unique_ptr<WriteBatchImpl> batch_;
   // TODO use std::unique_lock
-  std::unordered_set<SpinMutex*> locked_;
+  std::unordered_set<KeyMutex*> locked_;
   std::unique_ptr<CollectionTransactionCV::TransactionToken> ct_token_;
   int64_t timeout_;
 };
@@ -0,0 +1,198 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include "compression.hpp"
+
+#include <string.h>
+
+#include <vector>
+
+namespace KVDK_NAMESPACE {
+
+namespace {
+// The built-in LZ codec is a byte oriented LZ77 in the format of LZ4 blocks:
+// a sequence of (token, literals, offset, match length) where the high 4 bits
+// of token is number of literals and the low 4 bits is match length minus
+// kMinMatch, 15 in either of them means more length bytes follow. The last
+// sequence only has literals.
+constexpr uint64_t kMinMatch = 4;
+constexpr uint64_t kHashBits = 12;
+constexpr uint64_t kMaxOffset = 65535;
+// The last bytes are always literals, so matching never reads beyond input
+constexpr uint64_t kLastLiterals = 5;
+constexpr uint64_t kHeaderSize = 1 + sizeof(uint64_t);
+
+inline uint32_t load32(const char* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(uint32_t));
+  return v;
+}
+
+inline uint32_t hash32(uint32_t v) {
+  return (v * 2654435761U) >> (32 - kHashBits);
+}
+
+void appendLength(std::string* dst, uint64_t len) {
+  while (len >= 255) {
+    dst->push_back(static_cast<char>(255));
+    len -= 255;
+  }
+  dst->push_back(static_cast<char>(len));
+}
+
+// Append a sequence, "match_len" is 0 for the last one
+void appendSequence(std::string* dst, const char* literals,
+                    uint64_t num_literals, uint64_t offset,
+                    uint64_t match_len) {
+  size_t token_pos = dst->size();
+  dst->push_back(0);
+  uint8_t token = (num_literals >= 15 ? 15 : num_literals) << 4;
+  if (num_literals >= 15) {
+    appendLength(dst, num_literals - 15);
+  }
+  dst->append(literals, num_literals);
+  if (match_len > 0) {
+    dst->push_back(static_cast<char>(offset & 0xff));
+    dst->push_back(static_cast<char>(offset >> 8));
+    uint64_t len = match_len - kMinMatch;
+    token |= len >= 15 ? 15 : len;
+    if (len >= 15) {
+      appendLength(dst, len - 15);
+    }
+  }
+  (*dst)[token_pos] = static_cast<char>(token);
+}
+
+bool readLength(const uint8_t** src, const uint8_t* end, uint64_t* len) {
+  uint8_t byte;
+  do {
+    if (*src == end) {
+      return false;
+    }
+    byte = *(*src)++;
+    *len += byte;
+  } while (byte == 255);
+  return true;
+}
+
+void lzCompress(const StringView& src, std::string* dst) {
+  const char* base = src.data();
+  uint64_t size = src.size();
+  uint64_t anchor = 0;
+  if (size > kMinMatch + kLastLiterals) {
+    // Last position of each hashed 4 bytes
+    std::vector<uint32_t> table(1 << kHashBits, 0);
+    uint64_t match_limit = size - kLastLiterals;
+    uint64_t pos = 0;
+    while (pos + kMinMatch <= match_limit) {
+      uint32_t seq = load32(base + pos);
+      uint32_t h = hash32(seq);
+      uint64_t candidate = table[h];
+      table[h] = pos;
+      if (candidate >= pos || pos - candidate > kMaxOffset ||
+          load32(base + candidate) != seq) {
+        pos++;
+        continue;
+      }
+      uint64_t len = kMinMatch;
+      while (pos + len < match_limit &&
+             base[candidate + len] == base[pos + len]) {
+        len++;
+      }
+      appendSequence(dst, base + anchor, pos - anchor, pos - candidate, len);
+      pos += len;
+      anchor = pos;
+    }
+  }
+  appendSequence(dst, base + anchor, size - anchor, 0, 0);
+}
+
+bool lzDecompress(const StringView& src, char* dst, uint64_t size) {
+  const uint8_t* ip = reinterpret_cast<const uint8_t*>(src.data());
+  const uint8_t* end = ip + src.size();
+  uint64_t op = 0;
+  while (ip < end) {
+    uint8_t token = *ip++;
+    uint64_t num_literals = token >> 4;
+    if (num_literals == 15 && !readLength(&ip, end, &num_literals)) {
+      return false;
+    }
+    if (num_literals > static_cast<uint64_t>(end - ip) ||
+        num_literals > size - op) {
+      return false;
+    }
+    memcpy(dst + op, ip, num_literals);
+    ip += num_literals;
+    op += num_literals;
+    if (ip == end) {
+      break;
+    }
+
+    if (end - ip < 2) {
+      return false;
+    }
+    uint64_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    uint64_t match_len = token & 15;
+    if (match_len == 15 && !readLength(&ip, end, &match_len)) {
+      return false;
+    }
+    match_len += kMinMatch;
+    if (offset == 0 || offset > op || match_len > size - op) {
+      return false;
+    }
+    if (offset >= match_len) {
+      memcpy(dst + op, dst + op - offset, match_len);
+    } else {
+      // The match overlaps its own output, e.g. a run of bytes
+      for (uint64_t i = 0; i < match_len; i++) {
+        dst[op + i] = dst[op - offset + i];
+      }
+    }
+    op += match_len;
+  }
+  return op == size;
+}
+}  // namespace
+
+bool CompressValue(CompressionType type, const StringView& value,
+                   std::string* compressed) {
+  compressed->clear();
+  compressed->push_back(static_cast<char>(type));
+  uint64_t size = value.size();
+  compressed->append(reinterpret_cast<const char*>(&size), sizeof(uint64_t));
+  switch (type) {
+    case CompressionType::LZ:
+      lzCompress(value, compressed);
+      break;
+    default:
+      return false;
+  }
+  return compressed->size() < value.size();
+}
+
+bool DecompressedSize(const StringView& compressed, uint64_t* size) {
+  if (compressed.size() < kHeaderSize) {
+    return false;
+  }
+  memcpy(size, compressed.data() + 1, sizeof(uint64_t));
+  return true;
+}
+
+bool DecompressValue(const StringView& compressed, char* dst, uint64_t size) {
+  uint64_t raw_size;
+  if (!DecompressedSize(compressed, &raw_size) || raw_size != size) {
+    return false;
+  }
+  StringView payload(compressed.data() + kHeaderSize,
+                     compressed.size() - kHeaderSize);
+  switch (static_cast<CompressionType>(compressed[0])) {
+    case CompressionType::LZ:
+      return lzDecompress(payload, dst, size);
+    default:
+      return false;
+  }
+}
+
+}  // namespace KVDK_NAMESPACE
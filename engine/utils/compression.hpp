@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#pragma once
+
+#include <string>
+
+#include "../alias.hpp"
+#include "kvdk/configs.hpp"
+
+namespace KVDK_NAMESPACE {
+
+// Compress "value" with codec "type" to "compressed", return false if the
+// codec is not supported or the output is not smaller than "value".
+//
+// A compressed value is the codec (1 byte) and the size of the raw value (8
+// bytes) followed by output of the codec, so it can be decompressed without
+// knowing how it's compressed.
+bool CompressValue(CompressionType type, const StringView& value,
+                   std::string* compressed);
+
+// Fetch size of the raw value of "compressed", return false if it's
+// malformed
+bool DecompressedSize(const StringView& compressed, uint64_t* size);
+
+// Decompress "compressed" to "dst", which should have exactly
+// DecompressedSize() bytes. Return false if "compressed" is malformed
+bool DecompressValue(const StringView& compressed, char* dst, uint64_t size);
+
+inline bool DecompressValue(const StringView& compressed, std::string* value) {
+  uint64_t size;
+  if (!DecompressedSize(compressed, &size)) {
+    return false;
+  }
+  value->resize(size);
+  return DecompressValue(compressed, &(*value)[0], size);
+}
+
+}  // namespace KVDK_NAMESPACE
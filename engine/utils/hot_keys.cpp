@@ -0,0 +1,135 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include "hot_keys.hpp"
+
+#include <algorithm>
+
+namespace KVDK_NAMESPACE {
+
+namespace {
+template <typename Key, typename Value>
+typename std::unordered_map<Key, Value>::iterator smallest(
+    std::unordered_map<Key, Value>* map) {
+  using Pair = typename std::unordered_map<Key, Value>::value_type;
+  return std::min_element(
+      map->begin(), map->end(),
+      [](const Pair& a, const Pair& b) { return a.second < b.second; });
+}
+
+// Track "value" of "key" in "candidates" if it's one of the largest
+// "capacity" values. Once "candidates" is full, "threshold" is set to the
+// smallest tracked value, which a new key should exceed
+template <typename Key, typename Value, typename Threshold>
+void offer(std::unordered_map<Key, Value>* candidates, Key key, Value value,
+           size_t capacity, std::atomic<Threshold>* threshold) {
+  auto iter = candidates->find(key);
+  if (iter != candidates->end()) {
+    // Values of a key only grow
+    iter->second = value;
+  } else {
+    if (candidates->size() == capacity) {
+      auto coldest = smallest(candidates);
+      if (value <= coldest->second) {
+        return;
+      }
+      candidates->erase(coldest);
+    }
+    candidates->emplace(std::move(key), value);
+  }
+  if (candidates->size() == capacity) {
+    threshold->store(smallest(candidates)->second, std::memory_order_relaxed);
+  }
+}
+
+// The largest "k" values of "map" sorted from the largest
+template <typename Key, typename Value>
+std::vector<std::pair<Key, Value>> largest(
+    const std::unordered_map<Key, Value>& map, uint32_t k) {
+  using Pair = std::pair<Key, Value>;
+  std::vector<Pair> sorted(map.begin(), map.end());
+  std::sort(sorted.begin(), sorted.end(), [](const Pair& a, const Pair& b) {
+    return a.second > b.second;
+  });
+  if (sorted.size() > k) {
+    sorted.resize(k);
+  }
+  return sorted;
+}
+}  // namespace
+
+void TopKSketch::Add(const StringView& key) {
+  // Derive indexes of rows from two halves of one hash
+  uint64_t hash = hash_str(key.data(), key.size());
+  uint32_t h1 = hash;
+  uint32_t h2 = (hash >> 32) | 1;
+  uint32_t estimation = UINT32_MAX;
+  for (uint32_t i = 0; i < kDepth; i++) {
+    uint32_t index = (h1 + i * h2) % kWidth;
+    estimation = std::min(
+        estimation,
+        counters_[i][index].fetch_add(1, std::memory_order_relaxed) + 1);
+  }
+
+  if (estimation <= threshold_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::lock_guard<SpinMutex> lg(mu_);
+  offer(&candidates_, std::string(key.data(), key.size()), estimation,
+        kCandidates, &threshold_);
+}
+
+void TopKSketch::TopK(uint32_t k, std::vector<HotKey>* keys) {
+  std::lock_guard<SpinMutex> lg(mu_);
+  for (auto& candidate : largest(candidates_, k)) {
+    keys->emplace_back();
+    keys->back().key = std::move(candidate.first);
+    keys->back().count = candidate.second;
+  }
+}
+
+void TopKSketch::Reset() {
+  std::lock_guard<SpinMutex> lg(mu_);
+  for (auto& row : counters_) {
+    for (auto& counter : row) {
+      counter.store(0, std::memory_order_relaxed);
+    }
+  }
+  threshold_.store(0, std::memory_order_relaxed);
+  candidates_.clear();
+}
+
+void HotKeyDetector::Contended(uint64_t slot, uint64_t contentions) {
+  contentions_.fetch_add(1, std::memory_order_relaxed);
+  if (contentions <= slot_threshold_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::lock_guard<SpinMutex> lg(slots_mu_);
+  offer(&contended_slots_, slot, contentions, TopKSketch::kCandidates,
+        &slot_threshold_);
+}
+
+void HotKeyDetector::Get(uint32_t k, HotKeys* hot_keys) {
+  hot_keys->sample_interval = sample_interval_.load(std::memory_order_relaxed);
+  reads_.TopK(k, &hot_keys->reads);
+  writes_.TopK(k, &hot_keys->writes);
+  hot_keys->contentions = contentions_.load(std::memory_order_relaxed);
+  std::lock_guard<SpinMutex> lg(slots_mu_);
+  for (auto& slot : largest(contended_slots_, k)) {
+    hot_keys->contended_slots.emplace_back();
+    hot_keys->contended_slots.back().slot = slot.first;
+    hot_keys->contended_slots.back().contentions = slot.second;
+  }
+}
+
+void HotKeyDetector::Reset() {
+  reads_.Reset();
+  writes_.Reset();
+  std::lock_guard<SpinMutex> lg(slots_mu_);
+  contentions_.store(0, std::memory_order_relaxed);
+  slot_threshold_.store(0, std::memory_order_relaxed);
+  contended_slots_.clear();
+}
+
+}  // namespace KVDK_NAMESPACE
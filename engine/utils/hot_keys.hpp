@@ -0,0 +1,148 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../alias.hpp"
+#include "kvdk/types.hpp"
+#include "utils.hpp"
+
+namespace KVDK_NAMESPACE {
+
+// Streaming top-k of keys: a Count-Min sketch estimates counts of all keys,
+// and keys whose estimations exceed the smallest one of kCandidates tracked
+// keys replace it.
+//
+// A key is counted lock-free unless it's hot enough to be a candidate
+class TopKSketch {
+ public:
+  static constexpr uint32_t kCandidates = 128;
+
+  TopKSketch() { Reset(); }
+
+  void Add(const StringView& key);
+
+  // Append the hottest "k" keys to "keys", sorted from the hottest
+  void TopK(uint32_t k, std::vector<HotKey>* keys);
+
+  void Reset();
+
+ private:
+  static constexpr uint32_t kDepth = 4;
+  static constexpr uint32_t kWidth = 1 << 12;
+
+  std::atomic<uint32_t> counters_[kDepth][kWidth];
+  // Estimation a key should exceed to be a candidate, 0 while candidates
+  // are not full
+  std::atomic<uint32_t> threshold_;
+  SpinMutex mu_;
+  std::unordered_map<std::string, uint32_t> candidates_;
+};
+
+// Detect hot keys by sampling 1 in "sample interval" key accesses of each
+// thread into a TopKSketch of reads and one of writes, and find contended
+// hash table slots by their contention counts
+class HotKeyDetector {
+ public:
+  enum class Access { Read, Write };
+
+  // Sample 1 in "interval" accesses, 0 to disable
+  void SetSampleInterval(uint64_t interval) {
+    sample_interval_.store(interval, std::memory_order_relaxed);
+  }
+
+  bool Enabled() const {
+    return sample_interval_.load(std::memory_order_relaxed) != 0;
+  }
+
+  // Lookups of the calling thread while a WriteScope is alive are done to
+  // write keys under their locks, so they are sampled as writes rather than
+  // reads, and consecutive lookups of a key are sampled once
+  class WriteScope {
+   public:
+    WriteScope() : active_(true) { writeScopes()++; }
+    WriteScope(WriteScope&& other) : active_(other.active_) {
+      other.active_ = false;
+    }
+    ~WriteScope() { Exit(); }
+
+    void Exit() {
+      if (active_) {
+        active_ = false;
+        if (--writeScopes() == 0) {
+          lastWrite() = 0;
+        }
+      }
+    }
+
+   private:
+    bool active_;
+  };
+
+  // Sample a lookup of "key" with hash "hash". Lookups that may insert the
+  // key are writes, others are reads unless in a WriteScope
+  void SampleLookup(const StringView& key, uint64_t hash, bool may_insert) {
+    if (!Enabled()) {
+      return;
+    }
+    Access access = may_insert ? Access::Write : Access::Read;
+    if (writeScopes() > 0) {
+      if (lastWrite() == hash) {
+        return;
+      }
+      lastWrite() = hash;
+      access = Access::Write;
+    }
+    Sample(key, access);
+  }
+
+  void Sample(const StringView& key, Access access) {
+    uint64_t interval = sample_interval_.load(std::memory_order_relaxed);
+    if (interval == 0) {
+      return;
+    }
+    static thread_local uint64_t accesses = 0;
+    if (++accesses % interval == 0) {
+      (access == Access::Read ? reads_ : writes_).Add(key);
+    }
+  }
+
+  // Record a contention of "slot", which has been contended "contentions"
+  // times
+  void Contended(uint64_t slot, uint64_t contentions);
+
+  // Fill hottest "k" keys and most contended "k" slots to "hot_keys"
+  void Get(uint32_t k, HotKeys* hot_keys);
+
+  void Reset();
+
+ private:
+  static uint32_t& writeScopes() {
+    static thread_local uint32_t scopes = 0;
+    return scopes;
+  }
+
+  // Hash of the key last sampled in write scopes of this thread
+  static uint64_t& lastWrite() {
+    static thread_local uint64_t hash = 0;
+    return hash;
+  }
+
+  std::atomic<uint64_t> sample_interval_{0};
+  TopKSketch reads_;
+  TopKSketch writes_;
+
+  std::atomic<uint64_t> contentions_{0};
+  std::atomic<uint64_t> slot_threshold_{0};
+  SpinMutex slots_mu_;
+  // Slot index to contention count
+  std::unordered_map<uint64_t, uint64_t> contended_slots_;
+};
+
+}  // namespace KVDK_NAMESPACE
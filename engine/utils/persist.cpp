@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include "persist.hpp"
+
+#include <algorithm>
+
+namespace KVDK_NAMESPACE {
+
+namespace {
+std::atomic<uint64_t> next_policy_id{0};
+
+// Deferred persists of this thread in each policy it has deferred persists
+// of, keyed by id of the policy
+struct ThreadDeferredList {
+  ~ThreadDeferredList() {
+    for (auto& d : list) {
+      d.second->exited.store(true, std::memory_order_release);
+    }
+  }
+
+  std::vector<std::pair<uint64_t, std::shared_ptr<PersistPolicy::Deferred>>>
+      list;
+};
+
+thread_local ThreadDeferredList thread_deferred;
+}  // namespace
+
+PersistPolicy::PersistPolicy(PersistMode mode, const PMemEmulation& emulation)
+    : mode_(mode), emulation_(emulation), id_(next_policy_id.fetch_add(1)) {}
+
+PersistPolicy::Deferred* PersistPolicy::threadDeferred() const {
+  for (auto& d : thread_deferred.list) {
+    if (d.first == id_) {
+      return d.second.get();
+    }
+  }
+  return nullptr;
+}
+
+PersistPolicy::Deferred* PersistPolicy::createThreadDeferred() {
+  Deferred* existing = threadDeferred();
+  if (existing != nullptr) {
+    return existing;
+  }
+  auto& list = thread_deferred.list;
+  // Drop deferred persists of destroyed policies, which only this thread
+  // holds now
+  list.erase(std::remove_if(list.begin(), list.end(),
+                            [](const std::pair<uint64_t,
+                                               std::shared_ptr<Deferred>>& d) {
+                              return d.second.use_count() == 1;
+                            }),
+             list.end());
+  std::shared_ptr<Deferred> d(new Deferred(this));
+  {
+    std::lock_guard<std::mutex> lg(deferred_mu_);
+    deferred_.push_back(d);
+  }
+  list.emplace_back(id_, d);
+  return d.get();
+}
+
+PersistPolicy::DeferScope::DeferScope(PersistPolicy& policy, bool defer)
+    : deferred_(nullptr) {
+  // Nothing to defer in volatile mode, and a nested scope is a no-op
+  if (!defer || policy.Volatile() || deferringScope() != nullptr) {
+    return;
+  }
+  deferred_ = policy.createThreadDeferred();
+  deferred_->seq.fetch_add(1);
+  // Timestamps taken by rdtsc in the scope are after the scope is visible
+  // to FlushDeferred()
+  _mm_mfence();
+  _mm_lfence();
+  deferringScope() = deferred_;
+}
+
+PersistPolicy::DeferScope::~DeferScope() {
+  if (deferred_ != nullptr) {
+    deferringScope() = nullptr;
+    deferred_->seq.fetch_add(1, std::memory_order_release);
+  }
+}
+
+uint64_t PersistPolicy::FlushDeferred(const std::function<uint64_t()>& clock) {
+  std::lock_guard<std::mutex> lg(deferred_mu_);
+  uint64_t ts = clock();
+  // Scopes are checked after the clock is read
+  _mm_lfence();
+
+  std::vector<std::pair<const char*, size_t>> ranges;
+  for (size_t i = 0; i < deferred_.size();) {
+    Deferred* d = deferred_[i].get();
+    // Checked before ranges are taken, so an exited thread adds no more
+    bool exited = d->exited.load(std::memory_order_acquire);
+    // Scopes in progress may have taken timestamps before "ts", wait for
+    // them unless it's the calling thread
+    uint64_t seq = d->seq.load(std::memory_order_acquire);
+    if ((seq & 1) && d != deferringScope()) {
+      while (d->seq.load(std::memory_order_acquire) == seq) {
+        _mm_pause();
+      }
+    }
+    {
+      std::lock_guard<SpinMutex> dlg(d->mu);
+      ranges.insert(ranges.end(), d->ranges.begin(), d->ranges.end());
+      d->ranges.clear();
+      d->bytes.store(0, std::memory_order_relaxed);
+    }
+    if (exited) {
+      deferred_[i] = std::move(deferred_.back());
+      deferred_.pop_back();
+    } else {
+      i++;
+    }
+  }
+
+  // Write back ranges in address order, so cache lines of a XPLine reach the
+  // PMem device together and can be combined into a single media write.
+  // Overlapped ranges are merged to write back each line once
+  std::sort(ranges.begin(), ranges.end());
+  size_t merged = 0;
+  for (size_t i = 1; i < ranges.size(); i++) {
+    auto& last = ranges[merged];
+    if (ranges[i].first <= last.first + last.second) {
+      const char* end = std::max(last.first + last.second,
+                                 ranges[i].first + ranges[i].second);
+      last.second = end - last.first;
+    } else {
+      ranges[++merged] = ranges[i];
+    }
+  }
+  if (!ranges.empty()) {
+    ranges.resize(merged + 1);
+  }
+
+  // Write back all ranges and fence once
+  bool emulated = Emulated();
+  for (auto& range : ranges) {
+    pmem_flush(range.first, range.second);
+    if (emulated) {
+      emulate(range.first, range.second, false);
+    }
+  }
+  pmem_drain();
+  if (emulated) {
+    delay(emulation_.write_latency_ns);
+  }
+  return ts;
+}
+
+}  // namespace KVDK_NAMESPACE
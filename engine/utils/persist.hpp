@@ -0,0 +1,315 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#pragma once
+
+#include <immintrin.h>
+#include <libpmem.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "../alias.hpp"
+#include "../macros.hpp"
+#include "utils.hpp"
+
+namespace KVDK_NAMESPACE {
+
+// How writes to the data space of an instance are made durable
+enum class PersistMode : uint8_t {
+  // Data space is PMem, persisted by cache line write back and fences
+  PMem = 0,
+  // Data space is DRAM (see Configs::volatile_mode), nothing is persisted
+  // and records are not checksummed
+  Volatile,
+  // Data space is a regular file emulating PMem (see Configs::emulate_pmem),
+  // persisted like PMem and optionally msync-ed, with optional injected
+  // write latency and bandwidth limit
+  Emulated,
+};
+
+// Cost model and durability of PersistMode::Emulated
+struct PMemEmulation {
+  // msync persisted ranges to the file, so they survive OS crashes rather
+  // than only process crashes
+  bool msync = false;
+  // Injected latency of each persist barrier in nanoseconds
+  uint64_t write_latency_ns = 0;
+  // Write bandwidth of a writing thread in MB/s, 0 for unlimited
+  uint64_t write_bandwidth_mb = 0;
+};
+
+// Persistence primitives of the data space of an instance, all writes of its
+// records and their fields, batch logs and other metadata go through the
+// policy of the instance, which is owned by its PMEMAllocator. So instances
+// of different modes can be open in a process at the same time.
+//
+// The mode never changes after the instance opened, so branches on it are
+// well predicted.
+class PersistPolicy {
+ public:
+  // "emulation" is the cost model in PersistMode::Emulated
+  explicit PersistPolicy(PersistMode mode = PersistMode::PMem,
+                         const PMemEmulation& emulation = PMemEmulation());
+
+  PersistPolicy(const PersistPolicy&) = delete;
+  PersistPolicy& operator=(const PersistPolicy&) = delete;
+
+  PersistMode Mode() const { return mode_; }
+
+  bool Volatile() const { return mode_ == PersistMode::Volatile; }
+
+  bool Emulated() const { return mode_ == PersistMode::Emulated; }
+
+  // Whether records are checksummed, so they can be validated in recovery
+  bool Checksummed() const { return !Volatile(); }
+
+  // Write back and fence [addr, addr + len) after it's written
+  void Persist(const void* addr, size_t len) const {
+    if (maybeDefer(addr, len)) {
+      return;
+    }
+    switch (mode_) {
+      case PersistMode::PMem:
+        pmem_persist(addr, len);
+        break;
+      case PersistMode::Emulated:
+        pmem_persist(addr, len);
+        emulate(addr, len, true);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Copy "len" bytes from "src" to "dst" with non-temporal stores, which are
+  // not durable until Drain()
+  void CopyNT(void* dst, const void* src, size_t len) const {
+    if (deferring(this) != nullptr) {
+      // Lines are written back by FlushDeferred() of another thread, which
+      // can't drain non-temporal stores of this thread
+      memcpy(dst, src, len);
+      deferring(this)->Add(dst, len);
+      return;
+    }
+    switch (mode_) {
+      case PersistMode::PMem:
+        pmem_memcpy(dst, src, len, PMEM_F_MEM_NONTEMPORAL | PMEM_F_MEM_NODRAIN);
+        break;
+      case PersistMode::Emulated:
+        pmem_memcpy(dst, src, len, PMEM_F_MEM_NONTEMPORAL | PMEM_F_MEM_NODRAIN);
+        // Stores must be visible before msync, the latency is paid by Drain()
+        _mm_sfence();
+        emulate(dst, len, false);
+        break;
+      default:
+        memcpy(dst, src, len);
+        break;
+    }
+  }
+
+  // Wait for non-temporal stores issued before to be durable
+  void Drain() const {
+    if (deferring(this) != nullptr) {
+      return;
+    }
+    switch (mode_) {
+      case PersistMode::PMem:
+        pmem_drain();
+        break;
+      case PersistMode::Emulated:
+        pmem_drain();
+        delay(emulation_.write_latency_ns);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Store and persist "value" to a 8 bytes field by a non-temporal store
+  void StoreNT(uint64_t* dst, uint64_t value) const {
+    if (deferring(this) != nullptr) {
+      __atomic_store_n(dst, value, __ATOMIC_RELEASE);
+      deferring(this)->Add(dst, sizeof(uint64_t));
+    } else if (!Volatile()) {
+      _mm_stream_si64(reinterpret_cast<long long*>(dst),
+                      static_cast<long long>(value));
+      _mm_mfence();
+      maybeEmulate(dst, sizeof(uint64_t));
+    } else {
+      __atomic_store_n(dst, value, __ATOMIC_RELEASE);
+    }
+  }
+
+  // Store and persist "value" to a 4 bytes field by a non-temporal store
+  void StoreNT(uint32_t* dst, uint32_t value) const {
+    if (deferring(this) != nullptr) {
+      __atomic_store_n(dst, value, __ATOMIC_RELEASE);
+      deferring(this)->Add(dst, sizeof(uint32_t));
+    } else if (!Volatile()) {
+      _mm_stream_si32(reinterpret_cast<int*>(dst), static_cast<int>(value));
+      _mm_mfence();
+      maybeEmulate(dst, sizeof(uint32_t));
+    } else {
+      __atomic_store_n(dst, value, __ATOMIC_RELEASE);
+    }
+  }
+
+  // Write back and fence the cache line of "addr" after it's written
+  void Flush(const void* addr) const {
+    if (maybeDefer(addr, 1)) {
+      return;
+    }
+    if (!Volatile()) {
+      _mm_clwb(const_cast<void*>(addr));
+      _mm_mfence();
+      maybeEmulate(addr, 1);
+    } else {
+      asm volatile("" ::: "memory");
+    }
+  }
+
+  struct Deferred;
+
+  // Persists of the data space of "policy" in the scope are deferred to the
+  // next FlushDeferred() of it rather than made durable before return, see
+  // Configs::relaxed_durability.
+  //
+  // A scope should be opened right before its writes take their timestamps,
+  // and it must not block on other threads, as FlushDeferred() waits for
+  // scopes in progress
+  class DeferScope {
+   public:
+    DeferScope(PersistPolicy& policy, bool defer);
+    ~DeferScope();
+
+    DeferScope(const DeferScope&) = delete;
+    DeferScope& operator=(const DeferScope&) = delete;
+
+   private:
+    Deferred* deferred_;
+  };
+
+  // Make deferred persists of all threads durable.
+  //
+  // It reads "clock" on entry and waits for scopes in progress, so all
+  // deferred writes that took timestamps from "clock" before the returned
+  // value are durable on return
+  uint64_t FlushDeferred(const std::function<uint64_t()>& clock);
+
+  // Bytes of deferred persists of this thread not flushed yet
+  uint64_t ThreadDeferredBytes() const {
+    const Deferred* d = threadDeferred();
+    return d == nullptr ? 0 : d->bytes.load(std::memory_order_relaxed);
+  }
+
+  // Deferred persists of a thread
+  struct Deferred {
+    explicit Deferred(const PersistPolicy* _owner) : owner(_owner) {}
+
+    // Record [addr, addr + len) to be persisted, merged with the last range
+    // if they are contiguous
+    void Add(const void* addr, size_t len) {
+      const char* begin = static_cast<const char*>(addr);
+      std::lock_guard<SpinMutex> lg(mu);
+      if (!ranges.empty() &&
+          ranges.back().first + ranges.back().second == begin) {
+        ranges.back().second += len;
+      } else {
+        ranges.emplace_back(begin, len);
+      }
+      bytes.fetch_add(len, std::memory_order_relaxed);
+    }
+
+    const PersistPolicy* owner;
+    SpinMutex mu;
+    std::vector<std::pair<const char*, size_t>> ranges;
+    std::atomic<uint64_t> bytes{0};
+    // Odd while the thread is in a DeferScope
+    std::atomic<uint64_t> seq{0};
+    // Set once the thread exited, so its persists are flushed and dropped by
+    // the next FlushDeferred()
+    std::atomic<bool> exited{false};
+  };
+
+ private:
+  // Deferred persists of the current scope of this thread if it defers
+  // persists of "policy", otherwise nullptr
+  static Deferred* deferring(const PersistPolicy* policy) {
+    Deferred* d = deferringScope();
+    return d != nullptr && d->owner == policy ? d : nullptr;
+  }
+
+  static Deferred*& deferringScope() {
+    static thread_local Deferred* deferred = nullptr;
+    return deferred;
+  }
+
+  // Deferred persists of this thread, nullptr if it never deferred persists
+  // of this policy
+  Deferred* threadDeferred() const;
+
+  // Deferred persists of this thread, created and registered to
+  // FlushDeferred() on first use
+  Deferred* createThreadDeferred();
+
+  bool maybeDefer(const void* addr, size_t len) const {
+    Deferred* d = deferring(this);
+    if (d != nullptr) {
+      d->Add(addr, len);
+      return true;
+    }
+    return false;
+  }
+
+  void maybeEmulate(const void* addr, size_t len) const {
+    if (Emulated()) {
+      emulate(addr, len, true);
+    }
+  }
+
+  // Make [addr, addr + len) durable and pay for writing it in emulated mode,
+  // "barrier" for whether it ends with a persist barrier
+  void emulate(const void* addr, size_t len, bool barrier) const {
+    if (emulation_.msync) {
+      pmem_msync(addr, len);
+    }
+    uint64_t ns = barrier ? emulation_.write_latency_ns : 0;
+    if (emulation_.write_bandwidth_mb > 0) {
+      // 1 MB/s writes a byte per microsecond
+      ns += len * 1000 / emulation_.write_bandwidth_mb;
+    }
+    delay(ns);
+  }
+
+  // Busy wait, as sleeping takes much longer than PMem writes
+  static void delay(uint64_t ns) {
+    if (ns == 0) {
+      return;
+    }
+    auto end = std::chrono::steady_clock::now() + std::chrono::nanoseconds(ns);
+    while (std::chrono::steady_clock::now() < end) {
+      _mm_pause();
+    }
+  }
+
+  const PersistMode mode_;
+  const PMemEmulation emulation_;
+  // Distinguishes policies of closed and newly opened instances in
+  // per-thread caches, as they may share an address
+  const uint64_t id_;
+  std::mutex deferred_mu_;
+  // Deferred persists of threads that have opened a DeferScope of the policy,
+  // shared with the threads, which may outlive the policy
+  std::vector<std::shared_ptr<Deferred>> deferred_;
+};
+
+}  // namespace KVDK_NAMESPACE
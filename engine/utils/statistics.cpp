@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include "statistics.hpp"
+
+#include <algorithm>
+
+namespace KVDK_NAMESPACE {
+
+void LatencyHistogram::MergeTo(uint64_t* buckets, uint64_t* sum,
+                               uint64_t* max) const {
+  for (uint32_t i = 0; i < kNumBuckets; i++) {
+    buckets[i] += buckets_[i].load(std::memory_order_relaxed);
+  }
+  *sum += sum_.load(std::memory_order_relaxed);
+  *max = std::max(*max, max_.load(std::memory_order_relaxed));
+}
+
+StatsCollector::ThreadStats* StatsCollector::threadStats() {
+  auto& slot =
+      thread_stats_[ThreadManager::ThreadID() % thread_stats_.size()];
+  ThreadStats* stats = slot.load(std::memory_order_acquire);
+  if (stats == nullptr) {
+    ThreadStats* created = new ThreadStats();
+    if (slot.compare_exchange_strong(stats, created,
+                                     std::memory_order_acq_rel)) {
+      stats = created;
+    } else {
+      delete created;
+    }
+  }
+  return stats;
+}
+
+void StatsCollector::Collect(OpStatistics* ops) const {
+  double nanos_per_cycle = NanosPerCycle();
+  auto to_nanos = [&](uint64_t cycles) {
+    return static_cast<uint64_t>(cycles * nanos_per_cycle);
+  };
+
+  std::vector<uint64_t> buckets(LatencyHistogram::kNumBuckets);
+  for (uint32_t op = 0; op < KVDKStatOpNum; op++) {
+    std::fill(buckets.begin(), buckets.end(), 0);
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    for (auto& slot : thread_stats_) {
+      ThreadStats* stats = slot.load(std::memory_order_acquire);
+      if (stats != nullptr) {
+        stats->histograms[op].MergeTo(buckets.data(), &sum, &max);
+      }
+    }
+
+    OpStatistics& op_stats = ops[op];
+    op_stats = OpStatistics();
+    for (uint64_t n : buckets) {
+      op_stats.count += n;
+    }
+    if (op_stats.count == 0) {
+      continue;
+    }
+    op_stats.avg_ns = sum * nanos_per_cycle / op_stats.count;
+    op_stats.max_ns = to_nanos(max);
+
+    // Percentiles are the smallest value of the bucket they fall in
+    struct {
+      double ratio;
+      uint64_t* value;
+    } percentiles[] = {{0.5, &op_stats.p50_ns},
+                       {0.99, &op_stats.p99_ns},
+                       {0.999, &op_stats.p999_ns}};
+    uint64_t seen = 0;
+    size_t next = 0;
+    for (uint32_t i = 0; i < buckets.size() && next < 3; i++) {
+      seen += buckets[i];
+      while (next < 3 && seen >= percentiles[next].ratio * op_stats.count) {
+        *percentiles[next].value =
+            std::min(to_nanos(LatencyHistogram::BucketValue(i)),
+                     op_stats.max_ns);
+        next++;
+      }
+    }
+  }
+}
+
+}  // namespace KVDK_NAMESPACE
@@ -0,0 +1,130 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "../alias.hpp"
+#include "../thread_manager.hpp"
+#include "kvdk/types.hpp"
+#include "utils.hpp"
+
+namespace KVDK_NAMESPACE {
+
+// Log-linear histogram of latencies in cycles, which keeps 8 sub-buckets per
+// power of 2 so a recorded value is accurate to 1/8 of its magnitude
+class LatencyHistogram {
+ public:
+  static constexpr uint32_t kSubBucketBits = 3;
+  static constexpr uint32_t kSubBuckets = 1 << kSubBucketBits;
+  // Values up to 2^40 cycles are distinguished
+  static constexpr uint32_t kNumBuckets = (40 - kSubBucketBits + 1) *
+                                          kSubBuckets;
+
+  void Record(uint64_t cycles) {
+    buckets_[bucketIndex(cycles)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(cycles, std::memory_order_relaxed);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (cycles > max &&
+           !max_.compare_exchange_weak(max, cycles,
+                                       std::memory_order_relaxed)) {
+    }
+  }
+
+  // Add recorded values to "buckets", "sum" and "max"
+  void MergeTo(uint64_t* buckets, uint64_t* sum, uint64_t* max) const;
+
+  // Smallest value of bucket "index"
+  static uint64_t BucketValue(uint32_t index) {
+    if (index < kSubBuckets) {
+      return index;
+    }
+    uint32_t shift = index / kSubBuckets - 1;
+    return static_cast<uint64_t>(kSubBuckets + index % kSubBuckets) << shift;
+  }
+
+ private:
+  static uint32_t bucketIndex(uint64_t value) {
+    if (value < kSubBuckets) {
+      return value;
+    }
+    uint32_t shift = 63 - __builtin_clzll(value) - kSubBucketBits;
+    uint64_t index = (shift + 1) * kSubBuckets +
+                     ((value >> shift) & (kSubBuckets - 1));
+    return index < kNumBuckets ? index : kNumBuckets - 1;
+  }
+
+  std::atomic<uint64_t> buckets_[kNumBuckets]{};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+// Collect latencies of operations in per-thread histograms, which are merged
+// on Collect().
+//
+// Histograms of a thread are allocated on its first recorded operation.
+// Threads sharing a thread cache share histograms
+class StatsCollector {
+ public:
+  explicit StatsCollector(uint64_t num_thread_caches)
+      : thread_stats_(num_thread_caches) {}
+
+  ~StatsCollector() {
+    for (auto& stats : thread_stats_) {
+      delete stats.load();
+    }
+  }
+
+  void Enable(bool enable) {
+    enabled_.store(enable, std::memory_order_relaxed);
+  }
+
+  bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  void Record(StatOp op, uint64_t cycles) {
+    threadStats()->histograms[op].Record(cycles);
+  }
+
+  // Merge histograms of all threads to "ops", indexed by StatOp
+  void Collect(OpStatistics* ops) const;
+
+  // Time an operation from construction to destruction if statistics are
+  // enabled
+  class Timer {
+   public:
+    Timer(StatsCollector* collector, StatOp op)
+        : collector_(collector->Enabled() ? collector : nullptr),
+          op_(op),
+          start_(collector_ ? rdtsc() : 0) {}
+
+    ~Timer() {
+      if (collector_) {
+        collector_->Record(op_, rdtsc() - start_);
+      }
+    }
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+   private:
+    StatsCollector* collector_;
+    StatOp op_;
+    uint64_t start_;
+  };
+
+ private:
+  struct ThreadStats {
+    LatencyHistogram histograms[KVDKStatOpNum];
+  };
+
+  ThreadStats* threadStats();
+
+  std::atomic<bool> enabled_{false};
+  std::vector<std::atomic<ThreadStats*>> thread_stats_;
+};
+
+}  // namespace KVDK_NAMESPACE
@@ -0,0 +1,108 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+
+#include "../logger.hpp"
+
+namespace KVDK_NAMESPACE {
+
+Tracer::Tracer(uint64_t num_thread_caches, uint64_t buffer_events)
+    : buffer_events_(std::max<uint64_t>(buffer_events, 1)),
+      base_tsc_(rdtsc()),
+      rings_(num_thread_caches) {}
+
+Tracer::~Tracer() {
+  for (auto& ring : rings_) {
+    delete ring.load();
+  }
+}
+
+void Tracer::Op::begin(Tracer* tracer, const char* name) {
+  tracer_ = tracer;
+  name_ = name;
+  id_ = tracer->next_op_id_.fetch_add(1, std::memory_order_relaxed);
+  thread_id_ = static_cast<uint32_t>(ThreadManager::ThreadID());
+  start_ = stage_start_ = rdtsc();
+  tracing() = this;
+}
+
+void Tracer::Op::end() {
+  tracing() = nullptr;
+  tracer_->record({name_, start_, rdtsc(), id_, thread_id_, false});
+}
+
+void Tracer::Op::endStage(const char* stage) {
+  uint64_t now = rdtsc();
+  tracer_->record({stage, stage_start_, now, id_, thread_id_, true});
+  stage_start_ = now;
+}
+
+void Tracer::record(const Event& event) {
+  auto& slot = rings_[event.thread_id % rings_.size()];
+  Ring* ring = slot.load(std::memory_order_acquire);
+  if (ring == nullptr) {
+    Ring* created = new Ring(buffer_events_);
+    if (slot.compare_exchange_strong(ring, created,
+                                     std::memory_order_acq_rel)) {
+      ring = created;
+    } else {
+      delete created;
+    }
+  }
+  std::lock_guard<SpinMutex> lg(ring->mu);
+  ring->events[ring->written % ring->events.size()] = event;
+  ring->written++;
+}
+
+Status Tracer::Dump(const std::string& path) const {
+  std::vector<Event> events;
+  for (auto& slot : rings_) {
+    Ring* ring = slot.load(std::memory_order_acquire);
+    if (ring == nullptr) {
+      continue;
+    }
+    std::lock_guard<SpinMutex> lg(ring->mu);
+    uint64_t size = ring->events.size();
+    uint64_t begin = ring->written > size ? ring->written - size : 0;
+    for (uint64_t i = begin; i < ring->written; i++) {
+      events.push_back(ring->events[i % size]);
+    }
+  }
+  // Viewers nest events of a thread by their order, so an operation goes
+  // before its stages
+  std::sort(events.begin(), events.end(),
+            [](const Event& a, const Event& b) {
+              return a.start != b.start ? a.start < b.start
+                                        : a.stage < b.stage;
+            });
+
+  FILE* file = fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    GlobalLogger.Error("Open trace file %s error\n", path.c_str());
+    return Status::IOError;
+  }
+  double micros_per_cycle = NanosPerCycle() / 1000;
+  fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  for (size_t i = 0; i < events.size(); i++) {
+    const Event& e = events[i];
+    fprintf(file,
+            "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,"
+            "\"dur\":%.3f,\"pid\":%d,\"tid\":%u,\"args\":{\"op\":%lu}}",
+            i == 0 ? "" : ",", e.name, e.stage ? "stage" : "op",
+            (e.start - base_tsc_) * micros_per_cycle,
+            (e.end - e.start) * micros_per_cycle, getpid(), e.thread_id,
+            e.op_id);
+  }
+  fprintf(file, "\n]}\n");
+  bool ok = fflush(file) == 0;
+  fclose(file);
+  return ok ? Status::Ok : Status::IOError;
+}
+
+}  // namespace KVDK_NAMESPACE
@@ -0,0 +1,125 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "../alias.hpp"
+#include "../thread_manager.hpp"
+#include "kvdk/types.hpp"
+#include "utils.hpp"
+
+namespace KVDK_NAMESPACE {
+
+// Sampled tracing of internal stages of operations.
+//
+// 1 in "sample interval" operations of each thread is traced. A traced
+// operation records an event for itself and an event for each stage it
+// passes, stages are marked by Tracer::Stage() at their ends, so a stage
+// lasts from the end of the previous one (or start of the operation) to
+// its mark. Events are buffered in per-thread ring buffers, which keep the
+// latest events, and are written by Dump() in Chrome trace event format.
+//
+// Threads sharing a thread cache share ring buffers
+class Tracer {
+ public:
+  Tracer(uint64_t num_thread_caches, uint64_t buffer_events);
+
+  ~Tracer();
+
+  // Trace 1 in "interval" operations of each thread, 0 to stop tracing
+  void SetSampleInterval(uint64_t interval) {
+    sample_interval_.store(interval, std::memory_order_relaxed);
+  }
+
+  // Write buffered events to "path" as a Chrome trace JSON file, which can
+  // be opened by chrome://tracing or Perfetto UI
+  Status Dump(const std::string& path) const;
+
+  // Trace an operation from construction to destruction if it's sampled.
+  // Operations nested in a traced one are traced as part of it
+  class Op {
+   public:
+    Op(Tracer* tracer, const char* name) : tracer_(nullptr) {
+      uint64_t interval =
+          tracer->sample_interval_.load(std::memory_order_relaxed);
+      if (interval == 0 || tracing() != nullptr) {
+        return;
+      }
+      static thread_local uint64_t ops = 0;
+      if (++ops % interval == 0) {
+        begin(tracer, name);
+      }
+    }
+
+    ~Op() {
+      if (tracer_ != nullptr) {
+        end();
+      }
+    }
+
+    Op(const Op&) = delete;
+    Op& operator=(const Op&) = delete;
+
+   private:
+    friend class Tracer;
+
+    void begin(Tracer* tracer, const char* name);
+    void end();
+    void endStage(const char* stage);
+
+    Tracer* tracer_;
+    const char* name_;
+    uint64_t id_;
+    uint32_t thread_id_;
+    uint64_t start_;
+    uint64_t stage_start_;
+  };
+
+  // End stage "name" of the operation traced by this thread, if any.
+  // "name" should be a string literal
+  static void Stage(const char* name) {
+    Op* op = tracing();
+    if (op != nullptr) {
+      op->endStage(name);
+    }
+  }
+
+ private:
+  struct Event {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+    uint64_t op_id;
+    uint32_t thread_id;
+    bool stage;
+  };
+
+  struct Ring {
+    explicit Ring(uint64_t size) : events(size) {}
+
+    SpinMutex mu;
+    std::vector<Event> events;
+    uint64_t written = 0;
+  };
+
+  // Operation traced by this thread, nullptr if there is not one
+  static Op*& tracing() {
+    static thread_local Op* op = nullptr;
+    return op;
+  }
+
+  void record(const Event& event);
+
+  uint64_t buffer_events_;
+  uint64_t base_tsc_;
+  std::atomic<uint64_t> sample_interval_{0};
+  std::atomic<uint64_t> next_op_id_{0};
+  std::vector<std::atomic<Ring*>> rings_;
+};
+
+}  // namespace KVDK_NAMESPACE
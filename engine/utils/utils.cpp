@@ -5,6 +5,14 @@
 #include "utils.hpp"
 
 #include <hwloc.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include <chrono>
 
 #include "../logger.hpp"
 
@@ -50,4 +58,82 @@ int get_usable_pu(void) {
   hwloc_topology_destroy(topology);
   return pu;
 }
+
+int get_pmem_numa_node(const std::string& pmem_file, bool use_devdax_mode) {
+  struct stat st;
+  if (stat(pmem_file.c_str(), &st) < 0) {
+    GlobalLogger.Error("stat file %s failed %s\n", pmem_file.c_str(),
+                       strerror(errno));
+    return -1;
+  }
+
+  // A devdax device is a char device, and a fsdax file lives on a pmem block
+  // device or a partition of it
+  char spath[PATH_MAX];
+  const char* dev_type = use_devdax_mode ? "char" : "block";
+  dev_t dev = use_devdax_mode ? st.st_rdev : st.st_dev;
+  for (const char* attr :
+       {"device/numa_node", "numa_node", "../device/numa_node"}) {
+    snprintf(spath, PATH_MAX, "/sys/dev/%s/%d:%d/%s", dev_type, major(dev),
+             minor(dev), attr);
+    FILE* sfile = fopen(spath, "r");
+    if (sfile == nullptr) {
+      continue;
+    }
+    int numa_node = -1;
+    if (fscanf(sfile, "%d", &numa_node) != 1) {
+      numa_node = -1;
+    }
+    fclose(sfile);
+    if (numa_node >= 0) {
+      return numa_node;
+    }
+  }
+  return -1;
+}
+
+std::vector<int> get_numa_node_pus(int numa_node) {
+  std::vector<int> pus;
+  hwloc_topology_t topology;
+  if (hwloc_topology_init(&topology) < 0) {
+    GlobalLogger.Error("Failed to initialize the topology\n");
+    return pus;
+  }
+  if (hwloc_topology_load(topology) < 0) {
+    GlobalLogger.Error("Failed to load the topology\n");
+    hwloc_topology_destroy(topology);
+    return pus;
+  }
+
+  hwloc_obj_t node = hwloc_get_numanode_obj_by_os_index(topology, numa_node);
+  if (node != nullptr) {
+    int pu;
+    hwloc_bitmap_foreach_begin(pu, node->cpuset) { pus.push_back(pu); }
+    hwloc_bitmap_foreach_end();
+  }
+  hwloc_topology_destroy(topology);
+  return pus;
+}
+
+int bind_thread_to_pus(const std::vector<int>& pus) {
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (int pu : pus) {
+    CPU_SET(pu, &cpuset);
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+}
+
+double NanosPerCycle() {
+  static double nanos_per_cycle = []() {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t start_tsc = rdtsc();
+    std::chrono::nanoseconds elapsed;
+    do {
+      elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(10));
+    return static_cast<double>(elapsed.count()) / (rdtsc() - start_tsc);
+  }();
+  return nanos_per_cycle;
+}
 }  // namespace KVDK_NAMESPACE
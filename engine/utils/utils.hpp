@@ -93,12 +93,16 @@ inline uint64_t rdtsc() {
   return ((uint64_t)lo) | (((uint64_t)hi) << 32);
 }
 
+// Nanoseconds per rdtsc() cycle, calibrated against the steady clock on the
+// first call
+double NanosPerCycle();
+
 inline void atomic_load_16(void* dst, const void* src) {
-  (*(__uint128_t*)dst) = __atomic_load_16(src, std::memory_order_relaxed);
+  (*(__uint128_t*)dst) = __atomic_load_16(src, __ATOMIC_RELAXED);
 }
 
 inline void atomic_store_16(void* dst, const void* src) {
-  __atomic_store_16(dst, (*(__uint128_t*)src), std::memory_order_relaxed);
+  __atomic_store_16(dst, (*(__uint128_t*)src), __ATOMIC_RELAXED);
 }
 
 inline void memcpy_16(void* dst, const void* src) {
@@ -197,6 +201,81 @@ class SpinMutex {
   SpinMutex& operator=(const SpinMutex& s) = delete;
 };
 
+// A queued lock (Hemlock, a CLH variant) that only stores the tail of its
+// waiting queue.
+//
+// Waiters acquire the lock in FIFO order, and each waiter spins on the grant
+// field of its predecessor thread instead of the lock word, so a contended
+// lock does not bounce between all waiters and no waiter starves. Each thread
+// has a single grant field shared by all locks it holds.
+//
+// Notice: lock() and unlock() must be called by the same thread. As the lock
+// is handed over in FIFO order, a preempted waiter stalls all waiters behind
+// it, so prefer SpinMutex if threads outnumber CPU cores
+class QueuedMutex {
+ public:
+  QueuedMutex() = default;
+
+  void lock() {
+    ThreadNode* self = threadNode();
+    ThreadNode* pred = tail_.exchange(self, std::memory_order_acq_rel);
+    if (pred != nullptr) {
+      // Wait predecessor to grant this lock, then acknowledge it
+      while (pred->grant.load(std::memory_order_acquire) != this) {
+        _mm_pause();
+      }
+      pred->grant.store(nullptr, std::memory_order_release);
+    }
+  }
+
+  void unlock() {
+    ThreadNode* self = threadNode();
+    ThreadNode* expected = self;
+    if (!tail_.compare_exchange_strong(expected, nullptr,
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+      // Pass lock to successor, and wait its acknowledgement so the grant
+      // field can be reused
+      self->grant.store(this, std::memory_order_release);
+      while (self->grant.load(std::memory_order_acquire) != nullptr) {
+        _mm_pause();
+      }
+    }
+  }
+
+  bool try_lock() {
+    ThreadNode* expected = nullptr;
+    return tail_.compare_exchange_strong(expected, threadNode(),
+                                         std::memory_order_acquire,
+                                         std::memory_order_relaxed);
+  }
+
+  QueuedMutex(const QueuedMutex& s) = delete;
+  QueuedMutex(QueuedMutex&& s) = delete;
+  QueuedMutex& operator=(const QueuedMutex& s) = delete;
+
+ private:
+  struct alignas(64) ThreadNode {
+    std::atomic<QueuedMutex*> grant{nullptr};
+  };
+
+  static ThreadNode* threadNode() {
+    static thread_local ThreadNode node;
+    return &node;
+  }
+
+  std::atomic<ThreadNode*> tail_{nullptr};
+};
+
+// Mutex of hash table slots and LockTable, which guard keys and records. Build
+// with -DUSE_QUEUED_LOCK=ON to use QueuedMutex for them in workloads with hot
+// keys
+#ifdef KVDK_QUEUED_LOCK
+using KeyMutex = QueuedMutex;
+#else
+using KeyMutex = SpinMutex;
+#endif
+
 template <typename SharedMutex>
 class SharedLock {
  public:
@@ -498,6 +577,16 @@ void compare_excange_if_larger(std::atomic<T>& num, T target) {
 // Return the number of process unit (PU) that are bound to the kvdk instance
 int get_usable_pu(void);
 
+// Return the NUMA node that the PMem device of "pmem_file" attaches to, or -1
+// if it can't be detected
+int get_pmem_numa_node(const std::string& pmem_file, bool use_devdax_mode);
+
+// Return PUs of NUMA node "numa_node", or empty if it's not found
+std::vector<int> get_numa_node_pus(int numa_node);
+
+// Bind the calling thread to "pus", return 0 on success
+int bind_thread_to_pus(const std::vector<int>& pus);
+
 namespace TimeUtils {
 /* Return the UNIX time in microseconds */
 inline UnixTimeType unix_time(void) {
@@ -3,6 +3,8 @@
  */
 #pragma once
 
+#include <algorithm>
+
 #include "../alias.hpp"
 #include "../thread_manager.hpp"
 #include "../utils/utils.hpp"
@@ -270,11 +272,21 @@ class VersionController {
   }
 
   TimestampType LocalOldestSnapshotTS() {
-    return local_oldest_snapshot_.GetTimestamp();
+    return std::min(local_oldest_snapshot_.GetTimestamp(),
+                    durable_bound_.load(std::memory_order_relaxed));
   }
 
   TimestampType GlobalOldestSnapshotTs() {
-    return global_oldest_snapshot_ts_.load();
+    return std::min(global_oldest_snapshot_ts_.load(),
+                    durable_bound_.load(std::memory_order_relaxed));
+  }
+
+  // Writes with timestamps before "ts" are durable, see
+  // Configs::relaxed_durability. Oldest snapshots are bounded below it, so
+  // old versions are kept until their newer versions are durable
+  void SetDurableTimestamp(TimestampType ts) {
+    kvdk_assert(ts > 0, "");
+    durable_bound_.store(ts - 1);
   }
 
   // Update recorded oldest snapshot up to state by iterating every thread
@@ -307,6 +319,9 @@ class VersionController {
   // oldest snapshot until call UpdatedOldestSnapshot()
   SnapshotImpl local_oldest_snapshot_{kMaxTimestamp};
   std::atomic<TimestampType> global_oldest_snapshot_ts_{kMaxTimestamp};
+  // Upper bound of oldest snapshots, kMaxTimestamp if all writes are durable
+  // on return
+  std::atomic<TimestampType> durable_bound_{kMaxTimestamp};
 
   // These two used to get current timestamp of the instance
   // version_base_: The newest timestamp on instance closing last time
@@ -4,8 +4,11 @@
 
 namespace KVDK_NAMESPACE {
 
-void BatchWriteLog::EncodeTo(char* dst) {
+void BatchWriteLog::EncodeTo(const PersistPolicy& policy, char* dst) {
   kvdk_assert(stage == Stage::Initializing, "");
+  if (policy.Volatile()) {
+    return;
+  }
 
   size_t total_bytes;
   total_bytes =
@@ -47,10 +50,7 @@ void BatchWriteLog::EncodeTo(char* dst) {
   kvdk_assert(buffer.size() == total_bytes, "");
 
   memcpy(dst, buffer.data(), buffer.size());
-  for (size_t i = 0; i < buffer.size(); i += 64) {
-    _mm_clflushopt(&dst[i]);
-  }
-  _mm_mfence();
+  policy.Persist(dst, buffer.size());
 }
 
 void BatchWriteLog::DecodeFrom(char const* src) {
@@ -10,6 +10,7 @@
 #include "hash_table.hpp"
 #include "kvdk/write_batch.hpp"
 #include "utils/codec.hpp"
+#include "utils/persist.hpp"
 #include "utils/utils.hpp"
 
 namespace KVDK_NAMESPACE {
@@ -289,30 +290,31 @@ class BatchWriteLog {
   // K | HashLogEntry*K
   // L | ListLogEntry*K
   // dst is expected to have capacity of MaxBytes().
-  void EncodeTo(char* dst);
+  //
+  // Logs are persisted by "policy" of the instance. They are not kept in
+  // volatile mode as there is nothing to roll back, so EncodeTo() and Mark*()
+  // except MarkInitializing() are no-ops then
+  void EncodeTo(const PersistPolicy& policy, char* dst);
 
   void DecodeFrom(char const* src);
 
-  static void MarkProcessing(char* dst) {
-    dst = &dst[sizeof(size_t) + sizeof(TimestampType)];
-    *reinterpret_cast<Stage*>(dst) = Stage::Processing;
-    _mm_clflush(dst);
-    _mm_mfence();
+  static void MarkProcessing(const PersistPolicy& policy, char* dst) {
+    if (policy.Volatile()) {
+      return;
+    }
+    markStage(policy, dst, Stage::Processing);
   }
 
-  static void MarkCommitted(char* dst) {
-    dst = &dst[sizeof(size_t) + sizeof(TimestampType)];
-    *reinterpret_cast<Stage*>(dst) = Stage::Committed;
-    _mm_clflush(dst);
-    _mm_mfence();
+  static void MarkCommitted(const PersistPolicy& policy, char* dst) {
+    if (policy.Volatile()) {
+      return;
+    }
+    markStage(policy, dst, Stage::Committed);
   }
 
   // For rollback
-  static void MarkInitializing(char* dst) {
-    dst = &dst[sizeof(size_t) + sizeof(TimestampType)];
-    *reinterpret_cast<Stage*>(dst) = Stage::Initializing;
-    _mm_clflush(dst);
-    _mm_mfence();
+  static void MarkInitializing(const PersistPolicy& policy, char* dst) {
+    markStage(policy, dst, Stage::Initializing);
   }
 
   using StringLog = std::vector<StringLogEntry>;
@@ -327,6 +329,12 @@ class BatchWriteLog {
   TimestampType Timestamp() const { return timestamp_; }
 
  private:
+  static void markStage(const PersistPolicy& policy, char* dst, Stage stage) {
+    dst = &dst[sizeof(size_t) + sizeof(TimestampType)];
+    *reinterpret_cast<Stage*>(dst) = stage;
+    policy.Persist(dst, sizeof(Stage));
+  }
+
   Stage stage{Stage::Initializing};
   TimestampType timestamp_;
   StringLog string_logs_;
@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "configs.hpp"
+#include "types.hpp"
+
+namespace KVDK_NAMESPACE {
+
+enum class AsyncOpType : int {
+  StringGet = KVDK_ASYNC_STRING_GET,
+  StringPut = KVDK_ASYNC_STRING_PUT,
+  StringDelete = KVDK_ASYNC_STRING_DELETE,
+  SortedGet = KVDK_ASYNC_SORTED_GET,
+  SortedPut = KVDK_ASYNC_SORTED_PUT,
+  SortedDelete = KVDK_ASYNC_SORTED_DELETE,
+  HashGet = KVDK_ASYNC_HASH_GET,
+  HashPut = KVDK_ASYNC_HASH_PUT,
+  HashDelete = KVDK_ASYNC_HASH_DELETE,
+  ListPushFront = KVDK_ASYNC_LIST_PUSH_FRONT,
+  ListPushBack = KVDK_ASYNC_LIST_PUSH_BACK,
+  ListPopFront = KVDK_ASYNC_LIST_POP_FRONT,
+  ListPopBack = KVDK_ASYNC_LIST_POP_BACK,
+};
+
+// An operation submitted to an AsyncQueue
+struct AsyncOp {
+  AsyncOpType type;
+  // Name of the operated collection, ignored by string ops
+  std::string collection;
+  // Key of string ops and sorted/hash ops, ignored by list ops
+  std::string key;
+  // Value to put, or element to push for list ops
+  std::string value;
+  // Used by StringPut
+  WriteOptions write_options;
+  // Passed back in the completion of this op
+  uint64_t user_data = 0;
+};
+
+// Result of a finished AsyncOp
+struct AsyncCompletion {
+  uint64_t user_data;
+  AsyncOpType type;
+  // Same as the status returned by the corresponding synchronous API
+  Status status;
+  // Result of get and pop ops
+  std::string value;
+};
+
+// Called on the engine worker thread that finishes an op. It should not block
+// for long, as it delays other ops in the same worker
+using AsyncCallback = std::function<void(AsyncCompletion&& completion)>;
+
+// Submission and completion queue of async ops, see Engine::AsyncQueueCreate()
+//
+// Submitted ops are executed by engine worker threads in batches, ops in a
+// batch are executed in order, but ops of different batches may be executed
+// concurrently and complete out of order.
+class AsyncQueue {
+ public:
+  // Submit a batch of ops
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::InvalidBatchSize if there are more ops than the queue depth
+  // Status::Abort if the queue is full, poll completions and retry
+  //
+  // Notice: "ops" is left untouched if it's not submitted
+  virtual Status Submit(std::vector<AsyncOp>&& ops) = 0;
+  virtual Status Submit(AsyncOp&& op) = 0;
+
+  // Move at most "max_completions" completed ops to "completions", wait up to
+  // "timeout_ms" milliseconds if there is no completion yet, 0 to return
+  // immediately
+  //
+  // Return:
+  // Number of fetched completions
+  //
+  // Notice: completions are passed to the callback instead if the queue is
+  // created with it, so this always returns 0
+  virtual size_t Poll(std::vector<AsyncCompletion>* completions,
+                      size_t max_completions, int64_t timeout_ms = 0) = 0;
+
+  // Number of submitted ops that are not completed yet
+  virtual size_t InFlight() = 0;
+
+  // Destroying the queue waits all its submitted ops complete
+  virtual ~AsyncQueue() = default;
+};
+
+}  // namespace KVDK_NAMESPACE
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "comparator.hpp"
 #include "types.hpp"
@@ -19,6 +20,17 @@ enum class LogLevel : uint8_t {
   None,
 };
 
+// Codec to compress values
+enum class CompressionType : uint8_t {
+  // Follow Configs::value_compression in WriteOptions, same as None in
+  // Configs
+  Default = 0,
+  None,
+  // Built-in byte oriented LZ77 codec, which is fast to compress and
+  // decompress but has moderate compression ratio
+  LZ,
+};
+
 // Configs of created sorted collection
 // For correctness of encoding, please add new config field in the end of the
 // existing fields
@@ -38,6 +50,22 @@ struct Configs {
   // degraded due to synchronization cost
   uint64_t max_access_threads = 64;
 
+  // Max number of concurrent threads that access the instance without sharing
+  // internal thread slots, 0 or no larger than max_access_threads means
+  // disabled.
+  //
+  // Thread caches are reserved for up to this number of threads, but heavy
+  // resources of a cache, i.e. PMem segment and batch write log, are
+  // allocated on its first access. A thread leases the smallest free slot on
+  // its first access and returns it on exit, so threads share a slot only if
+  // more than this number of them are alive. This suits thread pools that
+  // resize under load.
+  //
+  // Notice: the PMem space should hold a PMem segment for each of
+  // max(max_access_threads, max_elastic_access_threads) threads, as each
+  // accessing thread may hold one
+  uint64_t max_elastic_access_threads = 0;
+
   // Size of PMem space to store KV data, this is not scalable in current
   // edition.
   //
@@ -61,10 +89,138 @@ struct Configs {
   //
   // A PMem segment is a piece of private space of a access thread, so each
   // thread can allocate space without contention. It also decides the max size
-  // of (key + value), which is slightly smaller than
-  // (pmem_block_size * pmem_segment_blocks)
+  // of (key + value) stored in a record, which is slightly smaller than
+  // (pmem_block_size * pmem_segment_blocks). Larger string values are stored
+  // in extents, see large_value_threshold
   uint64_t pmem_segment_blocks = 2 * 1024 * 1024;
 
+  // Allocate records from PMem segments by 256 bytes XPLines, the internal
+  // write unit of Optane PMem media.
+  //
+  // A record not larger than a XPLine never straddles two of them, and a
+  // larger one starts at a XPLine boundary if it would touch one more
+  // XPLine otherwise, so small records of a thread fill XPLines one after
+  // another. This reduces read-modify-writes inside the PMem device at the
+  // cost of some padding space, which is reused for later records. It only
+  // takes effect if pmem_block_size divides 256, and has no effect in
+  // volatile_mode
+  bool xpline_aware_allocation = false;
+
+  // String values not smaller than this are stored out of their records in a
+  // chain of extents, 0 to disable it.
+  //
+  // Extents are allocated apart from PMem segments of access threads and
+  // written with non-temporal stores, so large values don't waste space of
+  // thread segments, and values larger than a segment can be stored. Values
+  // whose record can't fit in a segment are always stored in extents
+  uint64_t large_value_threshold = 1 << 20;
+
+  // String values not smaller than this are stored in blobs separated from
+  // their records, 0 to disable it.
+  //
+  // A blob is stored like a large value (see large_value_threshold) but
+  // allocated from the segment of the writing thread. Updating only TTL of a
+  // key (e.g. by Engine::Expire()) writes a new small record sharing the
+  // blob, rather than copying the value. This reduces PMem writes of such
+  // updates at the cost of an indirection on reads. It only takes effect if
+  // smaller than large_value_threshold
+  uint64_t blob_value_threshold = 0;
+
+  // Codec to compress string values, which can be overridden by
+  // WriteOptions::compression of each write.
+  //
+  // A value is compressed before being persisted if it's not smaller than
+  // compression_threshold, and stored raw if compression doesn't shrink it.
+  // Reads decompress it transparently.
+  CompressionType value_compression = CompressionType::None;
+
+  uint64_t compression_threshold = 256;
+
+  // Store elems of these collection types in a compact record layout if it
+  // saves PMem space. A compact record has a 36 bytes header rather than 56
+  // by using 32-bit offsets and omitting expire time, e.g. a hash elem of a
+  // 8 bytes field and a 8 bytes value takes 64 bytes rather than 128 with
+  // the default pmem_block_size.
+  //
+  // 32-bit offsets address PMem in units of 64 bytes, so it only takes
+  // effect if pmem_block_size is a multiple of 64 and pmem_file_size is less
+  // than 256GB. Each record records its layout, so these can be changed
+  // between runs of an instance.
+  //
+  // Members of sets have no value, so they are always stored compactly if
+  // possible regardless of compact_hash_elems.
+  bool compact_hash_elems = false;
+  bool compact_sorted_elems = false;
+  bool compact_list_elems = false;
+
+  // Path of a file on a block device (e.g. a SSD) that cold string values
+  // are demoted to, empty to disable it.
+  //
+  // Reads of string keys are counted in the hash table, and the cleaner moves
+  // values of keys neither read nor written for at least
+  // cold_tier_cooling_period to the file, leaving a small record on PMem that
+  // refers to it. A cold value is read from the file by pread. Space of cold
+  // values of overwritten or deleted keys is not reclaimed from the file, so
+  // values are no longer demoted once it reaches cold_tier_max_file_size. An
+  // instance with cold values should always be opened with the same
+  // cold_tier_path
+  std::string cold_tier_path = "";
+
+  // Only string values not smaller than this are demoted to the cold tier
+  uint64_t cold_tier_min_value_size = 4096;
+
+  // Time in seconds that the read count of a string key is halved at most
+  // once in. A key written or read is demoted after it's idle for at least a
+  // period, and a frequently read one after more periods
+  double cold_tier_cooling_period = 600;
+
+  // Max size of the cold tier file in bytes
+  uint64_t cold_tier_max_file_size = 256ULL << 30;
+
+  // Write a cold value back to PMem as it's read by Engine::Get(). If it's
+  // demoted again unchanged, it reuses its space in the cold tier file
+  bool cold_tier_promote = true;
+
+  // Make single key string writes (e.g. Engine::Put() and Engine::Delete())
+  // durable in groups rather than before they return.
+  //
+  // Cache line write backs and fences of these writes are deferred to a group
+  // flush every relaxed_flush_interval_us microseconds, once a writing thread
+  // has relaxed_flush_bytes not flushed, or on Engine::Flush(). A crash loses
+  // such writes after the last group flush, and the instance recovers to a
+  // consistent prefix of writes at it.
+  //
+  // Other writes, i.e. batch writes, collection writes, Engine::Modify() and
+  // cold tier moves, are still durable on return and never discarded in
+  // recovery. Each of them pays a group flush before it's persisted, so it's
+  // ordered after relaxed writes before it. It has no effect in volatile_mode
+  bool relaxed_durability = false;
+
+  uint64_t relaxed_flush_interval_us = 1000;
+
+  uint64_t relaxed_flush_bytes = 1 << 20;
+
+  // Time operations in per-thread latency histograms on start, see
+  // Engine::GetStatistics(). It can be switched at runtime by
+  // Engine::EnableStatistics(), and costs a flag check per operation when off
+  bool enable_statistics = false;
+
+  // Trace 1 in "trace_sample_interval" write operations of each thread on
+  // start, recording timestamps of their internal stages (lock, lookup,
+  // allocate, persist, publish and clean), see Engine::DumpTrace(). 0 to
+  // disable, it can be changed at runtime by Engine::SetTraceSampleInterval()
+  uint64_t trace_sample_interval = 0;
+
+  // Size of per-thread ring buffers of traced events, which keep the latest
+  // events of a thread
+  uint64_t trace_buffer_events = 1 << 14;
+
+  // Sample 1 in "hot_key_sample_interval" key accesses of each thread into
+  // streaming top-k sketches of hot keys, and count contentions of hash slot
+  // locks, see Engine::GetHotKeys(). 0 to disable, it can be changed at
+  // runtime by Engine::SetHotKeySampleInterval()
+  uint64_t hot_key_sample_interval = 0;
+
   // The number of bucket groups in the hash table.
   //
   // It should be 2^n and should smaller than 2^32.
@@ -114,6 +270,42 @@ struct Configs {
   // file of the data file.
   std::string devdax_meta_dir = "/mnt/kvdk-pmem-meta";
 
+  // Run the instance entirely in DRAM, e.g. for caching or testing on
+  // machines without PMem.
+  //
+  // Data space of pmem_file_size bytes is anonymous memory rather than a
+  // file, writes are not persisted, records are not checksummed and batch
+  // writes are not logged. Nothing is written to the instance path and all
+  // data is lost on close. Volatile and persistent instances can be open in a
+  // process at the same time
+  bool volatile_mode = false;
+
+  // Back the data space of volatile mode with huge pages, fall back to
+  // transparent huge pages if no huge page is reserved
+  bool volatile_hugepage = false;
+
+  // Emulate PMem with regular files or tmpfs, e.g. for development and
+  // benchmarking on machines without PMem.
+  //
+  // Files under the instance path needn't be on a DAX file system. Writes are
+  // persisted by the same cache line write back and fences as on PMem, which
+  // makes them survive process crashes as the page cache does. Emulated and
+  // other instances can be open in a process at the same time
+  bool emulate_pmem = false;
+
+  // Also msync writes of the data space to the file in emulate_pmem, so they
+  // survive OS crashes at the cost of a system call per persist
+  bool emulate_pmem_msync = false;
+
+  // Latency in nanoseconds injected to each persist barrier of the data
+  // space in emulate_pmem, 0 to disable it
+  uint64_t emulate_pmem_write_latency_ns = 0;
+
+  // Write bandwidth of each writing thread in MB/s emulated by injected
+  // delays in emulate_pmem, 0 for unlimited. The cost model is kept per
+  // instance
+  uint64_t emulate_pmem_write_bandwidth_mb = 0;
+
   // Log information to show
   LogLevel log_level = LogLevel::Info;
 
@@ -122,6 +314,12 @@ struct Configs {
   // having few large skiplists. Default is to close optimization.
   bool opt_large_sorted_collection_recovery = false;
 
+  // Optional optimization strategy for few large hash collections or lists by
+  // splitting a collection into segments at sampled elements and recovering
+  // segments in multi-thread. Default is to close optimization.
+  bool opt_large_hash_collection_recovery = false;
+  bool opt_large_list_recovery = false;
+
   // If a checkpoint is made in last open, recover the instance to the
   // checkpoint version if this true
   //
@@ -129,12 +327,65 @@ struct Configs {
   // during recovery.
   bool recover_to_checkpoint = false;
 
+  // If set true, Open() returns right after batch write logs rolled back, and
+  // the instance restores data and rebuilds collections in background.
+  //
+  // Requests wait until data of their types are restored: string requests are
+  // served once all data segments are scanned, and a collection type is served
+  // once its collections are rebuilt. Collection types are rebuilt in order of
+  // first access by max_access_threads / 2 threads, which use extra thread
+  // caches, so they don't block requests of restored types. If lazy recovery
+  // fails, requests of types not restored return the error.
+  bool lazy_recovery = false;
+
+  // Number of threads to restore data segments and rebuild collections during
+  // recovery, 0 means the same as max_access_threads.
+  //
+  // Recovery runs before any request is served, so this can be set to the
+  // number of idle hyper-threads at boot, regardless of max_access_threads.
+  // In lazy recovery, collections are rebuilt by max_access_threads / 2
+  // threads instead.
+  uint64_t recovery_threads = 0;
+
+  // Bind recovery threads to the CPUs of the NUMA node that the PMem device
+  // attaches to, so segments are restored by NUMA-local threads. This is
+  // ignored if the NUMA node of the PMem device can't be detected.
+  bool numa_bind_recovery_threads = false;
+
+  // Time interval in seconds that recovery progress is reported by
+  // GlobalLogger, 0 to disable it. Progress can also be queried by
+  // Engine::GetRecoveryStats()
+  double report_recovery_progress_interval = 10.0;
+
   // If customer compare functions is used in a kvdk engine, these functions
   // should be registered to the comparator before open engine
   ComparatorTable comparator;
 
   // Background clean thread numbers.
   uint64_t clean_threads = 8;
+
+  // Number of threads of the background executor, which runs all background
+  // works of the instance, i.e. space cleaning, PMem free space organizing
+  // and PMem usage reporting. 0 to use clean_threads + 1
+  uint64_t background_threads = 0;
+
+  // CPUs that background threads are bound to, empty for no binding. Bind
+  // them to CPUs apart from foreground threads to reduce interference
+  std::vector<int> background_cpus;
+
+  // Nice value of background threads, a positive value lowers their priority
+  // under CPU contention. 0 to inherit priority of the opening thread
+  int background_nice = 0;
+
+  // Time budget in seconds of a run of a background task. A long work (e.g.
+  // purging a lot of outdated records) is split into runs of this budget, so
+  // background tasks share threads fairly
+  double background_task_budget = 0.1;
+
+  // Number of engine worker threads that execute ops submitted to
+  // AsyncQueues, 0 to disable async ops. Workers start on creation of the
+  // first AsyncQueue, see Engine::AsyncQueueCreate()
+  uint64_t async_threads = 4;
 };
 
 struct WriteOptions {
@@ -147,6 +398,9 @@ struct WriteOptions {
 
   // determine whether to update expired time if key already existed
   bool update_ttl;
+
+  // codec to compress value of this write, see Configs::value_compression
+  CompressionType compression = CompressionType::Default;
 };
 
 }  // namespace KVDK_NAMESPACE
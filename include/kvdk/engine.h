@@ -25,6 +25,7 @@ typedef struct KVDKHashIterator KVDKHashIterator;
 typedef struct KVDKSnapshot KVDKSnapshot;
 typedef struct KVDKSortedCollectionConfigs KVDKSortedCollectionConfigs;
 typedef struct KVDKRegex KVDKRegex;
+typedef struct KVDKAsyncQueue KVDKAsyncQueue;
 
 extern KVDKRegex* KVDKRegexCreate(char const* data, size_t len);
 extern void KVDKRegexDestroy(KVDKRegex* re);
@@ -48,6 +49,9 @@ extern void KVDKDestroyWriteOptions(KVDKWriteOptions*);
 extern void KVDKWriteOptionsSetTTLTime(KVDKWriteOptions*, int64_t);
 extern void KVDKWriteOptionsSetUpdateTTL(KVDKWriteOptions* kv_options,
                                          int update_ttl);
+// "compression" is a value of kvdk::CompressionType
+extern void KVDKWriteOptionsSetCompression(KVDKWriteOptions* kv_options,
+                                           int compression);
 
 extern KVDKSortedCollectionConfigs* KVDKCreateSortedCollectionConfigs();
 extern void KVDKSetSortedCollectionConfigs(KVDKSortedCollectionConfigs* configs,
@@ -68,6 +72,65 @@ extern void KVDKCloseEngine(KVDKEngine* engine);
 extern void KVDKRemovePMemContents(const char* name);
 extern KVDKSnapshot* KVDKGetSnapshot(KVDKEngine* engine, int make_checkpoint);
 extern void KVDKReleaseSnapshot(KVDKEngine* engine, KVDKSnapshot* snapshot);
+// Make all returned writes durable, which only matters with relaxed
+// durability of the instance
+extern KVDKStatus KVDKFlush(KVDKEngine* engine);
+
+// Runtime statistics of an instance, see kvdk::Statistics for meanings of
+// the fields
+typedef struct {
+  uint64_t count;
+  double avg_ns;
+  uint64_t p50_ns;
+  uint64_t p99_ns;
+  uint64_t p999_ns;
+  uint64_t max_ns;
+} KVDKOpStatistics;
+
+// See kvdk::RecoveryStats
+typedef struct {
+  int finished;
+  int segments_restored;
+  uint64_t restored_segments;
+  uint64_t restored_records;
+  uint64_t total_segments;
+  double elapsed_seconds;
+  double segments_per_second;
+  double records_per_second;
+  double eta_seconds;
+} KVDKRecoveryStats;
+
+typedef struct {
+  int enabled;
+  // Indexed by KVDKStatOp
+  KVDKOpStatistics ops[KVDKStatOpNum];
+  uint64_t pmem_capacity_bytes;
+  uint64_t pmem_usage_bytes;
+  uint64_t pmem_segment_bytes;
+  uint64_t cleaner_workers;
+  uint64_t cleaner_scanned_slots;
+  uint64_t cleaner_purged_records;
+  uint64_t cleaner_destroyed_collections;
+  uint64_t hash_buckets;
+  double hash_load_factor;
+  double hash_avg_chain_length;
+  uint64_t hash_max_chain_length;
+  KVDKRecoveryStats recovery;
+} KVDKStatistics;
+extern void KVDKGetStatistics(KVDKEngine* engine, KVDKStatistics* stats);
+extern void KVDKEnableStatistics(KVDKEngine* engine, int enable);
+extern void KVDKSetTraceSampleInterval(KVDKEngine* engine, uint64_t interval);
+extern KVDKStatus KVDKDumpTrace(KVDKEngine* engine, const char* path);
+
+// Called on each hot key with its estimated number of sampled accesses
+typedef void (*KVDKHotKeyFunc)(const char* key, size_t key_len,
+                               uint64_t count, void* args);
+// Call "func" on the hottest "k" keys of reads, or writes if "writes" is
+// non-zero, from the hottest one
+extern void KVDKGetHotKeys(KVDKEngine* engine, uint32_t k, int writes,
+                           KVDKHotKeyFunc func, void* args);
+extern void KVDKSetHotKeySampleInterval(KVDKEngine* engine, uint64_t interval);
+extern void KVDKResetHotKeys(KVDKEngine* engine);
 
 extern int KVDKRegisterCompFunc(KVDKEngine* engine, const char* compara_name,
                                 size_t compara_len,
@@ -133,6 +196,53 @@ extern KVDKStatus KVDKTransactionHashDelete(KVDKTransaction* txn,
 extern KVDKStatus KVDKTransactionCommit(KVDKTransaction* txn);
 extern void KVDKTransactionRollback(KVDKTransaction* txn);
 
+// For async ops
+typedef struct {
+  uint64_t user_data;
+  // KVDK_ASYNC_* op type, see types.h
+  int op_type;
+  KVDKStatus status;
+  // Result of get and pop ops, NULL for other ops. It's allocated by
+  // malloc() in KVDKAsyncQueuePoll and should be freed by caller, or only
+  // valid until return in KVDKAsyncCallback
+  char* val;
+  size_t val_len;
+} KVDKAsyncCompletion;
+// Called on engine worker threads on completion of async ops
+typedef void (*KVDKAsyncCallback)(KVDKAsyncCompletion const* completion,
+                                  void* args);
+
+// Create an async queue, completions are passed to "cb" if it's not NULL,
+// otherwise they are fetched by KVDKAsyncQueuePoll. Return NULL if async ops
+// are disabled by configs
+extern KVDKAsyncQueue* KVDKAsyncQueueCreate(KVDKEngine* engine,
+                                            size_t queue_depth,
+                                            KVDKAsyncCallback cb,
+                                            void* cb_args);
+// Wait all submitted ops complete and destroy the queue
+extern void KVDKAsyncQueueDestroy(KVDKAsyncQueue* queue);
+// Add an op to the next batch of the queue, "collection" is ignored by string
+// ops, "key" is ignored by list ops and "val" is ignored by get, delete and
+// pop ops
+extern void KVDKAsyncQueueAdd(KVDKAsyncQueue* queue, int op_type,
+                              char const* collection, size_t collection_len,
+                              char const* key, size_t key_len,
+                              char const* val, size_t val_len,
+                              uint64_t user_data);
+// Submit added ops as a batch. Return Abort if the queue is full, then the
+// batch is kept and can be submitted again after polling completions. Return
+// InvalidBatchSize if the batch is larger than queue depth, which never
+// succeeds, then discard it by KVDKAsyncQueueDiscard
+extern KVDKStatus KVDKAsyncQueueSubmit(KVDKAsyncQueue* queue);
+// Discard ops added but not submitted, return number of discarded ops
+extern size_t KVDKAsyncQueueDiscard(KVDKAsyncQueue* queue);
+// Fetch at most "max_completions" completions, wait up to "timeout_ms"
+// milliseconds if there is no completion. Return number of fetched ones
+extern size_t KVDKAsyncQueuePoll(KVDKAsyncQueue* queue,
+                                 KVDKAsyncCompletion* completions,
+                                 size_t max_completions, int64_t timeout_ms);
+extern size_t KVDKAsyncQueueInFlight(KVDKAsyncQueue* queue);
+
 // For String KV
 extern KVDKStatus KVDKGet(KVDKEngine* engine, const char* key, size_t key_len,
                           size_t* val_len, char** val);
@@ -142,6 +252,13 @@ extern KVDKStatus KVDKPut(KVDKEngine* engine, const char* key, size_t key_len,
 extern KVDKStatus KVDKDelete(KVDKEngine* engine, const char* key,
                              size_t key_len);
 
+// Read value of "key" without copying it out of PMem, chunk_func is called on
+// each chunk of the value in order. See definition of KVDKValueChunkFunc
+// (types.h) for more details.
+extern KVDKStatus KVDKGetChunks(KVDKEngine* engine, const char* key,
+                                size_t key_len, KVDKValueChunkFunc chunk_func,
+                                void* chunk_args);
+
 // Modify value of existing key in the engine
 //
 // * modify_func: customized function to modify existing value of key. See
@@ -240,6 +357,69 @@ extern void KVDKHashIteratorGetValue(KVDKHashIterator* iter, char** value_data,
 extern int KVDKHashIteratorMatchKey(KVDKHashIterator* iter,
                                     KVDKRegex const* re);
 
+/// Set ///////////////////////////////////////////////////////////////////////
+extern KVDKStatus KVDKSetCreate(KVDKEngine* engine, char const* key_data,
+                                size_t key_len);
+extern KVDKStatus KVDKSetDestroy(KVDKEngine* engine, char const* key_data,
+                                 size_t key_len);
+extern KVDKStatus KVDKSetCard(KVDKEngine* engine, char const* key_data,
+                              size_t key_len, size_t* card);
+extern KVDKStatus KVDKSetAdd(KVDKEngine* engine, char const* key_data,
+                             size_t key_len, char const* member_data,
+                             size_t member_len);
+extern KVDKStatus KVDKSetRemove(KVDKEngine* engine, char const* key_data,
+                                size_t key_len, char const* member_data,
+                                size_t member_len);
+extern KVDKStatus KVDKSetIsMember(KVDKEngine* engine, char const* key_data,
+                                  size_t key_len, char const* member_data,
+                                  size_t member_len, int* is_member);
+
+/// Sorted Set ////////////////////////////////////////////////////////////////
+extern KVDKStatus KVDKZSetCreate(KVDKEngine* engine, char const* key_data,
+                                 size_t key_len);
+extern KVDKStatus KVDKZSetDestroy(KVDKEngine* engine, char const* key_data,
+                                  size_t key_len);
+extern KVDKStatus KVDKZCard(KVDKEngine* engine, char const* key_data,
+                            size_t key_len, size_t* card);
+extern KVDKStatus KVDKZAdd(KVDKEngine* engine, char const* key_data,
+                           size_t key_len, char const* member_data,
+                           size_t member_len, double score);
+extern KVDKStatus KVDKZIncrBy(KVDKEngine* engine, char const* key_data,
+                              size_t key_len, char const* member_data,
+                              size_t member_len, double increment,
+                              double* new_score);
+extern KVDKStatus KVDKZRem(KVDKEngine* engine, char const* key_data,
+                           size_t key_len, char const* member_data,
+                           size_t member_len);
+extern KVDKStatus KVDKZScore(KVDKEngine* engine, char const* key_data,
+                             size_t key_len, char const* member_data,
+                             size_t member_len, double* score);
+extern KVDKStatus KVDKZRank(KVDKEngine* engine, char const* key_data,
+                            size_t key_len, char const* member_data,
+                            size_t member_len, size_t* rank);
+
+/// Stream ////////////////////////////////////////////////////////////////////
+extern KVDKStatus KVDKStreamCreate(KVDKEngine* engine, char const* key_data,
+                                   size_t key_len);
+extern KVDKStatus KVDKStreamDestroy(KVDKEngine* engine, char const* key_data,
+                                    size_t key_len);
+extern KVDKStatus KVDKXAdd(KVDKEngine* engine, char const* key_data,
+                           size_t key_len, char const* entry_data,
+                           size_t entry_len, uint64_t* id);
+extern KVDKStatus KVDKXLen(KVDKEngine* engine, char const* key_data,
+                           size_t key_len, size_t* len);
+extern KVDKStatus KVDKXTrim(KVDKEngine* engine, char const* key_data,
+                            size_t key_len, uint64_t min_id, size_t* trimmed);
+
+/// Time Series ///////////////////////////////////////////////////////////////
+extern KVDKStatus KVDKTSCreate(KVDKEngine* engine, char const* key_data,
+                               size_t key_len, int64_t bucket_width);
+extern KVDKStatus KVDKTSDestroy(KVDKEngine* engine, char const* key_data,
+                                size_t key_len);
+extern KVDKStatus KVDKTSAppend(KVDKEngine* engine, char const* key_data,
+                               size_t key_len, int64_t timestamp,
+                               double value);
+
 /// List //////////////////////////////////////////////////////////////////////
 extern KVDKStatus KVDKListCreate(KVDKEngine* engine, char const* key_data,
                                  size_t key_len);
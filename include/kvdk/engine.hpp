@@ -4,9 +4,13 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "async.hpp"
 #include "comparator.hpp"
 #include "configs.hpp"
 #include "iterator.hpp"
@@ -80,6 +84,17 @@ class Engine {
   // Return Status::NotFound if the "key" does not exist.
   virtual Status Get(const StringView key, std::string* value) = 0;
 
+  // Read value of STRING-type KV of "key" without copying it out of PMem.
+  // "chunk_func" is called on each chunk of the value in order, a value
+  // stored in extents (see Configs::large_value_threshold) is read extent by
+  // extent, and other values are read in a single chunk.
+  //
+  // Return:
+  // Return Status::Ok if all chunks are read or chunk_func stops reading.
+  // Return Status::NotFound if the "key" does not exist.
+  virtual Status GetChunks(const StringView key, ValueChunkFunc chunk_func,
+                           void* chunk_args) = 0;
+
   // Remove STRING-type KV of "key".
   //
   // Return:
@@ -137,8 +152,27 @@ class Engine {
   // transaction on this struct.
   // 3. Commit or Rollback the transaction as soon as possible to release locks
   // it holds.
+  // 4. Return nullptr if lazy recovery failed.
   virtual std::unique_ptr<Transaction> TransactionCreate() = 0;
 
+  // Create a queue to submit ops asynchronously, ops are executed by engine
+  // worker threads (see Configs::async_threads)
+  //
+  // Args:
+  // * queue_depth: max number of submitted ops that are not completed, or not
+  // polled if "callback" is not set
+  // * callback: if set, it's called on completion of each op instead of
+  // storing the completion to be polled
+  //
+  // Return:
+  // Return a pointer to the created queue, or nullptr if async ops are
+  // disabled or "queue_depth" is 0
+  //
+  // Notice:
+  // Destroy all queues before closing the instance
+  virtual std::unique_ptr<AsyncQueue> AsyncQueueCreate(
+      size_t queue_depth = 1024, AsyncCallback callback = nullptr) = 0;
+
   // Search the STRING-type or Collection and get the corresponding expired
   // time to *expired_time on success.
   //
@@ -475,6 +509,258 @@ class Engine {
                                            Status* s = nullptr) = 0;
   virtual void HashIteratorRelease(HashIterator*) = 0;
 
+  /// Set APIs ////////////////////////////////////////////////////////////////
+
+  // Create a empty set. A set only stores members, and it's cheaper than a
+  // hash collection with empty values
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::Existed if set already existed
+  // Status::WrongType if collection existed but not a set
+  // Status::PMemOverflow/Status::MemoryOverflow if PMem/DRAM exhausted
+  virtual Status SetCreate(StringView set) = 0;
+
+  // Destroy a set
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::NotFound if set not exist
+  // Status::WrongType if collection existed but not a set
+  virtual Status SetDestroy(StringView set) = 0;
+
+  // Add "member" to "set", do nothing if it's already a member
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::NotFound if set not exist
+  // Status::WrongType if collection existed but not a set
+  // Status::PMemOverflow/Status::MemoryOverflow if PMem/DRAM exhausted
+  virtual Status SetAdd(StringView set, StringView member) = 0;
+
+  // Remove "member" from "set"
+  //
+  // Return:
+  // Status::Ok on success or member not existed in set
+  // Status::NotFound if set not exist
+  // Status::WrongType if collection existed but not a set
+  virtual Status SetRemove(StringView set, StringView member) = 0;
+
+  // Check if "member" is a member of "set", store result in *is_member
+  virtual Status SetIsMember(StringView set, StringView member,
+                             bool* is_member) = 0;
+
+  // Get number of members in "set"
+  virtual Status SetCard(StringView set, size_t* card) = 0;
+
+  // Call "visitor" on each member of "set" at current version, stop if it
+  // returns false
+  virtual Status SetScan(StringView set,
+                         std::function<bool(StringView member)> visitor) = 0;
+
+  // Store members in all of "sets" to "members"
+  //
+  // Args:
+  // * integer_members: members of the sets are all 8 bytes integers encoded in
+  // native byte order, so the sets are intersected as sorted integer arrays
+  // with SIMD, which is faster than probing members of the smallest set in
+  // others if sets are of similar sizes. Members are returned in ascending
+  // order of the integers
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::NotFound if any set not exist
+  // Status::WrongType if any collection existed but not a set
+  // Status::InvalidArgument if integer_members but a member is not 8 bytes
+  virtual Status SetIntersect(const std::vector<StringView>& sets,
+                              std::vector<std::string>* members,
+                              bool integer_members = false) = 0;
+
+  // Store members in any of "sets" to "members"
+  virtual Status SetUnion(const std::vector<StringView>& sets,
+                          std::vector<std::string>* members) = 0;
+
+  /// Sorted Set APIs /////////////////////////////////////////////////////////
+
+  // Create a empty sorted set. Each member of a sorted set has a score, and
+  // members are ordered by (score, member)
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::Existed if sorted set already existed
+  // Status::WrongType if collection existed but not a sorted set
+  // Status::PMemOverflow/Status::MemoryOverflow if PMem/DRAM exhausted
+  virtual Status ZSetCreate(StringView zset) = 0;
+
+  // Destroy a sorted set
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::NotFound if sorted set not exist
+  // Status::WrongType if collection existed but not a sorted set
+  virtual Status ZSetDestroy(StringView zset) = 0;
+
+  // Add "member" with "score" to "zset", or update its score if it's already
+  // a member
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::NotFound if sorted set not exist
+  // Status::WrongType if collection existed but not a sorted set
+  // Status::InvalidArgument if score is NaN
+  // Status::PMemOverflow/Status::MemoryOverflow if PMem/DRAM exhausted
+  virtual Status ZAdd(StringView zset, StringView member, double score) = 0;
+
+  // Add "increment" to score of "member" in "zset" atomically, a not existed
+  // member is added with score "increment". Store the new score in *new_score
+  // if it's not nullptr
+  //
+  // Return: same as ZAdd()
+  virtual Status ZIncrBy(StringView zset, StringView member, double increment,
+                         double* new_score = nullptr) = 0;
+
+  // Remove "member" from "zset"
+  //
+  // Return:
+  // Status::Ok on success or member not existed in sorted set
+  // Status::NotFound if sorted set not exist
+  // Status::WrongType if collection existed but not a sorted set
+  virtual Status ZRem(StringView zset, StringView member) = 0;
+
+  // Store score of "member" in *score
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::NotFound if sorted set or member not exist
+  // Status::WrongType if collection existed but not a sorted set
+  virtual Status ZScore(StringView zset, StringView member, double* score) = 0;
+
+  // Get number of members in "zset"
+  virtual Status ZCard(StringView zset, size_t* card) = 0;
+
+  // Store 0-based rank of "member" in ascending order of (score, member) to
+  // *rank
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::NotFound if sorted set or member not exist
+  // Status::WrongType if collection existed but not a sorted set
+  virtual Status ZRank(StringView zset, StringView member, size_t* rank) = 0;
+
+  // Store (member, score) of members with score in [min_score, max_score] to
+  // "members" in ascending order of (score, member), at most "limit" members
+  // are returned
+  virtual Status ZRangeByScore(
+      StringView zset, double min_score, double max_score,
+      std::vector<std::pair<std::string, double>>* members,
+      size_t limit = SIZE_MAX) = 0;
+
+  /// Stream APIs /////////////////////////////////////////////////////////////
+
+  // Create a empty stream. A stream is an append-only sequence of entries,
+  // each entry is addressed by an id assigned by the engine. Ids are
+  // monotonically increasing and derived from the engine timestamp
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::Existed if stream already existed
+  // Status::WrongType if collection existed but not a stream
+  // Status::PMemOverflow/Status::MemoryOverflow if PMem/DRAM exhausted
+  virtual Status StreamCreate(StringView stream) = 0;
+
+  // Destroy a stream
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::NotFound if stream not exist
+  // Status::WrongType if collection existed but not a stream
+  virtual Status StreamDestroy(StringView stream) = 0;
+
+  // Append "entry" to "stream", store its id in *id if it's not nullptr
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::NotFound if stream not exist
+  // Status::WrongType if collection existed but not a stream
+  // Status::PMemOverflow/Status::MemoryOverflow if PMem/DRAM exhausted
+  virtual Status XAdd(StringView stream, StringView entry,
+                      uint64_t* id = nullptr) = 0;
+
+  // Get number of entries in "stream"
+  virtual Status XLen(StringView stream, size_t* len) = 0;
+
+  // Store (id, entry) of entries with id in [start_id, end_id] to "entries"
+  // in ascending order of id, at most "count" entries are returned
+  virtual Status XRange(StringView stream, uint64_t start_id, uint64_t end_id,
+                        std::vector<std::pair<uint64_t, std::string>>* entries,
+                        size_t count = SIZE_MAX) = 0;
+
+  // Store at most "count" entries with id larger than "last_id" to "entries"
+  // in ascending order of id, pass id of the last returned entry as
+  // "last_id" to read following entries
+  virtual Status XRead(StringView stream, uint64_t last_id, size_t count,
+                       std::vector<std::pair<uint64_t, std::string>>* entries) = 0;
+
+  // Remove entries with id less than "min_id" from "stream". Entries are
+  // trimmed by whole intervals of the DRAM index (64 entries), so some
+  // entries less than "min_id" may be kept. Trimmed entries are freed one by
+  // one by background cleaner.
+  // Store number of removed entries in *trimmed if it's not nullptr
+  virtual Status XTrim(StringView stream, uint64_t min_id,
+                       size_t* trimmed = nullptr) = 0;
+
+  /// Time Series APIs ////////////////////////////////////////////////////////
+
+  // Create a empty time series. Samples are packed into buckets of
+  // "bucket_width" in unit of sample timestamps, each bucket is stored as a
+  // single record
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::Existed if time series already existed
+  // Status::WrongType if collection existed but not a time series
+  // Status::InvalidArgument if bucket_width is not positive
+  // Status::PMemOverflow/Status::MemoryOverflow if PMem/DRAM exhausted
+  virtual Status TSCreate(StringView series, int64_t bucket_width) = 0;
+
+  // Destroy a time series
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::NotFound if time series not exist
+  // Status::WrongType if collection existed but not a time series
+  virtual Status TSDestroy(StringView series) = 0;
+
+  // Append a sample to "series", overwrite value of an existing sample with
+  // same timestamp. A sample later than all samples of its bucket is
+  // appended to the bucket record in place, others rewrite the bucket
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::NotFound if time series not exist
+  // Status::WrongType if collection existed but not a time series
+  // Status::PMemOverflow/Status::MemoryOverflow if PMem/DRAM exhausted
+  virtual Status TSAppend(StringView series, int64_t timestamp,
+                          double value) = 0;
+
+  // Store (timestamp, value) of samples with timestamp in [start, end] to
+  // "samples" in ascending order of timestamp
+  virtual Status TSRange(StringView series, int64_t start, int64_t end,
+                         std::vector<std::pair<int64_t, double>>* samples) = 0;
+
+  // Aggregate samples with timestamp in [start, end] by windows of "window"
+  // starting at "start", store sum, min, max and count of each non-empty
+  // window to "aggregates" in ascending order of window
+  //
+  // Return:
+  // Status::Ok on success
+  // Status::NotFound if time series not exist
+  // Status::WrongType if collection existed but not a time series
+  // Status::InvalidArgument if window is not positive
+  virtual Status TSAggregate(StringView series, int64_t start, int64_t end,
+                             int64_t window,
+                             std::vector<TimeSeriesAggregate>* aggregates) = 0;
+
   /// Other ///////////////////////////////////////////////////////////////////
 
   // Get a snapshot of the instance at this moment.
@@ -486,6 +772,7 @@ class Engine {
   // 1. You can maintain multiple snapshot but only the last checkpoint.
   // 2. Please release the snapshot as soon as it is not needed, as it will
   // forbid newer data being freed
+  // 3. Return nullptr if lazy recovery failed
   virtual Snapshot* GetSnapshot(bool make_checkpoint) = 0;
 
   // Make a backup on "snapshot" to "backup_log"
@@ -495,6 +782,47 @@ class Engine {
   // Release a snapshot of the instance
   virtual void ReleaseSnapshot(const Snapshot*) = 0;
 
+  // Get progress of the recovery in Open(), this is mostly useful with lazy
+  // recovery
+  virtual RecoveryStats GetRecoveryStats() = 0;
+
+  // Make all writes that returned before durable, which only matters with
+  // Configs::relaxed_durability.
+  //
+  // Notice: do not call it in a ModifyFunc
+  virtual Status Flush() = 0;
+
+  // Get runtime statistics of the instance. Operation latencies are only
+  // collected while enabled by Configs::enable_statistics or
+  // EnableStatistics(), other fields are always filled
+  virtual Statistics GetStatistics() = 0;
+
+  // Start or stop collecting operation latencies, collected ones are kept
+  virtual void EnableStatistics(bool enable) = 0;
+
+  // Trace 1 in "interval" write operations of each thread, 0 to stop
+  // tracing, see Configs::trace_sample_interval
+  virtual void SetTraceSampleInterval(uint64_t interval) = 0;
+
+  // Write the latest traced operations and their stages to file "path" in
+  // Chrome trace event format, which can be opened by chrome://tracing or
+  // Perfetto UI
+  virtual Status DumpTrace(const std::string& path) = 0;
+
+  // Get the hottest "k" keys of reads and writes, and the "k" hash table
+  // slots with the most lock contentions, which are sampled since
+  // Configs::hot_key_sample_interval or SetHotKeySampleInterval() enabled
+  // detection, or since the last ResetHotKeys(). At most 128 keys of each
+  // kind are tracked
+  virtual HotKeys GetHotKeys(uint32_t k) = 0;
+
+  // Sample 1 in "interval" key accesses of each thread to detect hot keys,
+  // 0 to stop detection. Sampled keys are kept
+  virtual void SetHotKeySampleInterval(uint64_t interval) = 0;
+
+  // Forget sampled hot keys and contentions
+  virtual void ResetHotKeys() = 0;
+
   // Create a KV iterator on sorted collection "collection", which is able to
   // sequentially iterate all KVs in the "collection".
   //
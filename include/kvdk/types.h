@@ -13,6 +13,20 @@
 #define KVDK_LIST_FRONT 0
 #define KVDK_LIST_BACK 1
 
+#define KVDK_ASYNC_STRING_GET 0
+#define KVDK_ASYNC_STRING_PUT 1
+#define KVDK_ASYNC_STRING_DELETE 2
+#define KVDK_ASYNC_SORTED_GET 3
+#define KVDK_ASYNC_SORTED_PUT 4
+#define KVDK_ASYNC_SORTED_DELETE 5
+#define KVDK_ASYNC_HASH_GET 6
+#define KVDK_ASYNC_HASH_PUT 7
+#define KVDK_ASYNC_HASH_DELETE 8
+#define KVDK_ASYNC_LIST_PUSH_FRONT 9
+#define KVDK_ASYNC_LIST_PUSH_BACK 10
+#define KVDK_ASYNC_LIST_POP_FRONT 11
+#define KVDK_ASYNC_LIST_POP_BACK 12
+
 // Customized modify function used in KVDKModify, indicate how to modify
 // existing value
 //
@@ -38,6 +52,16 @@ typedef int (*KVDKModifyFunc)(const char* old_val, size_t old_val_len,
 // Used in KVDKModify, indicate how to free allocated space in KVDKModifyFunc
 typedef void (*KVDKFreeFunc)(void*);
 
+// Used in KVDKGetChunks.
+//
+// *(input) chunk: a chunk of the value, it's only valid in the call
+// *(input) chunk_len: length of "chunk"
+// * args: customer args
+//
+// return 0 to stop reading following chunks
+typedef int (*KVDKValueChunkFunc)(const char* chunk, size_t chunk_len,
+                                  void* args);
+
 #define GENERATE_ENUM(ENUM) ENUM,
 #define GENERATE_STRING(STRING) #STRING,
 
@@ -45,7 +69,11 @@ typedef void (*KVDKFreeFunc)(void*);
   GEN(String)           \
   GEN(SortedCollection) \
   GEN(HashCollection)   \
-  GEN(List)
+  GEN(List)             \
+  GEN(Set)              \
+  GEN(ZSet)             \
+  GEN(Stream)           \
+  GEN(TimeSeries)
 
 typedef enum { KVDK_TYPES(GENERATE_ENUM) } KVDKValueType;
 
@@ -77,3 +105,30 @@ typedef enum { KVDK_STATUS(GENERATE_ENUM) } KVDKStatus;
 
 __attribute__((unused)) static char const* KVDKStatusStrings[] = {
     KVDK_STATUS(GENERATE_STRING)};
+
+// Operations timed by statistics of an instance, push and pop ops of lists
+// are counted as ListPush and ListPop
+#define KVDK_STAT_OPS(GEN) \
+  GEN(Get)                 \
+  GEN(Put)                 \
+  GEN(Delete)              \
+  GEN(Expire)              \
+  GEN(Modify)              \
+  GEN(BatchWrite)          \
+  GEN(SortedGet)           \
+  GEN(SortedPut)           \
+  GEN(SortedDelete)        \
+  GEN(HashGet)             \
+  GEN(HashPut)             \
+  GEN(HashDelete)          \
+  GEN(ListPush)            \
+  GEN(ListPop)
+
+#define GENERATE_STAT_OP_ENUM(OP) KVDKStatOp##OP,
+
+typedef enum {
+  KVDK_STAT_OPS(GENERATE_STAT_OP_ENUM) KVDKStatOpNum
+} KVDKStatOp;
+
+__attribute__((unused)) static char const* KVDKStatOpStrings[] = {
+    KVDK_STAT_OPS(GENERATE_STRING)};
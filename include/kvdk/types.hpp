@@ -3,6 +3,7 @@
 #include <cinttypes>
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "libpmemobj++/string_view.hpp"
 #include "types.h"
@@ -52,6 +53,117 @@ enum class ModifyOperation : int {
 using ModifyFunc = std::function<ModifyOperation(
     const std::string* old_value, std::string* new_value, void* args)>;
 
+// Used in Engine::GetChunks().
+//
+// *(input) chunk: a chunk of the value, it points to PMem directly and is
+// only valid in the call
+// * args: customer args
+//
+// return false to stop reading following chunks
+using ValueChunkFunc = std::function<bool(const StringView& chunk, void* args)>;
+
+// Progress of recovering an existing instance, see Engine::GetRecoveryStats()
+struct RecoveryStats {
+  // All data is restored and accessible
+  bool finished = false;
+  // Data segments are all restored, collections may be still rebuilding
+  bool segments_restored = false;
+  std::uint64_t restored_segments = 0;
+  std::uint64_t restored_records = 0;
+  // Estimated number of data segments to restore
+  std::uint64_t total_segments = 0;
+  // Time spent on restoring data segments
+  double elapsed_seconds = 0;
+  double segments_per_second = 0;
+  double records_per_second = 0;
+  // Estimated time to finish restoring data segments
+  double eta_seconds = 0;
+};
+
+using StatOp = KVDKStatOp;
+
+// Latencies of an operation type, see Engine::GetStatistics()
+struct OpStatistics {
+  std::uint64_t count = 0;
+  // Latencies in nanoseconds, percentiles are accurate to 1/8 of their
+  // magnitude
+  double avg_ns = 0;
+  std::uint64_t p50_ns = 0;
+  std::uint64_t p99_ns = 0;
+  std::uint64_t p999_ns = 0;
+  std::uint64_t max_ns = 0;
+};
+
+// Runtime statistics of an instance, see Engine::GetStatistics()
+struct Statistics {
+  // Operations are timed, see Engine::EnableStatistics()
+  bool enabled = false;
+  // Indexed by StatOp, counted only while enabled
+  OpStatistics ops[KVDKStatOpNum];
+
+  // PMem allocator
+  std::uint64_t pmem_capacity_bytes = 0;
+  std::uint64_t pmem_usage_bytes = 0;
+  // Space of PMem segments ever handed out to threads and extents
+  std::uint64_t pmem_segment_bytes = 0;
+
+  // Background cleaner
+  std::uint64_t cleaner_workers = 0;
+  std::uint64_t cleaner_scanned_slots = 0;
+  std::uint64_t cleaner_purged_records = 0;
+  std::uint64_t cleaner_destroyed_collections = 0;
+
+  // Hash table, estimated by sampling buckets. A chain is a hash bucket
+  // and the overflow buckets linked to it
+  std::uint64_t hash_buckets = 0;
+  double hash_load_factor = 0;
+  double hash_avg_chain_length = 0;
+  std::uint64_t hash_max_chain_length = 0;
+
+  RecoveryStats recovery;
+};
+
+// A key frequently accessed, see Engine::GetHotKeys()
+struct HotKey {
+  std::string key;
+  // Estimated number of sampled accesses, which never underestimates
+  std::uint64_t count = 0;
+};
+
+// A hash table slot whose lock is frequently contended
+struct ContendedSlot {
+  std::uint64_t slot = 0;
+  std::uint64_t contentions = 0;
+};
+
+// Hot keys and lock contentions sampled since enabled or last reset, see
+// Engine::GetHotKeys()
+struct HotKeys {
+  // Sorted from the hottest. Keys of collection elements are internal keys,
+  // which are prefixed by 8 bytes collection id. Lookups of keys for writing
+  // them under their locks, including deletes and background cleaning, are
+  // writes and sampled once per key and write, other lookups are reads
+  std::vector<HotKey> reads;
+  std::vector<HotKey> writes;
+  // Sorted from the most contended
+  std::vector<ContendedSlot> contended_slots;
+  // Slot lock acquisitions that found the lock held
+  std::uint64_t contentions = 0;
+  // A sampled count stands for "sample_interval" accesses
+  std::uint64_t sample_interval = 0;
+};
+
+// Aggregation of samples in a window of a time series, see
+// Engine::TSAggregate()
+struct TimeSeriesAggregate {
+  // Start timestamp of the window
+  std::int64_t window_start = 0;
+  std::uint64_t count = 0;
+  double sum = 0;
+  double min = 0;
+  double max = 0;
+};
+
 constexpr ExpireTimeType kPersistTime = INT64_MAX;
 constexpr TTLType kPersistTTL = INT64_MAX;
 constexpr TTLType kInvalidTTL = 0;
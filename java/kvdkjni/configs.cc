@@ -103,6 +103,18 @@ void Java_io_pmem_kvdk_Configs_setCleanThreads(JNIEnv*, jobject, jlong handle,
       num_threds;
 }
 
+/*
+ * Class:     io_pmem_kvdk_Configs
+ * Method:    setEnableStatistics
+ * Signature: (JZ)V
+ */
+void Java_io_pmem_kvdk_Configs_setEnableStatistics(JNIEnv*, jobject,
+                                                   jlong handle,
+                                                   jboolean enable) {
+  reinterpret_cast<KVDK_NAMESPACE::Configs*>(handle)->enable_statistics =
+      enable;
+}
+
 /*
  * Class:     io_pmem_kvdk_Configs
  * Method:    closeInternal
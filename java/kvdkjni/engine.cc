@@ -3,6 +3,9 @@
  */
 
 #include <assert.h>
+#include <string.h>
+
+#include <vector>
 
 #include "include/io_pmem_kvdk_Engine.h"
 #include "kvdkjni/kvdkjni.h"
@@ -436,3 +439,72 @@ void Java_io_pmem_kvdk_Engine_batchWrite(JNIEnv* env, jobject,
     KVDK_NAMESPACE::KVDKExceptionJni::ThrowNew(env, s);
   }
 }
+
+/*
+ * Class:     io_pmem_kvdk_Engine
+ * Method:    getStatistics
+ * Signature: (J)[J
+ */
+jlongArray Java_io_pmem_kvdk_Engine_getStatistics(JNIEnv* env, jobject,
+                                                  jlong handle) {
+  auto* engine = reinterpret_cast<KVDK_NAMESPACE::Engine*>(handle);
+  KVDK_NAMESPACE::Statistics stats = engine->GetStatistics();
+
+  // Flattened in the order parsed by io.pmem.kvdk.Statistics, doubles are
+  // passed by their bits
+  std::vector<jlong> values;
+  values.push_back(stats.enabled);
+  for (const auto& op : stats.ops) {
+    values.push_back(op.count);
+    values.push_back(static_cast<jlong>(op.avg_ns));
+    values.push_back(op.p50_ns);
+    values.push_back(op.p99_ns);
+    values.push_back(op.p999_ns);
+    values.push_back(op.max_ns);
+  }
+  values.push_back(stats.pmem_capacity_bytes);
+  values.push_back(stats.pmem_usage_bytes);
+  values.push_back(stats.pmem_segment_bytes);
+  values.push_back(stats.cleaner_workers);
+  values.push_back(stats.cleaner_scanned_slots);
+  values.push_back(stats.cleaner_purged_records);
+  values.push_back(stats.cleaner_destroyed_collections);
+  values.push_back(stats.hash_buckets);
+  jlong bits;
+  memcpy(&bits, &stats.hash_load_factor, sizeof(bits));
+  values.push_back(bits);
+  memcpy(&bits, &stats.hash_avg_chain_length, sizeof(bits));
+  values.push_back(bits);
+  values.push_back(stats.hash_max_chain_length);
+  const auto& recovery = stats.recovery;
+  values.push_back(recovery.finished);
+  values.push_back(recovery.segments_restored);
+  values.push_back(recovery.restored_segments);
+  values.push_back(recovery.restored_records);
+  values.push_back(recovery.total_segments);
+  for (double v :
+       {recovery.elapsed_seconds, recovery.segments_per_second,
+        recovery.records_per_second, recovery.eta_seconds}) {
+    memcpy(&bits, &v, sizeof(bits));
+    values.push_back(bits);
+  }
+
+  jlongArray ret = env->NewLongArray(values.size());
+  if (ret == nullptr) {
+    // exception thrown: OutOfMemoryError
+    return nullptr;
+  }
+  env->SetLongArrayRegion(ret, 0, values.size(), values.data());
+  return ret;
+}
+
+/*
+ * Class:     io_pmem_kvdk_Engine
+ * Method:    enableStatistics
+ * Signature: (JZ)V
+ */
+void Java_io_pmem_kvdk_Engine_enableStatistics(JNIEnv*, jobject, jlong handle,
+                                               jboolean enable) {
+  auto* engine = reinterpret_cast<KVDK_NAMESPACE::Engine*>(handle);
+  engine->EnableStatistics(enable);
+}
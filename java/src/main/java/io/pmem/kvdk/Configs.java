@@ -59,6 +59,11 @@ public class Configs extends KVDKObject {
         return this;
     }
 
+    public Configs setEnableStatistics(final boolean enable) {
+        setEnableStatistics(nativeHandle_, enable);
+        return this;
+    }
+
     // Native methods
     private static native long newConfigs();
 
@@ -78,6 +83,8 @@ public class Configs extends KVDKObject {
 
     private native void setCleanThreads(long handle, long num);
 
+    private native void setEnableStatistics(long handle, boolean enable);
+
     @Override
     protected final native void closeInternal(long handle);
 }
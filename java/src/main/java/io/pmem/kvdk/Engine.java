@@ -278,6 +278,19 @@ public class Engine extends KVDKObject {
         batchWrite(nativeHandle_, batch.getNativeHandle());
     }
 
+    /**
+     * Get runtime statistics of the engine. Operation latencies are only collected while enabled
+     * by {@link Configs#setEnableStatistics} or {@link #enableStatistics}.
+     */
+    public Statistics getStatistics() {
+        return new Statistics(getStatistics(nativeHandle_));
+    }
+
+    /** Start or stop collecting operation latencies, collected ones are kept. */
+    public void enableStatistics(boolean enable) {
+        enableStatistics(nativeHandle_, enable);
+    }
+
     // Native methods
     @Override
     protected final native void closeInternal(long handle);
@@ -343,6 +356,10 @@ public class Engine extends KVDKObject {
 
     private native void batchWrite(long engineHandle, long batchHandle);
 
+    private native long[] getStatistics(long engineHandle);
+
+    private native void enableStatistics(long engineHandle, boolean enable);
+
     private enum LibraryState {
         NOT_LOADED,
         LOADING,
@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+package io.pmem.kvdk;
+
+/** Runtime statistics of an engine, see kvdk::Statistics for meanings of the fields. */
+public class Statistics {
+    /** Operations timed by statistics, in the order of KVDK_STAT_OPS in types.h */
+    public enum Op {
+        GET,
+        PUT,
+        DELETE,
+        EXPIRE,
+        MODIFY,
+        BATCH_WRITE,
+        SORTED_GET,
+        SORTED_PUT,
+        SORTED_DELETE,
+        HASH_GET,
+        HASH_PUT,
+        HASH_DELETE,
+        LIST_PUSH,
+        LIST_POP
+    }
+
+    /** Latencies of an operation type in nanoseconds. */
+    public static class OpStatistics {
+        public final long count;
+        public final long avgNanos;
+        public final long p50Nanos;
+        public final long p99Nanos;
+        public final long p999Nanos;
+        public final long maxNanos;
+
+        private OpStatistics(long[] values, int offset) {
+            count = values[offset];
+            avgNanos = values[offset + 1];
+            p50Nanos = values[offset + 2];
+            p99Nanos = values[offset + 3];
+            p999Nanos = values[offset + 4];
+            maxNanos = values[offset + 5];
+        }
+    }
+
+    private static final int OP_FIELDS = 6;
+
+    /** Progress of lazy recovery, see kvdk::RecoveryStats. */
+    public static class RecoveryStatistics {
+        public final boolean finished;
+        public final boolean segmentsRestored;
+        public final long restoredSegments;
+        public final long restoredRecords;
+        public final long totalSegments;
+        public final double elapsedSeconds;
+        public final double segmentsPerSecond;
+        public final double recordsPerSecond;
+        public final double etaSeconds;
+
+        private RecoveryStatistics(long[] values, int offset) {
+            finished = values[offset] != 0;
+            segmentsRestored = values[offset + 1] != 0;
+            restoredSegments = values[offset + 2];
+            restoredRecords = values[offset + 3];
+            totalSegments = values[offset + 4];
+            elapsedSeconds = Double.longBitsToDouble(values[offset + 5]);
+            segmentsPerSecond = Double.longBitsToDouble(values[offset + 6]);
+            recordsPerSecond = Double.longBitsToDouble(values[offset + 7]);
+            etaSeconds = Double.longBitsToDouble(values[offset + 8]);
+        }
+    }
+
+    public final boolean enabled;
+    private final OpStatistics[] ops;
+    public final long pmemCapacityBytes;
+    public final long pmemUsageBytes;
+    public final long pmemSegmentBytes;
+    public final long cleanerWorkers;
+    public final long cleanerScannedSlots;
+    public final long cleanerPurgedRecords;
+    public final long cleanerDestroyedCollections;
+    public final long hashBuckets;
+    public final double hashLoadFactor;
+    public final double hashAvgChainLength;
+    public final long hashMaxChainLength;
+    public final RecoveryStatistics recovery;
+
+    /** Parse statistics flattened by the native getStatistics(). */
+    Statistics(long[] values) {
+        int i = 0;
+        enabled = values[i++] != 0;
+        ops = new OpStatistics[Op.values().length];
+        for (int op = 0; op < ops.length; op++) {
+            ops[op] = new OpStatistics(values, i);
+            i += OP_FIELDS;
+        }
+        pmemCapacityBytes = values[i++];
+        pmemUsageBytes = values[i++];
+        pmemSegmentBytes = values[i++];
+        cleanerWorkers = values[i++];
+        cleanerScannedSlots = values[i++];
+        cleanerPurgedRecords = values[i++];
+        cleanerDestroyedCollections = values[i++];
+        hashBuckets = values[i++];
+        hashLoadFactor = Double.longBitsToDouble(values[i++]);
+        hashAvgChainLength = Double.longBitsToDouble(values[i++]);
+        hashMaxChainLength = values[i++];
+        recovery = new RecoveryStatistics(values, i);
+    }
+
+    public OpStatistics getOpStatistics(Op op) {
+        return ops[op.ordinal()];
+    }
+}
@@ -5,6 +5,8 @@
 package io.pmem.kvdk;
 
 import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertTrue;
 
 import io.pmem.kvdk.Status.Code;
 import org.junit.Test;
@@ -151,4 +153,22 @@ public class EngineTest extends EngineTestBase {
         // check
         assertEquals(null, kvdkEngine.get(key1.getBytes()));
     }
+
+    @Test
+    public void testStatistics() throws KVDKException {
+        assertFalse(kvdkEngine.getStatistics().enabled);
+
+        kvdkEngine.enableStatistics(true);
+        kvdkEngine.put("key".getBytes(), "value".getBytes());
+        kvdkEngine.get("key".getBytes());
+        kvdkEngine.get("key".getBytes());
+
+        Statistics stats = kvdkEngine.getStatistics();
+        assertTrue(stats.enabled);
+        assertEquals(1, stats.getOpStatistics(Statistics.Op.PUT).count);
+        assertEquals(2, stats.getOpStatistics(Statistics.Op.GET).count);
+        assertTrue(stats.pmemUsageBytes > 0);
+        assertEquals(1L << 10, stats.hashBuckets);
+        assertTrue(stats.recovery.restoredSegments <= stats.recovery.totalSegments);
+    }
 }
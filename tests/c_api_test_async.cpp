@@ -0,0 +1,121 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "c_api_test.hpp"
+
+static void CountCompletion(KVDKAsyncCompletion const* completion,
+                            void* args) {
+  if (completion->status == KVDKStatus::Ok) {
+    static_cast<std::atomic<size_t>*>(args)->fetch_add(1);
+  }
+}
+
+TEST_F(EngineCAPITestBase, Async) {
+  size_t count = 1000;
+  size_t queue_depth = 64;
+  std::string collection{"AsyncHash"};
+  ASSERT_EQ(KVDKHashCreate(engine, collection.data(), collection.size()),
+            KVDKStatus::Ok);
+
+  auto key_of = [](size_t i) { return "async_key" + std::to_string(i); };
+
+  // Completions are polled
+  KVDKAsyncQueue* queue =
+      KVDKAsyncQueueCreate(engine, queue_depth, nullptr, nullptr);
+  ASSERT_NE(queue, nullptr);
+  std::vector<KVDKAsyncCompletion> completions(queue_depth);
+  size_t completed = 0;
+  auto submit = [&]() {
+    KVDKStatus s;
+    while ((s = KVDKAsyncQueueSubmit(queue)) == KVDKStatus::Abort) {
+      size_t cnt =
+          KVDKAsyncQueuePoll(queue, completions.data(), queue_depth, 10);
+      for (size_t j = 0; j < cnt; j++) {
+        ASSERT_EQ(completions[j].status, KVDKStatus::Ok);
+        // Puts return no value
+        ASSERT_EQ(completions[j].val, nullptr);
+      }
+      completed += cnt;
+    }
+    ASSERT_EQ(s, KVDKStatus::Ok);
+  };
+
+  // A batch larger than queue depth is rejected until discarded
+  std::string oversize{"oversize"};
+  for (size_t i = 0; i <= queue_depth; i++) {
+    KVDKAsyncQueueAdd(queue, KVDK_ASYNC_STRING_PUT, nullptr, 0,
+                      oversize.data(), oversize.size(), oversize.data(),
+                      oversize.size(), i);
+  }
+  ASSERT_EQ(KVDKAsyncQueueSubmit(queue), KVDKStatus::InvalidBatchSize);
+  ASSERT_EQ(KVDKAsyncQueueDiscard(queue), queue_depth + 1);
+  ASSERT_EQ(KVDKAsyncQueueSubmit(queue), KVDKStatus::Ok);
+  ASSERT_EQ(KVDKAsyncQueueInFlight(queue), 0);
+
+  for (size_t i = 0; i < count; i++) {
+    std::string key = key_of(i);
+    KVDKAsyncQueueAdd(queue, KVDK_ASYNC_STRING_PUT, nullptr, 0, key.data(),
+                      key.size(), key.data(), key.size(), i);
+    KVDKAsyncQueueAdd(queue, KVDK_ASYNC_HASH_PUT, collection.data(),
+                      collection.size(), key.data(), key.size(), key.data(),
+                      key.size(), i);
+    submit();
+  }
+  while (completed < count * 2) {
+    size_t cnt = KVDKAsyncQueuePoll(queue, completions.data(), queue_depth, 10);
+    for (size_t j = 0; j < cnt; j++) {
+      ASSERT_EQ(completions[j].status, KVDKStatus::Ok);
+      ASSERT_EQ(completions[j].val, nullptr);
+    }
+    completed += cnt;
+  }
+  ASSERT_EQ(KVDKAsyncQueueInFlight(queue), 0);
+
+  for (size_t i = 0; i < count; i++) {
+    std::string key = key_of(i);
+    KVDKAsyncQueueAdd(queue, KVDK_ASYNC_HASH_GET, collection.data(),
+                      collection.size(), key.data(), key.size(), nullptr, 0,
+                      i);
+    KVDKStatus s;
+    while ((s = KVDKAsyncQueueSubmit(queue)) == KVDKStatus::Abort) {
+      size_t cnt =
+          KVDKAsyncQueuePoll(queue, completions.data(), queue_depth, 10);
+      for (size_t j = 0; j < cnt; j++) {
+        ASSERT_EQ(completions[j].status, KVDKStatus::Ok);
+        ASSERT_EQ(completions[j].op_type, KVDK_ASYNC_HASH_GET);
+        ASSERT_EQ(std::string(completions[j].val, completions[j].val_len),
+                  key_of(completions[j].user_data));
+        free(completions[j].val);
+      }
+    }
+    ASSERT_EQ(s, KVDKStatus::Ok);
+  }
+  KVDKAsyncQueueDestroy(queue);
+
+  // Completions are passed to callback
+  std::atomic<size_t> deleted{0};
+  queue = KVDKAsyncQueueCreate(engine, queue_depth, CountCompletion, &deleted);
+  ASSERT_NE(queue, nullptr);
+  for (size_t i = 0; i < count; i++) {
+    std::string key = key_of(i);
+    KVDKAsyncQueueAdd(queue, KVDK_ASYNC_STRING_DELETE, nullptr, 0, key.data(),
+                      key.size(), nullptr, 0, i);
+    while (KVDKAsyncQueueSubmit(queue) == KVDKStatus::Abort) {
+    }
+  }
+  KVDKAsyncQueueDestroy(queue);
+  ASSERT_EQ(deleted.load(), count);
+  for (size_t i = 0; i < count; i++) {
+    std::string key = key_of(i);
+    char* val;
+    size_t val_len;
+    ASSERT_EQ(KVDKGet(engine, key.data(), key.size(), &val_len, &val),
+              KVDKStatus::NotFound);
+  }
+}
@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2021-2022 Intel Corporation
+ */
+
+#include <string>
+#include <vector>
+
+#include "../engine/coro/lookup_coro.hpp"
+#include "gtest/gtest.h"
+#include "kvdk/engine.hpp"
+#include "test_util.h"
+
+using namespace KVDK_NAMESPACE;
+
+class CoroLookupTest : public testing::Test {
+ protected:
+  Engine* engine = nullptr;
+  Configs configs;
+  const std::string db_path{"/mnt/pmem0/kvdk_coro_test"};
+
+  virtual void SetUp() override {
+    purgeDB();
+    configs.log_level = LogLevel::Error;
+    configs.pmem_file_size = (4ULL << 30);
+    configs.populate_pmem_space = false;
+    configs.hash_bucket_num = (1 << 10);
+    configs.pmem_segment_blocks = 8 * 1024;
+    configs.max_access_threads = 8;
+    ASSERT_EQ(Engine::Open(db_path, &engine, configs, stdout), Status::Ok);
+  }
+
+  virtual void TearDown() override {
+    delete engine;
+    purgeDB();
+  }
+
+ private:
+  void purgeDB() {
+    std::string cmd = "rm -rf " + db_path + "\n";
+    [[gnu::unused]] int _sink = system(cmd.c_str());
+  }
+};
+
+TEST_F(CoroLookupTest, InterleavedLookups) {
+  size_t count = 2000;
+  std::string hash_collection{"CoroHash"};
+  std::string sorted_collection{"CoroSorted"};
+  std::string unindexed_collection{"CoroSortedNoHashIndex"};
+  SortedCollectionConfigs no_hash_index;
+  no_hash_index.index_with_hashtable = false;
+  ASSERT_EQ(engine->HashCreate(hash_collection), Status::Ok);
+  ASSERT_EQ(engine->SortedCreate(sorted_collection), Status::Ok);
+  ASSERT_EQ(engine->SortedCreate(unindexed_collection, no_hash_index),
+            Status::Ok);
+
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < count; i++) {
+    keys.push_back("coro_key" + std::to_string(i));
+    // Every third key is missing
+    if (i % 3 == 0) {
+      continue;
+    }
+    ASSERT_EQ(engine->Put(keys[i], keys[i] + "_string"), Status::Ok);
+    ASSERT_EQ(engine->HashPut(hash_collection, keys[i], keys[i] + "_hash"),
+              Status::Ok);
+    ASSERT_EQ(
+        engine->SortedPut(sorted_collection, keys[i], keys[i] + "_sorted"),
+        Status::Ok);
+    ASSERT_EQ(
+        engine->SortedPut(unindexed_collection, keys[i], keys[i] + "_sorted"),
+        Status::Ok);
+  }
+
+  for (size_t in_flight : {1, 8, 16}) {
+    InterleavedLookup lookup(engine, in_flight);
+    std::vector<std::string> values(count * 4);
+    std::vector<Status> status(count * 4, Status::Fail);
+    for (size_t i = 0; i < count; i++) {
+      lookup.Get(keys[i], &values[i * 4], &status[i * 4]);
+      lookup.HashGet(hash_collection, keys[i], &values[i * 4 + 1],
+                     &status[i * 4 + 1]);
+      lookup.SortedGet(sorted_collection, keys[i], &values[i * 4 + 2],
+                       &status[i * 4 + 2]);
+      lookup.SortedGet(unindexed_collection, keys[i], &values[i * 4 + 3],
+                       &status[i * 4 + 3]);
+    }
+    lookup.Run();
+    for (size_t i = 0; i < count; i++) {
+      if (i % 3 == 0) {
+        for (size_t j = 0; j < 4; j++) {
+          ASSERT_EQ(status[i * 4 + j], Status::NotFound);
+        }
+      } else {
+        for (size_t j = 0; j < 4; j++) {
+          ASSERT_EQ(status[i * 4 + j], Status::Ok);
+        }
+        ASSERT_EQ(values[i * 4], keys[i] + "_string");
+        ASSERT_EQ(values[i * 4 + 1], keys[i] + "_hash");
+        ASSERT_EQ(values[i * 4 + 2], keys[i] + "_sorted");
+        ASSERT_EQ(values[i * 4 + 3], keys[i] + "_sorted");
+      }
+    }
+  }
+
+  // Lookups on missing collection
+  InterleavedLookup lookup(engine);
+  std::string value;
+  Status s = Status::Ok;
+  lookup.HashGet("NotExistedHash", keys[1], &value, &s);
+  lookup.Run();
+  ASSERT_EQ(s, Status::NotFound);
+
+  std::vector<StringView> key_views(keys.begin(), keys.end());
+  std::vector<std::string> values;
+  std::vector<Status> status;
+  MultiGet(engine, key_views, &values, &status);
+  ASSERT_EQ(values.size(), count);
+  for (size_t i = 0; i < count; i++) {
+    if (i % 3 == 0) {
+      ASSERT_EQ(status[i], Status::NotFound);
+    } else {
+      ASSERT_EQ(status[i], Status::Ok);
+      ASSERT_EQ(values[i], keys[i] + "_string");
+    }
+  }
+}
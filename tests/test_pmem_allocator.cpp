@@ -199,4 +199,37 @@ TEST_F(EnginePMemAllocatorTest, TestPMemAllocFreeList) {
   records.push_back(pmem_alloc->Allocate(1024ULL));
   ASSERT_EQ(pmem_alloc->PMemUsageInBytes(), pmem_size);
   delete pmem_alloc;
-}
\ No newline at end of file
+}
+
+TEST_F(EnginePMemAllocatorTest, TestXPLineAlignment) {
+  uint32_t num_thread = 1;
+  uint64_t num_segment_block = 1024;
+  uint64_t block_size = 64;
+  uint64_t pmem_size = num_segment_block * block_size * 16;
+  PMEMAllocator* pmem_alloc = PMEMAllocator::NewPMEMAllocator(
+      pmem_path, pmem_size, num_segment_block, block_size, num_thread, true,
+      false, nullptr);
+  ASSERT_NE(pmem_alloc, nullptr);
+  ASSERT_TRUE(pmem_alloc->EnableXPLineAlignment());
+
+  // Allocate records of various sizes in the first segment, a record spans
+  // no more XPLines than its size requires
+  std::vector<uint64_t> alloc_size{24, 100, 200, 64, 300, 130, 520, 250};
+  uint64_t allocated = 0;
+  for (size_t i = 0; allocated + 2 * kXPLineSize < pmem_alloc->SegmentSize();
+       i++) {
+    SpaceEntry space_entry =
+        pmem_alloc->Allocate(alloc_size[i % alloc_size.size()]);
+    ASSERT_NE(space_entry.size, 0);
+    uint64_t lines = (space_entry.size + kXPLineSize - 1) / kXPLineSize;
+    uint64_t first_line = space_entry.offset / kXPLineSize;
+    uint64_t last_line =
+        (space_entry.offset + space_entry.size - 1) / kXPLineSize;
+    ASSERT_EQ(last_line - first_line + 1, lines);
+    allocated = space_entry.offset + space_entry.size;
+  }
+
+  // Paddings are counted as freed space
+  ASSERT_LT((uint64_t)pmem_alloc->PMemUsageInBytes(), allocated);
+  delete pmem_alloc;
+}
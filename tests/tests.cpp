@@ -4,8 +4,13 @@
 
 #include <gflags/gflags.h>
 #include <gtest/gtest.h>
+#include <sys/wait.h>
 
+#include <condition_variable>
+#include <deque>
+#include <fstream>
 #include <future>
+#include <set>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -121,6 +126,8 @@ class EngineBasicTest : public testing::Test {
     switch (config_option_) {
       case OptRestore:
         configs.opt_large_sorted_collection_recovery = true;
+        configs.opt_large_hash_collection_recovery = true;
+        configs.opt_large_list_recovery = true;
         break;
       default:
         break;
@@ -1224,6 +1231,523 @@ TEST_F(EngineBasicTest, TestStringRestore) {
   delete engine;
 }
 
+TEST_F(EngineBasicTest, TestLazyRecovery) {
+  size_t num_threads = 8;
+  size_t count = 500;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string sorted_collection{"LazySorted"};
+  std::string hash_collection{"LazyHash"};
+  std::string list_collection{"LazyList"};
+  ASSERT_EQ(
+      engine->SortedCreate(sorted_collection, SortedCollectionConfigs()),
+      Status::Ok);
+  ASSERT_EQ(engine->HashCreate(hash_collection), Status::Ok);
+  ASSERT_EQ(engine->ListCreate(list_collection), Status::Ok);
+
+  auto Write = [&](uint32_t id) {
+    for (size_t i = 0; i < count; i++) {
+      std::string key{std::to_string(id) + "_" + std::to_string(i)};
+      ASSERT_EQ(engine->Put(key, key), Status::Ok);
+      ASSERT_EQ(engine->SortedPut(sorted_collection, key, key), Status::Ok);
+      ASSERT_EQ(engine->HashPut(hash_collection, key, key), Status::Ok);
+      ASSERT_EQ(engine->ListPushBack(list_collection, key), Status::Ok);
+    }
+  };
+  LaunchNThreads(num_threads, Write);
+  delete engine;
+
+  // Access collections in reverse order of default rebuild order
+  auto Check = [&](uint32_t id) {
+    std::string got;
+    for (size_t i = 0; i < count; i++) {
+      std::string key{std::to_string(id) + "_" + std::to_string(i)};
+      ASSERT_EQ(engine->HashGet(hash_collection, key, &got), Status::Ok);
+      ASSERT_EQ(got, key);
+      ASSERT_EQ(engine->Get(key, &got), Status::Ok);
+      ASSERT_EQ(got, key);
+      ASSERT_EQ(engine->SortedGet(sorted_collection, key, &got), Status::Ok);
+      ASSERT_EQ(got, key);
+    }
+    size_t list_size;
+    ASSERT_EQ(engine->ListSize(list_collection, &list_size), Status::Ok);
+    ASSERT_EQ(list_size, num_threads * count);
+  };
+
+  configs.lazy_recovery = true;
+  for (int i = 0; i < 2; i++) {
+    ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+              Status::Ok);
+    LaunchNThreads(num_threads, Check);
+    // Write new data while recovery may still be running
+    ASSERT_EQ(engine->Put("new_key", "new_value"), Status::Ok);
+    ASSERT_EQ(engine->HashCreate("LazyHashNew"), Status::Ok);
+    ASSERT_EQ(engine->HashPut("LazyHashNew", "field", "value"), Status::Ok);
+    std::string got;
+    ASSERT_EQ(engine->HashGet("LazyHashNew", "field", &got), Status::Ok);
+    ASSERT_EQ(got, "value");
+    ASSERT_EQ(engine->HashDestroy("LazyHashNew"), Status::Ok);
+    delete engine;
+  }
+  // Close right after lazy open
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  delete engine;
+  configs.lazy_recovery = false;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  LaunchNThreads(num_threads, Check);
+  delete engine;
+}
+
+TEST_F(EngineBasicTest, TestRecoveryThreads) {
+  size_t num_threads = 8;
+  size_t count = 1000;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string sorted_collection{"RecoverySorted"};
+  std::string hash_collection{"RecoveryHash"};
+  ASSERT_EQ(
+      engine->SortedCreate(sorted_collection, SortedCollectionConfigs()),
+      Status::Ok);
+  ASSERT_EQ(engine->HashCreate(hash_collection), Status::Ok);
+
+  auto Write = [&](uint32_t id) {
+    for (size_t i = 0; i < count; i++) {
+      std::string key{std::to_string(id) + "_" + std::to_string(i)};
+      ASSERT_EQ(engine->Put(key, key), Status::Ok);
+      ASSERT_EQ(engine->SortedPut(sorted_collection, key, key), Status::Ok);
+      ASSERT_EQ(engine->HashPut(hash_collection, key, key), Status::Ok);
+    }
+  };
+  auto Check = [&](uint32_t id) {
+    std::string got;
+    for (size_t i = 0; i < count; i++) {
+      std::string key{std::to_string(id) + "_" + std::to_string(i)};
+      ASSERT_EQ(engine->Get(key, &got), Status::Ok);
+      ASSERT_EQ(got, key);
+      ASSERT_EQ(engine->SortedGet(sorted_collection, key, &got), Status::Ok);
+      ASSERT_EQ(got, key);
+      ASSERT_EQ(engine->HashGet(hash_collection, key, &got), Status::Ok);
+      ASSERT_EQ(got, key);
+    }
+  };
+  LaunchNThreads(num_threads, Write);
+  delete engine;
+
+  // More recovery threads than access threads, and not a multiple of it
+  configs.recovery_threads = configs.max_access_threads * 2 + 3;
+  configs.numa_bind_recovery_threads = true;
+  for (bool lazy_recovery : {false, true}) {
+    configs.lazy_recovery = lazy_recovery;
+    ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+              Status::Ok);
+    LaunchNThreads(num_threads, Check);
+    // Wait lazy recovery finished
+    while (!engine->GetRecoveryStats().finished) {
+      std::this_thread::yield();
+    }
+    RecoveryStats stats = engine->GetRecoveryStats();
+    ASSERT_TRUE(stats.segments_restored);
+    ASSERT_GT(stats.restored_segments, 0);
+    ASSERT_EQ(stats.restored_segments, stats.total_segments);
+    ASSERT_GE(stats.restored_records, num_threads * count * 3);
+    ASSERT_EQ(stats.eta_seconds, 0);
+    // Overwrite all data after recovery
+    LaunchNThreads(num_threads, Write);
+    delete engine;
+  }
+
+  configs.recovery_threads = 0;
+  configs.lazy_recovery = false;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  LaunchNThreads(num_threads, Check);
+  delete engine;
+}
+
+TEST_F(EngineBasicTest, TestAsyncOps) {
+  int num_threads = 4;
+  uint64_t count = 1000;
+  size_t queue_depth = 64;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string sorted_collection{"AsyncSorted"};
+  std::string hash_collection{"AsyncHash"};
+  std::string list_collection{"AsyncList"};
+  ASSERT_EQ(
+      engine->SortedCreate(sorted_collection, SortedCollectionConfigs()),
+      Status::Ok);
+  ASSERT_EQ(engine->HashCreate(hash_collection), Status::Ok);
+  ASSERT_EQ(engine->ListCreate(list_collection), Status::Ok);
+
+  auto key_of = [](uint64_t tid, uint64_t i) {
+    return "async" + std::to_string(tid) + "_" + std::to_string(i);
+  };
+  auto make_op = [&](AsyncOpType type, uint64_t tid, uint64_t i) {
+    AsyncOp op;
+    op.type = type;
+    op.key = key_of(tid, i);
+    op.value = op.key + "_value";
+    op.user_data = i;
+    switch (type) {
+      case AsyncOpType::SortedGet:
+      case AsyncOpType::SortedPut:
+        op.collection = sorted_collection;
+        break;
+      case AsyncOpType::HashGet:
+      case AsyncOpType::HashPut:
+        op.collection = hash_collection;
+        break;
+      case AsyncOpType::ListPushBack:
+        op.collection = list_collection;
+        break;
+      default:
+        break;
+    }
+    return op;
+  };
+
+  // Submit batches of mixed ops and poll completions until all done
+  auto AsyncWriteAndRead = [&](uint64_t tid) {
+    std::unique_ptr<AsyncQueue> queue = engine->AsyncQueueCreate(queue_depth);
+    ASSERT_TRUE(queue != nullptr);
+    std::vector<AsyncCompletion> completions;
+    auto submit = [&](std::vector<AsyncOp>&& ops) {
+      Status s;
+      while ((s = queue->Submit(std::move(ops))) == Status::Abort) {
+        queue->Poll(&completions, queue_depth, 10);
+      }
+      ASSERT_EQ(s, Status::Ok);
+    };
+    for (uint64_t i = 0; i < count; i++) {
+      submit({make_op(AsyncOpType::StringPut, tid, i),
+              make_op(AsyncOpType::SortedPut, tid, i),
+              make_op(AsyncOpType::HashPut, tid, i),
+              make_op(AsyncOpType::ListPushBack, tid, i)});
+    }
+    while (queue->InFlight() > 0) {
+      queue->Poll(&completions, queue_depth, 10);
+    }
+    queue->Poll(&completions, queue_depth);
+    ASSERT_EQ(completions.size(), count * 4);
+    for (auto& c : completions) {
+      ASSERT_EQ(c.status, Status::Ok);
+    }
+
+    completions.clear();
+    for (uint64_t i = 0; i < count; i++) {
+      submit({make_op(AsyncOpType::StringGet, tid, i),
+              make_op(AsyncOpType::SortedGet, tid, i),
+              make_op(AsyncOpType::HashGet, tid, i)});
+    }
+    while (completions.size() < count * 3) {
+      queue->Poll(&completions, queue_depth, 10);
+    }
+    for (auto& c : completions) {
+      ASSERT_EQ(c.status, Status::Ok);
+      ASSERT_EQ(c.value, key_of(tid, c.user_data) + "_value");
+    }
+  };
+  LaunchNThreads(num_threads, AsyncWriteAndRead);
+
+  size_t list_size;
+  ASSERT_EQ(engine->ListSize(list_collection, &list_size), Status::Ok);
+  ASSERT_EQ(list_size, num_threads * count);
+
+  // Completions are passed to callback instead of being polled
+  std::atomic<uint64_t> deleted{0};
+  {
+    std::unique_ptr<AsyncQueue> queue = engine->AsyncQueueCreate(
+        queue_depth, [&](AsyncCompletion&& completion) {
+          ASSERT_EQ(completion.type, AsyncOpType::StringDelete);
+          ASSERT_EQ(completion.status, Status::Ok);
+          deleted.fetch_add(1);
+        });
+    ASSERT_TRUE(queue != nullptr);
+    std::vector<AsyncOp> ops(queue_depth + 1,
+                             make_op(AsyncOpType::StringDelete, 0, 0));
+    ASSERT_EQ(queue->Submit(std::move(ops)), Status::InvalidBatchSize);
+    for (uint64_t i = 0; i < count; i++) {
+      AsyncOp op = make_op(AsyncOpType::StringDelete, 0, i);
+      Status s;
+      while ((s = queue->Submit(std::move(op))) == Status::Abort) {
+        std::this_thread::yield();
+      }
+      ASSERT_EQ(s, Status::Ok);
+    }
+    std::vector<AsyncCompletion> completions;
+    ASSERT_EQ(queue->Poll(&completions, queue_depth), 0);
+    // Destroying queue waits all ops complete
+  }
+  ASSERT_EQ(deleted.load(), count);
+  std::string got;
+  for (uint64_t i = 0; i < count; i++) {
+    ASSERT_EQ(engine->Get(key_of(0, i), &got), Status::NotFound);
+  }
+  delete engine;
+}
+
+TEST_F(EngineBasicTest, TestQueuedMutex) {
+  size_t num_threads = 16;
+  size_t count = 100000;
+  std::vector<QueuedMutex> mutexes(4);
+  std::vector<uint64_t> counters(mutexes.size(), 0);
+  auto Increase = [&](size_t tid) {
+    for (size_t i = 0; i < count; i++) {
+      size_t idx = (tid + i) % mutexes.size();
+      if (i % 3 == 0) {
+        // Hold two locks at the same time in order
+        size_t next = (idx + 1) % mutexes.size();
+        size_t first = std::min(idx, next);
+        size_t second = std::max(idx, next);
+        std::lock_guard<QueuedMutex> lg1(mutexes[first]);
+        std::lock_guard<QueuedMutex> lg2(mutexes[second]);
+        counters[first]++;
+        counters[second]++;
+      } else if (i % 3 == 1) {
+        while (!mutexes[idx].try_lock()) {
+        }
+        counters[idx]++;
+        mutexes[idx].unlock();
+      } else {
+        std::lock_guard<QueuedMutex> lg(mutexes[idx]);
+        counters[idx]++;
+      }
+    }
+  };
+  LaunchNThreads(num_threads, Increase);
+  uint64_t total = 0;
+  for (auto c : counters) {
+    total += c;
+  }
+  uint64_t double_locked = (count + 2) / 3;
+  ASSERT_EQ(total, num_threads * (count + double_locked));
+}
+
+TEST_F(EngineBasicTest, TestCollectionRegistry) {
+  struct FakeCollection {
+    FakeCollection(CollectionIDType id) : id(id) {}
+    CollectionIDType ID() const { return id; }
+    CollectionIDType id;
+  };
+  CollectionRegistry<FakeCollection> registry;
+  size_t num_threads = 16;
+  size_t count = 1000;
+  // Each thread adds, gets and removes its own collections while others look
+  // up them
+  auto Access = [&](size_t tid) {
+    for (size_t i = 0; i < count; i++) {
+      CollectionIDType id = i * num_threads + tid;
+      registry.Add(std::make_shared<FakeCollection>(id));
+      auto got = registry.Get(id);
+      ASSERT_NE(got, nullptr);
+      ASSERT_EQ(got->ID(), id);
+      auto other = registry.Get(i * num_threads + (tid + 1) % num_threads);
+      if (other != nullptr) {
+        ASSERT_EQ(other->ID() % num_threads, (tid + 1) % num_threads);
+      }
+      if (i % 2 == 0) {
+        registry.Remove(id);
+        ASSERT_FALSE(registry.Contains(id));
+      }
+    }
+  };
+  LaunchNThreads(num_threads, Access);
+  auto all = registry.Snapshot();
+  ASSERT_EQ(all.size(), num_threads * count / 2);
+  // A miss never registers the collection
+  ASSERT_EQ(registry.Get(0), nullptr);
+  ASSERT_EQ(registry.Snapshot().size(), all.size());
+}
+
+TEST_F(EngineBasicTest, TestBackgroundExecutor) {
+  {
+    BackgroundExecutor executor(2, {0}, 5);
+    std::atomic<uint64_t> long_runs{0};
+    std::atomic<uint64_t> short_runs{0};
+    std::atomic<bool> bound{true};
+    // A long work split into runs of 10 ms budget
+    auto long_task = executor.AddTask(
+        "long", 10.0, 0.01, [&](const TaskBudget& budget) {
+          cpu_set_t cpuset;
+          pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+          if (CPU_COUNT(&cpuset) != 1 || !CPU_ISSET(0, &cpuset)) {
+            bound = false;
+          }
+          while (!budget.Exhausted()) {
+          }
+          return ++long_runs < 20;
+        });
+    executor.AddTask("short", 0.01, 0.01, [&](const TaskBudget&) {
+      short_runs++;
+      return false;
+    });
+    executor.Wake(long_task);
+    sleep(1);
+    executor.RemoveTask(long_task);
+    ASSERT_EQ(long_runs.load(), 20);
+    ASSERT_GT(short_runs.load(), 10);
+    ASSERT_TRUE(bound.load());
+    auto stats = executor.GetStats();
+    ASSERT_EQ(stats.size(), 1);
+    ASSERT_EQ(stats[0].name, "short");
+    ASSERT_EQ(stats[0].runs, short_runs.load());
+    executor.Close();
+  }
+
+  // Space of outdated records is still reclaimed on a single background
+  // thread
+  configs.background_threads = 1;
+  configs.background_nice = 10;
+  configs.background_task_budget = 0.01;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string key{"background_key"};
+  for (size_t i = 0; i < 10000; i++) {
+    ASSERT_EQ(engine->Put(key, std::to_string(i)), Status::Ok);
+  }
+  sleep(2);
+  std::string got;
+  ASSERT_EQ(engine->Get(key, &got), Status::Ok);
+  ASSERT_EQ(got, "9999");
+  delete engine;
+}
+
+TEST_F(EngineBasicTest, TestElasticAccessThreads) {
+  size_t num_threads = configs.max_access_threads * 4;
+  size_t count = 500;
+  configs.max_elastic_access_threads = 1024;
+  // Each elastic access thread may hold a PMem segment
+  Configs small_configs = configs;
+  small_configs.pmem_file_size = configs.pmem_segment_blocks *
+                                 configs.pmem_block_size *
+                                 configs.max_elastic_access_threads / 2;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, small_configs, stdout),
+            Status::InvalidConfiguration);
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string sorted_collection{"ElasticSorted"};
+  std::string hash_collection{"ElasticHash"};
+  std::string list_collection{"ElasticList"};
+  ASSERT_EQ(
+      engine->SortedCreate(sorted_collection, SortedCollectionConfigs()),
+      Status::Ok);
+  ASSERT_EQ(engine->HashCreate(hash_collection), Status::Ok);
+  ASSERT_EQ(engine->ListCreate(list_collection), Status::Ok);
+
+  // All threads stay in engine at the same time, which blocks forever if
+  // they have to share access thread slots. Keys are picked from different
+  // hash slots, so threads never wait for each other's key lock
+  std::vector<std::string> modify_keys;
+  std::set<KeyMutex*> key_locks;
+  HashTable* hash_table = dynamic_cast<KVEngine*>(engine)->GetHashTable();
+  for (size_t i = 0; modify_keys.size() < num_threads; i++) {
+    std::string key{"modify" + std::to_string(i)};
+    if (key_locks.insert(hash_table->AcquireLock(key).mutex()).second) {
+      modify_keys.push_back(key);
+    }
+  }
+  std::mutex mu;
+  std::condition_variable cv;
+  size_t entered = 0;
+  auto Wait = [&](const std::string*, std::string* new_value, void*) {
+    std::unique_lock<std::mutex> ul(mu);
+    entered++;
+    cv.notify_all();
+    EXPECT_TRUE(cv.wait_for(ul, std::chrono::seconds(10),
+                            [&]() { return entered == num_threads; }));
+    *new_value = "value";
+    return ModifyOperation::Write;
+  };
+  auto Write = [&](uint32_t id) {
+    ASSERT_EQ(engine->Modify(modify_keys[id], Wait, nullptr), Status::Ok);
+    for (size_t i = 0; i < count; i++) {
+      std::string key{std::to_string(id) + "_" + std::to_string(i)};
+      ASSERT_EQ(engine->Put(key, key), Status::Ok);
+      ASSERT_EQ(engine->SortedPut(sorted_collection, key, key), Status::Ok);
+      ASSERT_EQ(engine->HashPut(hash_collection, key, key), Status::Ok);
+      ASSERT_EQ(engine->ListPushBack(list_collection, key), Status::Ok);
+    }
+    auto batch = engine->WriteBatchCreate();
+    batch->StringPut("batch" + std::to_string(id), "batch");
+    batch->HashPut(hash_collection, "batch" + std::to_string(id), "batch");
+    ASSERT_EQ(engine->BatchWrite(batch), Status::Ok);
+  };
+  auto Check = [&](uint32_t id) {
+    std::string got;
+    for (size_t i = 0; i < count; i++) {
+      std::string key{std::to_string(id) + "_" + std::to_string(i)};
+      ASSERT_EQ(engine->Get(key, &got), Status::Ok);
+      ASSERT_EQ(got, key);
+      ASSERT_EQ(engine->SortedGet(sorted_collection, key, &got), Status::Ok);
+      ASSERT_EQ(got, key);
+      ASSERT_EQ(engine->HashGet(hash_collection, key, &got), Status::Ok);
+      ASSERT_EQ(got, key);
+    }
+    ASSERT_EQ(engine->Get("batch" + std::to_string(id), &got), Status::Ok);
+    ASSERT_EQ(got, "batch");
+    ASSERT_EQ(
+        engine->HashGet(hash_collection, "batch" + std::to_string(id), &got),
+        Status::Ok);
+    ASSERT_EQ(got, "batch");
+  };
+
+  LaunchNThreads(num_threads, Write);
+  LaunchNThreads(num_threads, Check);
+  size_t list_size;
+  ASSERT_EQ(engine->ListSize(list_collection, &list_size), Status::Ok);
+  ASSERT_EQ(list_size, num_threads * count);
+
+  Reboot();
+  LaunchNThreads(num_threads, Check);
+
+  // Ids of exited threads are leased again from the smallest, so ids stay
+  // below number of live threads, which are these threads, the main thread
+  // and a few background threads of the engine
+  std::vector<int64_t> ids(num_threads);
+  LaunchNThreads(num_threads,
+                 [&](uint32_t id) { ids[id] = ThreadManager::ThreadID(); });
+  ASSERT_LT(*std::max_element(ids.begin(), ids.end()),
+            static_cast<int64_t>(num_threads + 64));
+  delete engine;
+}
+
+TEST_F(EngineBasicTest, TestThreadIdRelease) {
+  std::mutex mu;
+  std::condition_variable cv;
+  bool done = false;
+  int64_t live_id = -1;
+  // Holds its id until the end of the test
+  std::thread live([&]() {
+    std::unique_lock<std::mutex> ul(mu);
+    live_id = ThreadManager::ThreadID();
+    cv.notify_all();
+    cv.wait(ul, [&]() { return done; });
+  });
+  {
+    std::unique_lock<std::mutex> ul(mu);
+    cv.wait(ul, [&]() { return live_id >= 0; });
+  }
+  // A thread that overwrote its id, like internal threads do, releases the
+  // id it leased rather than the id of the live thread
+  int64_t leased_id = -1;
+  std::thread([&]() {
+    leased_id = ThreadManager::ThreadID();
+    this_thread.id = live_id;
+  }).join();
+  int64_t new_id = -1;
+  std::thread([&]() { new_id = ThreadManager::ThreadID(); }).join();
+  ASSERT_NE(new_id, live_id);
+  ASSERT_EQ(new_id, leased_id);
+  {
+    std::lock_guard<std::mutex> lg(mu);
+    done = true;
+  }
+  cv.notify_all();
+  live.join();
+}
+
 TEST_F(EngineBasicTest, TestStringLargeValue) {
   configs.pmem_block_size = (1UL << 6);
   configs.pmem_segment_blocks = (1UL << 24);
@@ -1242,6 +1766,824 @@ TEST_F(EngineBasicTest, TestStringLargeValue) {
   delete engine;
 }
 
+TEST_F(EngineBasicTest, TestStringExtents) {
+  // Values larger than a segment (512KB) are split into several extents
+  configs.large_value_threshold = 64 * 1024;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::vector<std::string> keys{"inline", "one_extent", "multi_extents"};
+  std::vector<std::string> values{FastRandomString(1024),
+                                  FastRandomString(100 * 1024),
+                                  std::string(2 * 1024 * 1024, 'x')};
+  for (size_t i = 0; i < keys.size(); i++) {
+    ASSERT_EQ(engine->Put(keys[i], values[i]), Status::Ok);
+  }
+
+  auto check = [&]() {
+    for (size_t i = 0; i < keys.size(); i++) {
+      std::string got;
+      ASSERT_EQ(engine->Get(keys[i], &got), Status::Ok);
+      ASSERT_EQ(got, values[i]);
+
+      std::string chunked;
+      size_t num_chunks = 0;
+      ASSERT_EQ(engine->GetChunks(
+                    keys[i],
+                    [&](const StringView& chunk, void*) {
+                      chunked.append(chunk.data(), chunk.size());
+                      num_chunks++;
+                      return true;
+                    },
+                    nullptr),
+                Status::Ok);
+      ASSERT_EQ(chunked, values[i]);
+      ASSERT_EQ(num_chunks > 1, values[i].size() > 512 * 1024);
+    }
+  };
+  check();
+
+  // Stop reading after the first chunk
+  size_t num_chunks = 0;
+  ASSERT_EQ(engine->GetChunks(
+                keys[2],
+                [&](const StringView&, void*) {
+                  num_chunks++;
+                  return false;
+                },
+                nullptr),
+            Status::Ok);
+  ASSERT_EQ(num_chunks, 1);
+
+  // Overwrite, modify and delete values in extents
+  values[1] = std::string(700 * 1024, 'y');
+  ASSERT_EQ(engine->Put(keys[1], values[1]), Status::Ok);
+  values[2].append("z");
+  ASSERT_EQ(engine->Modify(
+                keys[2],
+                [](const std::string* old_value, std::string* new_value,
+                   void*) {
+                  new_value->assign(*old_value + "z");
+                  return ModifyOperation::Write;
+                },
+                nullptr),
+            Status::Ok);
+  ASSERT_EQ(engine->Put("deleted", values[2]), Status::Ok);
+  ASSERT_EQ(engine->Delete("deleted"), Status::Ok);
+  check();
+
+  Reboot();
+  check();
+  std::string got;
+  ASSERT_EQ(engine->Get("deleted", &got), Status::NotFound);
+  delete engine;
+}
+
+TEST_F(EngineBasicTest, TestStringBlobs) {
+  configs.blob_value_threshold = 4096;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string key{"blob"};
+  std::string value = FastRandomString(16 * 1024);
+  std::string got;
+  TTLType ttl;
+  ASSERT_EQ(engine->Put(key, value), Status::Ok);
+  // TTL updates write new records sharing the blob, which stays readable
+  // while old versions are purged
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(engine->Expire(key, INT32_MAX - i), Status::Ok);
+  }
+  ASSERT_EQ(engine->Get(key, &got), Status::Ok);
+  ASSERT_EQ(got, value);
+  ASSERT_EQ(engine->GetTTL(key, &ttl), Status::Ok);
+  ASSERT_LE(ttl, INT32_MAX - 999);
+  ASSERT_EQ(engine->Modify(
+                key,
+                [](const std::string* old_value, std::string* new_value,
+                   void*) {
+                  new_value->assign(*old_value);
+                  return ModifyOperation::Write;
+                },
+                nullptr, WriteOptions(kPersistTTL)),
+            Status::Ok);
+  ASSERT_EQ(engine->Expire("not_exist", INT32_MAX), Status::NotFound);
+
+  Reboot();
+  ASSERT_EQ(engine->Get(key, &got), Status::Ok);
+  ASSERT_EQ(got, value);
+  ASSERT_EQ(engine->GetTTL(key, &ttl), Status::Ok);
+  ASSERT_EQ(ttl, kPersistTTL);
+
+  // Overwrite and expire the blob
+  value = FastRandomString(8 * 1024);
+  ASSERT_EQ(engine->Put(key, value), Status::Ok);
+  ASSERT_EQ(engine->Get(key, &got), Status::Ok);
+  ASSERT_EQ(got, value);
+  ASSERT_EQ(engine->Expire(key, -1), Status::Ok);
+  ASSERT_EQ(engine->Get(key, &got), Status::NotFound);
+  delete engine;
+}
+
+TEST_F(EngineBasicTest, TestStringCompression) {
+  configs.value_compression = CompressionType::LZ;
+  configs.compression_threshold = 64;
+  configs.large_value_threshold = 64 * 1024;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string small{"small"};
+  std::string compressible(4096, 'a');
+  for (size_t i = 0; i < compressible.size(); i += 7) {
+    compressible[i] = 'a' + i % 26;
+  }
+  std::string incompressible = FastRandomString(4096);
+  // Compressed to about half, which is still stored in extents
+  std::string large =
+      FastRandomString(512 * 1024) + std::string(512 * 1024, 'a');
+  std::string got;
+  ASSERT_EQ(engine->Put("small", small), Status::Ok);
+  ASSERT_EQ(engine->Put("compressible", compressible), Status::Ok);
+  ASSERT_EQ(engine->Put("incompressible", incompressible), Status::Ok);
+  ASSERT_EQ(engine->Put("large", large), Status::Ok);
+  WriteOptions raw;
+  raw.compression = CompressionType::None;
+  ASSERT_EQ(engine->Put("raw", compressible, raw), Status::Ok);
+  std::string chunks;
+  ASSERT_EQ(engine->GetChunks(
+                "large",
+                [](const StringView& chunk, void* args) {
+                  static_cast<std::string*>(args)->append(chunk.data(),
+                                                          chunk.size());
+                  return true;
+                },
+                &chunks),
+            Status::Ok);
+  ASSERT_EQ(chunks, large);
+  // Modify reads the decompressed value
+  ASSERT_EQ(engine->Modify(
+                "compressible",
+                [](const std::string* old_value, std::string* new_value,
+                   void*) {
+                  new_value->assign(*old_value + "tail");
+                  return ModifyOperation::Write;
+                },
+                nullptr),
+            Status::Ok);
+  compressible.append("tail");
+  ASSERT_EQ(engine->Expire("incompressible", INT32_MAX), Status::Ok);
+
+  auto check = [&]() {
+    ASSERT_EQ(engine->Get("small", &got), Status::Ok);
+    ASSERT_EQ(got, small);
+    ASSERT_EQ(engine->Get("compressible", &got), Status::Ok);
+    ASSERT_EQ(got, compressible);
+    ASSERT_EQ(engine->Get("incompressible", &got), Status::Ok);
+    ASSERT_EQ(got, incompressible);
+    ASSERT_EQ(engine->Get("large", &got), Status::Ok);
+    ASSERT_EQ(got, large);
+    ASSERT_EQ(engine->Get("raw", &got), Status::Ok);
+    ASSERT_EQ(got, compressible.substr(0, 4096));
+  };
+  check();
+  Reboot();
+  check();
+  delete engine;
+}
+
+TEST_F(EngineBasicTest, TestCompactRecords) {
+  configs.compact_hash_elems = true;
+  configs.compact_sorted_elems = true;
+  configs.compact_list_elems = true;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string hash{"hash"}, sorted{"sorted"}, list{"list"};
+  ASSERT_EQ(engine->HashCreate(hash), Status::Ok);
+  ASSERT_EQ(engine->SortedCreate(sorted), Status::Ok);
+  ASSERT_EQ(engine->ListCreate(list), Status::Ok);
+  size_t num_elems = 1000;
+  // 8 bytes fields with 8 bytes values fit in a block as compact records
+  auto field = [](size_t i) {
+    std::string ret = std::to_string(i);
+    return ret + std::string(8 - ret.size(), 'f');
+  };
+  auto value = [](size_t i, size_t round) {
+    return std::string((char*)&i, 4) + std::string((char*)&round, 4);
+  };
+  auto write = [&](size_t round) {
+    for (size_t i = 0; i < num_elems; i++) {
+      ASSERT_EQ(engine->HashPut(hash, field(i), value(i, round)), Status::Ok);
+      ASSERT_EQ(engine->SortedPut(sorted, field(i), value(i, round)),
+                Status::Ok);
+      ASSERT_EQ(engine->ListPushBack(list, value(i, round)), Status::Ok);
+    }
+    // Delete records are elems too
+    for (size_t i = 0; i < num_elems; i += 3) {
+      ASSERT_EQ(engine->HashDelete(hash, field(i)), Status::Ok);
+      ASSERT_EQ(engine->SortedDelete(sorted, field(i)), Status::Ok);
+    }
+  };
+  auto check = [&](size_t round) {
+    std::string got;
+    size_t size;
+    for (size_t i = 0; i < num_elems; i++) {
+      Status expected = i % 3 == 0 ? Status::NotFound : Status::Ok;
+      ASSERT_EQ(engine->HashGet(hash, field(i), &got), expected);
+      if (expected == Status::Ok) {
+        ASSERT_EQ(got, value(i, round));
+      }
+      ASSERT_EQ(engine->SortedGet(sorted, field(i), &got), expected);
+      if (expected == Status::Ok) {
+        ASSERT_EQ(got, value(i, round));
+      }
+    }
+    ASSERT_EQ(engine->HashSize(hash, &size), Status::Ok);
+    ASSERT_EQ(size, num_elems - (num_elems + 2) / 3);
+    ASSERT_EQ(engine->SortedSize(sorted, &size), Status::Ok);
+    ASSERT_EQ(size, num_elems - (num_elems + 2) / 3);
+    ASSERT_EQ(engine->ListSize(list, &size), Status::Ok);
+    ASSERT_EQ(size, num_elems);
+    for (size_t i = 0; i < num_elems; i++) {
+      ASSERT_EQ(engine->ListPopFront(list, &got), Status::Ok);
+      ASSERT_EQ(got, value(i, round));
+    }
+  };
+
+  write(0);
+  check(0);
+  // Records of both layouts are recovered whether compact records are
+  // enabled or not
+  write(1);
+  configs.compact_hash_elems = false;
+  configs.compact_sorted_elems = false;
+  configs.compact_list_elems = false;
+  Reboot();
+  check(1);
+  write(2);
+  configs.compact_hash_elems = true;
+  configs.compact_sorted_elems = true;
+  configs.compact_list_elems = true;
+  Reboot();
+  check(2);
+  delete engine;
+}
+
+TEST_F(EngineBasicTest, TestColdTier) {
+  std::string cold_tier_path = FLAGS_path + ".cold";
+  remove(cold_tier_path.c_str());
+  configs.cold_tier_path = cold_tier_path;
+  configs.cold_tier_min_value_size = 1024;
+  configs.cold_tier_promote = false;
+  configs.value_compression = CompressionType::LZ;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  auto test_kvengine = static_cast<KVEngine*>(engine);
+  size_t num_keys = 100;
+  std::vector<std::string> values(num_keys);
+  for (size_t i = 0; i < num_keys; i++) {
+    // Half of values are compressible, which are demoted compressed
+    values[i] = i % 4 < 2 ? FastRandomString(4096)
+                          : FastRandomString(2048) + std::string(2048, 'a');
+    values[i].append(std::to_string(i));
+    ASSERT_EQ(engine->Put(std::to_string(i), values[i]), Status::Ok);
+  }
+  ASSERT_EQ(engine->Put("small", "small"), Status::Ok);
+  auto cold_tier_size = [&]() {
+    struct stat st;
+    return stat(cold_tier_path.c_str(), &st) == 0 ? st.st_size : 0;
+  };
+
+  // Keys are demoted after they are idle for a whole cooling period, and
+  // read keys after more periods
+  auto demote = [&](int periods) {
+    for (int i = 0; i < periods; i++) {
+      test_kvengine->TestDemoteColdStrings();
+    }
+  };
+  demote(1);
+  std::string got;
+  for (size_t i = 0; i < num_keys; i += 2) {
+    ASSERT_EQ(engine->Get(std::to_string(i), &got), Status::Ok);
+  }
+  ASSERT_EQ(cold_tier_size(), 0);
+  demote(2);
+  ASSERT_GE(cold_tier_size(), num_keys / 2 * 1024);
+  demote(2);
+  ASSERT_GE(cold_tier_size(), num_keys * 1024);
+
+  auto check = [&]() {
+    for (size_t i = 0; i < num_keys; i++) {
+      ASSERT_EQ(engine->Get(std::to_string(i), &got), Status::Ok);
+      ASSERT_EQ(got, values[i]);
+    }
+    ASSERT_EQ(engine->Get("small", &got), Status::Ok);
+    ASSERT_EQ(got, "small");
+  };
+  check();
+  // Update cold keys in different ways
+  values[0] = "updated";
+  ASSERT_EQ(engine->Put("0", values[0]), Status::Ok);
+  ASSERT_EQ(engine->Expire("1", INT32_MAX), Status::Ok);
+  ASSERT_EQ(engine->Modify(
+                "2",
+                [](const std::string* old_value, std::string* new_value,
+                   void*) {
+                  new_value->assign(*old_value + "tail");
+                  return ModifyOperation::Write;
+                },
+                nullptr),
+            Status::Ok);
+  values[2].append("tail");
+  check();
+  Reboot();
+  check();
+
+  // Read cold values are written back to PMem, and reuse their entries in
+  // the cold tier as they are demoted again unchanged
+  configs.cold_tier_promote = true;
+  Reboot();
+  test_kvengine = static_cast<KVEngine*>(engine);
+  check();
+  demote(3);
+  size_t demoted_size = cold_tier_size();
+  check();
+  demote(3);
+  ASSERT_EQ(cold_tier_size(), demoted_size);
+
+  // Values are not demoted if the cold tier is full
+  configs.cold_tier_max_file_size = demoted_size;
+  Reboot();
+  test_kvengine = static_cast<KVEngine*>(engine);
+  std::string new_value = FastRandomString(4096);
+  ASSERT_EQ(engine->Put("new", new_value), Status::Ok);
+  demote(3);
+  ASSERT_EQ(cold_tier_size(), demoted_size);
+  ASSERT_EQ(engine->Get("new", &got), Status::Ok);
+  ASSERT_EQ(got, new_value);
+
+  // Promoted values are readable without the cold tier. Nothing is demoted
+  // again by the background cleaner
+  configs.cold_tier_min_value_size = UINT64_MAX;
+  Reboot();
+  check();
+  configs.cold_tier_path = "";
+  Reboot();
+  check();
+  delete engine;
+  remove(cold_tier_path.c_str());
+}
+
+TEST_F(EngineBasicTest, TestVolatileMode) {
+  configs.volatile_mode = true;
+  configs.pmem_file_size = (1ULL << 30);
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  // Persistent instances can be opened along with volatile ones, and keep
+  // persisting their writes
+  std::string persistent_path = db_path + "_persistent";
+  Engine* persistent_engine = nullptr;
+  Configs persistent_configs = configs;
+  persistent_configs.volatile_mode = false;
+  ASSERT_EQ(Engine::Open(persistent_path.c_str(), &persistent_engine,
+                         persistent_configs, stdout),
+            Status::Ok);
+  ASSERT_EQ(persistent_engine->Put("persistent", "value"), Status::Ok);
+  delete persistent_engine;
+  ASSERT_EQ(Engine::Open(persistent_path.c_str(), &persistent_engine,
+                         persistent_configs, stdout),
+            Status::Ok);
+
+  std::string got;
+  ASSERT_EQ(engine->Put("string", "value"), Status::Ok);
+  ASSERT_EQ(engine->SortedCreate("sorted"), Status::Ok);
+  ASSERT_EQ(engine->SortedPut("sorted", "key", "value"), Status::Ok);
+  ASSERT_EQ(engine->HashCreate("hash"), Status::Ok);
+  ASSERT_EQ(engine->HashPut("hash", "key", "value"), Status::Ok);
+  ASSERT_EQ(engine->ListCreate("list"), Status::Ok);
+  ASSERT_EQ(engine->ListPushBack("list", "elem1"), Status::Ok);
+  ASSERT_EQ(engine->ListPushBack("list", "elem2"), Status::Ok);
+  ASSERT_EQ(engine->ListMove("list", ListPos::Front, "list", ListPos::Back,
+                             &got),
+            Status::Ok);
+  ASSERT_EQ(got, "elem1");
+  auto batch = engine->WriteBatchCreate();
+  batch->StringPut("batch_string", "value");
+  batch->SortedPut("sorted", "batch_key", "value");
+  batch->HashPut("hash", "batch_key", "value");
+  ASSERT_EQ(engine->BatchWrite(batch), Status::Ok);
+
+  ASSERT_EQ(engine->Get("string", &got), Status::Ok);
+  ASSERT_EQ(got, "value");
+  ASSERT_EQ(engine->Get("batch_string", &got), Status::Ok);
+  ASSERT_EQ(got, "value");
+  ASSERT_EQ(engine->SortedGet("sorted", "batch_key", &got), Status::Ok);
+  ASSERT_EQ(got, "value");
+  ASSERT_EQ(engine->HashGet("hash", "key", &got), Status::Ok);
+  ASSERT_EQ(got, "value");
+  ASSERT_EQ(engine->ListPopFront("list", &got), Status::Ok);
+  ASSERT_EQ(got, "elem2");
+
+  ASSERT_EQ(persistent_engine->Get("persistent", &got), Status::Ok);
+  ASSERT_EQ(got, "value");
+  ASSERT_EQ(persistent_engine->Get("string", &got), Status::NotFound);
+  delete persistent_engine;
+  int res __attribute__((unused)) =
+      system(("rm -rf " + persistent_path).c_str());
+
+  // Nothing survives close
+  Reboot();
+  ASSERT_EQ(engine->Get("string", &got), Status::NotFound);
+  ASSERT_EQ(engine->HashGet("hash", "key", &got), Status::NotFound);
+  delete engine;
+  engine = nullptr;
+}
+
+TEST_F(EngineBasicTest, TestEmulatedPMem) {
+  // A path on a regular file system rather than PMem
+  db_path = "/tmp/kvdk_emulated_pmem_test";
+  Destroy();
+  configs.pmem_file_size = (256ULL << 20);
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::IOError);
+  configs.emulate_pmem = true;
+  configs.emulate_pmem_write_latency_ns = 100;
+  configs.emulate_pmem_write_bandwidth_mb = 2000;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  // Instances of other modes can be opened along with emulated ones
+  Engine* volatile_engine = nullptr;
+  Configs volatile_configs = configs;
+  volatile_configs.emulate_pmem = false;
+  volatile_configs.volatile_mode = true;
+  ASSERT_EQ(Engine::Open((db_path + "_volatile").c_str(), &volatile_engine,
+                         volatile_configs, stdout),
+            Status::Ok);
+  ASSERT_EQ(volatile_engine->Put("volatile", "value"), Status::Ok);
+
+  size_t num_keys = 1000;
+  for (size_t i = 0; i < num_keys; i++) {
+    ASSERT_EQ(engine->Put(std::to_string(i), std::to_string(i)), Status::Ok);
+  }
+  ASSERT_EQ(engine->HashCreate("hash"), Status::Ok);
+  ASSERT_EQ(engine->HashPut("hash", "key", "value"), Status::Ok);
+  auto batch = engine->WriteBatchCreate();
+  batch->StringPut("batch_string", "value");
+  batch->HashPut("hash", "batch_key", "value");
+  ASSERT_EQ(engine->BatchWrite(batch), Status::Ok);
+  std::string got;
+  ASSERT_EQ(volatile_engine->Get("volatile", &got), Status::Ok);
+  ASSERT_EQ(volatile_engine->Get("batch_string", &got), Status::NotFound);
+  delete volatile_engine;
+
+  // Data persists in the files
+  configs.emulate_pmem_msync = true;
+  Reboot();
+  for (size_t i = 0; i < num_keys; i++) {
+    ASSERT_EQ(engine->Get(std::to_string(i), &got), Status::Ok);
+    ASSERT_EQ(got, std::to_string(i));
+  }
+  ASSERT_EQ(engine->Get("batch_string", &got), Status::Ok);
+  ASSERT_EQ(got, "value");
+  ASSERT_EQ(engine->HashGet("hash", "batch_key", &got), Status::Ok);
+  ASSERT_EQ(got, "value");
+  ASSERT_EQ(engine->Put("0", "updated"), Status::Ok);
+  Reboot();
+  ASSERT_EQ(engine->Get("0", &got), Status::Ok);
+  ASSERT_EQ(got, "updated");
+  delete engine;
+  engine = nullptr;
+}
+
+TEST_F(EngineBasicTest, TestEmulatedPMemCostModels) {
+  db_path = "/tmp/kvdk_emulated_pmem_test";
+  Destroy();
+  std::string slow_path = db_path + "_slow";
+  int res __attribute__((unused)) = system(("rm -rf " + slow_path).c_str());
+  configs.pmem_file_size = (256ULL << 20);
+  configs.emulate_pmem = true;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  // Opened later with a different cost model, which takes effect on its own
+  // writes only
+  Engine* slow_engine = nullptr;
+  Configs slow_configs = configs;
+  uint64_t latency_ms = 1;
+  slow_configs.emulate_pmem_write_latency_ns = latency_ms * 1000000;
+  ASSERT_EQ(Engine::Open(slow_path.c_str(), &slow_engine, slow_configs,
+                         stdout),
+            Status::Ok);
+
+  auto put_ms = [](Engine* e, size_t num_keys) -> int64_t {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < num_keys; i++) {
+      EXPECT_EQ(e->Put(std::to_string(i), std::to_string(i)), Status::Ok);
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  };
+  size_t num_keys = 100;
+  // Each put pays at least a persist barrier
+  auto slow_ms = put_ms(slow_engine, num_keys);
+  ASSERT_GE(static_cast<uint64_t>(slow_ms), num_keys * latency_ms);
+  ASSERT_LT(put_ms(engine, num_keys), slow_ms);
+
+  delete slow_engine;
+  res = system(("rm -rf " + slow_path).c_str());
+  delete engine;
+  engine = nullptr;
+}
+
+TEST_F(EngineBasicTest, TestRelaxedDurability) {
+  configs.relaxed_durability = true;
+  // Only flush on Engine::Flush() and batch writes
+  configs.relaxed_flush_interval_us = 1ULL << 40;
+  configs.relaxed_flush_bytes = UINT64_MAX;
+  size_t num_keys = 100;
+  // Crash a child process after writes, records written after the last group
+  // flush are discarded in recovery even if they reached PMem
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    if (Engine::Open(db_path.c_str(), &engine, configs, stdout) !=
+        Status::Ok) {
+      _exit(1);
+    }
+    for (size_t i = 0; i < num_keys; i++) {
+      engine->Put("flushed" + std::to_string(i), "v1");
+      engine->Put("updated" + std::to_string(i), "v1");
+    }
+    engine->Flush();
+    for (size_t i = 0; i < num_keys; i++) {
+      engine->Put("unflushed" + std::to_string(i), "v2");
+      engine->Put("updated" + std::to_string(i), "v2");
+      engine->Delete("flushed" + std::to_string(i));
+    }
+    _exit(0);
+  }
+  int status;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string got;
+  auto check_prefix = [&]() {
+    for (size_t i = 0; i < num_keys; i++) {
+      ASSERT_EQ(engine->Get("flushed" + std::to_string(i), &got), Status::Ok);
+      ASSERT_EQ(got, "v1");
+      ASSERT_EQ(engine->Get("updated" + std::to_string(i), &got), Status::Ok);
+      ASSERT_EQ(got, "v1");
+      ASSERT_EQ(engine->Get("unflushed" + std::to_string(i), &got),
+                Status::NotFound);
+    }
+  };
+  check_prefix();
+
+  // Writes are flushed on close, and a batch write is durable on return
+  ASSERT_EQ(engine->Put("key", "value"), Status::Ok);
+  auto batch = engine->WriteBatchCreate();
+  batch->StringPut("batch_key", "value");
+  ASSERT_EQ(engine->BatchWrite(batch), Status::Ok);
+  configs.relaxed_durability = false;
+  Reboot();
+  check_prefix();
+  ASSERT_EQ(engine->Get("key", &got), Status::Ok);
+  ASSERT_EQ(engine->Get("batch_key", &got), Status::Ok);
+  delete engine;
+  engine = nullptr;
+}
+
+TEST_F(EngineBasicTest, TestRelaxedDurabilityStrictWrites) {
+  configs.relaxed_durability = true;
+  configs.relaxed_flush_interval_us = 1ULL << 40;
+  configs.relaxed_flush_bytes = UINT64_MAX;
+  size_t num_keys = 100;
+  auto modify = [](const std::string*, std::string* new_value, void*) {
+    *new_value = "modified";
+    return ModifyOperation::Write;
+  };
+  // Collection writes and Modify() are durable on return, so relaxed writes
+  // before them are recovered with them
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    if (Engine::Open(db_path.c_str(), &engine, configs, stdout) !=
+            Status::Ok ||
+        engine->HashCreate("hash") != Status::Ok) {
+      _exit(1);
+    }
+    for (size_t i = 0; i < num_keys; i++) {
+      engine->Put("before_hash" + std::to_string(i), "v");
+    }
+    if (engine->HashPut("hash", "key", "v") != Status::Ok) {
+      _exit(1);
+    }
+    for (size_t i = 0; i < num_keys; i++) {
+      engine->Put("before_modify" + std::to_string(i), "v");
+    }
+    if (engine->Modify("modified", modify, nullptr) != Status::Ok) {
+      _exit(1);
+    }
+    for (size_t i = 0; i < num_keys; i++) {
+      engine->Put("unflushed" + std::to_string(i), "v");
+    }
+    _exit(0);
+  }
+  int status;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string got;
+  ASSERT_EQ(engine->HashGet("hash", "key", &got), Status::Ok);
+  ASSERT_EQ(engine->Get("modified", &got), Status::Ok);
+  ASSERT_EQ(got, "modified");
+  for (size_t i = 0; i < num_keys; i++) {
+    ASSERT_EQ(engine->Get("before_hash" + std::to_string(i), &got),
+              Status::Ok);
+    ASSERT_EQ(engine->Get("before_modify" + std::to_string(i), &got),
+              Status::Ok);
+    ASSERT_EQ(engine->Get("unflushed" + std::to_string(i), &got),
+              Status::NotFound);
+  }
+  delete engine;
+  engine = nullptr;
+}
+
+TEST_F(EngineBasicTest, TestStatistics) {
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string got;
+  ASSERT_EQ(engine->Put("key", "value"), Status::Ok);
+  Statistics stats = engine->GetStatistics();
+  ASSERT_FALSE(stats.enabled);
+  ASSERT_EQ(stats.ops[KVDKStatOpPut].count, 0);
+  ASSERT_GT(stats.pmem_usage_bytes, 0);
+  ASSERT_EQ(stats.pmem_capacity_bytes, configs.pmem_file_size);
+  ASSERT_EQ(stats.hash_buckets, configs.hash_bucket_num);
+  ASSERT_GT(stats.hash_load_factor, 0);
+  ASSERT_GE(stats.hash_avg_chain_length, 1);
+
+  engine->EnableStatistics(true);
+  size_t num_ops = 1000;
+  for (size_t i = 0; i < num_ops; i++) {
+    ASSERT_EQ(engine->Put("key" + std::to_string(i), "value"), Status::Ok);
+    ASSERT_EQ(engine->Get("key" + std::to_string(i), &got), Status::Ok);
+  }
+  ASSERT_EQ(engine->Get("missing", &got), Status::NotFound);
+  engine->EnableStatistics(false);
+  ASSERT_EQ(engine->Put("key", "value"), Status::Ok);
+
+  stats = engine->GetStatistics();
+  ASSERT_EQ(stats.ops[KVDKStatOpPut].count, num_ops);
+  ASSERT_EQ(stats.ops[KVDKStatOpGet].count, num_ops + 1);
+  ASSERT_EQ(stats.ops[KVDKStatOpDelete].count, 0);
+  for (StatOp op : {KVDKStatOpPut, KVDKStatOpGet}) {
+    const OpStatistics& op_stats = stats.ops[op];
+    ASSERT_GT(op_stats.avg_ns, 0);
+    ASSERT_LE(op_stats.p50_ns, op_stats.p99_ns);
+    ASSERT_LE(op_stats.p99_ns, op_stats.p999_ns);
+    ASSERT_LE(op_stats.p999_ns, op_stats.max_ns);
+  }
+  delete engine;
+  engine = nullptr;
+}
+
+TEST_F(EngineBasicTest, TestTrace) {
+  configs.trace_sample_interval = 1;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string collection = "trace_collection";
+  ASSERT_EQ(engine->SortedCreate(collection), Status::Ok);
+  ASSERT_EQ(engine->Put("key", "value"), Status::Ok);
+  ASSERT_EQ(engine->SortedPut(collection, "key", "value"), Status::Ok);
+  auto batch = engine->WriteBatchCreate();
+  batch->StringPut("batch_key", "value");
+  batch->SortedPut(collection, "batch_key", "value");
+  ASSERT_EQ(engine->BatchWrite(batch), Status::Ok);
+
+  auto ReadTrace = [&](const std::string& path) {
+    std::ifstream file(path);
+    return std::string(std::istreambuf_iterator<char>(file),
+                       std::istreambuf_iterator<char>());
+  };
+  auto Count = [](const std::string& str, const std::string& pattern) {
+    size_t cnt = 0;
+    for (size_t pos = str.find(pattern); pos != std::string::npos;
+         pos = str.find(pattern, pos + 1)) {
+      cnt++;
+    }
+    return cnt;
+  };
+
+  std::string trace_path = db_path + "_trace.json";
+  ASSERT_EQ(engine->DumpTrace(trace_path), Status::Ok);
+  std::string trace = ReadTrace(trace_path);
+  ASSERT_EQ(trace.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["), 0);
+  ASSERT_EQ(Count(trace, "\"cat\":\"op\""), 3);
+  for (const char* op : {"\"Put\"", "\"SortedPut\"", "\"BatchWrite\""}) {
+    ASSERT_EQ(Count(trace, op), 1);
+  }
+  for (const char* stage : {"\"lock\"", "\"lookup\"", "\"allocate\"",
+                            "\"persist\"", "\"publish\"", "\"log\"",
+                            "\"commit\""}) {
+    ASSERT_GT(Count(trace, stage), 0);
+  }
+
+  // Untraced operations leave buffered events unchanged
+  engine->SetTraceSampleInterval(0);
+  ASSERT_EQ(engine->Put("key", "value"), Status::Ok);
+  ASSERT_EQ(engine->DumpTrace(trace_path), Status::Ok);
+  ASSERT_EQ(Count(ReadTrace(trace_path), "\"cat\":\"op\""), 3);
+
+  engine->SetTraceSampleInterval(2);
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(engine->Put("key", "value"), Status::Ok);
+  }
+  ASSERT_EQ(engine->DumpTrace(trace_path), Status::Ok);
+  ASSERT_EQ(Count(ReadTrace(trace_path), "\"cat\":\"op\""), 8);
+  ASSERT_EQ(engine->DumpTrace("/non-existing-dir/trace.json"),
+            Status::IOError);
+  remove(trace_path.c_str());
+  delete engine;
+  engine = nullptr;
+}
+
+TEST_F(EngineBasicTest, TestHotKeys) {
+  configs.hot_key_sample_interval = 1;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string got;
+  size_t num_keys = 1000;
+  size_t hot_writes = 1000;
+  size_t hot_reads = 500;
+  for (size_t i = 0; i < num_keys; i++) {
+    ASSERT_EQ(engine->Put("key" + std::to_string(i), "value"), Status::Ok);
+  }
+  ASSERT_EQ(engine->Put("hot_read", "value"), Status::Ok);
+  for (size_t i = 0; i < hot_writes; i++) {
+    ASSERT_EQ(engine->Put("hot_write", std::to_string(i)), Status::Ok);
+  }
+  for (size_t i = 0; i < hot_reads; i++) {
+    ASSERT_EQ(engine->Get("hot_read", &got), Status::Ok);
+  }
+
+  HotKeys hot_keys = engine->GetHotKeys(3);
+  ASSERT_EQ(hot_keys.sample_interval, 1);
+  ASSERT_EQ(hot_keys.writes.size(), 3);
+  ASSERT_EQ(hot_keys.writes[0].key, "hot_write");
+  ASSERT_GE(hot_keys.writes[0].count, hot_writes);
+  ASSERT_LT(hot_keys.writes[1].count, hot_writes);
+  ASSERT_FALSE(hot_keys.reads.empty());
+  ASSERT_EQ(hot_keys.reads[0].key, "hot_read");
+  ASSERT_GE(hot_keys.reads[0].count, hot_reads);
+
+  // Contend a slot by concurrent writes of a key
+  size_t num_threads = 8;
+  LaunchNThreads(num_threads, [&](int) {
+    for (size_t i = 0; i < 1000; i++) {
+      ASSERT_EQ(engine->Put("contended", "value"), Status::Ok);
+    }
+  });
+  hot_keys = engine->GetHotKeys(3);
+  ASSERT_EQ(hot_keys.writes[0].key, "contended");
+  ASSERT_LE(hot_keys.contended_slots.size(), 3);
+  for (auto& slot : hot_keys.contended_slots) {
+    ASSERT_LE(slot.contentions, hot_keys.contentions);
+  }
+
+  engine->SetHotKeySampleInterval(0);
+  ASSERT_EQ(engine->Put("hot_write", "value"), Status::Ok);
+  ASSERT_EQ(engine->GetHotKeys(3).writes[1].count, hot_keys.writes[1].count);
+  engine->ResetHotKeys();
+  hot_keys = engine->GetHotKeys(3);
+  ASSERT_EQ(hot_keys.sample_interval, 0);
+  ASSERT_TRUE(hot_keys.reads.empty());
+  ASSERT_TRUE(hot_keys.writes.empty());
+  ASSERT_TRUE(hot_keys.contended_slots.empty());
+  ASSERT_EQ(hot_keys.contentions, 0);
+
+  // Writes of hash elems are sampled on their internal keys rather than the
+  // locked hash, and lookups of a delete are sampled once as a write
+  engine->SetHotKeySampleInterval(1);
+  ASSERT_EQ(engine->HashCreate("hash"), Status::Ok);
+  ASSERT_EQ(engine->Put("deleted", "value"), Status::Ok);
+  engine->ResetHotKeys();
+  for (size_t i = 0; i < hot_writes; i++) {
+    ASSERT_EQ(engine->HashPut("hash", "field", std::to_string(i)), Status::Ok);
+  }
+  ASSERT_EQ(engine->Delete("deleted"), Status::Ok);
+  hot_keys = engine->GetHotKeys(2);
+  ASSERT_EQ(hot_keys.writes.size(), 2);
+  ASSERT_EQ(hot_keys.writes[0].key.substr(8), "field");
+  ASSERT_GE(hot_keys.writes[0].count, hot_writes);
+  ASSERT_EQ(hot_keys.writes[1].key, "deleted");
+  for (auto& read : hot_keys.reads) {
+    ASSERT_NE(read.key, "deleted");
+  }
+  delete engine;
+  engine = nullptr;
+}
+
 TEST_F(EngineBasicTest, TestSortedRestore) {
   size_t num_threads = 16;
   for (int opt_large_sorted_collection_recovery : {0, 1}) {
@@ -1481,6 +2823,82 @@ TEST_F(EngineBasicTest, TestMultiThreadSortedRestore) {
   delete engine;
 }
 
+TEST_F(EngineBasicTest, TestLargeHashAndListRestore) {
+  size_t num_threads = 4;
+  size_t count = 15000;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string hash{"large_hash"};
+  std::string list{"large_list"};
+  ASSERT_EQ(engine->HashCreate(hash), Status::Ok);
+  ASSERT_EQ(engine->ListCreate(list), Status::Ok);
+
+  // fields with odd index are deleted after put
+  auto HPut = [&](size_t tid) {
+    for (size_t i = 0; i < count; i++) {
+      std::string field{std::to_string(tid) + "_" + std::to_string(i)};
+      ASSERT_EQ(engine->HashPut(hash, field, field), Status::Ok);
+      if (i % 2 == 1) {
+        ASSERT_EQ(engine->HashDelete(hash, field), Status::Ok);
+      }
+    }
+  };
+  LaunchNThreads(num_threads, HPut);
+
+  std::deque<std::string> list_copy;
+  for (size_t i = 0; i < num_threads * count; i++) {
+    std::string elem{std::to_string(i)};
+    ASSERT_EQ(engine->ListPushBack(list, elem), Status::Ok);
+    list_copy.push_back(elem);
+  }
+  std::string sink;
+  for (size_t i = 0; i < count / 2; i++) {
+    ASSERT_EQ(engine->ListPopFront(list, &sink), Status::Ok);
+    ASSERT_EQ(sink, list_copy.front());
+    list_copy.pop_front();
+  }
+
+  auto CheckData = [&]() {
+    size_t sz = 0;
+    ASSERT_EQ(engine->HashSize(hash, &sz), Status::Ok);
+    ASSERT_EQ(sz, num_threads * count / 2);
+    std::string got;
+    for (size_t tid = 0; tid < num_threads; tid++) {
+      for (size_t i = 0; i < count; i++) {
+        std::string field{std::to_string(tid) + "_" + std::to_string(i)};
+        if (i % 2 == 1) {
+          ASSERT_EQ(engine->HashGet(hash, field, &got), Status::NotFound);
+        } else {
+          ASSERT_EQ(engine->HashGet(hash, field, &got), Status::Ok);
+          ASSERT_EQ(got, field);
+        }
+      }
+    }
+
+    ASSERT_EQ(engine->ListSize(list, &sz), Status::Ok);
+    ASSERT_EQ(sz, list_copy.size());
+    auto iter = engine->ListIteratorCreate(list);
+    ASSERT_NE(iter, nullptr);
+    size_t idx = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      ASSERT_EQ(iter->Value(), list_copy[idx++]);
+    }
+    ASSERT_EQ(idx, list_copy.size());
+    engine->ListIteratorRelease(iter);
+  };
+
+  CheckData();
+  delete engine;
+  for (bool opt_restore : {false, true}) {
+    configs.opt_large_hash_collection_recovery = opt_restore;
+    configs.opt_large_list_recovery = opt_restore;
+    ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+              Status::Ok);
+    CheckData();
+    delete engine;
+  }
+}
+
 TEST_F(EngineBasicTest, TestList) {
   size_t num_threads = 1;
   size_t count = 1000;
@@ -1896,6 +3314,379 @@ TEST_F(EngineBasicTest, TestHash) {
   delete engine;
 }
 
+TEST_F(EngineBasicTest, TestSet) {
+  size_t num_threads = 4;
+  size_t count = 1000;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string set1{"Set1"};
+  std::string set2{"Set2"};
+  std::string hash{"NotSet"};
+  ASSERT_EQ(engine->SetCreate(set1), Status::Ok);
+  ASSERT_EQ(engine->SetCreate(set1), Status::Existed);
+  ASSERT_EQ(engine->SetCreate(set2), Status::Ok);
+  ASSERT_EQ(engine->HashCreate(hash), Status::Ok);
+  ASSERT_EQ(engine->SetCreate(hash), Status::WrongType);
+  ASSERT_EQ(engine->SetAdd(hash, "member"), Status::WrongType);
+  ASSERT_EQ(engine->HashPut(set1, "member", "value"), Status::WrongType);
+  ValueType type;
+  ASSERT_EQ(engine->TypeOf(set1, &type), Status::Ok);
+  ASSERT_EQ(type, ValueType::Set);
+
+  // set1 holds all numbers, set2 holds even ones
+  auto SAdd = [&](size_t tid) {
+    for (size_t i = tid; i < count; i += num_threads) {
+      std::string member = EncodeUint64(i);
+      ASSERT_EQ(engine->SetAdd(set1, member), Status::Ok);
+      // Adding an existing member is a no-op
+      ASSERT_EQ(engine->SetAdd(set1, member), Status::Ok);
+      if (i % 2 == 0) {
+        ASSERT_EQ(engine->SetAdd(set2, member), Status::Ok);
+      }
+    }
+  };
+  LaunchNThreads(num_threads, SAdd);
+
+  auto CheckSets = [&]() {
+    size_t card;
+    ASSERT_EQ(engine->SetCard(set1, &card), Status::Ok);
+    ASSERT_EQ(card, count);
+    ASSERT_EQ(engine->SetCard(set2, &card), Status::Ok);
+    ASSERT_EQ(card, count / 2);
+    bool is_member;
+    ASSERT_EQ(engine->SetIsMember(set2, EncodeUint64(2), &is_member),
+              Status::Ok);
+    ASSERT_TRUE(is_member);
+    ASSERT_EQ(engine->SetIsMember(set2, EncodeUint64(1), &is_member),
+              Status::Ok);
+    ASSERT_FALSE(is_member);
+
+    size_t scanned = 0;
+    ASSERT_EQ(engine->SetScan(set2,
+                              [&](StringView member) {
+                                uint64_t v;
+                                EXPECT_TRUE(DecodeUint64(member, &v));
+                                EXPECT_EQ(v % 2, 0);
+                                scanned++;
+                                return true;
+                              }),
+              Status::Ok);
+    ASSERT_EQ(scanned, count / 2);
+
+    for (bool integer_members : {false, true}) {
+      std::vector<std::string> members;
+      ASSERT_EQ(engine->SetIntersect({set1, set2}, &members, integer_members),
+                Status::Ok);
+      ASSERT_EQ(members.size(), count / 2);
+      if (integer_members) {
+        for (size_t i = 0; i < members.size(); i++) {
+          ASSERT_EQ(members[i], EncodeUint64(i * 2));
+        }
+      }
+    }
+    std::vector<std::string> members;
+    ASSERT_EQ(engine->SetUnion({set1, set2}, &members), Status::Ok);
+    ASSERT_EQ(members.size(), count);
+  };
+  CheckSets();
+
+  // Sets are recovered as sets
+  Reboot();
+  CheckSets();
+
+  for (size_t i = 0; i < count; i += 2) {
+    ASSERT_EQ(engine->SetRemove(set1, EncodeUint64(i)), Status::Ok);
+  }
+  std::vector<std::string> members;
+  ASSERT_EQ(engine->SetIntersect({set1, set2}, &members), Status::Ok);
+  ASSERT_TRUE(members.empty());
+  ASSERT_EQ(engine->SetIntersect({set1, "NoSuchSet"}, &members),
+            Status::NotFound);
+  ASSERT_EQ(engine->SetDestroy(hash), Status::WrongType);
+  ASSERT_EQ(engine->SetDestroy(set1), Status::Ok);
+  size_t card;
+  ASSERT_EQ(engine->SetCard(set1, &card), Status::NotFound);
+  delete engine;
+}
+
+TEST_F(EngineBasicTest, TestZSet) {
+  size_t num_threads = 4;
+  size_t count = 1000;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string zset{"ZSet"};
+  std::string set{"NotZSet"};
+  ASSERT_EQ(engine->ZSetCreate(zset), Status::Ok);
+  ASSERT_EQ(engine->ZSetCreate(zset), Status::Existed);
+  ASSERT_EQ(engine->SetCreate(set), Status::Ok);
+  ASSERT_EQ(engine->ZAdd(set, "member", 1), Status::WrongType);
+  ASSERT_EQ(engine->SetAdd(zset, "member"), Status::WrongType);
+  ASSERT_EQ(engine->ZAdd(zset, "member", std::nan("")),
+            Status::InvalidArgument);
+  ValueType type;
+  ASSERT_EQ(engine->TypeOf(zset, &type), Status::Ok);
+  ASSERT_EQ(type, ValueType::ZSet);
+
+  // Member i ends with score i after each thread increases it once
+  auto MemberOf = [](size_t i) { return "member" + std::to_string(i); };
+  for (size_t i = 0; i < count; i++) {
+    ASSERT_EQ(engine->ZAdd(zset, MemberOf(i), 0), Status::Ok);
+  }
+  auto ZIncr = [&](size_t) {
+    for (size_t i = 0; i < count; i++) {
+      ASSERT_EQ(engine->ZIncrBy(zset, MemberOf(i),
+                                static_cast<double>(i) / num_threads),
+                Status::Ok);
+    }
+  };
+  LaunchNThreads(num_threads, ZIncr);
+
+  auto CheckZSet = [&]() {
+    size_t card;
+    ASSERT_EQ(engine->ZCard(zset, &card), Status::Ok);
+    ASSERT_EQ(card, count);
+    for (size_t i = 0; i < count; i++) {
+      double score;
+      ASSERT_EQ(engine->ZScore(zset, MemberOf(i), &score), Status::Ok);
+      ASSERT_DOUBLE_EQ(score, i);
+      size_t rank;
+      ASSERT_EQ(engine->ZRank(zset, MemberOf(i), &rank), Status::Ok);
+      ASSERT_EQ(rank, i);
+    }
+    std::vector<std::pair<std::string, double>> members;
+    ASSERT_EQ(engine->ZRangeByScore(zset, 10, 19.5, &members), Status::Ok);
+    ASSERT_EQ(members.size(), 10);
+    for (size_t i = 0; i < members.size(); i++) {
+      ASSERT_EQ(members[i].first, MemberOf(i + 10));
+      ASSERT_DOUBLE_EQ(members[i].second, i + 10);
+    }
+    ASSERT_EQ(engine->ZRangeByScore(zset, 0, count, &members, 5), Status::Ok);
+    ASSERT_EQ(members.size(), 5);
+  };
+  CheckZSet();
+
+  // Score index is rebuilt after recovery
+  Reboot();
+  CheckZSet();
+
+  // Concurrent updates and queries keep the index consistent with scores
+  auto UpdateAndQuery = [&](size_t tid) {
+    for (size_t i = 0; i < count; i++) {
+      if (tid % 2 == 0) {
+        ASSERT_EQ(engine->ZAdd(zset, MemberOf(i), -static_cast<double>(i)),
+                  Status::Ok);
+      } else {
+        size_t rank;
+        ASSERT_EQ(engine->ZRank(zset, MemberOf(i), &rank), Status::Ok);
+        ASSERT_LT(rank, count);
+      }
+    }
+  };
+  LaunchNThreads(num_threads, UpdateAndQuery);
+  size_t rank;
+  ASSERT_EQ(engine->ZRank(zset, MemberOf(count - 1), &rank), Status::Ok);
+  ASSERT_EQ(rank, 0);
+
+  ASSERT_EQ(engine->ZRem(zset, MemberOf(count - 1)), Status::Ok);
+  ASSERT_EQ(engine->ZRem(zset, MemberOf(count - 1)), Status::Ok);
+  ASSERT_EQ(engine->ZRank(zset, MemberOf(count - 1), &rank), Status::NotFound);
+  ASSERT_EQ(engine->ZRank(zset, MemberOf(count - 2), &rank), Status::Ok);
+  ASSERT_EQ(rank, 0);
+  ASSERT_EQ(engine->ZSetDestroy(set), Status::WrongType);
+  ASSERT_EQ(engine->ZSetDestroy(zset), Status::Ok);
+  size_t card;
+  ASSERT_EQ(engine->ZCard(zset, &card), Status::NotFound);
+  delete engine;
+}
+
+TEST_F(EngineBasicTest, TestStream) {
+  size_t num_threads = 4;
+  size_t count = 1000;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string stream{"Stream"};
+  std::string list{"NotStream"};
+  ASSERT_EQ(engine->StreamCreate(stream), Status::Ok);
+  ASSERT_EQ(engine->StreamCreate(stream), Status::Existed);
+  ASSERT_EQ(engine->ListCreate(list), Status::Ok);
+  ASSERT_EQ(engine->StreamCreate(list), Status::WrongType);
+  ASSERT_EQ(engine->XAdd(list, "entry"), Status::WrongType);
+  ASSERT_EQ(engine->ListPushBack(stream, "elem"), Status::WrongType);
+  ValueType type;
+  ASSERT_EQ(engine->TypeOf(stream, &type), Status::Ok);
+  ASSERT_EQ(type, ValueType::Stream);
+
+  auto XAdd = [&](size_t tid) {
+    for (size_t i = 0; i < count; i++) {
+      ASSERT_EQ(engine->XAdd(stream, std::to_string(tid)), Status::Ok);
+    }
+  };
+  LaunchNThreads(num_threads, XAdd);
+
+  std::vector<std::pair<uint64_t, std::string>> all;
+  auto CheckStream = [&]() {
+    size_t len;
+    ASSERT_EQ(engine->XLen(stream, &len), Status::Ok);
+    ASSERT_EQ(len, count * num_threads);
+    std::vector<std::pair<uint64_t, std::string>> entries;
+    ASSERT_EQ(engine->XRange(stream, 0, UINT64_MAX, &entries), Status::Ok);
+    ASSERT_EQ(entries.size(), len);
+    for (size_t i = 1; i < entries.size(); i++) {
+      ASSERT_LT(entries[i - 1].first, entries[i].first);
+    }
+    if (all.empty()) {
+      all = entries;
+    } else {
+      ASSERT_EQ(all, entries);
+    }
+    // Read by id ranges and pages
+    size_t begin = count / 3;
+    size_t end = begin + 100;
+    ASSERT_EQ(engine->XRange(stream, all[begin].first, all[end].first,
+                             &entries),
+              Status::Ok);
+    ASSERT_EQ(entries.size(), end - begin + 1);
+    ASSERT_EQ(entries.front(), all[begin]);
+    ASSERT_EQ(entries.back(), all[end]);
+    uint64_t last_id = 0;
+    size_t read = 0;
+    while (true) {
+      ASSERT_EQ(engine->XRead(stream, last_id, 100, &entries), Status::Ok);
+      if (entries.empty()) {
+        break;
+      }
+      ASSERT_EQ(entries.front(), all[read]);
+      read += entries.size();
+      last_id = entries.back().first;
+    }
+    ASSERT_EQ(read, all.size());
+  };
+  CheckStream();
+
+  // Sparse index is rebuilt after recovery, and new ids keep increasing
+  Reboot();
+  CheckStream();
+  uint64_t id;
+  ASSERT_EQ(engine->XAdd(stream, "last", &id), Status::Ok);
+  ASSERT_GT(id, all.back().first);
+  all.emplace_back(id, "last");
+
+  // Only whole index intervals are trimmed
+  size_t trimmed;
+  ASSERT_EQ(engine->XTrim(stream, all[100].first, &trimmed), Status::Ok);
+  ASSERT_LE(trimmed, 100);
+  ASSERT_EQ(trimmed % 64, 0);
+  std::vector<std::pair<uint64_t, std::string>> entries;
+  ASSERT_EQ(engine->XRange(stream, 0, UINT64_MAX, &entries), Status::Ok);
+  ASSERT_EQ(entries.size(), all.size() - trimmed);
+  ASSERT_EQ(entries.front(), all[trimmed]);
+  ASSERT_EQ(engine->XTrim(stream, UINT64_MAX, &trimmed), Status::Ok);
+  size_t len;
+  ASSERT_EQ(engine->XLen(stream, &len), Status::Ok);
+  ASSERT_EQ(len, 0);
+  ASSERT_EQ(engine->XAdd(stream, "after trim", &id), Status::Ok);
+  ASSERT_EQ(engine->XRange(stream, 0, UINT64_MAX, &entries), Status::Ok);
+  ASSERT_EQ(entries.size(), 1);
+
+  ASSERT_EQ(engine->StreamDestroy(list), Status::WrongType);
+  ASSERT_EQ(engine->StreamDestroy(stream), Status::Ok);
+  ASSERT_EQ(engine->XLen(stream, &len), Status::NotFound);
+  delete engine;
+}
+
+TEST_F(EngineBasicTest, TestTimeSeries) {
+  size_t num_threads = 4;
+  int64_t count = 1000;
+  int64_t bucket_width = 64;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string series{"Series"};
+  std::string hash{"NotSeries"};
+  ASSERT_EQ(engine->TSCreate(series, 0), Status::InvalidArgument);
+  ASSERT_EQ(engine->TSCreate(series, bucket_width), Status::Ok);
+  ASSERT_EQ(engine->TSCreate(series, bucket_width), Status::Existed);
+  ASSERT_EQ(engine->HashCreate(hash), Status::Ok);
+  ASSERT_EQ(engine->TSAppend(hash, 0, 0), Status::WrongType);
+  ASSERT_EQ(engine->HashPut(series, "key", "value"), Status::WrongType);
+  ValueType type;
+  ASSERT_EQ(engine->TypeOf(series, &type), Status::Ok);
+  ASSERT_EQ(type, ValueType::TimeSeries);
+
+  // Sample at timestamp t has value t, appended by interleaved threads so
+  // buckets are written concurrently
+  auto Append = [&](size_t tid) {
+    for (int64_t t = tid; t < count; t += num_threads) {
+      ASSERT_EQ(engine->TSAppend(series, t, t), Status::Ok);
+    }
+  };
+  LaunchNThreads(num_threads, Append);
+  // Overwrite and a sample before time 0
+  ASSERT_EQ(engine->TSAppend(series, 10, 10), Status::Ok);
+  ASSERT_EQ(engine->TSAppend(series, -1, -1), Status::Ok);
+
+  auto CheckSeries = [&]() {
+    std::vector<std::pair<int64_t, double>> samples;
+    ASSERT_EQ(engine->TSRange(series, -1, count, &samples), Status::Ok);
+    ASSERT_EQ(samples.size(), count + 1);
+    for (int64_t i = 0; i <= count; i++) {
+      ASSERT_EQ(samples[i].first, i - 1);
+      ASSERT_DOUBLE_EQ(samples[i].second, i - 1);
+    }
+    ASSERT_EQ(engine->TSRange(series, 100, 199, &samples), Status::Ok);
+    ASSERT_EQ(samples.size(), 100);
+    ASSERT_EQ(samples.front().first, 100);
+
+    // Windows not aligned with buckets
+    int64_t window = 100;
+    std::vector<TimeSeriesAggregate> aggregates;
+    ASSERT_EQ(engine->TSAggregate(series, 50, count - 1, window, &aggregates),
+              Status::Ok);
+    ASSERT_EQ(aggregates.size(), (count - 50 + window - 1) / window);
+    for (auto& agg : aggregates) {
+      int64_t last = std::min(agg.window_start + window, count) - 1;
+      ASSERT_EQ(agg.count,
+                static_cast<uint64_t>(last - agg.window_start + 1));
+      ASSERT_DOUBLE_EQ(agg.min, agg.window_start);
+      ASSERT_DOUBLE_EQ(agg.max, last);
+      ASSERT_DOUBLE_EQ(agg.sum, (agg.window_start + last) * agg.count / 2.0);
+    }
+  };
+  CheckSeries();
+
+  // Bucket directory is rebuilt after recovery
+  Reboot();
+  CheckSeries();
+
+  // Samples in timestamp order are appended to tails of buckets in place,
+  // which fill up and are rewritten several times in one bucket
+  std::string ordered{"OrderedSeries"};
+  int64_t num_ordered = 10000;
+  ASSERT_EQ(engine->TSCreate(ordered, num_ordered), Status::Ok);
+  for (int64_t t = 0; t < num_ordered; t++) {
+    ASSERT_EQ(engine->TSAppend(ordered, t, t), Status::Ok);
+  }
+  // Overwrite a sample in the tail
+  ASSERT_EQ(engine->TSAppend(ordered, num_ordered - 1, 0), Status::Ok);
+  auto CheckOrdered = [&]() {
+    std::vector<std::pair<int64_t, double>> samples;
+    ASSERT_EQ(engine->TSRange(ordered, 0, num_ordered, &samples), Status::Ok);
+    ASSERT_EQ(samples.size(), num_ordered);
+    for (int64_t i = 0; i < num_ordered; i++) {
+      ASSERT_EQ(samples[i].first, i);
+      ASSERT_DOUBLE_EQ(samples[i].second, i == num_ordered - 1 ? 0 : i);
+    }
+  };
+  CheckOrdered();
+  Reboot();
+  CheckOrdered();
+
+  ASSERT_EQ(engine->TSDestroy(hash), Status::WrongType);
+  ASSERT_EQ(engine->TSDestroy(series), Status::Ok);
+  std::vector<std::pair<int64_t, double>> samples;
+  ASSERT_EQ(engine->TSRange(series, 0, count, &samples), Status::NotFound);
+  delete engine;
+}
+
 TEST_F(EngineBasicTest, TestStringHotspot) {
   size_t n_thread_reading = 16;
   size_t n_thread_writing = 16;
@@ -3829,6 +5620,130 @@ TEST_F(EngineBasicTest, TestDynamicCleaner) {
 
   delete engine;
 }
+
+TEST_F(EngineBasicTest, TestLazyRecoveryDuringRebuild) {
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  std::string sorted_collection{"LazySorted"};
+  ASSERT_EQ(
+      engine->SortedCreate(sorted_collection, SortedCollectionConfigs()),
+      Status::Ok);
+  ASSERT_EQ(engine->Put("key", "value"), Status::Ok);
+  ASSERT_EQ(engine->SortedPut(sorted_collection, "key", "value"), Status::Ok);
+  delete engine;
+
+  configs.lazy_recovery = true;
+  std::string got;
+  // Hold the rebuild thread after the first collection type rebuilt
+  std::atomic<bool> rebuild_held{false};
+  std::atomic<bool> release_rebuild{false};
+  SyncPoint::GetInstance()->SetCallBack(
+      "KVEngine::runInRecoverySlots", [&](void*) {
+        if (!rebuild_held.exchange(true)) {
+          while (!release_rebuild.load()) {
+            std::this_thread::yield();
+          }
+        }
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  while (!rebuild_held.load()) {
+    std::this_thread::yield();
+  }
+  // This thread has a thread id less than max_access_threads, it never
+  // shares an access thread slot with rebuild threads, so its string
+  // requests are served while collections are being rebuilt
+  ASSERT_EQ(engine->Put("key2", "value2"), Status::Ok);
+  ASSERT_EQ(engine->Get("key", &got), Status::Ok);
+  ASSERT_EQ(got, "value");
+  ASSERT_EQ(engine->Get("key2", &got), Status::Ok);
+  ASSERT_EQ(got, "value2");
+
+  // Run more foreground threads than max_access_threads, so some of them are
+  // leased thread ids of rebuild threads, [max_access_threads,
+  // max_access_threads + max_access_threads / 2), they must wait until the
+  // rebuild done rather than sharing thread caches with rebuild threads
+  uint64_t first_rebuild_tid = configs.max_access_threads;
+  uint64_t num_rebuild_tids = std::max<uint64_t>(1, first_rebuild_tid / 2);
+  uint64_t num_slots = (first_rebuild_tid + num_rebuild_tids +
+                        configs.max_access_threads - 1) /
+                       configs.max_access_threads * configs.max_access_threads;
+  uint64_t num_foreground = first_rebuild_tid + num_rebuild_tids;
+  std::vector<int64_t> foreground_tids(num_foreground, -1);
+  std::atomic<uint64_t> leased{0};
+  std::atomic<uint64_t> finished{0};
+  auto is_rebuild_tid = [&](int64_t tid) {
+    uint64_t slot = tid % num_slots;
+    return slot >= first_rebuild_tid &&
+           slot < first_rebuild_tid + num_rebuild_tids;
+  };
+  std::vector<std::thread> foreground;
+  for (uint64_t i = 0; i < num_foreground; i++) {
+    foreground.emplace_back([&, i]() {
+      foreground_tids[i] = ThreadManager::ThreadID();
+      leased.fetch_add(1);
+      while (leased.load() < num_foreground) {
+        std::this_thread::yield();
+      }
+      ASSERT_EQ(engine->Put("fg" + std::to_string(i), std::to_string(i)),
+                Status::Ok);
+      finished.fetch_add(1);
+      // Keep the thread id leased until all threads done
+      while (finished.load() < num_foreground) {
+        std::this_thread::yield();
+      }
+    });
+  }
+  while (leased.load() < num_foreground) {
+    std::this_thread::yield();
+  }
+  uint64_t num_blocked = std::count_if(foreground_tids.begin(),
+                                       foreground_tids.end(), is_rebuild_tid);
+  // Thread ids are dense, so some ids of rebuild threads are leased
+  ASSERT_GT(num_blocked, 0U);
+  while (finished.load() < num_foreground - num_blocked) {
+    std::this_thread::yield();
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_EQ(finished.load(), num_foreground - num_blocked);
+
+  release_rebuild.store(true);
+  for (auto& t : foreground) {
+    t.join();
+  }
+  for (uint64_t i = 0; i < num_foreground; i++) {
+    ASSERT_EQ(engine->Get("fg" + std::to_string(i), &got), Status::Ok);
+    ASSERT_EQ(got, std::to_string(i));
+  }
+  ASSERT_EQ(engine->SortedGet(sorted_collection, "key", &got), Status::Ok);
+  ASSERT_EQ(got, "value");
+  delete engine;
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->Reset();
+
+  // Fail lazy recovery in rebuilding collections, strings are still served
+  // and collection requests return the error
+  SyncPoint::GetInstance()->SetCallBack(
+      "KVEngine::runInRecoverySlots",
+      [&](void* s) { *static_cast<Status*>(s) = Status::Abort; });
+  SyncPoint::GetInstance()->EnableProcessing();
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  ASSERT_EQ(engine->SortedGet(sorted_collection, "key", &got), Status::Abort);
+  ASSERT_EQ(engine->Get("key2", &got), Status::Ok);
+  ASSERT_EQ(got, "value2");
+  delete engine;
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->Reset();
+
+  configs.lazy_recovery = false;
+  ASSERT_EQ(Engine::Open(db_path.c_str(), &engine, configs, stdout),
+            Status::Ok);
+  ASSERT_EQ(engine->SortedGet(sorted_collection, "key", &got), Status::Ok);
+  ASSERT_EQ(got, "value");
+  delete engine;
+}
 #endif
 
 int main(int argc, char** argv) {